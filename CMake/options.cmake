@@ -352,6 +352,7 @@ if(UNIX)
     unset(FLTK_USE_XFT CACHE)
     unset(FLTK_USE_XCURSOR CACHE)
     unset(FLTK_USE_XFIXES CACHE)
+    unset(FLTK_USE_XSHM CACHE)
     if(X11_FOUND)
       if(NOT X11_Xfixes_FOUND)
         message(WARNING "Install development headers for libXfixes (e.g., libxfixes-dev)")
@@ -477,6 +478,7 @@ option(FLTK_BUILD_SHARED_LIBS
 option(FLTK_OPTION_PRINT_SUPPORT      "allow print support"          ON)
 option(FLTK_OPTION_FILESYSTEM_SUPPORT "allow file system support"    ON)
 option(FLTK_OPTION_PEN_SUPPORT        "include Pen/Tablet support"   ON)
+option(FLTK_OPTION_PROFILER           "record event loop and draw spans" OFF)
 
 option(FLTK_BUILD_FORMS        "Build forms compatibility library"   OFF)
 option(FLTK_BUILD_FLUID        "Build FLUID"                         ON)
@@ -542,6 +544,16 @@ else(FLTK_OPTION_PEN_SUPPORT)  # option disabled by user
   set(FLTK_HAVE_PEN_SUPPORT 0)
 endif(FLTK_OPTION_PEN_SUPPORT)
 
+#######################################################################
+# Event loop and draw profiler, see class Fl_Profiler
+#######################################################################
+
+if(FLTK_OPTION_PROFILER)
+  set(FLTK_HAVE_PROFILER 1)
+else()
+  set(FLTK_HAVE_PROFILER 0)
+endif()
+
 #######################################################################
 if(DOXYGEN_FOUND)
   option(FLTK_BUILD_HTML_DOCS "build html docs" ON)
@@ -1045,6 +1057,16 @@ else(FLTK_USE_XRENDER)
   set(FLTK_XRENDER_FOUND FALSE)
 endif(FLTK_USE_XRENDER)
 
+#######################################################################
+if(X11_XShm_FOUND AND X11_Xext_FOUND)
+  option(FLTK_USE_XSHM "use the MIT-SHM extension of lib Xext" ON)
+endif(X11_XShm_FOUND AND X11_Xext_FOUND)
+
+if(FLTK_USE_XSHM)
+  set(HAVE_XSHM ${X11_XShm_FOUND})
+  list(APPEND FLTK_BUILD_INCLUDE_DIRECTORIES ${X11_XShm_INCLUDE_PATH})
+endif(FLTK_USE_XSHM)
+
 #######################################################################
 set(FL_NO_PRINT_SUPPORT FALSE)
 if(X11_FOUND AND NOT FLTK_OPTION_PRINT_SUPPORT)
@@ -48,6 +48,7 @@ Fl_Window *openFile(const char *name, char *flags, bool close = false) {
   int debug = 0;
   while ((d = strchr(++d, 'd'))) debug++;
   bool optimize_mem = strchr(flags, 'm');
+  bool frame_deltas = strchr(flags, 'c');
   bool desaturate = strchr(flags, 'D');
   bool average = strchr(flags, 'A');
   bool test_tiles = strchr(flags, 'T');
@@ -65,9 +66,10 @@ Fl_Window *openFile(const char *name, char *flags, bool close = false) {
   win->color(BackGroundColor);
   if (close)
     win->callback(quit_cb);
-  printf("Loading '%s'%s%s ... ", name,
+  printf("Loading '%s'%s%s%s ... ", name,
     uncache ? " (uncached)" : "",
-    optimize_mem ? " (optimized)" : "");
+    optimize_mem ? " (optimized)" : "",
+    frame_deltas ? " (compressed frames)" : "");
 
   // create a canvas for the animation
   Fl_Box *canvas = test_tiles ? 0 : new Fl_Box(0, 0, 0, 0); // canvas will be resized by animation
@@ -77,6 +79,8 @@ Fl_Window *openFile(const char *name, char *flags, bool close = false) {
     gif_flags |= Fl_Anim_GIF_Image::DEBUG_FLAG;
   if (optimize_mem)
     gif_flags |= Fl_Anim_GIF_Image::OPTIMIZE_MEMORY;
+  if (frame_deltas)
+    gif_flags |= Fl_Anim_GIF_Image::FRAME_DELTAS;
 
   // create animation, specifying this canvas as display widget
   Fl_Anim_GIF_Image *animgif = new Fl_Anim_GIF_Image(name, canvas, gif_flags);
@@ -171,8 +175,8 @@ Fl_Window *openFile(const char *name, char *flags, bool close = false) {
       int x = (w == animgif->w() && h == animgif->h()) ? 0 : animgif->frame_x(i);
       int y = (w == animgif->w() && h == animgif->h()) ? 0 : animgif->frame_y(i);
       Fl_Box *b = new Fl_Box(x, y, w, h);
-      // get the frame image
-      b->image(animgif->image(i));
+      // get the frame image (compressed frames are composited only temporarily)
+      b->image(frame_deltas ? animgif->image(i)->copy() : animgif->image(i));
       win->end();
       win->show();
     }
@@ -254,7 +258,7 @@ int main(int argc, char *argv[]) {
              "   filename [-{flags}] open single file [with options] \n"
              "   No arguments open a fileselector\n"
              "   {flags} can be: d=debug mode, u=uncached, D=desaturated, A=color averaged, T=tiled\n"
-             "                   m=minimal update, r[scale factor]=resize by 'scale factor'\n"
+             "                   m=minimal update, c=compressed frames, r[scale factor]=resize by 'scale factor'\n"
              "   Use keys '+'/'-/0' to change speed of the active image (belowmouse).\n", testsuite);
       exit(1);
     }
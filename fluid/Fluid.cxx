@@ -48,12 +48,18 @@
 #endif
 #include <FL/Fl_Help_Dialog.H>
 #include <FL/Fl_PNG_Image.H>
+#include <FL/Fl_GIF_Image.H>
 #include <FL/Fl_File_Icon.H>
 #include <FL/Fl_Printer.H>
 #include <FL/fl_string_functions.h>
 #include "../src/flstring.h"
 
 #include <locale.h>     // setlocale()..
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#  include <signal.h>   // signal()
+#  include <sys/wait.h> // waitpid()
+#  include <unistd.h>   // fork(), pipe(), sysconf()
+#endif
 #undef min
 #undef max
 #include <limits>      // std::numeric_limits<int>::max()
@@ -150,16 +156,19 @@ int Application::run(int argc,char **argv) {
     c = argv[i];
 
   fl_register_images();
+  // uncompressed GIF images are written as Fl_Pixmap code, as they were
+  // before Fl_GIF_Image decoded to RGB data, so the generated code is unchanged
+  Fl_GIF_Image::xpm_data = true;
 
   make_main_window();
 
+  // fluid -u, -c, -cs: process all project files and exit
+  if (batch_mode)
+    ::exit(batch_compile());
+
   if (c) {
-    if (batch_mode) {
-      proj.set_filename(c);
-    } else {
-      // In GUI mode, filenames must always be absolute.
-      proj.set_filename(fl_filename_absolute_str(c));
-    }
+    // In GUI mode, filenames must always be absolute.
+    proj.set_filename(fl_filename_absolute_str(c));
   }
   if (!batch_mode) {
 #ifdef __APPLE__
@@ -186,44 +195,10 @@ int Application::run(int argc,char **argv) {
   }
   proj.undo.suspend();
   if (c && !fluid::io::read_file(proj, c,0)) {
-    if (batch_mode) {
-      fprintf(stderr,"%s : %s\n", c, strerror(errno));
-      exit(1);
-    }
     fl_message("Can't read %s: %s", c, strerror(errno));
   }
   proj.undo.resume();
 
-  // command line args override code and header filenames from the project file
-  // in batch mode only
-  if (batch_mode) {
-    if (!args.code_filename.empty()) {
-      proj.code_file_set = 1;
-      proj.code_file_name = args.code_filename;
-    }
-    if (!args.header_filename.empty()) {
-      proj.header_file_set = 1;
-      proj.header_file_name = args.header_filename;
-    }
-  }
-
-  if (args.update_file) {            // fluid -u
-    fluid::io::write_file(proj, c, 0);
-    if (!args.compile_file)
-      exit(0);
-  }
-
-  if (args.compile_file) {           // fluid -c[s]
-    if (args.compile_strings)
-      proj.write_strings();
-    write_code_files();
-    exit(0);
-  }
-
-  // don't lock up if inconsistent command line arguments were given
-  if (batch_mode)
-    exit(0);
-
   proj.set_modflag(0);
   proj.undo.clear();
 
@@ -850,7 +825,8 @@ void Application::print_snapshots() {
  presented to the user.
 
  In batch_mode, the function will either be silent, or, if opening or writing
- the files fails, write an error message to \c stderr and exit with exit code 1.
+ the files fails, write an error message to \c stderr and return 1, so that
+ the remaining files of a batch run are still processed.
 
  In interactive mode, it will pop up an error message, or, if the user
  hasn't disabled that, pop up a confirmation message.
@@ -886,7 +862,7 @@ int Application::write_code_files(bool dont_show_completion_dialog)
               code_filename_rel.c_str(),
               header_filename_rel.c_str(),
               strerror(errno));
-      exit(1);
+      return 1;
     }
   } else {
     if (!x) {
@@ -894,6 +870,7 @@ int Application::write_code_files(bool dont_show_completion_dialog)
                  code_filename_rel.c_str(),
                  header_filename_rel.c_str(),
                  strerror(errno));
+      return 1;
     } else {
       proj.set_modflag(-1, 0);
       if (dont_show_completion_dialog==false && completion_button->value()) {
@@ -907,6 +884,142 @@ int Application::write_code_files(bool dont_show_completion_dialog)
 }
 
 
+/**
+ Run the command line operations on a single project file in batch mode.
+
+ The project replaces the current project. Code and header files that did not
+ change are not written again, so build systems will not recompile them.
+
+ \param[in] filename the .fl project file
+ \return 0 if the operation succeeded, 1 if the file could not be read or
+    a file could not be written
+ */
+int Application::batch_file(const std::string &filename) {
+  Fl_Timestamp start = Fl::now();
+  const char *c = filename.c_str();
+  proj.set_filename(c);
+
+  proj.undo.suspend();
+  if (!fluid::io::read_file(proj, c, 0)) {
+    fprintf(stderr,"%s : %s\n", c, strerror(errno));
+    proj.undo.resume();
+    return 1;
+  }
+  proj.undo.resume();
+
+  // command line args override code and header filenames from the project file
+  if (!args.code_filename.empty()) {
+    proj.code_file_set = 1;
+    proj.code_file_name = args.code_filename;
+  }
+  if (!args.header_filename.empty()) {
+    proj.header_file_set = 1;
+    proj.header_file_name = args.header_filename;
+  }
+
+  int ret = 0;
+  if (args.update_file) {            // fluid -u
+    if (!fluid::io::write_file(proj, c, 0)) {
+      fprintf(stderr,"%s : %s\n", c, strerror(errno));
+      ret = 1;
+    }
+  }
+
+  if (args.compile_file) {           // fluid -c[s]
+    if (args.compile_strings)
+      ret |= proj.write_strings();
+    ret |= write_code_files();
+  }
+
+  if (args.timings) {
+    printf("%s: %.1f ms\n", c, Fl::seconds_since(start) * 1000.0);
+    fflush(stdout);
+  }
+  return ret;
+}
+
+
+/**
+ Run the command line operations on all project files in batch mode.
+
+ With more than one file, the files are distributed over several worker
+ processes that are forked after the application was initialized, so the
+ startup cost is only paid once. Workers take the next file from a shared
+ queue when they are done with the previous one. Threads can't be used here,
+ because the nodes write their code into the global project.
+
+ On Windows, or with \c -j 1, all files are processed one after the other.
+
+ \return 0 if all files were processed, 1 if any of them failed
+ */
+int Application::batch_compile() {
+  const std::vector<std::string> &files = args.files;
+  Fl_Timestamp start = Fl::now();
+  int ret = 0;
+
+  int jobs = args.jobs;
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  jobs = 1;
+#else
+  if (jobs <= 0)
+    jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (jobs > (int)files.size())
+    jobs = (int)files.size();
+  int queue[2];
+  if (jobs > 1 && pipe(queue) == 0) {
+    fflush(stdout);
+    fflush(stderr);
+    std::vector<pid_t> workers;
+    for (int j = 0; j < jobs; j++) {
+      pid_t pid = fork();
+      if (pid == 0) {
+        // worker: the pipe hands out file indices, writes of 4 bytes are atomic
+        close(queue[1]);
+        unsigned int index;
+        while (read(queue[0], &index, sizeof(index)) == sizeof(index))
+          ret |= batch_file(files[index]);
+        fflush(stdout);
+        fflush(stderr);
+        ::_exit(ret);
+      }
+      if (pid > 0)
+        workers.push_back(pid);
+    }
+    close(queue[0]);
+    if (!workers.empty()) {
+      signal(SIGPIPE, SIG_IGN);
+      for (unsigned int index = 0; index < files.size(); index++) {
+        ssize_t n;
+        do { n = write(queue[1], &index, sizeof(index)); } while (n == -1 && errno == EINTR);
+        if (n != sizeof(index)) { ret = 1; break; }   // all workers died
+      }
+      close(queue[1]);
+      for (pid_t pid : workers) {
+        int status = 0;
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR) { }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+          ret = 1;
+      }
+      jobs = (int)workers.size();
+    } else {
+      close(queue[1]);
+      jobs = 1;
+    }
+  } else {
+    jobs = 1;
+  }
+  if (jobs == 1)
+#endif
+  for (const std::string &f : files)
+    ret |= batch_file(f);
+
+  if (args.timings && files.size() > 1)
+    printf("%d files in %.1f ms, %d job%s\n", (int)files.size(),
+           Fl::seconds_since(start) * 1000.0, jobs, jobs == 1 ? "" : "s");
+  return ret;
+}
+
+
 /**
  User chose to cut the currently selected widgets.
  */
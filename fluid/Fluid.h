@@ -168,6 +168,10 @@ public: // Methods
   void print_snapshots();
   // Generate the C++ source and header filenames and write those files.
   int write_code_files(bool dont_show_completion_dialog=false);
+  // Run the command line operations on a single project file in batch mode.
+  int batch_file(const std::string &filename);
+  // Run the command line operations on all project files in batch mode.
+  int batch_compile();
 
   // User chose to cut the currently selected widgets.
   void cut_selected();
@@ -285,19 +285,24 @@ void Project::set_filename(const std::string &c) {
 
 /**
  Write the strings that are used in i18n.
+
+ In batch mode, an error message is written to \c stderr if the file can't
+ be written.
+
+ \return 1 if the operation failed, 0 if it succeeded
  */
-void Project::write_strings() {
+int Project::write_strings() {
   Fluid.flush_text_widgets();
   if (!proj_filename) {
     Fluid.save_project_file(nullptr);
-    if (!proj_filename) return;
+    if (!proj_filename) return 1;
   }
   std::string filename = stringsfile_path() + stringsfile_name();
   int x = fluid::io::write_strings(*this, filename);
   if (Fluid.batch_mode) {
     if (x) {
       fprintf(stderr, "%s : %s\n", filename.c_str(), strerror(errno));
-      exit(1);
+      return 1;
     }
   } else {
     if (x) {
@@ -306,6 +311,7 @@ void Project::write_strings() {
       fl_message("Wrote %s", stringsfile_name().c_str());
     }
   }
+  return x ? 1 : 0;
 }
 
 
@@ -112,7 +112,7 @@ public: // Methods
 
   void set_filename(std::nullptr_t);
   void set_filename(const std::string &c);
-  void write_strings();
+  int write_strings();
 
   void set_modflag(int mf, int mfc = -1);
 };
@@ -21,6 +21,12 @@
 #include <FL/Fl.H>
 #include <FL/filename.H>
 #include <FL/fl_ask.H>
+#include <FL/fl_utf8.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 using namespace fluid;
 using namespace fluid::app;
@@ -41,16 +47,19 @@ int Args::load(int argc,char **argv) {
   int i = 1;
   Fl::args_to_utf8(argc, argv); // for MSYS2/MinGW
   if (   (Fl::args(argc,argv,i,arg_cb) == 0)     // unsupported argument found
-      || (Fluid.batch_mode && (i != argc-1))        // .fl filename missing
+      || (Fluid.batch_mode && !load_files(argc, argv, i)) // .fl filename missing
       || (!Fluid.batch_mode && (i < argc-1))        // more than one filename found
       || (argv[i] && (argv[i][0] == '-'))) {  // unknown option
     static const char *msg =
-    "usage: %s <switches> name.fl\n"
+    "usage: %s <switches> name.fl [name.fl ...]\n"
     " -u : update .fl file and exit (may be combined with '-c' or '-cs')\n"
     " -c : write .cxx and .h and exit\n"
     " -cs : write .cxx and .h and strings and exit\n"
     " -o <name> : .cxx output filename, or extension if <name> starts with '.'\n"
     " -h <name> : .h output filename, or extension if <name> starts with '.'\n"
+    " -j <n> : process several .fl files in n parallel jobs, default is one per CPU\n"
+    " -t : print the time spent on each .fl file\n"
+    " @<file> : read more .fl filenames from <file>, one per line\n"
     " --help : brief usage information\n"
     " --version, -v : print fluid version number\n"
     " -d : enable internal debugging\n";
@@ -71,6 +80,53 @@ int Args::load(int argc,char **argv) {
 }
 
 
+/**
+ Collect the .fl files to process in batch mode.
+
+ All remaining arguments are project files. An argument starting with '@'
+ names a response file that lists more project files, one per line. Empty
+ lines and lines starting with '#' are ignored.
+
+ \param[in] argc number of arguments in the list
+ \param[in] argv pointer to an array of arguments
+ \param[in] i index of the first filename
+ \return 1 if at least one file was found and the arguments are consistent,
+    0 otherwise
+ */
+int Args::load_files(int argc, char **argv, int i) {
+  files.clear();
+  for ( ; i < argc; i++) {
+    const char *a = argv[i];
+    if (a[0] == '-') return 0;
+    if (a[0] != '@') {
+      files.push_back(a);
+      continue;
+    }
+    FILE *f = fl_fopen(a + 1, "rb");
+    if (!f) {
+      fprintf(stderr, "%s : %s\n", a + 1, strerror(errno));
+      return 0;
+    }
+    char line[FL_PATH_MAX];
+    while (fgets(line, sizeof(line), f)) {
+      char *s = line, *e = line + strlen(line);
+      while (*s == ' ' || *s == '\t') s++;
+      while (e > s && (e[-1] == '\n' || e[-1] == '\r' || e[-1] == ' ' || e[-1] == '\t')) e--;
+      if (e == s || *s == '#') continue;
+      files.push_back(std::string(s, e - s));
+    }
+    fclose(f);
+  }
+  if (files.empty()) return 0;
+  // a complete output filename can't be shared by several projects
+  if (files.size() > 1) {
+    if (!code_filename.empty() && code_filename[0] != '.') return 0;
+    if (!header_filename.empty() && header_filename[0] != '.') return 0;
+  }
+  return 1;
+}
+
+
 int Args::arg_cb(int argc, char** argv, int& i) {
   return Fluid.args.arg(argc, argv, i);
 }
@@ -110,6 +166,14 @@ int Args::arg(int argc, char** argv, int& i) {
     Fluid.batch_mode++;
     i++; return 1;
   }
+  if (argv[i][1] == 'j' && !argv[i][2] && i+1 < argc) {
+    jobs = atoi(argv[i+1]);
+    i += 2; return 2;
+  }
+  if (argv[i][1] == 't' && !argv[i][2]) {
+    timings = 1;
+    i++; return 1;
+  }
   if (argv[i][1] == 'o' && !argv[i][2] && i+1 < argc) {
     code_filename = argv[i+1];
     Fluid.batch_mode++;
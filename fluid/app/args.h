@@ -18,6 +18,7 @@
 #define FLUID_APP_ARGS_H
 
 #include <string>
+#include <vector>
 
 namespace fluid {
 namespace app {
@@ -27,6 +28,8 @@ class Args {
   static int arg_cb(int argc, char** argv, int& i);
   // Handle args individually.
   int arg(int argc, char** argv, int& i);
+  // Collect the .fl files to process in batch mode.
+  int load_files(int argc, char **argv, int i);
 public:
   /// Set, if Fluid was started with the command line argument -u
   int update_file { 0 };            // fluid -u
@@ -42,6 +45,12 @@ public:
   std::string autodoc_path { };         // fluid --autodoc path
   /// Set, if Fluid was started with the command line argument -v
   int show_version { 0 };           // fluid -v
+  /// .fl files to process in batch mode, with response files expanded
+  std::vector<std::string> files { };
+  /// number of parallel jobs in batch mode, 0 for one per CPU
+  int jobs { 0 };                   // fluid -j n
+  /// Set, if the time spent on each file is printed in batch mode
+  int timings { 0 };                // fluid -t
   /// Constructor.
   Args() = default;
   // Load args from command line into variables.
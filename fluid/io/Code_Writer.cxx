@@ -599,6 +599,8 @@ int Code_Writer::write_code(const std::string& code_arg, const std::string& head
   code_filename = code_arg;
   header_filename = header_arg;
   write_codeview = to_codeview;
+  if (to_codeview)
+    proj_.tree.invalidate_text_index();
 
   // Remember the last code file location for MergeBack
   if (!code_arg.empty() && proj_.write_mergeback_data && !to_codeview)
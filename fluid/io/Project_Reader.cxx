@@ -65,6 +65,19 @@ int fluid::io::read_file(Project &proj, const char *filename, int merge, Strateg
   return f.read_project(filename, merge, strategy);
 }
 
+/** \brief Read .fl project text from memory.
+ \param[in] data, size the .fl text
+ \param[in] name a name for error messages
+ \param[in] merge if this is set, merge the text into an existing project
+ \param[in] strategy add new nodes after current or as last child
+ \return 0 if the operation failed, 1 if it succeeded
+ */
+int fluid::io::read_buffer(Project &proj, const char *data, size_t size, const char *name, int merge, Strategy strategy) {
+  Project_Reader f(proj);
+  strategy.source(Strategy::FROM_FILE);
+  return f.read_project(data, size, name, merge, strategy);
+}
+
 /**
  Convert a single ASCII char, assumed to be a hex digit, into its decimal value.
  \param[in] x ASCII character
@@ -114,34 +127,61 @@ Project_Reader::~Project_Reader()
 
 /**
  Open an .fl file for reading.
+
+ The whole file is read into memory at once, so the tokenizer does not need
+ to call into stdio for every single character.
+
  \param[in] s filename, if nullptr, read from stdin instead
  \return 0 if the operation failed, 1 if it succeeded
  */
 int Project_Reader::open_read(const char *s) {
   lineno = 1;
-  if (!s) {
-    fin = stdin;
-    fname = "stdin";
-  } else {
-    FILE *f = fl_fopen(s, "rb");
-    if (!f)
-      return 0;
-    fin = f;
-    fname = s;
+  FILE *f = s ? fl_fopen(s, "rb") : stdin;
+  if (!f)
+    return 0;
+  data_.clear();
+  if (f != stdin && fseek(f, 0, SEEK_END) == 0) {
+    long size = ftell(f);
+    if (size > 0) data_.reserve((size_t)size);
+    rewind(f);
   }
+  char chunk[0x10000];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    data_.append(chunk, n);
+  int err = ferror(f);
+  if (f != stdin)
+    fclose(f);
+  if (err)
+    return 0;
+  fname = s ? s : "stdin";
+  mem_pos_ = data_.data();
+  mem_end_ = mem_pos_ + data_.size();
+  return 1;
+}
+
+/**
+ Read .fl text from memory instead of a file.
+ \param[in] data, size the text, which must stay valid until close_read()
+ \param[in] name a name for error messages
+ \return 1
+ */
+int Project_Reader::open_read(const char *data, size_t size, const char *name) {
+  lineno = 1;
+  if (!data) data = "";
+  mem_pos_ = data;
+  mem_end_ = data + size;
+  fname = name;
   return 1;
 }
 
 /**
  Close the .fl file.
- \return 0 if the operation failed, 1 if it succeeded
+ \return 1
  */
 int Project_Reader::close_read() {
-  if (fin != stdin) {
-    int x = fclose(fin);
-    fin = nullptr;
-    return x >= 0;
-  }
+  mem_pos_ = mem_end_ = nullptr;
+  std::string().swap(data_);
   return 1;
 }
 
@@ -174,7 +214,7 @@ int Project_Reader::read_quoted() {      // read whatever character is after a \
       for (c=x=0; x<3; x++) {
         int ch = nextchar();
         d = hexdigit(ch);
-        if (d > 15) {ungetc(ch,fin); break;}
+        if (d > 15) {unget(ch); break;}
         c = (c<<4)+d;
       }
       break;
@@ -184,7 +224,7 @@ int Project_Reader::read_quoted() {      // read whatever character is after a \
       for (x=0; x<2; x++) {
         int ch = nextchar();
         d = hexdigit(ch);
-        if (d>7) {ungetc(ch,fin); break;}
+        if (d>7) {unget(ch); break;}
         c = (c<<3)+d;
       }
       break;
@@ -389,13 +429,29 @@ Node *Project_Reader::read_children(Node *p, int merge, Strategy strategy, char
  \return 0 if the operation failed, 1 if it succeeded
  */
 int Project_Reader::read_project(const char *filename, int merge, Strategy strategy) {
+  if (!open_read(filename))
+    return 0;
+  return read_project_(merge, strategy);
+}
+
+/** \brief Read .fl project text from memory.
+ \param[in] data, size the .fl text
+ \param[in] name a name for error messages
+ \param[in] merge if this is set, merge the text into an existing project
+ at Fluid.proj.tree.current
+ \param[in] strategy add new nodes after current or as last child
+ \return 0 if the operation failed, 1 if it succeeded
+ */
+int Project_Reader::read_project(const char *data, size_t size, const char *name, int merge, Strategy strategy) {
+  open_read(data, size, name);
+  return read_project_(merge, strategy);
+}
+
+// Read the project from the input opened by open_read().
+int Project_Reader::read_project_(int merge, Strategy strategy) {
   Node *o;
   proj_.undo.suspend();
   read_version = 0.0;
-  if (!open_read(filename)) {
-    proj_.undo.resume();
-    return 0;
-  }
   if (merge)
     deselect();
   else
@@ -441,7 +497,7 @@ int Project_Reader::read_project(const char *filename, int merge, Strategy strat
 void Project_Reader::read_error(const char *format, ...) {
   va_list args;
   va_start(args, format);
-  if (!fin) { // FIXME: this line suppresses any error messages in interactive mode
+  if (!mem_pos_) { // FIXME: this line suppresses any error messages in interactive mode
     char buffer[1024]; // TODO: hides class member "buffer"
     vsnprintf(buffer, sizeof(buffer), format, args);
     fl_message("%s", buffer);
@@ -477,7 +533,7 @@ const char *Project_Reader::read_word(int wantbrace) {
   // skip all the whitespace before it:
   for (;;) {
     x = nextchar();
-    if (x < 0 && feof(fin)) {   // eof
+    if (x < 0 && at_eof()) {   // eof
       return nullptr;
     } else if (x == '#') {      // comment
       do x = nextchar(); while (x >= 0 && x != '\n');
@@ -510,6 +566,7 @@ const char *Project_Reader::read_word(int wantbrace) {
       else if (x == '}') {if (!nesting--) break;}
       buffer[length++] = x;
       expand_buffer(length);
+      append_run(length, true);
     }
     buffer[length] = 0;
     return buffer;
@@ -529,15 +586,46 @@ const char *Project_Reader::read_word(int wantbrace) {
       else if (x<0 || fl_ascii_isspace(x) || x=='{' || x=='}' || x=='#') break;
       buffer[length++] = x;
       expand_buffer(length);
+      append_run(length, false);
       x = nextchar();
     }
-    ungetc(x, fin);
+    unget(x);
     buffer[length] = 0;
     return buffer;
 
   }
 }
 
+/**
+ Copy a run of plain characters from the input to the end of the word buffer.
+
+ read_word() handles one character at a time, but most characters need no
+ special treatment. This copies all of them up to the next character that
+ does in a single step.
+
+ \param[inout] length length of the word in the buffer, updated
+ \param[in] in_braces if set, spaces are part of the word, but newlines are
+    not, because they must be counted
+ */
+void Project_Reader::append_run(int &length, bool in_braces) {
+  const char *s = mem_pos_, *e = s;
+  if (in_braces) {
+    while (e < mem_end_ && *e != '\n' && *e != '\r' && *e != '\\'
+           && *e != '{' && *e != '}' && *e != '#')
+      e++;
+  } else {
+    while (e < mem_end_ && (unsigned char)*e > ' ' && *e != '\\'
+           && *e != '{' && *e != '}' && *e != '#')
+      e++;
+  }
+  int n = (int)(e - s);
+  if (!n) return;
+  expand_buffer(length + n);
+  memcpy(buffer + length, s, n);
+  length += n;
+  mem_pos_ = e;
+}
+
 /** Read a word and interpret it as an integer value.
  \return integer value, or 0 if the word is not an integer
  */
@@ -563,7 +651,7 @@ int Project_Reader::read_fdesign_line(const char*& name, const char*& value) {
   // find a colon:
   for (;;) {
     x = nextchar();
-    if (x < 0 && feof(fin)) return 0;
+    if (x < 0 && at_eof()) return 0;
     if (x == '\n') {length = 0; continue;} // no colon this line...
     if (!fl_ascii_isspace(x)) {
       buffer[length++] = x;
@@ -577,7 +665,7 @@ int Project_Reader::read_fdesign_line(const char*& name, const char*& value) {
   // skip to start of value:
   for (;;) {
     x = nextchar();
-    if ((x < 0 && feof(fin)) || x == '\n' || !fl_ascii_isspace(x)) break;
+    if ((x < 0 && at_eof()) || x == '\n' || !fl_ascii_isspace(x)) break;
   }
 
   // read the value:
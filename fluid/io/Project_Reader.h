@@ -22,6 +22,7 @@
 #include <FL/fl_attr.h>
 
 #include <stdio.h>
+#include <string>
 
 
 class Node;
@@ -35,6 +36,7 @@ namespace io {
 extern int fdesign_flip;
 
 int read_file(Project &proj, const char *, int merge, Strategy strategy=Strategy::FROM_FILE_AS_LAST_CHILD);
+int read_buffer(Project &proj, const char *data, size_t size, const char *name, int merge, Strategy strategy=Strategy::FROM_FILE_AS_LAST_CHILD);
 
 class Project_Reader
 {
@@ -42,8 +44,12 @@ protected:
   /// Link Project_Reader class to the project.
   Project &proj_;
 
-  /// Project input file
-  FILE *fin = nullptr;
+  /// Contents of the project file, the reader works on this copy in memory
+  std::string data_;
+  /// Position of the next character to read, or nullptr if nothing is open
+  const char *mem_pos_ = nullptr;
+  /// End of the text that is read
+  const char *mem_end_ = nullptr;
   /// Number of most recently read line
   int lineno = 0;
   /// Pointer to the file path and name (not copied!)
@@ -55,7 +61,12 @@ protected:
 
   void expand_buffer(int length);
 
-  int nextchar() { for (;;) { int ret = fgetc(fin); if (ret!='\r') return ret; } }
+  int getchar_() { return mem_pos_ < mem_end_ ? (unsigned char)*mem_pos_++ : EOF; }
+  int nextchar() { for (;;) { int ret = getchar_(); if (ret!='\r') return ret; } }
+  void unget(int c) { if (c != EOF) mem_pos_--; }
+  bool at_eof() { return mem_pos_ >= mem_end_; }
+  void append_run(int &length, bool in_braces);
+  int read_project_(int merge, Strategy strategy);
 
 public:
   /// Holds the file version number after reading the "version" tag
@@ -65,11 +76,13 @@ public:
   Project_Reader(Project &proj);
   ~Project_Reader();
   int open_read(const char *s);
+  int open_read(const char *data, size_t size, const char *name);
   int close_read();
   const char *filename_name();
   int read_quoted();
   Node *read_children(Node *p, int merge, Strategy strategy, char skip_options=0);
   int read_project(const char *, int merge, Strategy strategy=Strategy::FROM_FILE_AS_LAST_CHILD);
+  int read_project(const char *data, size_t size, const char *name, int merge, Strategy strategy=Strategy::FROM_FILE_AS_LAST_CHILD);
   void read_error(const char *format, ...);
   const char *read_word(int wantbrace = 0);
   int read_int();
@@ -51,6 +51,18 @@ int fluid::io::write_file(Project &proj, const char *filename, int selected_only
   return out.write_project(filename, selected_only, to_codeview);
 }
 
+/** \brief Write the project as .fl text into a memory buffer.
+ \param[out] buffer the text replaces the contents of this string
+ \param[in] selected_only write only the selected nodes in the widget_tree
+ \param[in] to_codeview if set, the text will be shown in the codeview dialog
+ \return 0 if the operation failed, 1 if it succeeded
+ */
+int fluid::io::write_buffer(Project &proj, std::string &buffer, int selected_only, bool to_codeview) {
+  Project_Writer out(proj);
+  buffer.clear();
+  return out.write_project(buffer, selected_only, to_codeview);
+}
+
 // ---- Project_Writer ---------------------------------------------- MARK: -
 
 /** \brief Construct local project writer. */
@@ -81,12 +93,26 @@ int Project_Writer::open_write(const char *s) {
   return 1;
 }
 
+/**
+ Collect the .fl design in a memory buffer instead of a file.
+ \param[in] buffer the text is appended to this string
+ \return 1
+ */
+int Project_Writer::open_write(std::string &buffer) {
+  buffer_ = &buffer;
+  return 1;
+}
+
 /**
  Close the .fl design file.
  Don't close, if data was sent to stdout.
  \return 1 if succeeded, 0 if fclose failed
  */
 int Project_Writer::close_write() {
+  if (buffer_) {
+    buffer_ = nullptr;
+    return 1;
+  }
   if (fout != stdout) {
     int x = fclose(fout);
     fout = stdout;
@@ -104,11 +130,28 @@ int Project_Writer::close_write() {
  */
 int Project_Writer::write_project(const char *filename, int selected_only, bool sv) {
   write_codeview_ = sv;
-  proj_.undo.suspend();
-  if (!open_write(filename)) {
-    proj_.undo.resume();
+  if (!open_write(filename))
     return 0;
-  }
+  return write_project_(selected_only);
+}
+
+/** \brief Write the .fl design description into a memory buffer.
+ \param[out] buffer the text is appended to this string
+ \param[in] selected_only write only the selected nodes in the widget_tree
+ \param[in] sv if set, this text will be used by codeview
+ \return 1
+ */
+int Project_Writer::write_project(std::string &buffer, int selected_only, bool sv) {
+  write_codeview_ = sv;
+  open_write(buffer);
+  return write_project_(selected_only);
+}
+
+// Write the project to the output opened by open_write().
+int Project_Writer::write_project_(int selected_only) {
+  proj_.undo.suspend();
+  if (write_codeview_)
+    proj_.tree.invalidate_text_index();
 #if (FL_MAJOR_VERSION==1) && (FL_MINOR_VERSION==5) && (FL_PATCH_VERSION==0)
   // For Fluid 1.5.0 write the version tag as 1.050020 instead of 1.5000 to
   // indicate changes in the file format during 1.5.0 development. Reading
@@ -162,13 +205,13 @@ int Project_Writer::write_project(const char *filename, int selected_only, bool
  \param[in] w NUL terminated text
  */
 void Project_Writer::write_word(const char *w) {
-  if (needspace) putc(' ', fout);
+  if (needspace) put(' ');
   needspace = 1;
-  if (!w || !*w) {fprintf(fout,"{}"); return;}
+  if (!w || !*w) {put("{}"); return;}
   const char *p;
   // see if it is a single word:
   for (p = w; is_id(*p); p++) ;
-  if (!*p) {fprintf(fout,"%s",w); return;}
+  if (!*p) {put(w); return;}
   // see if there are matching braces:
   int n = 0;
   for (p = w; *p; p++) {
@@ -177,7 +220,7 @@ void Project_Writer::write_word(const char *w) {
   }
   int mismatched = (n != 0);
   // write out brace-quoted string:
-  putc('{', fout);
+  put('{');
   for (; *w; w++) {
     switch (*w) {
     case '{':
@@ -185,12 +228,12 @@ void Project_Writer::write_word(const char *w) {
       if (!mismatched) break;
     case '\\':
     case '#':
-      putc('\\',fout);
+      put('\\');
       break;
     }
-    putc(*w,fout);
+    put(*w);
   }
-  putc('}', fout);
+  put('}');
 }
 
 /**
@@ -202,8 +245,24 @@ void Project_Writer::write_word(const char *w) {
 void Project_Writer::write_string(const char *format, ...) {
   va_list args;
   va_start(args, format);
-  if (needspace && *format != '\n') fputc(' ',fout);
-  vfprintf(fout, format, args);
+  if (needspace && *format != '\n') put(' ');
+  if (buffer_) {
+    char buf[1024];
+    va_list args2;
+    va_copy(args2, args);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    if (n < (int)sizeof(buf)) {
+      buffer_->append(buf, n < 0 ? 0 : n);
+    } else {
+      size_t size = buffer_->size();
+      buffer_->resize(size + n + 1);
+      vsnprintf(&(*buffer_)[size], n + 1, format, args2);
+      buffer_->resize(size + n);
+    }
+    va_end(args2);
+  } else {
+    vfprintf(fout, format, args);
+  }
   va_end(args);
   needspace = !fl_ascii_isspace(format[strlen(format)-1]);
 }
@@ -213,8 +272,8 @@ void Project_Writer::write_string(const char *format, ...) {
  \param[in] n indent level
  */
 void Project_Writer::write_indent(int n) {
-  fputc('\n',fout);
-  while (n--) {fputc(' ',fout); fputc(' ',fout);}
+  put('\n');
+  while (n--) put("  ");
   needspace = 0;
 }
 
@@ -222,8 +281,8 @@ void Project_Writer::write_indent(int n) {
  Write a '{' to the .fl file at the given indenting level.
  */
 void Project_Writer::write_open() {
-  if (needspace) fputc(' ',fout);
-  fputc('{',fout);
+  if (needspace) put(' ');
+  put('{');
   needspace = 0;
 }
 
@@ -233,7 +292,7 @@ void Project_Writer::write_open() {
  */
 void Project_Writer::write_close(int n) {
   if (needspace) write_indent(n);
-  fputc('}',fout);
+  put('}');
   needspace = 1;
 }
 
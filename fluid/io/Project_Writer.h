@@ -32,6 +32,7 @@ class Project;
 namespace io {
 
 int write_file(Project &proj, const char *, int selected_only = 0, bool to_codeview = false);
+int write_buffer(Project &proj, std::string &buffer, int selected_only = 0, bool to_codeview = false);
 
 class Project_Writer
 {
@@ -45,13 +46,21 @@ protected:
   int needspace = 0;
   /// Set if this file will be used in the codeview dialog
   bool write_codeview_ = false;
+  /// If set, the project is written into this string instead of fout
+  std::string *buffer_ = nullptr;
+
+  void put(char c) { if (buffer_) buffer_->push_back(c); else putc(c, fout); }
+  void put(const char *s) { if (buffer_) buffer_->append(s); else fputs(s, fout); }
+  int write_project_(int selected_only);
 
 public:
   Project_Writer(Project &proj);
   ~Project_Writer();
   int open_write(const char *s);
+  int open_write(std::string &buffer);
   int close_write();
   int write_project(const char *filename, int selected_only, bool codeview);
+  int write_project(std::string &buffer, int selected_only, bool codeview = false);
   void write_word(const char *);
   void write_word(const std::string& word) { write_word(word.c_str()); }
   void write_string(const char *,...) __fl_attr((__format__ (__printf__, 2, 3)));
@@ -59,6 +68,8 @@ public:
   void write_open();
   void write_close(int n);
   FILE *file() const { return fout; }
+  /// Return the number of bytes written so far, used to mark the codeview text positions
+  long tell() const { return buffer_ ? (long)buffer_->size() : ftell(fout); }
   bool write_codeview() const { return write_codeview_; }
 };
 
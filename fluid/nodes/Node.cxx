@@ -473,6 +473,8 @@ Node::~Node() {
   if (Fluid.proj.tree.last == this) Fluid.proj.tree.last = prev;
   if (Fluid.proj.tree.first == this) Fluid.proj.tree.first = next;
   if (Fluid.proj.tree.current == this) Fluid.proj.tree.current = nullptr;
+  Fluid.proj.tree.invalidate_text_index();
+  Fluid.proj.tree.use_uid(uid_, -1);
   if (current_widget == this) current_widget = nullptr;
   if (current_node == this) current_node = nullptr;
   if (parent) parent->remove_child(this);
@@ -817,8 +819,8 @@ void Node::move_before(Node* g) {
 
 // write a widget and all its children:
 void Node::write(fluid::io::Project_Writer &f) {
-  if (f.write_codeview()) proj1.start = (int)ftell(f.file()) + 1;
-  if (f.write_codeview()) proj2.start = (int)ftell(f.file()) + 1;
+  if (f.write_codeview()) proj1.start = (int)f.tell() + 1;
+  if (f.write_codeview()) proj2.start = (int)f.tell() + 1;
   f.write_indent(level);
   f.write_word(type_name());
 
@@ -833,18 +835,18 @@ void Node::write(fluid::io::Project_Writer &f) {
   write_properties(f);
   if (parent) parent->write_parent_properties(f, this, true);
   f.write_close(level);
-  if (f.write_codeview()) proj1.end = (int)ftell(f.file());
+  if (f.write_codeview()) proj1.end = (int)f.tell();
   if (!can_have_children()) {
-    if (f.write_codeview()) proj2.end = (int)ftell(f.file());
+    if (f.write_codeview()) proj2.end = (int)f.tell();
     return;
   }
   // now do children:
   f.write_open();
   for (auto *child : children())
     child->write(f);
-  if (f.write_codeview()) proj2.start = (int)ftell(f.file()) + 1;
+  if (f.write_codeview()) proj2.start = (int)f.tell() + 1;
   f.write_close(level);
-  if (f.write_codeview()) proj2.end = (int)ftell(f.file());
+  if (f.write_codeview()) proj2.end = (int)f.tell();
 }
 
 void Node::write_properties(fluid::io::Project_Writer &f) {
@@ -1196,32 +1198,28 @@ void Node::write_code2(fluid::io::Code_Writer&) {
 
  Try to set the given id as the unique id for this node. If the suggested id
  is 0, or it is already taken inside this project, we try another random id
- until we find one that is unique.
+ until we find one that is unique. The tree keeps count of the uids in use,
+ so this does not have to visit every node.
 
  \param[in] suggested_uid the preferred uid for this node
  \return the actual uid that was given to the node
  */
 unsigned short Node::set_uid(unsigned short suggested_uid) {
+  fluid::node::Tree &tree = Fluid.proj.tree;
   // if there is no suggestion, come up with a random number
   if (suggested_uid==0)
     suggested_uid = (unsigned short)rand();
-  // loop until we find a unique number
+  // loop until we find a unique number, 0 means "no uid"
   for (;;) {
-    // loop through every node in the project
-    Node *tp = Fluid.proj.tree.first;
-    for ( ; tp; tp = tp->next) {
-      // abort if the suggested id is already taken
-      if (tp!=this && tp->uid_==suggested_uid) {
-        break;
-      }
-    }
-    // we are done if we have not fund the suggested id anywhere else
-    if (tp==nullptr) {
+    int users = tree.uid_users(suggested_uid);
+    if (uid_ == suggested_uid) users--; // don't count ourselves
+    if (suggested_uid != 0 && users <= 0)
       break;
-    }
     // try again with another random number
     suggested_uid = (unsigned short)rand();
   }
+  tree.use_uid(uid_, -1);
+  tree.use_uid(suggested_uid, +1);
   uid_ = suggested_uid;
   return suggested_uid;
 }
@@ -22,6 +22,9 @@
 #include "nodes/Widget_Node.h"
 #include "widgets/Node_Browser.h"
 
+#include <algorithm>
+#include <set>
+
 using namespace fluid;
 using namespace fluid::node;
 
@@ -81,6 +84,20 @@ void Tree::delete_selected_nodes() {
   }
 }
 
+/** Count the nodes that use a uid.
+
+ Node::set_uid() uses this table to check in constant time if a uid is taken,
+ instead of walking the entire tree for every node that is read or pasted.
+
+ \param[in] uid the uid of a node, 0 is not counted
+ \param[in] delta +1 if a node starts using the uid, -1 if it stops
+ */
+void Tree::use_uid(unsigned short uid, int delta) {
+  if (!uid) return;
+  if (uid_users_.empty()) uid_users_.resize(0x10000);
+  uid_users_[uid] += delta;
+}
+
 /** Find a node by its unique id.
 
  Every node in a type tree has an id that is unique for the current project.
@@ -90,6 +107,7 @@ void Tree::delete_selected_nodes() {
  \return the node with this uid, or nullptr if not found
  */
 Node *Tree::find_by_uid(unsigned short uid) {
+  if (!uid_users(uid)) return nullptr;
   for (auto tp: all_nodes()) {
     if (tp->get_uid() == uid) return tp;
   }
@@ -99,28 +117,95 @@ Node *Tree::find_by_uid(unsigned short uid) {
 
 /** Find a node by using the codeview text positions.
 
+ If text ranges of several nodes contain the position, the node that comes
+ first in the tree wins. The lookup uses an index of text runs that is built
+ the first time it is needed after the text was generated, so moving the
+ cursor through a large project does not walk the whole tree every time.
+
  \param[in] text_type 0=source file, 1=header, 2=.fl project file
  \param[in] crsr cursor position in text
  \return the node we found or nullptr
  */
 Node *Tree::find_in_text(int text_type, int crsr) {
+  if (text_type < 0 || text_type > 2) return nullptr;
+  if (!text_index_valid_[text_type]) build_text_index(text_type);
+  const std::vector<Text_Run> &runs = text_index_[text_type];
+  // find the last run that starts at or before the cursor
+  auto it = std::upper_bound(runs.begin(), runs.end(), crsr,
+                             [](int pos, const Text_Run &run) { return pos < run.start; });
+  if (it == runs.begin()) return nullptr;
+  return (it - 1)->node;
+}
+
+/** Forget the codeview text index.
+
+ This must be called whenever the text positions stored in the nodes change,
+ or when a node is deleted.
+ */
+void Tree::invalidate_text_index() {
+  for (int i = 0; i < 3; i++) {
+    text_index_valid_[i] = false;
+    text_index_[i].clear();
+  }
+}
+
+/** Build the index that maps codeview text positions to nodes.
+
+ The text ranges of the nodes may nest or overlap. The index splits the text
+ at every range boundary and stores the first node in tree order that covers
+ each piece, or nullptr for text that belongs to no node. Neighboring pieces
+ that map to the same node are merged.
+
+ \param[in] text_type 0=source file, 1=header, 2=.fl project file
+ */
+void Tree::build_text_index(int text_type) {
+  struct Edge {
+    int pos, order;
+    bool open;
+  };
+  std::vector<Edge> edges;
+  std::vector<Node*> nodes;
+  auto add = [&](const TextSpan &span) {
+    // empty and unset ranges never match
+    if (span.start < 0 || span.end <= span.start) return;
+    int order = (int)nodes.size() - 1;
+    edges.push_back({ span.start, order, true });
+    edges.push_back({ span.end, order, false });
+  };
   for (auto node: all_nodes()) {
+    nodes.push_back(node);
     switch (text_type) {
       case 0:
-        if (crsr >= node->setup_node.c.start && crsr < node->setup_node.c.end) return node;
-        if (crsr >= node->finalize_node.c.start && crsr < node->finalize_node.c.end) return node;
-        if (crsr >= node->static_data.c.start && crsr < node->static_data.c.end) return node;
+        add(node->setup_node.c);
+        add(node->finalize_node.c);
+        add(node->static_data.c);
         break;
       case 1:
-        if (crsr >= node->setup_node.h.start && crsr < node->setup_node.h.end) return node;
-        if (crsr >= node->finalize_node.h.start && crsr < node->finalize_node.h.end) return node;
-        if (crsr >= node->static_data.h.start && crsr < node->static_data.h.end) return node;
+        add(node->setup_node.h);
+        add(node->finalize_node.h);
+        add(node->static_data.h);
         break;
       case 2:
-        if (crsr >= node->proj1.start && crsr < node->proj1.end) return node;
-        if (crsr >= node->proj2.start && crsr < node->proj2.end) return node;
+        add(node->proj1);
+        add(node->proj2);
         break;
     }
   }
-  return nullptr;
+  std::sort(edges.begin(), edges.end(),
+            [](const Edge &a, const Edge &b) { return a.pos < b.pos; });
+
+  std::vector<Text_Run> &runs = text_index_[text_type];
+  runs.clear();
+  std::multiset<int> active;
+  for (size_t i = 0; i < edges.size(); ) {
+    int pos = edges[i].pos;
+    for ( ; i < edges.size() && edges[i].pos == pos; i++) {
+      if (edges[i].open) active.insert(edges[i].order);
+      else active.erase(active.find(edges[i].order));
+    }
+    Node *node = active.empty() ? nullptr : nodes[*active.begin()];
+    if (runs.empty() || runs.back().node != node)
+      runs.push_back({ pos, node });
+  }
+  text_index_valid_[text_type] = true;
 }
@@ -19,6 +19,8 @@
 
 #include "nodes/iterators.h"
 
+#include <vector>
+
 class Node;
 
 namespace fluid {
@@ -32,6 +34,21 @@ class Tree {
   /// Link Tree class to the project.
   Project &proj_;
 
+  /// Start of a run of text that maps to the same node, see find_in_text().
+  struct Text_Run {
+    int start;
+    Node *node;
+  };
+  /// Text runs sorted by position, for source, header, and project text.
+  std::vector<Text_Run> text_index_[3];
+  /// Set if the matching text index is up to date.
+  bool text_index_valid_[3] = { false, false, false };
+
+  void build_text_index(int text_type);
+
+  /// Number of nodes that use each uid, empty until the first uid is set.
+  std::vector<int> uid_users_;
+
 public:
 
   Node *first = nullptr;
@@ -56,7 +73,11 @@ public:
   Widget_Node_Range all_selected_widgets() { return Widget_Node_Range(*this, true); }
 
   Node *find_by_uid(unsigned short uid);
+  /// Return the number of nodes that currently use this uid.
+  int uid_users(unsigned short uid) const { return uid_users_.empty() ? 0 : uid_users_[uid]; }
+  void use_uid(unsigned short uid, int delta);
   Node *find_in_text(int text_type, int crsr);
+  void invalidate_text_index();
 };
 
 } // namespace node
@@ -26,11 +26,34 @@
 #include <FL/Fl_Tabs.H>
 #include <FL/Fl_Button.H>
 #include "../src/flstring.h"
-static char *cv_design_filename = nullptr;
 int cv_code_choice;
 extern void select_only(Node *o);
 extern void reveal_in_browser(Node *t);
 
+/**
+ Replace the text in a code view buffer, but only change the part that differs.
+
+ Most edits change only a few lines of the generated text. Keeping the common
+ start and end of the old text avoids relayouting and restyling the entire
+ buffer, and nothing at all is done if the text did not change.
+*/
+static void cv_splice_text(Fl_Text_Buffer *buffer, const std::string &text) {
+  char *old_text = buffer->text();
+  const size_t old_len = strlen(old_text);
+  const size_t new_len = text.size();
+  const size_t n = old_len < new_len ? old_len : new_len;
+  size_t prefix = 0, suffix = 0;
+  while (prefix < n && old_text[prefix] == text[prefix]) prefix++;
+  while (suffix < n - prefix && old_text[old_len-1-suffix] == text[new_len-1-suffix]) suffix++;
+  // don't split UTF-8 sequences
+  while (prefix > 0 && ((old_text[prefix] & 0xc0) == 0x80 || (text[prefix] & 0xc0) == 0x80)) prefix--;
+  while (suffix > 0 && (text[new_len-suffix] & 0xc0) == 0x80) suffix--;
+  free(old_text);
+  if (prefix == old_len && prefix == new_len)
+    return;
+  buffer->replace((int)prefix, (int)(old_len - suffix), text.c_str() + prefix, (int)(new_len - prefix - suffix));
+}
+
 /**
  Update the header and source code highlighting depending on the
  currently selected object
@@ -146,24 +169,19 @@ void update_codeview_position_cb(class Fl_Tabs*, void*) {
 
 /**
  Generate a header, source, strings, or design file and load the content into
- the Code Viewer widgets.  Source and header code are generated entirely in
- memory (via ostringstream) and pushed directly into the text buffers — no
- temporary files are written or read back for those tabs.
+ the Code Viewer widgets.  Source, header, and design text are generated entirely
+ in memory and spliced into the text buffers, so only the lines that changed
+ are updated, and no temporary files are written or read back for those tabs.
 */
 void update_codeview_cb(class Fl_Button*, void*) {
   if (!codeview_panel || !codeview_panel->visible())
     return;
 
-  if (!cv_design_filename) {
-    cv_design_filename = (char*)malloc(FL_PATH_MAX);
-    fl_strlcpy(cv_design_filename, Fluid.get_tmpdir().c_str(), FL_PATH_MAX);
-    fl_strlcat(cv_design_filename, "codeview_tmp.fl", FL_PATH_MAX);
-  }
-
   if (cv_project->visible_r()) {
-    fluid::io::write_file(Fluid.proj, cv_design_filename, false, true);
+    std::string text;
+    fluid::io::write_buffer(Fluid.proj, text, false, true);
     int top = cv_project->top_line();
-    cv_project->buffer()->loadfile(cv_design_filename);
+    cv_splice_text(cv_project->buffer(), text);
     cv_project->scroll(top, 0);
   } else if (cv_strings->visible_r()) {
     static const char *exts[] = { ".txt", ".po", ".msg" };
@@ -186,12 +204,12 @@ void update_codeview_cb(class Fl_Button*, void*) {
     // and does not write over the code files on disk.
     if (f.write_code(code_filename, header_filename, true))
     {
-      // Push generated text directly into the editor buffers.
+      // Splice the generated text into the editor buffers.
       int pos = cv_source->top_line();
-      cv_source->buffer()->text(f.code_string().c_str());
+      cv_splice_text(cv_source->buffer(), f.code_string());
       cv_source->scroll(pos, 0);
       pos = cv_header->top_line();
-      cv_header->buffer()->text(f.header_string().c_str());
+      cv_splice_text(cv_header->buffer(), f.header_string());
       cv_header->scroll(pos, 0);
       // update the source code highlighting
       update_codeview_position();
@@ -26,55 +26,129 @@
 
 #include <FL/Fl.H>
 #include <FL/Fl_Window.H>
-#include <FL/Fl_Preferences.H>
 #include <FL/Fl_Menu_Bar.H>
 #include <FL/fl_ask.H>
-#include "tools/filename.h"
-#include "../src/flstring.h"
-
-#if defined(_WIN32) && !defined(__CYGWIN__)
-#  include <io.h>
-#  include <windows.h>
-#  define getpid (int)GetCurrentProcessId
-#else
-#  include <unistd.h>
-#endif // _WIN32 && !__CYGWIN__
-
-// This file implements an undo system using temporary files; ideally
-// we'd like to do this in memory, however the current data structures
-// and design aren't well-suited...  Instead, we save and restore
-// checkpoint files.
+
+#include <zlib.h>
+
+// This file implements an undo system that keeps the project text of every
+// checkpoint in memory. Only the text of the latest checkpoint is kept in
+// full, all other levels are stored as the difference to their neighbor, so
+// memory use is proportional to the size of the edits, not of the project.
+// Long differences are compressed, and the oldest levels are dropped when
+// the undo buffer grows beyond max_bytes_.
 
 extern Fl_Window* the_panel;
 
 using namespace fluid;
 using namespace fluid::proj;
 
+// Differences shorter than this are not worth compressing.
+static const size_t min_compressed = 512;
+
 
 Undo::Undo(Project &p)
 : proj_( p )
 { }
 
 Undo::~Undo() {
-  // TODO: delete old undo files when calling the destructor.
 }
 
 
-// Return the undo filename.
-// The filename is constructed in a static internal buffer and
-// this buffer is overwritten by every call of this function.
-// The return value is a pointer to this internal string.
-char *Undo::filename(int level) {
-  if (!path_len_) {
-    Fluid.preferences.getUserdataPath(path_, sizeof(path_));
-    path_len_ = (unsigned int)strlen(path_);
+// Store n bytes of text, compressed if that saves memory.
+void Undo::Chunk::pack(const char *text, size_t n) {
+  size = 0;
+  if (n >= min_compressed) {
+    uLongf len = compressBound((uLong)n);
+    data.resize(len);
+    if (compress2((Bytef*)&data[0], &len, (const Bytef*)text, (uLong)n, Z_BEST_SPEED) == Z_OK
+        && len < n) {
+      data.resize(len);
+      data.shrink_to_fit();
+      size = n;
+      return;
+    }
   }
+  data.assign(text, n);
+}
 
-  // append filename: "undo_PID_LEVEL.fl"
-  snprintf(path_ + path_len_,
-           sizeof(path_) - path_len_ - 1,
-           "undo_%d_%d.fl", getpid(), level);
-  return path_;
+// Return the uncompressed text.
+std::string Undo::Chunk::unpack() const {
+  if (!size) return data;
+  std::string text(size, '\0');
+  uLongf len = (uLongf)size;
+  if (uncompress((Bytef*)&text[0], &len, (const Bytef*)data.data(), (uLong)data.size()) != Z_OK)
+    text.clear();
+  return text;
+}
+
+
+// Move text_ to the given undo level by applying the steps in between.
+void Undo::move_to(int level) {
+  while (text_level_ > level) {
+    const Step &s = steps_[text_level_ - 1 - first_];
+    text_.replace(s.prefix, text_.size() - s.prefix - s.suffix, s.older.unpack());
+    text_level_--;
+  }
+  while (text_level_ < level) {
+    const Step &s = steps_[text_level_ - first_];
+    text_.replace(s.prefix, text_.size() - s.prefix - s.suffix, s.newer.unpack());
+    text_level_++;
+  }
+}
+
+// Store the current project as the given undo level, dropping all levels
+// above it. Return 0 on error.
+int Undo::store(int level) {
+  std::string text;
+  if (!fluid::io::write_buffer(proj_, text)) return 0;
+
+  int top = first_ + (int)steps_.size();
+  if (text_level_ < 0 || level <= first_ || level - 1 > top) {
+    // start a new history at this level
+    steps_.clear();
+    steps_bytes_ = 0;
+    first_ = level;
+  } else {
+    move_to(level - 1);
+    while (first_ + (int)steps_.size() > level - 1) {
+      steps_bytes_ -= steps_.back().older.bytes() + steps_.back().newer.bytes();
+      steps_.pop_back();
+    }
+    // find the part that changed since the previous level
+    const size_t n = text_.size() < text.size() ? text_.size() : text.size();
+    size_t prefix = 0, suffix = 0;
+    while (prefix < n && text_[prefix] == text[prefix]) prefix++;
+    while (suffix < n - prefix && text_[text_.size() - 1 - suffix] == text[text.size() - 1 - suffix]) suffix++;
+    Step s;
+    s.prefix = prefix;
+    s.suffix = suffix;
+    s.older.pack(text_.data() + prefix, text_.size() - prefix - suffix);
+    s.newer.pack(text.data() + prefix, text.size() - prefix - suffix);
+    steps_bytes_ += s.older.bytes() + s.newer.bytes();
+    steps_.push_back(std::move(s));
+  }
+  text_.swap(text);
+  text_level_ = level;
+  trim();
+  return 1;
+}
+
+// Drop the oldest undo levels until the steps fit into max_bytes_.
+void Undo::trim() {
+  while (steps_bytes_ > max_bytes_ && steps_.size() > 1) {
+    steps_bytes_ -= steps_.front().older.bytes() + steps_.front().newer.bytes();
+    steps_.erase(steps_.begin());
+    first_++;
+  }
+}
+
+// Load the project from the given undo level, return 0 on error.
+int Undo::restore(int level) {
+  if (text_level_ < 0 || level < first_ || level > first_ + (int)steps_.size())
+    return 0;
+  move_to(level);
+  return fluid::io::read_buffer(proj_, text_.data(), text_.size(), "undo buffer", 0);
 }
 
 
@@ -95,8 +169,8 @@ void Undo::redo() {
     widget_browser->new_list();
   }
   int reload_panel = (the_panel && the_panel->visible());
-  if (!fluid::io::read_file(proj_, filename(current_ + 1), 0)) {
-    // Unable to read checkpoint file, don't redo...
+  if (!restore(current_ + 1)) {
+    // Unable to read checkpoint, don't redo...
     widget_browser->rebuild();
     proj_.update_settings_dialog();
     resume();
@@ -128,13 +202,16 @@ void Undo::undo() {
   // int redo_item = main_menubar->find_index(redo_cb);
   once_type_ = OnceType::ALWAYS;
 
-  if (current_ <= 0) {
+  if (current_ <= first_) {
     fl_beep();
     return;
   }
 
   if (current_ == last_) {
-    fluid::io::write_file(proj_, filename(current_));
+    if (!store(current_)) {
+      fl_beep();
+      return;
+    }
   }
 
   suspend();
@@ -146,8 +223,8 @@ void Undo::undo() {
     widget_browser->new_list();
   }
   int reload_panel = (the_panel && the_panel->visible());
-  if (!fluid::io::read_file(proj_, filename(current_ - 1), 0)) {
-    // Unable to read checkpoint file, don't undo...
+  if (!restore(current_ - 1)) {
+    // Unable to read checkpoint, don't undo...
     widget_browser->rebuild();
     proj_.update_settings_dialog();
     proj_.set_modflag(0, 0);
@@ -209,11 +286,9 @@ void Undo::checkpoint() {
   // int redo_item = main_menubar->find_index(redo_cb);
   once_type_ = OnceType::ALWAYS;
 
-  // Save the current UI to a checkpoint file...
-  const char *file = filename(current_);
-  if (!fluid::io::write_file(proj_, file)) {
-    // Don't attempt to do undo stuff if we can't write a checkpoint file...
-    perror(file);
+  // Save the current UI to the undo buffer...
+  if (!store(current_)) {
+    // Don't attempt to do undo stuff if we can't write a checkpoint...
     return;
   }
 
@@ -224,7 +299,6 @@ void Undo::checkpoint() {
   // Update the current undo level...
   current_ ++;
   last_ = current_;
-  if (current_ > max_) max_ = current_;
 
   // Enable the Undo and disable the Redo menu items...
   // main_menu[undo_item].activate();
@@ -235,13 +309,15 @@ void Undo::checkpoint() {
 void Undo::clear() {
   // int undo_item = main_menubar->find_index(undo_cb);
   // int redo_item = main_menubar->find_index(redo_cb);
-  // Remove old checkpoint files...
-  for (int i = 0; i <= max_; i ++) {
-    fl_unlink(filename(i));
-  }
+  // Release all checkpoints...
+  steps_.clear();
+  steps_.shrink_to_fit();
+  std::string().swap(text_);
+  text_level_ = -1;
+  steps_bytes_ = 0;
 
   // Reset current, last, and save indices...
-  current_ = last_ = max_ = 0;
+  current_ = last_ = first_ = 0;
   if (proj_.modflag) save_ = -1;
   else save_ = 0;
 
@@ -17,7 +17,8 @@
 #ifndef undo_h
 #define undo_h
 
-#include <FL/filename.H>
+#include <string>
+#include <vector>
 
 class Fl_Widget;
 
@@ -36,24 +37,53 @@ public:
     WINDOW_RESIZE
   };
 
+  /// Part of a checkpoint's .fl text, zlib compressed if it is long enough.
+  struct Chunk {
+    std::string data;
+    size_t size = 0;    ///< uncompressed size, 0 if data is not compressed
+    void pack(const char *text, size_t n);
+    std::string unpack() const;
+    size_t bytes() const { return data.size(); }
+  };
+
+  /// Difference between the .fl text of two neighboring undo levels.
+  /// Both texts share \c prefix bytes at the start and \c suffix bytes
+  /// at the end, only the differing middle parts are stored.
+  struct Step {
+    size_t prefix = 0, suffix = 0;
+    Chunk older, newer;
+  };
+
   /// Link Undo class to this project.
   Project &proj_;
   /// Current undo level in buffer
   int current_ = 0;
   /// Last undo level in buffer
   int last_ = 0;
-  // Maximum undo level used
-  int max_ = 0;
   /// Last undo level that was saved
   int save_ = -1;
   // Undo checkpointing paused?
   int paused_ = 0;
-  // Undo file path
-  char path_[FL_PATH_MAX] { };
-  // length w/o filename
-  unsigned int path_len_ = 0;
   /// Suspend further undos of the same type
   OnceType once_type_ = OnceType::ALWAYS;
+  /// Oldest undo level still in buffer
+  int first_ = 0;
+  /// steps_[i] turns the text of level first_+i into the text of level first_+i+1
+  std::vector<Step> steps_;
+  /// Full .fl text of undo level text_level_
+  std::string text_;
+  /// Undo level of text_, or -1 if there is none
+  int text_level_ = -1;
+  /// Memory used by all steps
+  size_t steps_bytes_ = 0;
+  /// Oldest levels are dropped when the steps use more memory than this
+  size_t max_bytes_ = 64 * 1024 * 1024;
+
+private:
+  void move_to(int level);
+  int store(int level);
+  int restore(int level);
+  void trim();
 
 public:
 
@@ -72,8 +102,6 @@ public:
   void resume();
   // Suspend undo checkpoints
   void suspend();
-  // Return the undo filename.
-  char *filename(int level);
 
   // Redo menu callback
   void redo();
@@ -24,8 +24,10 @@
 #include "Fl_Window_Driver.H"
 #include "Fl_System_Driver.H"
 #include "Fl_Timeout.h"
+#include "Fl_Offscreen_Cache.H"
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Tooltip.H>
+#include <FL/Fl_Profiler.H>
 #include <FL/fl_draw.H>
 
 #include <ctype.h>
@@ -685,6 +687,18 @@ void Fl::Private::run_idle() {
   }
 }
 
+// Frame pacing, see Fl::frame_rate()
+static double frame_interval_ = 0;  // minimum time between frames, 0 if not paced
+static Fl_Timestamp frame_start_;   // start time of the last frame
+static int loop_flush_ = 0;         // set while the event loop flushes
+// Frame statistics, see Fl::frame_stats()
+static int handle_depth_ = 0;       // number of nested Fl::handle() calls
+static Fl_Timestamp handle_start_;  // start time of the outermost Fl::handle()
+static double events_time_ = 0;     // event handling time since the last frame
+static int coalesced_ = 0;          // flushes deferred since the last frame
+static double frame_events_ = 0, frame_draw_ = 0, frame_flush_ = 0;
+static int frame_coalesced_ = 0;
+
 /**
  Waits a maximum of \p time_to_wait seconds or until "something happens".
 
@@ -696,7 +710,12 @@ void Fl::Private::run_idle() {
  occurs (this will happen on X11 if a signal happens).
 */
 double Fl::wait(double time_to_wait) {
-  return system_driver()->wait(time_to_wait);
+  FL_PROFILE_SPAN(WAIT, "Fl::wait", NULL, NULL, -1);
+  // time spent waiting inside an event handler is not event time
+  if (handle_depth_) events_time_ += seconds_since(handle_start_);
+  double ret = system_driver()->wait(time_to_wait);
+  if (handle_depth_) handle_start_ = now();
+  return ret;
 }
 
 #define FOREVER 1e20
@@ -885,6 +904,60 @@ void Fl::redraw() {
   for (Fl_X* i = Fl_X::first; i; i = i->next) i->w->redraw();
 }
 
+// Set while damage waits for the next frame, see Fl::Private::frame_pending_
+int Fl::Private::frame_pending_ = 0;
+
+static void frame_due(void *) {
+  Fl::Private::frame_pending_ = 0; // waking up the event loop is all it takes
+}
+
+// Returns true if the next frame must wait, see Fl::frame_rate()
+static bool defer_frame() {
+  if (frame_interval_ <= 0 || !loop_flush_) return false;
+  double elapsed = Fl::seconds_since(frame_start_);
+  if (elapsed >= frame_interval_ || elapsed < 0) return false;
+  if (!Fl::Private::frame_pending_) {
+    Fl::Private::frame_pending_ = 1;
+    Fl::add_timeout(frame_interval_ - elapsed, frame_due);
+  }
+  coalesced_++;
+  return true;
+}
+
+/* Called by the event loop instead of Fl::flush(), pacing only applies to
+ these flushes: an explicit Fl::flush(), e.g. from a callback that updates
+ a progress bar during a long computation, always redraws. */
+void Fl::Private::flush_frame() {
+  loop_flush_++;
+  Fl::flush();
+  loop_flush_--;
+}
+
+static int damage_debug_ = 0;
+static bool damage_debug_erasing = false; // next flush erases outlines
+
+static void erase_damage_outlines(void *) {
+  damage_debug_erasing = true;
+  for (Fl_X *i = Fl_X::first; i; i = i->next) i->w->damage(FL_DAMAGE_EXPOSE);
+}
+
+// Outlines the damaged rectangles of a window, see Fl::damage_debug()
+static void outline_damage(Fl_Window *wi, const Fl_Damage_List &damaged) {
+  wi->make_current();
+  fl_color(FL_RED);
+  if (!damaged.count()) {
+    fl_rect(0, 0, wi->w(), wi->h());
+  } else {
+    for (int n = 0; n < damaged.count(); n++) {
+      const Fl_Damage_List::Rect &r = damaged.rect(n);
+      fl_rect(r.x, r.y, r.w, r.h);
+    }
+  }
+  Fl::remove_timeout(erase_damage_outlines);
+  Fl::add_timeout(0.25, erase_damage_outlines);
+}
+
+
 /**
   Causes all the windows that need it to be redrawn and graphics forced
   out through the pipes.
@@ -897,16 +970,42 @@ void Fl::redraw() {
   event queue.
 */
 void Fl::flush() {
+  FL_PROFILE_SPAN(FLUSH, "Fl::flush", NULL, NULL, -1);
+  if (damage() && defer_frame()) {
+    // keep the damage, it is drawn with the next frame
+    screen_driver()->flush();
+    return;
+  }
+  bool drawn = (damage() != 0);
+  Fl_Timestamp draw_start;
+  if (drawn) draw_start = now();
   if (damage()) {
     damage_ = 0;
+    bool outline = damage_debug_ && !damage_debug_erasing;
+    damage_debug_erasing = false;
+    Fl_Damage_List::flushed_windows = Fl_Damage_List::flushed_rects = 0;
+    Fl_Damage_List::flushed_area = 0;
+    Fl_Damage_List::drawn_widgets = 0;
     for (Fl_X* i = Fl_X::first; i; i = i->next) {
       Fl_Window* wi = i->w;
-      if (Fl_Window_Driver::driver(wi)->wait_for_expose_value) {damage_ = 1; continue;}
+      Fl_Window_Driver *driver = Fl_Window_Driver::driver(wi);
+      if (driver->wait_for_expose_value) {damage_ = 1; continue;}
       if (!wi->visible_r()) continue;
       if (wi->damage()) {
-        Fl_Window_Driver::driver(wi)->flush();
+        // the rectangle list is only valid while it describes the region:
+        Fl_Damage_List damaged = driver->damage_list;
+        if (!i->region || damaged.region() != i->region) damaged.clear();
+        Fl_Damage_List::flushed_windows++;
+        Fl_Damage_List::flushed_rects += damaged.count() ? damaged.count() : 1;
+        Fl_Damage_List::flushed_area += damaged.count() ? damaged.area() : (long)wi->w() * wi->h();
+        {
+          FL_PROFILE_SPAN(DRAW, NULL, wi, NULL, -1);
+          driver->flush();
+        }
         wi->clear_damage();
+        if (outline) outline_damage(wi, damaged);
       }
+      driver->damage_list.clear();
       // destroy damage regions for windows that don't use them:
       if (i->region) {
         fl_graphics_driver->XDestroyRegion(i->region);
@@ -914,7 +1013,138 @@ void Fl::flush() {
       }
     }
   }
+  if (!drawn) {
+    screen_driver()->flush();
+    return;
+  }
+  Fl_Timestamp flush_start = now();
   screen_driver()->flush();
+  Fl_Timestamp flush_end = now();
+  frame_events_ = events_time_;
+  frame_draw_ = seconds_between(flush_start, draw_start);
+  frame_flush_ = seconds_between(flush_end, flush_start);
+  frame_coalesced_ = coalesced_;
+  events_time_ = 0;
+  coalesced_ = 0;
+  frame_start_ = draw_start;
+}
+
+
+/**
+  Limits how often Fl::flush() redraws windows during Fl::wait().
+
+  By default, each Fl::wait() redraws the damaged windows after processing
+  events. Programs that update widgets at a high rate, e.g. from Fl::awake()
+  callbacks or short timeouts, may then redraw far more often than the
+  display can show. With a frame rate set, a redraw requested less than one
+  frame interval after the previous one is deferred: damage keeps
+  accumulating and is drawn at the next frame time by a single flush.
+
+  Only the redraws done by the event loop itself are paced. Explicit calls
+  to Fl::flush(), also from callbacks, always redraw immediately.
+
+  \param[in] hz  maximum number of redraws per second, e.g. 60,
+                 or 0 (the default) to redraw without delay
+  \see Fl::frame_stats()
+  \since 1.5.0
+*/
+void Fl::frame_rate(double hz) {
+  frame_interval_ = hz > 0 ? 1.0 / hz : 0;
+}
+
+
+/**
+  Returns the maximum number of redraws per second, 0 if not limited.
+  \see Fl::frame_rate(double)
+  \since 1.5.0
+*/
+double Fl::frame_rate() {
+  return frame_interval_ > 0 ? 1.0 / frame_interval_ : 0;
+}
+
+
+/**
+  Reports timing statistics of the last frame, i.e. the last Fl::flush()
+  that redrew something.
+
+  \param[out] events     seconds spent in Fl::handle() since the previous frame,
+                         not counting nested Fl::wait() calls
+  \param[out] draw       seconds spent drawing the windows
+  \param[out] flush      seconds spent sending the drawing to the display
+  \param[out] coalesced  number of redraws deferred into this frame by Fl::frame_rate()
+  \see Fl::redraw_stats()
+  \since 1.5.0
+*/
+void Fl::frame_stats(double &events, double &draw, double &flush, int &coalesced) {
+  events = frame_events_;
+  draw = frame_draw_;
+  flush = frame_flush_;
+  coalesced = frame_coalesced_;
+}
+
+
+/**
+  Shows which parts of the windows are redrawn, to help tune redraws.
+
+  When turned on, each Fl::flush() outlines the rectangles of the windows
+  it redraws in red, until the outlines are erased a quarter of a second
+  later. Windows that are completely redrawn are outlined as a whole.
+
+  \param[in] on  non-zero to outline redrawn areas, 0 to stop
+  \see Fl::redraw_stats()
+  \since 1.5.0
+*/
+void Fl::damage_debug(int on) {
+  damage_debug_ = on;
+}
+
+
+/**
+  Returns whether Fl::flush() outlines the areas it redraws.
+  \see Fl::damage_debug(int)
+  \since 1.5.0
+*/
+int Fl::damage_debug() {
+  return damage_debug_;
+}
+
+
+/**
+  Reports how much the last Fl::flush() that redrew something did redraw.
+
+  Damage of a window is collected as a short list of rectangles; nearby
+  rectangles are merged when their union is not much larger.
+
+  \param[out] windows  number of redrawn windows
+  \param[out] rects    number of damage rectangles, a completely redrawn window counts one
+  \param[out] area     sum of the areas of the damage rectangles, in FLTK units
+  \param[out] widgets  number of child widgets that were drawn
+  \see Fl::damage_debug(int)
+  \since 1.5.0
+*/
+void Fl::redraw_stats(int &windows, int &rects, long &area, int &widgets) {
+  windows = Fl_Damage_List::flushed_windows;
+  rects = Fl_Damage_List::flushed_rects;
+  area = Fl_Damage_List::flushed_area;
+  widgets = Fl_Damage_List::drawn_widgets;
+}
+
+
+/**
+  Reports how well the shaped text cache of the display works.
+
+  With Pango, i.e. the Cairo and Wayland drivers and the Xlib driver built
+  with Pango, drawn and measured strings are itemized and shaped once and
+  kept in a cache of limited size. Other drivers report zeros.
+
+  \param[out] hits       number of strings found in the cache
+  \param[out] misses     number of strings shaped and added to the cache
+  \param[out] evictions  number of strings removed from the full cache
+  \see Fl::frame_stats()
+  \since 1.5.0
+*/
+void Fl::text_cache_stats(unsigned long &hits, unsigned long &misses, unsigned long &evictions) {
+  Fl_Display_Device::display_device()->driver()->text_cache_stats(hits, misses, evictions);
 }
 
 
@@ -1445,11 +1675,11 @@ Fl_Event_Dispatch Fl::event_dispatch()
  */
 int Fl::handle(int e, Fl_Window* window)
 {
-  if (e_dispatch) {
-    return e_dispatch(e, window);
-  } else {
-    return handle_(e, window);
-  }
+  FL_PROFILE_SPAN(EVENT, NULL, window, NULL, e);
+  if (!handle_depth_++) handle_start_ = now();
+  int ret = e_dispatch ? e_dispatch(e, window) : handle_(e, window);
+  if (!--handle_depth_) events_time_ += seconds_since(handle_start_);
+  return ret;
 }
 
 
@@ -1825,6 +2055,7 @@ void Fl_Widget::damage(uchar fl) {
       fl_graphics_driver->XDestroyRegion(i->region);
       i->region = 0;
     }
+    Fl_Window_Driver::driver((Fl_Window*)this)->damage_list.clear();
     damage_ |= fl;
     Fl::damage(FL_DAMAGE_CHILD);
   }
@@ -1835,6 +2066,9 @@ void Fl_Widget::damage(uchar fl, int X, int Y, int W, int H) {
   // mark all parent widgets between this and window with FL_DAMAGE_CHILD:
   while (wi->type() < FL_WINDOW) {
     wi->damage_ |= fl;
+    // the display list or offscreen buffer of a widget includes its children
+    if (wi->flags_ & RETAINED_DRAWING) Fl_Display_List::discard(wi);
+    if (wi->flags_ & OFFSCREEN_CACHED) Fl_Offscreen_Cache::discard(wi);
     wi = wi->parent();
     if (!wi) return;
     fl = FL_DAMAGE_CHILD;
@@ -1855,16 +2089,23 @@ void Fl_Widget::damage(uchar fl, int X, int Y, int W, int H) {
     return;
   }
 
+  Fl_Damage_List &list = Fl_Window_Driver::driver((Fl_Window*)wi)->damage_list;
+  Fl_Damage_List::Rect r;
   if (wi->damage()) {
-    // if we already have damage we must merge with existing region:
+    // if we already have damage we must merge with existing region,
+    // unless the rectangle is already part of it:
     if (i->region) {
-      fl_graphics_driver->add_rectangle_to_region(i->region, X, Y, W, H);
+      if (list.region() != i->region) list.clear(i->region);
+      if (list.add(X, Y, W, H, r))
+        fl_graphics_driver->add_rectangle_to_region(i->region, r.x, r.y, r.w, r.h);
     }
     wi->damage_ |= fl;
   } else {
     // create a new region:
     if (i->region) fl_graphics_driver->XDestroyRegion(i->region);
     i->region = fl_graphics_driver->XRectangleRegion(X,Y,W,H);
+    list.clear(i->region);
+    list.add(X, Y, W, H, r);
     wi->damage_ = fl;
   }
   Fl::damage(FL_DAMAGE_CHILD);
@@ -82,7 +82,11 @@ class Fl_Anim_GIF_Image::FrameInfo {
       h(0),
       delay(0),
       dispose(DISPOSE_UNDEF),
-      transparent_color_index(-1) {}
+      transparent_color_index(-1),
+      delta(0),
+      delta_size(0),
+      cpal(0),
+      trans(-1) {}
     Fl_RGB_Image *rgb;                // full frame image
     Fl_Shared_Image *scalable;        // used for hardware-accelerated scaling
     Fl_Color average_color;           // last average color
@@ -93,6 +97,25 @@ class Fl_Anim_GIF_Image::FrameInfo {
     Dispose dispose;                  // disposal method
     int transparent_color_index;      // needed for dispose()
     RGBA_Color transparent_color;     // needed for dispose()
+    uchar *delta;                     // packed color indices (FRAME_DELTAS only)
+    int delta_size;                   // size of 'delta' in bytes
+    Fl_GIF_Image::GIF_FRAME::CPAL *cpal; // color table (FRAME_DELTAS only)
+    int trans;                        // transparent color index or -1
+  };
+
+  // A composited frame kept for playback (FRAME_DELTAS only)
+  struct DecodedFrame {
+    DecodedFrame() :
+      frame(-1),
+      rgb(0),
+      average_color(FL_BLACK),
+      average_weight(-1),
+      desaturated(false) {}
+    int frame;                        // frame index, or -1 if unused
+    Fl_RGB_Image *rgb;                // full frame image
+    Fl_Color average_color;           // last average color
+    float average_weight;             // last average weight
+    bool desaturated;                 // flag if frame is desaturated
   };
 
   FrameInfo(Fl_Anim_GIF_Image *anim) :
@@ -111,7 +134,17 @@ class Fl_Anim_GIF_Image::FrameInfo {
     scaling((Fl_RGB_Scaling)0),
     debug_(0),
     optimize_mem(false),
-    offscreen(0) {}
+    offscreen(0),
+    deltas(false),
+    gif_w(0),
+    gif_h(0),
+    has_dispose_previous(false),
+    saved(0),
+    saved_frame(-1),
+    composed(-1),
+    ring(0),
+    ring_size(0),
+    memory_cap(16 * 1024 * 1024) {}
   ~FrameInfo();
   void clear();
   void copy(const FrameInfo& fi);
@@ -122,6 +155,9 @@ class Fl_Anim_GIF_Image::FrameInfo {
   void resize(int W, int H);
   void scale_frame(int frame);
   void set_frame(int frame);
+  DecodedFrame *decoded(int frame);
+  bool prefetch();
+  void clear_ring();
 private:
   Fl_Anim_GIF_Image *anim;          // a pointer to the Image (only needed for name())
   bool valid;                       // flag if valid data
@@ -141,9 +177,21 @@ private:
   int debug_;                       // Flag for debug outputs
   bool optimize_mem;                // Flag to store frames in original dimensions
   uchar *offscreen;                 // internal "offscreen" buffer
+  bool deltas;                      // Flag to store frames as packed indices
+  int gif_w;                        // width of the offscreen buffer
+  int gif_h;                        // height of the offscreen buffer
+  bool has_dispose_previous;        // any frame disposes to previous
+  uchar *saved;                     // offscreen after the last frame not disposed to previous
+  int saved_frame;                  // frame in 'saved', or -1
+  int composed;                     // frame in 'offscreen', or -1
+  DecodedFrame *ring;               // composited frames (FRAME_DELTAS only)
+  int ring_size;                    // number of entries in 'ring'
+  size_t memory_cap;                // memory for 'ring' in bytes
 private:
-private:
+  void compose(int frame_);
   void dispose(int frame_);
+  void draw_indices(const GifFrame &f, const uchar *bits,
+                    const Fl_GIF_Image::GIF_FRAME::CPAL *cpal, int trans);
   void on_frame_data(Fl_GIF_Image::GIF_FRAME &gf);
   void on_extension_data(Fl_GIF_Image::GIF_FRAME &gf);
   void set_to_background(int frame_);
@@ -175,15 +223,90 @@ void Fl_Anim_GIF_Image::FrameInfo::clear() {
     if (frames[frames_size].scalable)
       frames[frames_size].scalable->release();
     delete frames[frames_size].rgb;
+    delete[] frames[frames_size].delta;
+    delete[] frames[frames_size].cpal;
   }
+  clear_ring();
   delete[] offscreen;
   offscreen = 0;
+  delete[] saved;
+  saved = 0;
+  has_dispose_previous = false;
   free(frames);
   frames = 0;
   frames_size = 0;
 }
 
 
+void Fl_Anim_GIF_Image::FrameInfo::clear_ring() {
+  for (int i = 0; i < ring_size; i++)
+    delete ring[i].rgb;
+  delete[] ring;
+  ring = 0;
+  ring_size = 0;
+}
+
+
+/*
+  Packs color indices with a run length encoding: a byte n < 128 is followed
+  by n+1 literal indices, a byte n >= 128 by one index repeated n-126 times.
+  Returns an allocated buffer and its size in 'size'.
+*/
+static uchar *pack_indices(const uchar *src, int n, int &size) {
+  uchar *packed = new uchar[n + (n + 127) / 128 + 1];
+  uchar *p = packed;
+  int i = 0;
+  while (i < n) {
+    int run = 1;
+    while (i + run < n && run < 129 && src[i + run] == src[i]) run++;
+    if (run >= 2) {
+      *p++ = (uchar)(run + 126);
+      *p++ = src[i];
+      i += run;
+      continue;
+    }
+    // literals up to the next run of at least 3 indices
+    int lit = 1;
+    while (i + lit < n && lit < 128 &&
+           !(i + lit + 2 < n && src[i + lit] == src[i + lit + 1] && src[i + lit] == src[i + lit + 2]))
+      lit++;
+    *p++ = (uchar)(lit - 1);
+    memcpy(p, src + i, lit);
+    p += lit;
+    i += lit;
+  }
+  size = (int)(p - packed);
+  uchar *shrunk = new uchar[size > 0 ? size : 1];
+  memcpy(shrunk, packed, size);
+  delete[] packed;
+  return shrunk;
+}
+
+
+// Unpacks 'n' color indices packed by pack_indices()
+static void unpack_indices(const uchar *packed, int size, uchar *dst, int n) {
+  const uchar *end = packed + size;
+  uchar *dend = dst + n;
+  while (packed < end && dst < dend) {
+    int c = *packed++;
+    if (c < 128) {
+      int lit = c + 1;
+      if (lit > dend - dst) lit = (int)(dend - dst);
+      if (lit > end - packed) lit = (int)(end - packed);
+      memcpy(dst, packed, lit);
+      dst += lit;
+      packed += lit;
+    } else if (packed < end) {
+      int run = c - 126;
+      if (run > dend - dst) run = (int)(dend - dst);
+      memset(dst, *packed++, run);
+      dst += run;
+    }
+  }
+  if (dst < dend) memset(dst, 0, dend - dst);
+}
+
+
 double Fl_Anim_GIF_Image::FrameInfo::convert_delay(int d) const {
   if (d <= 0)
     d = loop_count != 1 ? 10 : 0;
@@ -208,10 +331,23 @@ void Fl_Anim_GIF_Image::FrameInfo::copy(const FrameInfo& fi) {
       frames[i].h = new_h;
     }
     // just copy data 1:1 now - scaling will be done adhoc when frame is displayed
-    frames[i].rgb = (Fl_RGB_Image *)fi.frames[i].rgb->copy();
+    frames[i].rgb = fi.frames[i].rgb ? (Fl_RGB_Image *)fi.frames[i].rgb->copy() : 0;
     frames[i].scalable = 0;
+    if (fi.frames[i].delta) {
+      frames[i].delta = new uchar[fi.frames[i].delta_size > 0 ? fi.frames[i].delta_size : 1];
+      memcpy(frames[i].delta, fi.frames[i].delta, fi.frames[i].delta_size);
+      frames[i].cpal = new Fl_GIF_Image::GIF_FRAME::CPAL[256];
+      memcpy(frames[i].cpal, fi.frames[i].cpal, 256 * sizeof(Fl_GIF_Image::GIF_FRAME::CPAL));
+    }
   }
   optimize_mem = fi.optimize_mem;
+  deltas = fi.deltas;
+  gif_w = fi.gif_w;
+  gif_h = fi.gif_h;
+  has_dispose_previous = fi.has_dispose_previous;
+  background_color_index = fi.background_color_index;
+  background_color = fi.background_color;
+  memory_cap = fi.memory_cap;
   scaling = Fl_Image::RGB_scaling(); // save current scaling mode
   loop_count = fi.loop_count; // .. and the loop_count!
 }
@@ -224,6 +360,14 @@ void Fl_Anim_GIF_Image::FrameInfo::dispose(int frame) {
   // dispose frame with index 'frame_' to offscreen buffer
   switch (frames[frame].dispose) {
     case DISPOSE_PREVIOUS: {
+        if (deltas) {
+          // 'saved' holds the first not DISPOSE_TO_PREVIOUS frame, see compose()
+          if (saved_frame < 0)
+            set_to_background(frame);
+          else
+            memcpy(offscreen, saved, gif_w * gif_h * 4);
+          break;
+        }
         // dispose to previous restores to first not DISPOSE_TO_PREVIOUS frame
         int prev(frame);
         while (prev > 0 && frames[prev].dispose == DISPOSE_PREVIOUS)
@@ -240,13 +384,14 @@ void Fl_Anim_GIF_Image::FrameInfo::dispose(int frame) {
         int pw = frames[prev].w;
         int ph = frames[prev].h;
         const char *src = frames[prev].rgb->data()[0];
-        if (px == 0 && py == 0 && pw == canvas_w && ph == canvas_h)
+        // frame images are canvas-sized unless memory is optimized
+        if (!optimize_mem || (px == 0 && py == 0 && pw == canvas_w && ph == canvas_h))
           memcpy((char *)dst, (char *)src, canvas_w * canvas_h * 4);
         else {
           if ( px + pw > canvas_w ) pw = canvas_w - px;
           if ( py + ph > canvas_h ) ph = canvas_h - py;
           for (int y = 0; y < ph; y++) {
-            memcpy(dst + ( y + py ) * canvas_w * 4 + px, src + y * frames[prev].w * 4, pw * 4);
+            memcpy(dst + (( y + py ) * canvas_w + px) * 4, src + y * frames[prev].w * 4, pw * 4);
           }
         }
         break;
@@ -305,10 +450,14 @@ void Fl_Anim_GIF_Image::FrameInfo::on_frame_data(Fl_GIF_Image::GIF_FRAME &gf) {
   if (!gf.ifrm) {
     // first frame, get width/height
     valid = true; // may be reset later from loading callback
-    canvas_w = gf.width;
-    canvas_h = gf.height;
-    offscreen = new uchar[canvas_w * canvas_h * 4];
-    memset(offscreen, 0, canvas_w * canvas_h * 4);
+    canvas_w = gif_w = gf.width;
+    canvas_h = gif_h = gf.height;
+    if (deltas) {
+      optimize_mem = false;
+    } else {
+      offscreen = new uchar[canvas_w * canvas_h * 4];
+      memset(offscreen, 0, canvas_w * canvas_h * 4);
+    }
   }
 
   if (!gf.ifrm) {
@@ -340,27 +489,28 @@ void Fl_Anim_GIF_Image::FrameInfo::on_frame_data(Fl_GIF_Image::GIF_FRAME &gf) {
     frame.x, frame.y, frame.w, frame.h,
     gf.delay, gf.dispose, gf.trans));
 
+  if (deltas) {
+    // keep the color indices only, frames are composited when shown
+    frame.delta = pack_indices(gf.bptr, frame.w * frame.h, frame.delta_size);
+    frame.cpal = new Fl_GIF_Image::GIF_FRAME::CPAL[256];
+    memcpy(frame.cpal, gf.cpal, 256 * sizeof(Fl_GIF_Image::GIF_FRAME::CPAL));
+    frame.trans = gf.trans;
+    if (frame.dispose == DISPOSE_PREVIOUS)
+      has_dispose_previous = true;
+    if (!push_back_frame(frame)) {
+      delete[] frame.delta;
+      delete[] frame.cpal;
+      valid = false;
+    }
+    return;
+  }
+
   // we know now everything we need about the frame..
   dispose(frames_size - 1);
 
   // copy image data to offscreen
-  const uchar *bits = gf.bptr;
+  draw_indices(frame, gf.bptr, gf.cpal, gf.trans);
   const uchar *endp = offscreen + canvas_w * canvas_h * 4;
-  for (int y = frame.y; y < frame.y + frame.h; y++) {
-    for (int x = frame.x; x < frame.x + frame.w; x++) {
-      uchar c = *bits++;
-      if (c == gf.trans)
-        continue;
-      uchar *buf = offscreen;
-      buf += (y * canvas_w * 4 + (x * 4));
-      if (buf >= endp)
-        continue;
-      *buf++ = gf.cpal[c].r;
-      *buf++ = gf.cpal[c].g;
-      *buf++ = gf.cpal[c].b;
-      *buf = T_NONE;
-    }
-  }
 
   // create RGB image from offscreen
   if (optimize_mem) {
@@ -388,6 +538,126 @@ void Fl_Anim_GIF_Image::FrameInfo::on_frame_data(Fl_GIF_Image::GIF_FRAME &gf) {
 }
 
 
+void Fl_Anim_GIF_Image::FrameInfo::draw_indices(const GifFrame &f, const uchar *bits,
+                                                const Fl_GIF_Image::GIF_FRAME::CPAL *cpal,
+                                                int trans) {
+  const uchar *endp = offscreen + gif_w * gif_h * 4;
+  for (int y = f.y; y < f.y + f.h; y++) {
+    for (int x = f.x; x < f.x + f.w; x++) {
+      uchar c = *bits++;
+      if (c == trans)
+        continue;
+      uchar *buf = offscreen;
+      buf += (y * gif_w * 4 + (x * 4));
+      if (buf >= endp)
+        continue;
+      *buf++ = cpal[c].r;
+      *buf++ = cpal[c].g;
+      *buf++ = cpal[c].b;
+      *buf = T_NONE;
+    }
+  }
+}
+
+
+void Fl_Anim_GIF_Image::FrameInfo::compose(int frame) {
+  // composite frame 'frame' onto the previous one in the offscreen buffer
+  if (frame == 0) {
+    memset(offscreen, 0, gif_w * gif_h * 4);
+    saved_frame = -1;
+  } else {
+    dispose(frame - 1);
+  }
+  const GifFrame &f = frames[frame];
+  uchar *bits = new uchar[f.w * f.h + 1];
+  unpack_indices(f.delta, f.delta_size, bits, f.w * f.h);
+  draw_indices(f, bits, f.cpal, f.trans);
+  delete[] bits;
+  if (has_dispose_previous && f.dispose != DISPOSE_PREVIOUS) {
+    memcpy(saved, offscreen, gif_w * gif_h * 4);
+    saved_frame = frame;
+  }
+  composed = frame;
+}
+
+
+/*
+  Returns the composited image of a frame in FRAME_DELTAS mode. The image is
+  kept in a ring of recently used and prefetched frames; when the ring is
+  full, the frame farthest behind the current frame is replaced.
+*/
+Fl_Anim_GIF_Image::FrameInfo::DecodedFrame *Fl_Anim_GIF_Image::FrameInfo::decoded(int frame) {
+  if (frame < 0 || frame >= frames_size)
+    return 0;
+  size_t frame_bytes = (size_t)gif_w * gif_h * 4;
+  if (!ring) {
+    size_t n = frame_bytes ? memory_cap / frame_bytes : 2;
+    if (n < 2) n = 2;
+    if (n > (size_t)frames_size) n = frames_size;
+    ring_size = (int)n;
+    ring = new DecodedFrame[ring_size];
+  }
+  int i, slot = 0, farthest = -1;
+  int current = anim->frame_ >= 0 ? anim->frame_ : frame;
+  for (i = 0; i < ring_size; i++) {
+    if (ring[i].frame == frame)
+      return &ring[i];
+    int distance = ring[i].frame < 0 ? frames_size :
+                   (ring[i].frame - current + frames_size) % frames_size;
+    if (distance > farthest) {
+      farthest = distance;
+      slot = i;
+    }
+  }
+  if (!offscreen) {
+    offscreen = new uchar[frame_bytes];
+    composed = -1;
+  }
+  if (has_dispose_previous && !saved)
+    saved = new uchar[frame_bytes];
+  if (frame <= composed)
+    composed = -1; // start over
+  while (composed < frame)
+    compose(composed + 1);
+  DEBUG(("  decoded frame %d into slot %d\n", frame + 1, slot));
+  DecodedFrame &d = ring[slot];
+  delete d.rgb;
+  d = DecodedFrame();
+  uchar *buf = new uchar[frame_bytes];
+  memcpy(buf, offscreen, frame_bytes);
+  d.rgb = new Fl_RGB_Image(buf, gif_w, gif_h, 4);
+  d.rgb->alloc_array = 1;
+  d.frame = frame;
+  return &d;
+}
+
+
+/*
+  Composites the next frame after the current one that is not in the ring
+  yet, as long as there is room for it. Returns false if there is nothing
+  left to do.
+*/
+bool Fl_Anim_GIF_Image::FrameInfo::prefetch() {
+  int current = anim->frame_;
+  if (!deltas || current < 0 || !frames_size)
+    return false;
+  if (!ring)
+    decoded(current);
+  for (int i = 1; i < ring_size; i++) {
+    int f = (current + i) % frames_size;
+    int j;
+    for (j = 0; j < ring_size; j++) {
+      if (ring[j].frame == f) break;
+    }
+    if (j == ring_size) {
+      decoded(f);
+      return true;
+    }
+  }
+  return false;
+}
+
+
 bool Fl_Anim_GIF_Image::FrameInfo::push_back_frame(const GifFrame &frame) {
   void *tmp = realloc(frames, sizeof(GifFrame) * (frames_size + 1));
   if (!tmp) {
@@ -419,6 +689,8 @@ void Fl_Anim_GIF_Image::FrameInfo::resize(int W, int H) {
 
 
 void Fl_Anim_GIF_Image::FrameInfo::scale_frame(int frame) {
+  if (deltas)
+    return; // composited frames are scaled when drawn
   // Do the actual scaling after a resize if neccessary
   int new_w = optimize_mem ? frames[frame].w : canvas_w;
   int new_h = optimize_mem ? frames[frame].h : canvas_h;
@@ -449,12 +721,30 @@ void Fl_Anim_GIF_Image::FrameInfo::set_to_background(int frame) {
     bg = tp;
   color.alpha = tp == bg ? T_FULL : tp < 0 ? T_FULL : T_NONE;
   DEBUG(("  set to color %d/%d/%d alpha=%d\n", color.r, color.g, color.b, color.alpha));
-  for (uchar *p = offscreen + canvas_w * canvas_h * 4 - 4; p >= offscreen; p -= 4)
+  for (uchar *p = offscreen + gif_w * gif_h * 4 - 4; p >= offscreen; p -= 4)
     memcpy(p, &color, 4);
 }
 
 
 void Fl_Anim_GIF_Image::FrameInfo::set_frame(int frame) {
+  if (deltas) {
+    DecodedFrame *d = decoded(frame);
+    if (!d)
+      return;
+    if (average_weight >= 0 && average_weight < 1 &&
+        ((average_color != d->average_color) ||
+         (average_weight != d->average_weight))) {
+      d->rgb->color_average(average_color, average_weight);
+      d->average_color = average_color;
+      d->average_weight = average_weight;
+    }
+    if (desaturate && !d->desaturated) {
+      d->rgb->desaturate();
+      d->desaturated = true;
+    }
+    return;
+  }
+
   // scaling pending?
   scale_frame(frame);
 
@@ -535,6 +825,7 @@ Fl_Anim_GIF_Image::Fl_Anim_GIF_Image(const char *filename,
 {
   fi_->debug_ = ((flags_ & LOG_FLAG) != 0) + 2 * ((flags_ & DEBUG_FLAG) != 0);
   fi_->optimize_mem = (flags_ & OPTIMIZE_MEMORY);
+  fi_->deltas = (flags_ & FRAME_DELTAS) != 0;
   valid_ = load(filename, NULL, 0);
   if (canvas_w() && canvas_h()) {
     if (!w() && !h()) {
@@ -584,6 +875,7 @@ Fl_Anim_GIF_Image::Fl_Anim_GIF_Image(const char* imagename, const unsigned char
 {
   fi_->debug_ = ((flags_ & LOG_FLAG) != 0) + 2 * ((flags_ & DEBUG_FLAG) != 0);
   fi_->optimize_mem = (flags_ & OPTIMIZE_MEMORY);
+  fi_->deltas = (flags_ & FRAME_DELTAS) != 0;
   valid_ = load(imagename, data, length);
   if (canvas_w() && canvas_h()) {
     if (!w() && !h()) {
@@ -619,6 +911,7 @@ Fl_Anim_GIF_Image::Fl_Anim_GIF_Image() :
  */
 Fl_Anim_GIF_Image::~Fl_Anim_GIF_Image() /* override */ {
   Fl::remove_timeout(cb_animate, this);
+  Fl::remove_idle(cb_prefetch, this);
   delete fi_;
   free(name_);
 }
@@ -693,7 +986,16 @@ void Fl_Anim_GIF_Image::cb_animate(void *d) {
 }
 
 
+/*static*/
+void Fl_Anim_GIF_Image::cb_prefetch(void *d) {
+  Fl_Anim_GIF_Image *b = (Fl_Anim_GIF_Image *)d;
+  if (!b->fi_->prefetch())
+    Fl::remove_idle(cb_prefetch, d);
+}
+
+
 void Fl_Anim_GIF_Image::clear_frames() {
+  Fl::remove_idle(cb_prefetch, this);
   fi_->clear();
   valid_ = false;
 }
@@ -709,7 +1011,10 @@ void Fl_Anim_GIF_Image::clear_frames() {
       and 1 returns the original image
  */
 void Fl_Anim_GIF_Image::color_average(Fl_Color c, float i) /* override */ {
-  if (i < 0) {
+  if (i < 0 && fi_->deltas) {
+    // frames are composited later, average them then
+    i = -i;
+  } else if (i < 0) {
     // immediate mode
     i = -i;
     for (int f=0; f < frames(); f++) {
@@ -892,6 +1197,7 @@ void Fl_Anim_GIF_Image::frame(int frame) {
  */
 int Fl_Anim_GIF_Image::frame_count(const char *name, const unsigned char *imgdata /* = NULL */, size_t imglength /* = 0 */) {
   Fl_Anim_GIF_Image temp;
+  temp.fi_->deltas = true; // don't composite the frames
   temp.load(name, imgdata, imglength);
   int frames = temp.valid() ? temp.frames() : 0;
   return frames;
@@ -981,6 +1287,31 @@ bool Fl_Anim_GIF_Image::frame_uncache() const {
 }
 
 
+/** Set the memory used for composited frames.
+
+ If the animation was loaded with \ref FRAME_DELTAS, only as many composited
+ frames as fit into \p bytes are kept, but at least two. The default is 16 MB.
+ Frames that are already composited are released.
+
+ \param[in] bytes memory for composited frames in bytes
+ \see FRAME_DELTAS
+ \since 1.5.0
+ */
+void Fl_Anim_GIF_Image::frame_memory(size_t bytes) {
+  fi_->memory_cap = bytes;
+  fi_->clear_ring();
+}
+
+
+/** Return the memory used for composited frames.
+ \return the frame_memory() setting in bytes
+ \since 1.5.0
+ */
+size_t Fl_Anim_GIF_Image::frame_memory() const {
+  return fi_->memory_cap;
+}
+
+
 /** Get the number of frames in the animation.
  \return the number of frames
  */
@@ -993,18 +1324,24 @@ int Fl_Anim_GIF_Image::frames() const {
  \return a pointer to the image or NULL if this is not an animation.
  */
 Fl_Image *Fl_Anim_GIF_Image::image() const {
-  return frame_ >= 0 && frame_ < frames() ? fi_->frames[frame_].rgb : 0;
+  return image(frame_);
 }
 
 
 /** Return the image of the given frame index.
 
+ If the animation was loaded with \ref FRAME_DELTAS, the frame is composited
+ if necessary, and the image is only valid until other frames are composited.
+
  \param[in] frame_ index into list of frames
  \return image data or NULL if the frame number is not valid.
  */
 Fl_Image *Fl_Anim_GIF_Image::image(int frame_) const {
-  if (frame_ >= 0 && frame_ < frames())
+  if (frame_ >= 0 && frame_ < frames()) {
+    if (fi_->deltas)
+      return fi_->decoded(frame_)->rgb;
     return fi_->frames[frame_].rgb;
+  }
   return 0;
 }
 
@@ -1113,6 +1450,8 @@ bool Fl_Anim_GIF_Image::next_frame() {
   if (is_animated() && delay > 0 && speed_ > 0) {  // normal GIF has no delay
     delay /= speed_;
     Fl::add_timeout(delay, cb_animate, this);
+    if (fi_->deltas && !Fl::has_idle(cb_prefetch, this))
+      Fl::add_idle(cb_prefetch, this); // composite the next frames meanwhile
   }
   return true;
 }
@@ -1256,6 +1595,7 @@ bool Fl_Anim_GIF_Image::start() {
  */
 bool Fl_Anim_GIF_Image::stop() {
   Fl::remove_timeout(cb_animate, this);
+  Fl::remove_idle(cb_prefetch, this);
   return fi_->frames_size != 0;
 }
 
@@ -1281,6 +1621,9 @@ void Fl_Anim_GIF_Image::uncache() /* override */ {
   for (int i=0; i < fi_->frames_size; i++) {
     if (fi_->frames[i].rgb) fi_->frames[i].rgb->uncache();
   }
+  for (int i=0; i < fi_->ring_size; i++) {
+    if (fi_->ring[i].rgb) fi_->ring[i].rgb->uncache();
+  }
 }
 
 
@@ -0,0 +1,92 @@
+//
+// Damage rectangle lists for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Damage_List.H"
+
+int Fl_Damage_List::flushed_windows = 0;
+int Fl_Damage_List::flushed_rects = 0;
+long Fl_Damage_List::flushed_area = 0;
+int Fl_Damage_List::drawn_widgets = 0;
+
+
+Fl_Damage_List::Rect Fl_Damage_List::union_(const Rect &a, const Rect &b) {
+  Rect u;
+  u.x = a.x < b.x ? a.x : b.x;
+  u.y = a.y < b.y ? a.y : b.y;
+  int r = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  int t = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  u.w = r - u.x;
+  u.h = t - u.y;
+  return u;
+}
+
+
+long Fl_Damage_List::overlap_(const Rect &a, const Rect &b) {
+  int x = a.x > b.x ? a.x : b.x;
+  int y = a.y > b.y ? a.y : b.y;
+  int r = a.x + a.w < b.x + b.w ? a.x + a.w : b.x + b.w;
+  int t = a.y + a.h < b.y + b.h ? a.y + a.h : b.y + b.h;
+  if (r <= x || t <= y) return 0;
+  return (long)(r - x) * (t - y);
+}
+
+
+/* Returns the total area of the rectangles. Rectangles may overlap a little,
+ so this is an upper bound of the damaged area. */
+long Fl_Damage_List::area() const {
+  long a = 0;
+  for (int i = 0; i < count_; i++) a += area_(rects_[i]);
+  return a;
+}
+
+
+bool Fl_Damage_List::add(int X, int Y, int W, int H, Rect &r) {
+  Rect n = { X, Y, W, H };
+  int i;
+  for (i = 0; i < count_; i++) {
+    if (overlap_(rects_[i], n) == area_(n)) return false; // already damaged
+  }
+  // merge with rectangles whose union doesn't waste more than a quarter
+  // of the area they cover, the union may then merge with others
+  for (i = 0; i < count_; ) {
+    Rect u = union_(rects_[i], n);
+    long covered = area_(rects_[i]) + area_(n) - overlap_(rects_[i], n);
+    if (area_(u) * 4 <= covered * 5) {
+      n = u;
+      remove_(i);
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+  if (count_ == max_rects) {
+    // merge with the rectangle that grows the least
+    int best = 0;
+    long growth = -1;
+    for (i = 0; i < count_; i++) {
+      long g = area_(union_(rects_[i], n)) - area_(rects_[i]);
+      if (growth < 0 || g < growth) { best = i; growth = g; }
+    }
+    n = union_(rects_[best], n);
+    remove_(best);
+    for (i = count_; i--; ) {
+      if (overlap_(rects_[i], n) == area_(rects_[i])) remove_(i);
+    }
+  }
+  rects_[count_++] = n;
+  r = n;
+  return true;
+}
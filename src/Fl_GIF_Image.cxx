@@ -30,6 +30,7 @@
 
 #include <FL/Fl.H>
 #include <FL/Fl_GIF_Image.H>
+#include <FL/Fl_Image.H>
 #include "Fl_Image_Reader.h"
 #include <FL/fl_utf8.h>
 #include "flstring.h"
@@ -37,8 +38,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-// Read a .gif file and convert it to a "xpm" format (actually my
-// modified one with compressed colormaps).
+// Read a .gif file and convert it to RGB(A) pixels, or to a "xpm" format
+// (actually my modified one with compressed colormaps).
 
 // Extensively modified from original code for gif2ras by
 // Patrick J. Naughton of Sun Microsystems.  The original
@@ -83,6 +84,21 @@ struct ColorMap {
   uchar Blue[256];
 };
 
+/*
+  Internally used structure of the LZW decoder table. Codes below the
+  clear code stand for one pixel, the other codes for a string of 'len'
+  pixels: the string of code 'prefix' followed by 'suffix'. 'first' is
+  the first pixel of the string.
+*/
+struct LZW_Entry {
+  short prefix;
+  short len;
+  uchar suffix;
+  uchar first;
+};
+
+bool Fl_GIF_Image::xpm_data = false;
+
 /*
   This small helper function checks for read errors or end of file
   and does some cleanup if an error was found.
@@ -131,7 +147,8 @@ static int gif_error(Fl_Image_Reader &rdr, int line, uchar *Image) {
   \see Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data, const long length)
 */
 Fl_GIF_Image::Fl_GIF_Image(const char *filename) :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
   Fl_Image_Reader rdr;
   if (rdr.open(filename) == -1) {
@@ -174,7 +191,8 @@ Fl_GIF_Image::Fl_GIF_Image(const char *filename) :
   \since 1.4.0
 */
 Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data, const size_t length) :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
   Fl_Image_Reader rdr;
   if (rdr.open(imagename, data, length) == -1) {
@@ -205,7 +223,8 @@ Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data, con
   \see Fl_GIF_Image(const char *imagename, const unsigned char *data, const size_t length)
 */
 Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data) :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
   Fl_Image_Reader rdr;
   if (rdr.open(imagename, data) == -1) {
@@ -216,7 +235,8 @@ Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data) :
 }
 
 Fl_GIF_Image::Fl_GIF_Image(const char *filename, bool anim) :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
   Fl_Image_Reader rdr;
   if (rdr.open(filename) == -1) {
@@ -228,7 +248,8 @@ Fl_GIF_Image::Fl_GIF_Image(const char *filename, bool anim) :
 }
 
 Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data, const size_t length, bool anim) :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
   Fl_Image_Reader rdr;
   if (rdr.open(imagename, data, length) == -1) {
@@ -243,136 +264,137 @@ Fl_GIF_Image::Fl_GIF_Image(const char *imagename, const unsigned char *data, con
 
 */
 Fl_GIF_Image::Fl_GIF_Image() :
-  Fl_Pixmap((char *const*)0)
+  Fl_Pixmap((char *const*)0),
+  rgb_(0)
 {
 }
 
 
+/**
+  The destructor frees all memory and server resources that are used by
+  the image.
+*/
+Fl_GIF_Image::~Fl_GIF_Image() {
+  set_rgb(0);
+}
+
+
+/*
+  Internally used function to advance the row pointer 'YC' of a GIF image
+  to the next row, in the order the rows are stored (de-interlacing).
+  Returns false when all rows have been stored.
+*/
+static bool next_row(int &YC, int &Pass, int Height, int Interlace) {
+  if (!Interlace)
+    return ++YC < Height;
+  static const int start[4] = { 0, 4, 2, 1 };
+  static const int step[4] = { 8, 8, 4, 2 };
+  YC += step[Pass];
+  while (YC >= Height && Pass < 3) // skip passes without rows in small images
+    YC = start[++Pass];
+  return YC < Height;
+}
+
+
 /*
   Internally used method to read from the LZW compressed data
   stream 'rdr' and decode it to 'Image' buffer.
 
+  The codes are read through a bit buffer that is refilled a data sub-block
+  at a time, and each code is looked up in a table that knows the length and
+  first pixel of its string, so that the string can be written backwards
+  straight into the image row. Only strings that span rows go through a
+  temporary buffer.
+
   NOTE: This methode has been extracted from load_gif_()
         in order to make the code more read/hand-able.
 
 */
 void Fl_GIF_Image::lzw_decode(Fl_Image_Reader &rdr, uchar *Image,
-  int Width, int Height, int CodeSize, int ColorMapSize, int Interlace) {
+  int Width, int Height, int CodeSize, int Interlace) {
   int YC = 0, Pass = 0; /* Used to de-interlace the picture */
-  uchar *p = Image;
+  uchar *p = Image;     /* NULL when all rows have been stored */
   uchar *eol = p+Width;
+  if (Width <= 0 || Height <= 0) p = NULL;
 
   int InitCodeSize = CodeSize;
   int ClearCode = (1 << (CodeSize-1));
   int EOFCode = ClearCode + 1;
   int FirstFree = ClearCode + 2;
-  int FinChar = 0;
   int ReadMask = (1<<CodeSize) - 1;
   int FreeCode = FirstFree;
-  int OldCode = ClearCode;
+  int OldCode = -1;     /* no previous code after a clear code */
+
+  // table used by LZW decompressor, literal codes never change:
+  LZW_Entry Table[4096];
+  for (int i = 0; i < ClearCode; i++) {
+    Table[i].prefix = -1;
+    Table[i].len = 1;
+    Table[i].suffix = Table[i].first = (uchar)i;
+  }
 
-  // tables used by LZW decompressor:
-  short int Prefix[4096];
-  uchar Suffix[4096];
-
-  int blocklen = rdr.read_byte();
-  uchar thisbyte = rdr.read_byte(); blocklen--;
-  CHECK_ERROR
-  int frombit = 0;
+  uchar OutCode[4096];  // temporary array for strings that span rows
+  uchar block[256];     // current data sub-block
+  int blockpos = 0, blocklen = 0;
+  unsigned int bits = 0; // bit buffer, the next code is in the low bits
+  int nbits = 0;
 
   // loop to read LZW compressed image data
 
   for (;;) {
 
     /* Fetch the next code from the raster data stream.  The codes can be
-    * any length from 3 to 12 bits, packed into 8-bit bytes, so we have to
-    * maintain our location as a pointer and a bit offset.
-    * In addition, GIF adds totally useless and annoying block counts
-    * that must be correctly skipped over. */
-    int CurCode = thisbyte;
-    if (frombit+CodeSize > 7) {
-      if (blocklen <= 0) {
-        blocklen = rdr.read_byte();
-        CHECK_ERROR
-        if (blocklen <= 0) break;
-      }
-      thisbyte = rdr.read_byte(); blocklen--;
-      CHECK_ERROR
-      CurCode |= thisbyte<<8;
-    }
-    if (frombit+CodeSize > 15) {
-      if (blocklen <= 0) {
+    * any length from 3 to 12 bits, packed into 8-bit bytes. GIF adds
+    * totally useless and annoying block counts that must be correctly
+    * skipped over, a block length of zero ends the data. */
+    while (nbits < CodeSize) {
+      if (blockpos >= blocklen) {
         blocklen = rdr.read_byte();
+        for (blockpos = 0; blockpos < blocklen; blockpos++)
+          block[blockpos] = rdr.read_byte();
         CHECK_ERROR
-        if (blocklen <= 0) break;
+        if (blocklen == 0) return;
+        blockpos = 0;
       }
-      thisbyte = rdr.read_byte(); blocklen--;
-      CHECK_ERROR
-      CurCode |= thisbyte<<16;
+      bits |= (unsigned int)block[blockpos++] << nbits;
+      nbits += 8;
     }
-    CurCode = (CurCode>>frombit)&ReadMask;
-    frombit = (frombit+CodeSize)%8;
+    int CurCode = bits & ReadMask;
+    bits >>= CodeSize;
+    nbits -= CodeSize;
 
     if (CurCode == ClearCode) {
       CodeSize = InitCodeSize;
       ReadMask = (1<<CodeSize) - 1;
       FreeCode = FirstFree;
-      OldCode = ClearCode;
+      OldCode = -1;
       continue;
     }
 
     if (CurCode == EOFCode) {
-      rdr.skip(blocklen);
-      blocklen = rdr.read_byte(); // Block-Terminator must follow!
+      // skip the rest of the data, the Block-Terminator must follow
+      while (blocklen > 0) {
+        blocklen = rdr.read_byte();
+        rdr.skip(blocklen);
+        CHECK_ERROR
+      }
       break;
     }
 
-    uchar OutCode[4097]; // temporary array for reversing codes
-    uchar *tp = OutCode;
-    int i;
-    if (CurCode < FreeCode) {
-      i = CurCode;
-    } else if (CurCode == FreeCode) {
-      *tp++ = (uchar)FinChar;
-      i = OldCode;
-    } else {
+    if (CurCode > FreeCode || (CurCode == FreeCode && OldCode < 0)) {
       Fl::error("Fl_GIF_Image: %s - LZW Barf at offset %ld", rdr.name(), rdr.tell());
       break;
     }
 
-    while (i >= ColorMapSize) {
-      if (i < FreeCode) {
-        *tp++ = Suffix[i];
-        i = Prefix[i];
-      } else { // FIXME - should never happen (?)
-        Fl::error("Fl_GIF_Image: %s - i(%d) >= FreeCode (%d) at offset %ld",
-                  rdr.name(), i, FreeCode, rdr.tell());
-        // NOTREACHED
-        i = FreeCode - 1; // fix broken index ???
-        break;
-      }
-    }
-    *tp++ = FinChar = i;
-    do {
-      *p++ = *--tp;
-      if (p >= eol) {
-        if (!Interlace) YC++;
-        else switch (Pass) {
-          case 0: YC += 8; if (YC >= Height) {Pass++; YC = 4;} break;
-          case 1: YC += 8; if (YC >= Height) {Pass++; YC = 2;} break;
-          case 2: YC += 4; if (YC >= Height) {Pass++; YC = 1;} break;
-          case 3: YC += 2; break;
-        }
-        if (YC>=Height) YC=0; /* cheap bug fix when excess data */
-        p = Image + YC*Width;
-        eol = p+Width;
-      }
-    } while (tp > OutCode);
-
-    if (OldCode != ClearCode) {
+    // add the string of the previous code plus the first pixel of this one,
+    // which is also the string of this code if it was not in the table yet
+    if (OldCode >= 0) {
       if (FreeCode < 4096) {
-        Prefix[FreeCode] = (short)OldCode;
-        Suffix[FreeCode] = FinChar;
+        LZW_Entry &e = Table[FreeCode];
+        e.prefix = (short)OldCode;
+        e.len = Table[OldCode].len + 1;
+        e.first = Table[OldCode].first;
+        e.suffix = CurCode < FreeCode ? Table[CurCode].first : e.first;
         FreeCode++;
       }
       if (FreeCode > ReadMask) {
@@ -383,7 +405,65 @@ void Fl_GIF_Image::lzw_decode(Fl_Image_Reader &rdr, uchar *Image,
       }
     }
     OldCode = CurCode;
+
+    if (!p) continue; // excess data, the image is complete
+
+    int len = Table[CurCode].len;
+    if (len <= eol - p) { // write the string backwards into this row
+      uchar *tp = p + len;
+      for (int i = CurCode; i >= 0; i = Table[i].prefix)
+        *--tp = Table[i].suffix;
+      p += len;
+    } else {              // the string spans rows
+      uchar *tp = OutCode + len;
+      for (int i = CurCode; i >= 0; i = Table[i].prefix)
+        *--tp = Table[i].suffix;
+      while (len > 0 && p) {
+        int n = (int)(eol - p);
+        if (n > len) n = len;
+        memcpy(p, tp, n);
+        p += n; tp += n; len -= n;
+        if (p >= eol) {
+          p = next_row(YC, Pass, Height, Interlace) ? Image + YC*Width : NULL;
+          eol = p + Width;
+        }
+      }
+      continue;
+    }
+    if (p >= eol) {
+      p = next_row(YC, Pass, Height, Interlace) ? Image + YC*Width : NULL;
+      eol = p + Width;
+    }
+  }
+}
+
+
+/*
+  Internally used function to convert raw 'Image' data to RGB pixels, or RGBA
+  pixels if the image has a transparent pixel. Returns an allocated buffer of
+  Width*Height*depth bytes.
+*/
+static uchar *convert_to_rgb(const uchar *Image, int Width, int Height, const ColorMap &CMap, int transparent_pixel, int &depth) {
+  depth = transparent_pixel >= 0 ? 4 : 3;
+  // one palette entry per pixel value, written with a single copy
+  uchar palette[256][4];
+  for (int i = 0; i < 256; i++) {
+    palette[i][0] = CMap.Red[i];
+    palette[i][1] = CMap.Green[i];
+    palette[i][2] = CMap.Blue[i];
+    palette[i][3] = 255;
+  }
+  if (transparent_pixel >= 0)
+    memset(palette[transparent_pixel], 0, 4); // same as fl_convert_pixmap()
+  size_t n = (size_t)Width * Height;
+  uchar *rgb = new uchar[n * depth];
+  uchar *q = rgb;
+  if (depth == 4) {
+    for (size_t i = 0; i < n; i++, q += 4) memcpy(q, palette[Image[i]], 4);
+  } else {
+    for (size_t i = 0; i < n; i++, q += 3) memcpy(q, palette[Image[i]], 3);
   }
+  return rgb;
 }
 
 
@@ -470,7 +550,9 @@ static char ** convert_to_xpm(uchar *Image, int Width, int Height, ColorMap &CMa
 /*
   This method reads GIF image data and creates an RGB or RGBA image. The GIF
   format supports only 1 bit for alpha. The final image data is stored in
-  a modified XPM format (Fl_GIF_Image is a subclass of Fl_Pixmap).
+  an Fl_RGB_Image whose pixels are shared as data() of this image, or, if
+  Fl_GIF_Image::xpm_data is set, in a modified XPM format (Fl_GIF_Image is a
+  subclass of Fl_Pixmap).
   To avoid code duplication, we use an Fl_Image_Reader that reads data from
   either a file or from memory.
 
@@ -479,7 +561,7 @@ static char ** convert_to_xpm(uchar *Image, int Width, int Height, ColorMap &CMa
   image is decoded (as with Fl_GIF_Image), but all contained images are read.
   The new Fl_Anim_GIF_Image class is derived from Fl_GIF_Image and utilises this
   feature in order to avoid code duplication of the GIF decoding routines.
-  The first image is in this case (additionally) stored in the usual way as described
+  The first image is in this case (additionally) stored in the XPM format described
   above (making the Fl_Anim_GIF_Image a normal Fl_GIF_Image too).
   All subsequent images are only decoded (and not converted to XPM) and passed
   to Fl_Anim_GIF_Image, which stores them on its own (in RGBA format).
@@ -645,6 +727,10 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
       CHECK_ERROR
       if (CodeSize < 2 || CodeSize > 8) { // though invalid, other decoders accept an use it
         Fl::warning("Fl_GIF_Image: %s invalid LZW-initial code size %d.\n", rdr.name(), CodeSize);
+        if (CodeSize > 11) { // codes can't have more than 12 bits
+          ld(ERR_FORMAT);
+          return;
+        }
       }
       CodeSize++;
 
@@ -686,7 +772,7 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
       // now read the LZW compressed image data
 
       Image = new uchar[Width*Height];
-      lzw_decode(rdr, Image, Width, Height, CodeSize, ColorMapSize, Interlace);
+      lzw_decode(rdr, Image, Width, Height, CodeSize, Interlace);
       if (ld()) return; // CHECK_ERROR aborted already
 
       // Notify derived class on loaded image data
@@ -735,7 +821,7 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
           data((const char **)new_data, Height + 2);
           alloc_data = 1;
           delete[] moved_image;
-        } else {
+        } else if (anim || xpm_data) {
           // Fl_GIF_Image does not apply offsets and just show the first frame at 0, 0
           w(Width);
           h(Height);
@@ -743,6 +829,15 @@ void Fl_GIF_Image::load_gif_(Fl_Image_Reader &rdr, bool anim/*=false*/)
           char **new_data = convert_to_xpm(Image, Width, Height, CMap, ColorMapSize, has_transparent ? transparent_pixel : -1);
           data((const char **)new_data, Height + 2);
           alloc_data = 1;
+        } else {
+          // same as above, but the pixels go straight to an RGB(A) image
+          w(Width);
+          h(Height);
+          int depth;
+          uchar *pixels = convert_to_rgb(Image, Width, Height, CMap, has_transparent ? transparent_pixel : -1, depth);
+          Fl_RGB_Image *img = new Fl_RGB_Image(pixels, Width, Height, depth);
+          img->alloc_array = 1;
+          set_rgb(img);
         }
       }
 
@@ -804,3 +899,69 @@ void Fl_GIF_Image::load(const char *imagename, const unsigned char *data, const
     load_gif_(rdr, anim);
   }
 }
+
+
+/*
+  Internally used method to make 'img' the pixels of this image, or to
+  delete them if 'img' is NULL. The image data is shared the same way
+  Fl_RGB_Image shares it, so that data()[0] points to the pixels.
+*/
+void Fl_GIF_Image::set_rgb(Fl_RGB_Image *img) {
+  if (rgb_) {
+    delete rgb_;
+    data(0, 0);
+  }
+  rgb_ = img;
+  if (img) {
+    d(img->d());
+    data((const char **)&img->array, 1);
+  }
+}
+
+
+Fl_Image *Fl_GIF_Image::copy(int W, int H) const {
+  if (!rgb_) return Fl_Pixmap::copy(W, H);
+  Fl_Image *img = rgb_->copy(W, H);
+  if (!img) return 0;
+  Fl_GIF_Image *new_image = new Fl_GIF_Image();
+  new_image->w(img->w());
+  new_image->h(img->h());
+  new_image->set_rgb((Fl_RGB_Image *)img);
+  return new_image;
+}
+
+
+void Fl_GIF_Image::color_average(Fl_Color c, float i) {
+  if (!rgb_) {
+    Fl_Pixmap::color_average(c, i);
+    return;
+  }
+  rgb_->color_average(c, i);
+  d(rgb_->d());
+}
+
+
+void Fl_GIF_Image::desaturate() {
+  if (!rgb_) {
+    Fl_Pixmap::desaturate();
+    return;
+  }
+  rgb_->desaturate();
+  d(rgb_->d());
+}
+
+
+void Fl_GIF_Image::draw(int X, int Y, int W, int H, int cx, int cy) {
+  if (!rgb_) {
+    Fl_Pixmap::draw(X, Y, W, H, cx, cy);
+    return;
+  }
+  rgb_->scale(w(), h(), 0, 1);
+  rgb_->draw(X, Y, W, H, cx, cy);
+}
+
+
+void Fl_GIF_Image::uncache() {
+  if (rgb_) rgb_->uncache();
+  Fl_Pixmap::uncache();
+}
@@ -420,10 +420,30 @@ void Fl_Gl_Window::draw_begin() {
 }
 
 /**
- To be used as a match for a previous call to Fl_Gl_Window::draw_begin().
+ Sends the primitives drawn with the FLTK 2D drawing API to OpenGL.
+ Between draw_begin() and draw_end(), these primitives are accumulated and
+ sent to OpenGL in a few calls, so they may be drawn after OpenGL calls that
+ follow them in the code. Call this function before such OpenGL calls,
+ including those in the draw() method of a child widget, it does nothing
+ outside of draw_begin() and draw_end().
  \see \ref opengl_with_fltk_widgets
+ \since 1.5.0
+ */
+void Fl_Gl_Window::draw_flush() {
+  if (Fl_Surface_Device::surface() != Fl_OpenGL_Display_Device::display_device()) return;
+  Fl_OpenGL_Graphics_Driver *drv = (Fl_OpenGL_Graphics_Driver*)Fl_Surface_Device::surface()->driver();
+  drv->flush_batch();
+}
+
+/**
+ To be used as a match for a previous call to Fl_Gl_Window::draw_begin().
+ Primitives drawn with the FLTK 2D drawing API since draw_begin() are
+ accumulated and sent to OpenGL in a few calls; they are all drawn when
+ this function returns.
+ \see draw_flush(), \ref opengl_with_fltk_widgets
  */
 void Fl_Gl_Window::draw_end() {
+  draw_flush();
   glMatrixMode(GL_MODELVIEW);
   glPopMatrix();
 
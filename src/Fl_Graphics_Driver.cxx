@@ -543,7 +543,7 @@ void Fl_Graphics_Driver::_rbox(int fill, int x, int y, int w, int h, int r) {
   transformed_vertex(xd+lut[2]*rr, bd-lut[2]*rr);
   transformed_vertex(xd+lut[1]*rr, bd-lut[3]*rr);
   transformed_vertex(xd+lut[0]*rr, bd-lut[4]*rr);
-  if (fill) fl_end_polygon(); else fl_end_loop();
+  if (fill) end_polygon(); else end_loop();
 }
 
 /** see fl_rounded_rect() */
@@ -782,6 +782,12 @@ int Fl_Graphics_Driver::antialias() {
   return 0;
 }
 
+/** Reports the counters of the shaped text cache of the driver, if any, see Fl::text_cache_stats() */
+void Fl_Graphics_Driver::text_cache_stats(unsigned long &hits, unsigned long &misses,
+                                          unsigned long &evictions) {
+  hits = misses = evictions = 0;
+}
+
 /**
  \}
  \endcond
@@ -22,7 +22,10 @@
 
 #include <FL/Fl_Group.H>
 #include "Fl_Window_Driver.H"
+#include "Fl_Offscreen_Cache.H"
+#include "Fl_Damage_List.H"
 #include <FL/Fl_Rect.H>
+#include <FL/Fl_Profiler.H>
 #include <FL/fl_draw.H>
 
 #include <stdlib.h> // malloc etc.
@@ -944,7 +947,12 @@ void Fl_Group::draw() {
 void Fl_Group::update_child(Fl_Widget& widget) const {
   if (widget.damage() && widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
-    widget.draw();
+    FL_PROFILE_SPAN(DRAW, NULL, &widget, NULL, -1);
+    if (!Fl_Offscreen_Cache::draw(widget) && !Fl_Display_List::replay(widget)) {
+      Fl_Display_List::Recorder recorder(widget);
+      widget.draw();
+    }
+    Fl_Damage_List::drawn_widgets++;
     widget.clear_damage();
   }
 }
@@ -960,7 +968,12 @@ void Fl_Group::draw_child(Fl_Widget& widget) const {
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
     // The following call clears all damage flags and then *sets* FL_DAMAGE_ALL
     widget.clear_damage(FL_DAMAGE_ALL);
-    widget.draw();
+    FL_PROFILE_SPAN(DRAW, NULL, &widget, NULL, -1);
+    if (!Fl_Offscreen_Cache::draw(widget) && !Fl_Display_List::replay(widget)) {
+      Fl_Display_List::Recorder recorder(widget);
+      widget.draw();
+    }
+    Fl_Damage_List::drawn_widgets++;
     widget.clear_damage();
   }
 }
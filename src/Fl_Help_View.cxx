@@ -44,6 +44,8 @@
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
+#include <limits.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <string>
@@ -68,6 +70,12 @@
 
 static constexpr int MAX_COLUMNS = 200;
 
+// Documents larger than this are formatted incrementally, this many bytes at a time
+static constexpr size_t FORMAT_CHUNK_SIZE = 65536;
+
+// Number of layouts for other widths that are kept in memory
+static constexpr size_t LAYOUT_CACHE_SIZE = 3;
+
 //
 // Implementation class
 //
@@ -108,9 +116,13 @@ public:
     selection_last_ = 0;
 
     scrollbar_size_ = 0;
+
+    layout_valid_ = false;
+    layout_key_   = { 0, 0, 0, 0 };
   }
   ~Impl()
   {
+    stop_format();
     clear_selection();
     free_data();
   }
@@ -156,6 +168,75 @@ public:
     int           ol_num;               // item number in ordered list
   };
 
+  /** Private struct to describe one entry in the display list of a block. */
+  struct Draw_Item {
+    enum class Kind : uchar { TEXT, LINE, RULE, CELL, IMAGE };
+    Kind          kind;                 // Type of item
+    uchar         border;               // CELL: draw border?
+    Fl_Font       font;                 // TEXT: font
+    Fl_Fontsize   size;                 // TEXT: font size
+    Fl_Color      color;                // Text, line, or border color
+    Fl_Color      bgcolor;              // CELL: background color
+    int           x;                    // X position in document coordinates
+    int           y;                    // Y position (TEXT: baseline) in document coordinates
+    int           w;                    // Width
+    int           h;                    // Height (TEXT: line height)
+    int           descent;              // TEXT: font descent
+    int           space;                // TEXT: width of a space, used to highlight the selection
+    int           pos;                  // TEXT: offset of the text in value_
+    int           extra;                // TEXT: extra length of HTML entities in the text
+    int           text;                 // TEXT: offset of the text in Display_List::text
+    int           len;                  // TEXT: length of the text in bytes
+    Fl_Image      *img;                 // IMAGE: image to draw
+  };
+
+  /** Private struct to hold the parsed, ready to draw contents of a block. */
+  struct Display_List {
+    bool          valid = false;        // Has the list been built?
+    std::vector<Draw_Item> items;       // Draw items in document order
+    std::string   text;                 // UTF-8 text of all TEXT items
+  };
+
+  /** Private struct to hold the plain text of the document for find(). */
+  struct Search_Index {
+    bool          valid = false;        // Has the index been built?
+    std::string   text;                 // Text without tags and entities, ASCII in lowercase
+    std::vector<int> block_start;       // Offset in text of the first character of each block
+    std::vector<std::pair<int, int> > map; // (offset in text, offset in value_) where text is not contiguous
+    void          clear();
+    int           to_value(int pos) const;
+    int           to_text(int pos) const;
+  };
+
+  struct Link;
+
+  /** Private struct with all values that a layout depends on. */
+  struct Layout_Key {
+    int           width;                // Initial document width
+    int           scrollsize;           // Scrollbar size
+    Fl_Color      color;                // Widget background color
+    Fl_Color      textcolor;            // Default text color
+    bool operator==(const Layout_Key &k) const {
+      return width == k.width && scrollsize == k.scrollsize
+          && color == k.color && textcolor == k.textcolor;
+    }
+  };
+
+  /** Private struct to keep a complete layout for another document width. */
+  struct Layout {
+    Layout_Key    key;
+    std::vector<Text_Block> blocks;
+    std::vector<std::shared_ptr<Link> > links;
+    std::map<std::string, int> targets;
+    std::vector<Display_List> display_lists;
+    std::string   title;
+    int           size;
+    int           hsize;
+    Fl_Color      bgcolor;
+    Fl_Color      textcolor;
+    Fl_Color      linkcolor;
+  };
+
   /** Private class to hold a link with target and its position on screen. */
   struct Link {
     std::string   filename_;            // Filename part of a link
@@ -188,6 +269,40 @@ public:
   enum class Align { RIGHT = -1, CENTER, LEFT };  ///< Alignments
   enum class Mode { DRAW, PUSH, DRAG };           ///< Draw modes
 
+  /** Private struct to hold the state of format_chunk() between calls. */
+  struct Format_State {
+    const char    *ptr;                 // Current position in value_, nullptr at the start of a pass
+    const char    *stop_ptr;            // Stop after this position, nullptr to format everything
+    int           stop_y;               // Stop below this vertical position
+    size_t        stop_blocks;          // Number of blocks when the last chunk stopped
+    size_t        length;               // Length of value_
+    char          initial_load;         // Value of initial_load when formatting started
+    int           hsize;                // Initial document width
+    int           needed;               // Width of the widest element that did not fit
+    int           done;
+    Text_Block    *block;               // Points into blocks_, which is not modified between chunks
+    int           cells[MAX_COLUMNS];
+    int           row;
+    char          linkdest[1024];
+    int           xx, yy, ww, hh;
+    int           line;
+    int           links;
+    Fl_Font       font;
+    Fl_Fontsize   fsize;
+    Fl_Color      fcolor;
+    unsigned char border;
+    Align         talign;
+    Align         newalign;
+    int           head, pre, needspace;
+    int           table_width, table_offset;
+    int           column;
+    int           columns[MAX_COLUMNS];
+    Fl_Color      tc, rc;
+    Margin_Stack  margins;
+    std::vector<int> OL_num;
+    Font_Stack    fstack;               // Copy of fstack_, which draw() uses between chunks
+  };
+
   private: // data members
 
   // HTML source and raw data
@@ -203,6 +318,12 @@ public:
   std::vector<Text_Block> blocks_;      ///< List of all text blocks on screen
   std::vector<std::shared_ptr<Link> > link_list_; ///< List of all clickable links and their position on screen
   std::map<std::string, int> target_line_map_;    ///< List of vertical position of all HTML Targets in a document
+  std::vector<Display_List> display_lists_;       ///< Display list for each block, built on demand
+  Search_Index  search_index_;          ///< Plain text of all blocks for find(), built on demand
+  std::unique_ptr<Format_State> format_state_; ///< State of incremental formatting, nullptr if not formatting
+  bool          layout_valid_;          ///< True if blocks_ etc. hold a complete layout for layout_key_
+  Layout_Key    layout_key_;            ///< Width and colors of the current layout
+  std::vector<Layout> layout_cache_;    ///< Layouts for other widths, most recently used first
 
   int           topline_;               ///< Vertical offset of document, measure in pixels
   int           leftline_;              ///< Horizontal offset of document, measure in pixels
@@ -231,8 +352,6 @@ public:
   static int    selection_push_last_;   ///< Last character of selection during mouse down
   static int    selection_drag_first_;  ///< First character of selection during mouse drag
   static int    selection_drag_last_;   ///< Last character of selection during mouse drag
-  static Mode   draw_mode_;             ///< Temporarily modify `draw()` method to measure selection start or end during `handle()`
-  static int    current_pos_;           ///< Temporarily store text offset while measuring during `handle()`
 
   // Callback
 
@@ -257,6 +376,15 @@ public:
   void          add_target(const std::string &n, int yy);
   int           do_align(Text_Block *block, int line, int xx, Align a, int &l);
   void          format();
+  bool          format_chunk();
+  void          finish_format();
+  void          stop_format();
+  static void   format_idle_cb(void *data);
+  void          update_scrollbars(bool scroll = true);
+  Layout_Key    layout_key() const;
+  void          save_layout();
+  bool          restore_layout(const Layout_Key &key);
+  void          clear_layout_cache();
   void          format_table(int *table_width, int *columns, const char *table);
   Align         get_align(const char *p, Align a);
   const char    *get_attr(const char *p, const char *n, char *buf, int bufsize);
@@ -264,6 +392,17 @@ public:
   Fl_Shared_Image *get_image(const char *name, int W, int H);
   int           get_length(const char *l);
 
+  // Display list and search index
+
+  const Display_List &display_list(int i);
+  void          build_display_list(const Text_Block &block, Display_List &dl);
+  void          add_text(Display_List &dl, const char *t, int x, int y, int pos, int entity_extra_length = 0);
+  Draw_Item     &add_item(Display_List &dl, Draw_Item::Kind kind, int x, int y, int w, int h);
+  void          draw_item(const Display_List &dl, const Draw_Item &item);
+  void          build_search_index();
+  /// Discard all display lists and the search index.
+  void          invalidate() { display_lists_.clear(); search_index_.clear(); }
+
   // Font and font stack
 
   /// Initialize the font stack with default values.
@@ -277,7 +416,7 @@ public:
 
   // Text selection
 
-  void          hv_draw(const char *t, int x, int y, int entity_extra_length = 0);
+  void          measure_selection(Mode mode);
   char          begin_selection();
   char          extend_selection();
   void          end_selection();
@@ -316,15 +455,15 @@ public:
   /** Return the document height in pixels. */
   int           size() const { return (size_); }
   /** Set the default text color. */
-  void          textcolor(Fl_Color c) { if (textcolor_ == defcolor_) textcolor_ = c; defcolor_ = c; }
+  void          textcolor(Fl_Color c) { if (textcolor_ == defcolor_) textcolor_ = c; defcolor_ = c; display_lists_.clear(); }
   /** Return the current default text color. */
   Fl_Color      textcolor() const { return (defcolor_); }
   /** Set the default text font. */
-  void          textfont(Fl_Font f) { textfont_ = f; format(); }
+  void          textfont(Fl_Font f) { textfont_ = f; clear_layout_cache(); format(); }
   /** Return the default text font. */
   Fl_Font       textfont() const { return (textfont_); }
   /** Set the default text size. */
-  void          textsize(Fl_Fontsize s) { textsize_ = s; format(); }
+  void          textsize(Fl_Fontsize s) { textsize_ = s; clear_layout_cache(); format(); }
   /** Get the default text size. */
   Fl_Fontsize   textsize() const { return (textsize_); }
   void          topline(const char *n);
@@ -354,15 +493,10 @@ public:
 //
 
 static char initial_load = 0;
-// We don't put the offscreen buffer in the help view class because
-// we'd need to include platform.H in the header...
-static Fl_Offscreen fl_help_view_buffer;
 int Fl_Help_View::Impl::selection_push_first_ = 0;
 int Fl_Help_View::Impl::selection_push_last_ = 0;
 int Fl_Help_View::Impl::selection_drag_first_ = 0;
 int Fl_Help_View::Impl::selection_drag_last_ = 0;
-Fl_Help_View::Impl::Mode Fl_Help_View::Impl::draw_mode_ = Mode::DRAW;
-int Fl_Help_View::Impl::current_pos_ = 0;
 
 //
 // Local functions declarations, implementations are at the end of the file
@@ -667,7 +801,9 @@ void Fl_Help_View::Impl::free_data() {
     value_ = 0;
   }
 
+  clear_layout_cache();
   blocks_ .clear();
+  invalidate();
   link_list_.clear();
   target_line_map_.clear();
 }
@@ -879,102 +1015,210 @@ int Fl_Help_View::Impl::do_align(
   computes positions and sizes for each text and image element, manages links and targets,
   and sets up the scrolling and rendering parameters for the widget.
 
-  The main algorithm consists of an outer loop that may repeat if the computed content
-  exceeds the available width (to adjust hsize_), and an inner loop that parses the text,
-  handles tags, manages formatting state, and builds the layout structures.
+  Layouts are cached per document width. If the widget was formatted before
+  with the same width, for instance when only the height of the widget
+  changed, the previous layout is reused and only the scrollbars are updated.
+
+  Documents that are larger than FORMAT_CHUNK_SIZE bytes are formatted
+  incrementally: the first call lays out the text up to a screen below the
+  visible area, and the rest of the document is formatted in an idle
+  callback. During that time size() returns an estimate.
+
+  \see format_chunk()
 */
 void Fl_Help_View::Impl::format() {
+  DEBUG_FUNCTION(__LINE__,__FUNCTION__);
+
+  Layout_Key key = layout_key();
+
+  if (layout_valid_ && key == layout_key_) {
+    // Same width and colors as the current layout
+    update_scrollbars();
+    return;
+  }
+  if (format_state_ && key == layout_key_) {
+    // Incremental formatting for this width is in progress
+    update_scrollbars();
+    return;
+  }
+
+  stop_format();
+  if (layout_valid_)
+    save_layout();
+  if (restore_layout(key)) {
+    update_scrollbars();
+    return;
+  }
+
+  layout_key_ = key;
+  format_state_.reset(new Format_State());
+  format_state_->ptr          = nullptr;
+  format_state_->initial_load = initial_load;
+  format_state_->stop_blocks  = 0;
+  format_state_->hsize        = key.width;
+  format_state_->length       = value_ ? strlen(value_) : 0;
+  layout_valid_ = false;
+
+  if (format_state_->length > FORMAT_CHUNK_SIZE) {
+    // Format the visible part and a screen below it now, the rest later
+    format_state_->stop_ptr = value_;
+    format_state_->stop_y   = topline_ + 2 * view.h();
+    if (!format_chunk()) {
+      update_scrollbars();
+      Fl::add_idle(format_idle_cb, this);
+      return;
+    }
+  } else {
+    format_state_->stop_ptr = nullptr;
+    format_chunk();
+  }
+  if (value_)
+    update_scrollbars();
+}
+
+
+/**
+  \brief Formats the document, or a part of it.
+
+  This is the actual HTML parser and layout engine that is used by format().
+  The outer loop may repeat if the computed content exceeds the available
+  width (to adjust hsize_), and an inner loop parses the text, handles tags,
+  manages formatting state, and builds the layout structures.
+
+  All formatting state is kept in format_state_. If format_state_->stop_ptr
+  is not nullptr, formatting stops at the first block that starts below
+  format_state_->stop_y and after format_state_->stop_ptr, but never inside
+  a table. The next call continues where the last call stopped.
+
+  \return true if the document is completely formatted, false if not
+*/
+bool Fl_Help_View::Impl::format_chunk() {
+  Format_State  &st = *format_state_;
   int           i;              // Looping var
-  int           done;           // Are we done yet?
-  Text_Block    *block = nullptr, // Current block
+  int           &done = st.done;// Are we done yet?
+  Text_Block    *&block = st.block, // Current block
                 *cell;          // Current table cell
-  int           cells[MAX_COLUMNS],
+  int           (&cells)[MAX_COLUMNS] = st.cells,
                                 // Cells in the current row...
-                row;            // Current table row (block number)
-  const char    *ptr,           // Pointer into block
+                &row = st.row;  // Current table row (block number)
+  const char    *&ptr = st.ptr, // Pointer into block
                 *start,         // Pointer to start of element
                 *attrs;         // Pointer to start of element attributes
   Edit_Buffer   buf;            // Text buffer
   char          attr[1024],     // Attribute buffer
                 wattr[1024],    // Width attribute buffer
                 hattr[1024],    // Height attribute buffer
-                linkdest[1024]; // Link destination
-  int           xx, yy, ww, hh = 0; // Size of current text fragment
-  int           line;           // Current line in block
-  int           links;          // Links for current line
-  Fl_Font       font;
-  Fl_Fontsize   fsize;          // Current font and size
-  Fl_Color      fcolor;         // Current font color
-  unsigned char border;         // Draw border?
-  Align talign;         // Current alignment
-  Align newalign;       // New alignment
-  int           head,           // In the <HEAD> section?
-                pre,            // <PRE> text?
-                needspace;      // Do we need whitespace?
-  int           table_width,    // Width of table
-                table_offset;   // Offset of table
-  int           column,         // Current table column number
-                columns[MAX_COLUMNS];
+                (&linkdest)[1024] = st.linkdest; // Link destination
+  int           &xx = st.xx, &yy = st.yy, &ww = st.ww, &hh = st.hh;
+                                // Size of current text fragment
+  int           &line = st.line;// Current line in block
+  int           &links = st.links; // Links for current line
+  Fl_Font       &font = st.font;
+  Fl_Fontsize   &fsize = st.fsize; // Current font and size
+  Fl_Color      &fcolor = st.fcolor; // Current font color
+  unsigned char &border = st.border; // Draw border?
+  Align         &talign = st.talign; // Current alignment
+  Align         &newalign = st.newalign; // New alignment
+  int           &head = st.head,// In the <HEAD> section?
+                &pre = st.pre,  // <PRE> text?
+                &needspace = st.needspace; // Do we need whitespace?
+  int           &table_width = st.table_width, // Width of table
+                &table_offset = st.table_offset; // Offset of table
+  int           &column = st.column, // Current table column number
+                (&columns)[MAX_COLUMNS] = st.columns;
                                 // Column widths
-  Fl_Color      tc, rc;         // Table/row background color
-  Fl_Boxtype    b = view.box() ? view.box() : FL_DOWN_BOX;
-                                // Box to draw...
-  Margin_Stack  margins;        // Left margin stack...
-  std::vector<int> OL_num;         // if nonnegative, in OL mode and this is the item number
-
-  OL_num.push_back(-1);
+  Fl_Color      &tc = st.tc, &rc = st.rc; // Table/row background color
+  Margin_Stack  &margins = st.margins; // Left margin stack...
+  std::vector<int> &OL_num = st.OL_num; // if nonnegative, in OL mode and this is the item number
+  int           &needed = st.needed; // Width needed by the widest element
+  char          saved_load = initial_load;
 
   DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
-  // Reset document width...
-  int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
-  hsize_ = view.w() - scrollsize - Fl::box_dw(b);
-
-  done = 0;
-  while (!done)
-  {
-    // Reset state variables...
-    done       = 1;
-    blocks_.clear();
-    link_list_.clear();
-    target_line_map_.clear();
-    size_      = 0;
-    bgcolor_   = view.color();
-    textcolor_ = textcolor();
-    linkcolor_ = fl_contrast(FL_BLUE, view.color());
+  // Images must be loaded the same way as when formatting started
+  initial_load = st.initial_load;
 
-    tc = rc = bgcolor_;
+  if (!ptr) {
+    // Reset document width...
+    hsize_ = st.hsize;
+    done   = 0;
+  } else {
+    // Continue after the last chunk, the last block is not complete
+    if (display_lists_.size() > st.stop_blocks - 1)
+      display_lists_.resize(st.stop_blocks - 1);
+    search_index_.clear();
+    Fl_Font f; Fl_Fontsize fs; Fl_Color fc;
+    fstack_ = st.fstack;
+    fstack_.top(f, fs, fc);
+    fl_font(f, fs);
+  }
 
-    title_ = "Untitled";
+  while (!done || ptr)
+  {
+    if (!ptr) {
+      // Reset state variables...
+      done       = 1;
+      blocks_.clear();
+      invalidate();
+      link_list_.clear();
+      target_line_map_.clear();
+      size_      = 0;
+      bgcolor_   = view.color();
+      textcolor_ = textcolor();
+      linkcolor_ = fl_contrast(FL_BLUE, view.color());
+
+      tc = rc = bgcolor_;
+
+      title_ = "Untitled";
+
+      if (!value_) {
+        format_state_.reset();
+        initial_load = saved_load;
+        return true;
+      }
 
-    if (!value_)
-      return;
+      // Setup for formatting...
+      initfont(font, fsize, fcolor);
 
-    // Setup for formatting...
-    initfont(font, fsize, fcolor);
-
-    line         = 0;
-    links        = 0;
-    margins.clear();
-    xx           = 4;
-    yy           = fsize + 2;
-    ww           = 0;
-    column       = 0;
-    border       = 0;
-    hh           = 0;
-    block        = add_block(value_, xx, yy, hsize_, 0);
-    row          = 0;
-    head         = 0;
-    pre          = 0;
-    talign       = Align::LEFT;
-    newalign     = Align::LEFT;
-    needspace    = 0;
-    linkdest[0]  = '\0';
-    table_offset = 0;
+      line         = 0;
+      links        = 0;
+      margins.clear();
+      OL_num.clear();
+      OL_num.push_back(-1);
+      xx           = 4;
+      yy           = fsize + 2;
+      ww           = 0;
+      column       = 0;
+      border       = 0;
+      hh           = 0;
+      block        = add_block(value_, xx, yy, hsize_, 0);
+      row          = 0;
+      head         = 0;
+      pre          = 0;
+      talign       = Align::LEFT;
+      newalign     = Align::LEFT;
+      needspace    = 0;
+      linkdest[0]  = '\0';
+      table_offset = 0;
+      needed       = 0;
+      ptr          = value_;
+      st.stop_blocks = 0;
+    }
 
     // Html text character loop
-    for (ptr = value_, buf.clear(); *ptr;)
+    for (buf.clear(); *ptr;)
     {
+      // Stop at the start of a new block below the requested area
+      if (st.stop_ptr && ptr > st.stop_ptr && blocks_.size() > st.stop_blocks
+          && !row && buf.size() == 0 && yy > st.stop_y) {
+        st.stop_blocks = blocks_.size();
+        st.fstack = fstack_;
+        // Estimate the document height from the formatted part
+        size_ = (int)((double)yy * st.length / (ptr - value_));
+        initial_load = saved_load;
+        return false;
+      }
+
       // End of word?
       if ((*ptr == '<' || fl_ascii_isspace(*ptr)) && buf.size() > 0)
       {
@@ -984,11 +1228,8 @@ void Fl_Help_View::Impl::format() {
         if (!head && !pre)
         {
           // Check width...
-          if (ww > hsize_) {
-            hsize_ = ww;
-            done   = 0;
-            break;
-          }
+          if (ww > hsize_ && ww > needed)
+            needed = ww;
 
           if (needspace && xx > block->x)
             ww += (int)fl_width(' ');
@@ -1029,7 +1270,8 @@ void Fl_Help_View::Impl::format() {
           {
             if (*ptr == '\n')
             {
-              if (xx > hsize_) break;
+              if (xx > hsize_ && xx > needed)
+                needed = xx;
 
               line     = do_align(block, line, xx, newalign, links);
               xx       = block->x;
@@ -1046,11 +1288,8 @@ void Fl_Help_View::Impl::format() {
             ptr ++;
           }
 
-          if (xx > hsize_) {
-            hsize_ = xx;
-            done   = 0;
-            break;
-          }
+          if (xx > hsize_ && xx > needed)
+            needed = xx;
 
           needspace = 0;
         }
@@ -1196,9 +1435,8 @@ void Fl_Help_View::Impl::format() {
               printf("xx=%d, table_width=%d, hsize_=%d\n", xx, table_width,
                      hsize_);
 #endif // DEBUG
-              hsize_ = xx + table_width;
-              done   = 0;
-              break;
+              if (xx + table_width > needed)
+                needed = xx + table_width;
             }
 
             switch (get_align(attrs, talign))
@@ -1543,11 +1781,8 @@ void Fl_Help_View::Impl::format() {
 
           ww = width;
 
-          if (ww > hsize_) {
-            hsize_ = ww;
-            done   = 0;
-            break;
-          }
+          if (ww > hsize_ && ww > needed)
+            needed = ww;
 
           if (needspace && xx > block->x)
             ww += (int)fl_width(' ');
@@ -1577,11 +1812,8 @@ void Fl_Help_View::Impl::format() {
         if (linkdest[0])
           add_link(linkdest, xx, yy - hh, ww, hh);
 
-        if (xx > hsize_) {
-          hsize_ = xx;
-          done   = 0;
-          break;
-        }
+        if (xx > hsize_ && xx > needed)
+          needed = xx;
 
         line      = do_align(block, line, xx, newalign, links);
         xx        = block->x;
@@ -1631,11 +1863,8 @@ void Fl_Help_View::Impl::format() {
   //    printf("line = %d, xx = %d, ww = %d, block->x = %d, block->w = %d\n",
   //       line, xx, ww, block->x, block->w);
 
-      if (ww > hsize_) {
-        hsize_ = ww;
-        done   = 0;
-        break;
-      }
+      if (ww > hsize_ && ww > needed)
+        needed = ww;
 
       if (needspace && xx > block->x)
         ww += (int)fl_width(' ');
@@ -1659,11 +1888,36 @@ void Fl_Help_View::Impl::format() {
 
     block->end = ptr;
     size_      = yy + hh;
+    st.ptr     = nullptr;
+
+    // Format again if anything did not fit into the document width
+    if (needed > hsize_) {
+      hsize_ = needed;
+      done   = 0;
+    }
   }
   // Make sure that the last block will have the correct height.
   if (hh > block->h) block->h = hh;
 
-//  printf("margins.depth_=%d\n", margins.depth_);
+  format_state_.reset();
+  layout_valid_ = true;
+  initial_load = saved_load;
+  return true;
+}
+
+
+/**
+  \brief Shows, hides, and resizes the scrollbars for the current document size.
+
+  \param[in] scroll if true, the document is also scrolled so that the
+    current top line and left position are within the new range. If false,
+    only the range of the vertical scrollbar is updated, which is used while
+    the document is formatted in the background.
+ */
+void Fl_Help_View::Impl::update_scrollbars(bool scroll)
+{
+  Fl_Boxtype    b = view.box() ? view.box() : FL_DOWN_BOX;
+                                // Box to draw...
 
   int dx = Fl::box_dw(b) - Fl::box_dx(b);
   int dy = Fl::box_dh(b) - Fl::box_dy(b);
@@ -1698,6 +1952,11 @@ void Fl_Help_View::Impl::format() {
     }
   }
 
+  if (!scroll) {
+    view.scrollbar_.value(topline_, view.h() - ss, 0, size_);
+    return;
+  }
+
   // Reset scrolling if it needs to be...
   if (view.scrollbar_.visible()) {
     int temph = view.h() - Fl::box_dh(b);
@@ -1714,6 +1973,151 @@ void Fl_Help_View::Impl::format() {
 }
 
 
+/**
+  \brief Formats the rest of the document if it is formatted incrementally.
+
+  This is used by methods that need the complete layout, for instance to
+  find a target or a search string.
+ */
+void Fl_Help_View::Impl::finish_format()
+{
+  if (!format_state_)
+    return;
+  Fl::remove_idle(format_idle_cb, this);
+  format_state_->stop_ptr = nullptr;
+  format_chunk();
+  update_scrollbars(false);
+  view.redraw();
+}
+
+
+/**
+  \brief Stops incremental formatting and discards the partial layout state.
+ */
+void Fl_Help_View::Impl::stop_format()
+{
+  if (!format_state_)
+    return;
+  Fl::remove_idle(format_idle_cb, this);
+  format_state_.reset();
+}
+
+
+/**
+  \brief Idle callback that formats the next part of a large document.
+  \param[in] data pointer to the Fl_Help_View::Impl instance
+ */
+void Fl_Help_View::Impl::format_idle_cb(void *data)
+{
+  Impl *impl = (Impl *)data;
+  Format_State &st = *impl->format_state_;
+
+  st.stop_y = -1;
+  if (st.length - (st.ptr - impl->value_) > FORMAT_CHUNK_SIZE)
+    st.stop_ptr = st.ptr + FORMAT_CHUNK_SIZE;
+  else
+    st.stop_ptr = impl->value_ + st.length;
+
+  if (impl->format_chunk())
+    Fl::remove_idle(format_idle_cb, data);
+
+  impl->update_scrollbars(false);
+  impl->view.redraw();
+}
+
+
+/**
+  \brief Returns the widget attributes that the layout of the document depends on.
+ */
+Fl_Help_View::Impl::Layout_Key Fl_Help_View::Impl::layout_key() const
+{
+  Fl_Boxtype b = view.box() ? view.box() : FL_DOWN_BOX;
+  int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
+  Layout_Key key;
+  key.width      = view.w() - scrollsize - Fl::box_dw(b);
+  key.scrollsize = scrollsize;
+  key.color      = view.color();
+  key.textcolor  = textcolor();
+  return key;
+}
+
+
+/**
+  \brief Moves the current layout into the layout cache.
+
+  The least recently used layout is removed if the cache is full.
+ */
+void Fl_Help_View::Impl::save_layout()
+{
+  Layout layout;
+  layout.key           = layout_key_;
+  layout.blocks        = std::move(blocks_);
+  layout.links         = std::move(link_list_);
+  layout.targets       = std::move(target_line_map_);
+  layout.display_lists = std::move(display_lists_);
+  layout.title         = title_;
+  layout.size          = size_;
+  layout.hsize         = hsize_;
+  layout.bgcolor       = bgcolor_;
+  layout.textcolor     = textcolor_;
+  layout.linkcolor     = linkcolor_;
+
+  blocks_.clear();
+  link_list_.clear();
+  target_line_map_.clear();
+  invalidate();
+  layout_valid_ = false;
+
+  layout_cache_.insert(layout_cache_.begin(), std::move(layout));
+  if (layout_cache_.size() > LAYOUT_CACHE_SIZE)
+    layout_cache_.pop_back();
+}
+
+
+/**
+  \brief Makes a cached layout the current layout.
+  \param[in] key width and colors of the requested layout
+  \return true if a matching layout was found in the cache
+ */
+bool Fl_Help_View::Impl::restore_layout(const Layout_Key &key)
+{
+  for (auto it = layout_cache_.begin(); it != layout_cache_.end(); ++it) {
+    if (!(it->key == key))
+      continue;
+    blocks_          = std::move(it->blocks);
+    link_list_       = std::move(it->links);
+    target_line_map_ = std::move(it->targets);
+    display_lists_   = std::move(it->display_lists);
+    search_index_.clear();
+    title_           = it->title;
+    size_            = it->size;
+    hsize_           = it->hsize;
+    bgcolor_         = it->bgcolor;
+    textcolor_       = it->textcolor;
+    linkcolor_       = it->linkcolor;
+    layout_key_      = key;
+    layout_valid_    = true;
+    layout_cache_.erase(it);
+    return true;
+  }
+  return false;
+}
+
+
+/**
+  \brief Discards the current layout and all cached layouts.
+
+  This must be called whenever the document or an attribute changes that
+  is not part of Layout_Key, for instance the text font or size.
+ */
+void Fl_Help_View::Impl::clear_layout_cache()
+{
+  stop_format();
+  layout_cache_.clear();
+  layout_valid_ = false;
+}
+
+
 /**
   \brief Format a table
   \param[out] table_width Total width of the table
@@ -2448,55 +2852,50 @@ int Fl_Help_View::Impl::get_length(const char *l) {
   - &word; style characters mess up our count inside a word boundary
   - we can only select words, no individual characters
   - no dragging of the selection into another widget
-  - we are using the draw() function to measure screen postion of text
-    by rerouting the code via draw_mode_. Some drawing functions are
-    still called which is slow and requires a fake graphics context.
-    It may help to get rid of those calls if not in DRAW mode.
+
+  Text positions are measured by walking the display list of each visible
+  block (see measure_selection()), so no fake graphics context is needed.
 
   matt.
  */
 
 /**
-  \brief Draws a text string in the help view.
+  \brief Finds the text run under the mouse and updates the selection helpers.
 
-  This function draws the text string \p t at position (\p x, \p y) in the help view.
-  If the text is selected, it draws a selection rectangle around it and changes the text color.
+  This function walks the display lists of all visible blocks and checks
+  which text run is under the mouse pointer. Depending on \p mode it sets
+  the start or the end of the current mouse selection.
 
-  \param[in] t Text to draw
-  \param[in] x X position to draw at
-  \param[in] y Y position to draw at
-  \param[in] entity_extra_length (unclear)
+  \param[in] mode Mode::PUSH to start a new selection, Mode::DRAG to extend it
  */
-void Fl_Help_View::Impl::hv_draw(const char *t, int x, int y, int entity_extra_length)
+void Fl_Help_View::Impl::measure_selection(Mode mode)
 {
-  if (draw_mode_ == Mode::DRAW) {
-    if (selected_ && current_pos_<selection_last_ && current_pos_>=selection_first_) {
-      Fl_Color c = fl_color();
-      fl_color(tmp_selection_color_);
-      int w = (int)fl_width(t);
-      if (current_pos_+(int)strlen(t)<selection_last_)
-        w += (int)fl_width(' ');
-      fl_rectf(x, y+fl_descent()-fl_height(), w, fl_height());
-      fl_color(selection_text_color_);
-      fl_draw(t, x, y);
-      fl_color(c);
-    } else {
-      fl_draw(t, x, y);
-    }
-  } else {
-    // If draw_mode_ is not DRAW, we don't actually draw anything, but instead
-    // measure where text blocks are on screen during a mouse selection process.
-    int w = (int)fl_width(t);
-    if ( (Fl::event_x() >= x) && (Fl::event_x() < x+w) ) {
-      if ( (Fl::event_y() >= y-fl_height()+fl_descent()) && (Fl::event_y() <= y+fl_descent()) ) {
-        int f = (int) current_pos_;
-        int l = (int) (f+strlen(t)); // use 'quote_char' to calculate the true length of the HTML string
-        if (draw_mode_ == Mode::PUSH) {
-          selection_push_first_ = selection_drag_first_ = f;
-          selection_push_last_ = selection_drag_last_ = l;
-        } else { // Mode::DRAG
-          selection_drag_first_ = f;
-          selection_drag_last_ = l + entity_extra_length;
+  if (!value_)
+    return;
+
+  int ex = Fl::event_x(), ey = Fl::event_y();
+
+  for (int i = 0; i < (int)blocks_.size(); i ++) {
+    const Text_Block &block = blocks_[i];
+    if ((block.y + block.h) < topline_ || block.y >= (topline_ + view.h()))
+      continue;
+    const Display_List &dl = display_list(i);
+    for (const Draw_Item &item : dl.items) {
+      if (item.kind != Draw_Item::Kind::TEXT)
+        continue;
+      int xx = item.x + view.x() - leftline_;
+      int yy = item.y + view.y() - topline_;
+      if ( (ex >= xx) && (ex < xx+item.w) ) {
+        if ( (ey >= yy-item.h+item.descent) && (ey <= yy+item.descent) ) {
+          int f = item.pos;
+          int l = f + item.len; // use 'quote_char' to calculate the true length of the HTML string
+          if (mode == Mode::PUSH) {
+            selection_push_first_ = selection_drag_first_ = f;
+            selection_push_last_ = selection_drag_last_ = l;
+          } else { // Mode::DRAG
+            selection_drag_first_ = f;
+            selection_drag_last_ = l + item.extra;
+          }
         }
       }
     }
@@ -2519,15 +2918,7 @@ char Fl_Help_View::Impl::begin_selection()
   selection_push_first_ = selection_push_last_ = 0;
   selection_drag_first_ = selection_drag_last_ = 0;
 
-  if (!fl_help_view_buffer) fl_help_view_buffer = fl_create_offscreen(1, 1);
-
-  draw_mode_ = Mode::PUSH;
-
-    fl_begin_offscreen(fl_help_view_buffer);
-    draw();
-    fl_end_offscreen();
-
-  draw_mode_ = Mode::DRAW;
+  measure_selection(Mode::PUSH);
 
   if (selection_push_last_) return 1;
   else return 0;
@@ -2556,13 +2947,7 @@ char Fl_Help_View::Impl::extend_selection()
 
   selected_ = true;
 
-  draw_mode_ = Mode::DRAG;
-
-    fl_begin_offscreen(fl_help_view_buffer);
-    draw();
-    fl_end_offscreen();
-
-  draw_mode_ = Mode::DRAW;
+  measure_selection(Mode::DRAG);
 
   if (selection_push_first_ < selection_drag_first_) {
     selection_first_ = selection_push_first_;
@@ -2602,25 +2987,111 @@ void Fl_Help_View::Impl::end_selection()
 }
 
 
-// ------ Fl_Help_View Protected and Public methods
+// ---- Display list
 
-// ---- Widget management
+
+/*
+  About the display list:
+
+  format() computes the position of all blocks, but it does not store
+  the position of every word in a block. The first time a block is drawn
+  or measured, its HTML text is parsed once more and the result is stored
+  as a list of draw items (text runs, underlines, rules, table cells, and
+  images) in document coordinates. draw() and measure_selection() only
+  walk these lists, so scrolling does not parse any HTML.
+
+  The display lists are cleared by format(), free_data(), and whenever
+  a rendering attribute changes that is not handled by format().
+ */
 
 /**
-  \brief Draws the Fl_Help_View widget.
-*/
-void Fl_Help_View::draw() {
-  impl_->draw();
+  \brief Returns the display list for the block with index \p i.
+
+  The display list is built on demand if it does not exist yet.
+
+  \param[in] i index of the block in blocks_
+  \return the display list of the block
+ */
+const Fl_Help_View::Impl::Display_List &Fl_Help_View::Impl::display_list(int i)
+{
+  if (display_lists_.size() != blocks_.size())
+    display_lists_.resize(blocks_.size());
+  Display_List &dl = display_lists_[i];
+  if (!dl.valid)
+    build_display_list(blocks_[i], dl);
+  return dl;
 }
 
+
 /**
-  \brief Draws the Fl_Help_View widget.
-  \see Fl_Help_View::draw()
+  \brief Adds a text run with the current font and color to a display list.
+
+  \param[in,out] dl the display list
+  \param[in] t text to add, UTF-8 encoded
+  \param[in] x, y position of the text baseline in document coordinates
+  \param[in] pos offset of the text in value_
+  \param[in] entity_extra_length byte length difference between HTML entities and UTF-8
  */
-void Fl_Help_View::Impl::draw()
+void Fl_Help_View::Impl::add_text(Display_List &dl, const char *t, int x, int y,
+                                  int pos, int entity_extra_length)
+{
+  Draw_Item item;
+  memset(&item, 0, sizeof(Draw_Item));
+  item.kind    = Draw_Item::Kind::TEXT;
+  item.font    = fl_font();
+  item.size    = fl_size();
+  item.color   = fl_color();
+  item.x       = x;
+  item.y       = y;
+  item.w       = (int)fl_width(t);
+  item.h       = fl_height();
+  item.descent = fl_descent();
+  item.space   = (int)fl_width(' ');
+  item.pos     = pos;
+  item.extra   = entity_extra_length;
+  item.text    = (int)dl.text.size();
+  item.len     = (int)strlen(t);
+  dl.text.append(t, item.len);
+  dl.items.push_back(item);
+}
+
+
+/**
+  \brief Adds a graphics item with the current color to a display list.
+
+  \param[in,out] dl the display list
+  \param[in] kind type of the item: LINE, RULE, CELL, or IMAGE
+  \param[in] x, y, w, h position and size in document coordinates
+  \return the new item, so the caller can set additional attributes
+ */
+Fl_Help_View::Impl::Draw_Item &Fl_Help_View::Impl::add_item(
+  Display_List &dl, Draw_Item::Kind kind, int x, int y, int w, int h)
+{
+  Draw_Item item;
+  memset(&item, 0, sizeof(Draw_Item));
+  item.kind    = kind;
+  item.color   = fl_color();
+  item.x       = x;
+  item.y       = y;
+  item.w       = w;
+  item.h       = h;
+  dl.items.push_back(item);
+  return dl.items.back();
+}
+
+
+/**
+  \brief Parses the HTML text of a block and builds its display list.
+
+  This is the parser that was formerly run by draw() for every visible
+  block on every redraw. All positions are stored in document coordinates,
+  i.e. without the widget position and the scroll offsets.
+
+  \param[in] block the text block
+  \param[out] dl the display list of the block
+ */
+void Fl_Help_View::Impl::build_display_list(const Text_Block &block, Display_List &dl)
 {
-  int                   i;              // Looping var
-  const Text_Block      *block;         // Pointer to current block
   const char            *ptr,           // Pointer to text in block
                         *attrs;         // Pointer to start of element attributes
   Edit_Buffer           buf;            // Text buffer
@@ -2632,542 +3103,626 @@ void Fl_Help_View::Impl::draw()
   Fl_Color              fcolor;         // current font color
   int                   head, pre,      // Flags for text
                         needspace;      // Do we need whitespace?
-  Fl_Boxtype            b = view.box() ? view.box() : FL_DOWN_BOX;
-                                        // Box to draw...
   int                   underline,      // Underline text?
                         xtra_ww;        // Extra width for underlined space between words
+  int                   pos;            // Offset of the current text in value_
 
   DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
-  // Draw the scrollbar(s) and box first...
-  ww = view.w();
-  hh = view.h();
-  i  = 0;
-
-  view.draw_box(b, view.x(), view.y(), ww, hh, bgcolor_);
-
-  if ( view.hscrollbar_.visible() || view.scrollbar_.visible() ) {
-    int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
-    int hor_vis = view.hscrollbar_.visible();
-    int ver_vis = view.scrollbar_.visible();
-    // Scrollbar corner
-    int scorn_x = view.x() + ww - (ver_vis?scrollsize:0) - Fl::box_dw(b) + Fl::box_dx(b);
-    int scorn_y = view.y() + hh - (hor_vis?scrollsize:0) - Fl::box_dh(b) + Fl::box_dy(b);
-    if ( hor_vis ) {
-      if ( view.hscrollbar_.h() != scrollsize ) {            // scrollsize changed?
-        view.hscrollbar_.resize(view.x(), scorn_y, scorn_x - view.x(), scrollsize);
-        view.init_sizes();
-      }
-      view.draw_child(view.hscrollbar_);
-      hh -= scrollsize;
-    }
-    if ( ver_vis ) {
-      if ( view.scrollbar_.w() != scrollsize ) {             // scrollsize changed?
-        view.scrollbar_.resize(scorn_x, view.y(), scrollsize, scorn_y - view.y());
-        view.init_sizes();
-      }
-      view.draw_child(view.scrollbar_);
-      ww -= scrollsize;
-    }
-    if ( hor_vis && ver_vis ) {
-      // Both scrollbars visible? Draw little gray box in corner
-      fl_color(FL_GRAY);
-      fl_rectf(scorn_x, scorn_y, scrollsize, scrollsize);
-    }
-  }
-
-  if (!value_)
-    return;
-
-  if (selected_) {
-    if (Fl::focus() == &view) {
-      // If this widget has the focus, we use the selection color directly
-      tmp_selection_color_ = view.selection_color();
-    } else {
-      // Otherwise we blend the selection color with the background color
-      tmp_selection_color_ = fl_color_average(bgcolor_, view.selection_color(), 0.8f);
-    }
-    selection_text_color_ = fl_contrast(textcolor_, tmp_selection_color_);
-  }
-  current_pos_ = 0;
+  dl.items.clear();
+  dl.text.clear();
+  dl.valid = true;
 
-  // Clip the drawing to the inside of the box...
-  fl_push_clip(view.x() + Fl::box_dx(b), view.y() + Fl::box_dy(b),
-               ww - Fl::box_dw(b), hh - Fl::box_dh(b));
   fl_color(textcolor_);
 
-  // Draw all visible blocks...
-  for (i = 0, block = &blocks_[0]; i < (int)blocks_.size(); i ++, block ++)
-    if ((block->y + block->h) >= topline_ && block->y < (topline_ + view.h()))
+  line      = 0;
+  xx        = block.line[line];
+  yy        = block.y;
+  ww        = 0;
+  hh        = 0;
+  pre       = 0;
+  head      = 0;
+  needspace = 0;
+  underline = 0;
+  pos       = (int) (block.start-value_);
+
+  initfont(font, fsize, fcolor);
+  // byte length difference between html entity (encoded by &...;) and
+  // UTF-8 encoding of same character
+  int entity_extra_length = 0;
+  for (ptr = block.start, buf.clear(); ptr < block.end;)
+  {
+    if ((*ptr == '<' || fl_ascii_isspace(*ptr)) && buf.size() > 0)
     {
-      line      = 0;
-      xx        = block->line[line];
-      yy        = block->y - topline_;
-      hh        = 0;
-      pre       = 0;
-      head      = 0;
-      needspace = 0;
-      underline = 0;
-
-      initfont(font, fsize, fcolor);
-      // byte length difference between html entity (encoded by &...;) and
-      // UTF-8 encoding of same character
-      int entity_extra_length = 0;
-      for (ptr = block->start, buf.clear(); ptr < block->end;)
+      if (!head && !pre)
       {
-        if ((*ptr == '<' || fl_ascii_isspace(*ptr)) && buf.size() > 0)
-        {
-          if (!head && !pre)
-          {
-            // Check width...
-            ww = buf.width();
-
-            if (needspace && xx > block->x)
-              xx += (int)fl_width(' ');
-
-            if ((xx + ww) > block->w)
-            {
-              if (line < 31)
-                line ++;
-              xx = block->line[line];
-              yy += hh;
-              hh = 0;
-            }
-
-            hv_draw(buf.c_str(), xx + view.x() - leftline_, yy + view.y(), entity_extra_length);
-            buf.clear();
-            entity_extra_length = 0;
-            if (underline) {
-              xtra_ww = fl_ascii_isspace(*ptr)?(int)fl_width(' '):0;
-              fl_xyline(xx + view.x() - leftline_, yy + view.y() + 1,
-                        xx + view.x() - leftline_ + ww + xtra_ww);
-            }
-            current_pos_ = (int) (ptr-value_);
-
-            xx += ww;
-            if ((fsize + 2) > hh)
-              hh = fsize + 2;
-
-            needspace = 0;
-          }
-          else if (pre)
-          {
-            while (fl_ascii_isspace(*ptr))
-            {
-              if (*ptr == '\n')
-              {
-                hv_draw(buf.c_str(), xx + view.x() - leftline_, yy + view.y());
-                if (underline) fl_xyline(xx + view.x() - leftline_, yy + view.y() + 1,
-                                         xx + view.x() - leftline_ + buf.width());
-                buf.clear();
-                current_pos_ = (int) (ptr-value_);
-                if (line < 31)
-                  line ++;
-                xx = block->line[line];
-                yy += hh;
-                hh = fsize + 2;
-              }
-              else if (*ptr == '\t')
-              {
-                // Do tabs every 8 columns...
-                buf += ' '; // add at least one space
-                while (buf.size() & 7)
-                  buf += ' ';
-              }
-              else {
-                buf += ' ';
-              }
-              if ((fsize + 2) > hh)
-                hh = fsize + 2;
-
-              ptr ++;
-            }
-
-            if (buf.size() > 0)
-            {
-              hv_draw(buf.c_str(), xx + view.x() - leftline_, yy + view.y());
-              ww = buf.width();
-              buf.clear();
-              if (underline) fl_xyline(xx + view.x() - leftline_, yy + view.y() + 1,
-                                       xx + view.x() - leftline_ + ww);
-              xx += ww;
-              current_pos_ = (int) (ptr-value_);
-            }
-
-            needspace = 0;
-          }
-          else
-          {
-            buf.clear();
+        // Check width...
+        ww = buf.width();
 
-            while (fl_ascii_isspace(*ptr))
-              ptr ++;
-            current_pos_ = (int) (ptr-value_);
-          }
-        }
+        if (needspace && xx > block.x)
+          xx += (int)fl_width(' ');
 
-        if (*ptr == '<')
+        if ((xx + ww) > block.w)
         {
-          ptr ++;
-
-          if (strncmp(ptr, "!--", 3) == 0)
-          {
-            // Comment...
-            ptr += 3;
-            if ((ptr = strstr(ptr, "-->")) != nullptr)
-            {
-              ptr += 3;
-              continue;
-            }
-            else
-              break;
-          }
-
-          while (*ptr && *ptr != '>' && !fl_ascii_isspace(*ptr))
-            buf += *ptr++;
+          if (line < 31)
+            line ++;
+          xx = block.line[line];
+          yy += hh;
+          hh = 0;
+        }
 
-          attrs = ptr;
-          while (*ptr && *ptr != '>')
-            ptr ++;
+        add_text(dl, buf.c_str(), xx, yy, pos, entity_extra_length);
+        buf.clear();
+        entity_extra_length = 0;
+        if (underline) {
+          xtra_ww = fl_ascii_isspace(*ptr)?(int)fl_width(' '):0;
+          add_item(dl, Draw_Item::Kind::LINE, xx, yy + 1, ww + xtra_ww, 0);
+        }
+        pos = (int) (ptr-value_);
 
-          if (*ptr == '>')
-            ptr ++;
+        xx += ww;
+        if ((fsize + 2) > hh)
+          hh = fsize + 2;
 
-          // end of command reached, set the supposed start of printed eord here
-          current_pos_ = (int) (ptr-value_);
-          if (buf.cmp("HEAD"))
-            head = 1;
-          else if (buf.cmp("BR"))
+        needspace = 0;
+      }
+      else if (pre)
+      {
+        while (fl_ascii_isspace(*ptr))
+        {
+          if (*ptr == '\n')
           {
+            add_text(dl, buf.c_str(), xx, yy, pos);
+            if (underline) add_item(dl, Draw_Item::Kind::LINE, xx, yy + 1, buf.width(), 0);
+            buf.clear();
+            pos = (int) (ptr-value_);
             if (line < 31)
               line ++;
-            xx = block->line[line];
+            xx = block.line[line];
             yy += hh;
-            hh = 0;
+            hh = fsize + 2;
           }
-          else if (buf.cmp("HR"))
+          else if (*ptr == '\t')
           {
-            fl_line(block->x + view.x(), yy + view.y(), block->w + view.x(),
-                    yy + view.y());
-
-            if (line < 31)
-              line ++;
-            xx = block->line[line];
-            yy += 2 * fsize;//hh;
-            hh = 0;
+            // Do tabs every 8 columns...
+            buf += ' '; // add at least one space
+            while (buf.size() & 7)
+              buf += ' ';
           }
-          else if (buf.cmp("CENTER") ||
-                   buf.cmp("P") ||
-                   buf.cmp("H1") ||
-                   buf.cmp("H2") ||
-                   buf.cmp("H3") ||
-                   buf.cmp("H4") ||
-                   buf.cmp("H5") ||
-                   buf.cmp("H6") ||
-                   buf.cmp("UL") ||
-                   buf.cmp("OL") ||
-                   buf.cmp("DL") ||
-                   buf.cmp("LI") ||
-                   buf.cmp("DD") ||
-                   buf.cmp("DT") ||
-                   buf.cmp("PRE"))
-          {
-            if (tolower(buf[0]) == 'h')
-            {
-              font  = FL_HELVETICA_BOLD;
-              fsize = textsize_ + '7' - buf[1];
-            }
-            else if (buf.cmp("DT"))
-            {
-              font  = textfont_ | FL_ITALIC;
-              fsize = textsize_;
-            }
-            else if (buf.cmp("PRE"))
-            {
-              font  = FL_COURIER;
-              fsize = textsize_;
-              pre   = 1;
-            }
+          else {
+            buf += ' ';
+          }
+          if ((fsize + 2) > hh)
+            hh = fsize + 2;
 
-            if (buf.cmp("LI"))
-            {
-              if (block->ol) {
-                char buf[10];
-                snprintf(buf, sizeof(buf), "%d. ", block->ol_num);
-                hv_draw(buf, xx - (int)fl_width(buf) + view.x() - leftline_, yy + view.y());
-              }
-              else {
-                // draw bullet (&bull;) Unicode: U+2022, UTF-8 (hex): e2 80 a2
-                unsigned char bullet[4] = { 0xe2, 0x80, 0xa2, 0x00 };
-                hv_draw((char *)bullet, xx - fsize + view.x() - leftline_, yy + view.y());
-              }
-            }
+          ptr ++;
+        }
 
-            pushfont(font, fsize);
-            buf.clear();
-          }
-          else if (buf.cmp("A") &&
-                   get_attr(attrs, "HREF", attr, sizeof(attr)) != nullptr)
-          {
-            fl_color(linkcolor_);
-            underline = 1;
-          }
-          else if (buf.cmp("/A"))
-          {
-            fl_color(textcolor_);
-            underline = 0;
-          }
-          else if (buf.cmp("FONT"))
-          {
-            if (get_attr(attrs, "COLOR", attr, sizeof(attr)) != nullptr) {
-              textcolor_ = get_color(attr, textcolor_);
-            }
+        if (buf.size() > 0)
+        {
+          add_text(dl, buf.c_str(), xx, yy, pos);
+          ww = buf.width();
+          buf.clear();
+          if (underline) add_item(dl, Draw_Item::Kind::LINE, xx, yy + 1, ww, 0);
+          xx += ww;
+          pos = (int) (ptr-value_);
+        }
 
-            if (get_attr(attrs, "FACE", attr, sizeof(attr)) != nullptr) {
-              if (!strncasecmp(attr, "helvetica", 9) ||
-                  !strncasecmp(attr, "arial", 5) ||
-                  !strncasecmp(attr, "sans", 4)) font = FL_HELVETICA;
-              else if (!strncasecmp(attr, "times", 5) ||
-                       !strncasecmp(attr, "serif", 5)) font = FL_TIMES;
-              else if (!strncasecmp(attr, "symbol", 6)) font = FL_SYMBOL;
-              else font = FL_COURIER;
-            }
+        needspace = 0;
+      }
+      else
+      {
+        buf.clear();
 
-            if (get_attr(attrs, "SIZE", attr, sizeof(attr)) != nullptr) {
-              if (isdigit(attr[0] & 255)) {
-                // Absolute size
-                fsize = (int)(textsize_ * pow(1.2, atof(attr) - 3.0));
-              } else {
-                // Relative size
-                fsize = (int)(fsize * pow(1.2, atof(attr) - 3.0));
-              }
-            }
+        while (fl_ascii_isspace(*ptr))
+          ptr ++;
+        pos = (int) (ptr-value_);
+      }
+    }
 
-            pushfont(font, fsize);
-          }
-          else if (buf.cmp("/FONT"))
-          {
-            popfont(font, fsize, textcolor_);
-          }
-          else if (buf.cmp("U"))
-            underline = 1;
-          else if (buf.cmp("/U"))
-            underline = 0;
-          else if (buf.cmp("B") ||
-                   buf.cmp("STRONG"))
-            pushfont(font |= FL_BOLD, fsize);
-          else if (buf.cmp("TD") ||
-                   buf.cmp("TH"))
-          {
-            int tx, ty, tw, th;
+    if (*ptr == '<')
+    {
+      ptr ++;
 
-            if (tolower(buf[1]) == 'h')
-              pushfont(font |= FL_BOLD, fsize);
-            else
-              pushfont(font = textfont_, fsize);
+      if (strncmp(ptr, "!--", 3) == 0)
+      {
+        // Comment...
+        ptr += 3;
+        if ((ptr = strstr(ptr, "-->")) != nullptr)
+        {
+          ptr += 3;
+          continue;
+        }
+        else
+          break;
+      }
 
-            tx = block->x - 4 - leftline_;
-            ty = block->y - topline_ - fsize - 3;
-            tw = block->w - block->x + 7;
-            th = block->h + fsize - 5;
+      while (*ptr && *ptr != '>' && !fl_ascii_isspace(*ptr))
+        buf += *ptr++;
 
-            if (tx < 0)
-            {
-              tw += tx;
-              tx  = 0;
-            }
+      attrs = ptr;
+      while (*ptr && *ptr != '>')
+        ptr ++;
 
-            if (ty < 0)
-            {
-              th += ty;
-              ty  = 0;
-            }
+      if (*ptr == '>')
+        ptr ++;
 
-            tx += view.x();
-            ty += view.y();
+      // end of command reached, set the supposed start of printed eord here
+      pos = (int) (ptr-value_);
+      if (buf.cmp("HEAD"))
+        head = 1;
+      else if (buf.cmp("BR"))
+      {
+        if (line < 31)
+          line ++;
+        xx = block.line[line];
+        yy += hh;
+        hh = 0;
+      }
+      else if (buf.cmp("HR"))
+      {
+        add_item(dl, Draw_Item::Kind::RULE, block.x, yy, block.w - block.x, 0);
 
-            if (block->bgcolor != bgcolor_)
-            {
-              fl_color(block->bgcolor);
-              fl_rectf(tx, ty, tw, th);
-              fl_color(textcolor_);
-            }
+        if (line < 31)
+          line ++;
+        xx = block.line[line];
+        yy += 2 * fsize;//hh;
+        hh = 0;
+      }
+      else if (buf.cmp("CENTER") ||
+               buf.cmp("P") ||
+               buf.cmp("H1") ||
+               buf.cmp("H2") ||
+               buf.cmp("H3") ||
+               buf.cmp("H4") ||
+               buf.cmp("H5") ||
+               buf.cmp("H6") ||
+               buf.cmp("UL") ||
+               buf.cmp("OL") ||
+               buf.cmp("DL") ||
+               buf.cmp("LI") ||
+               buf.cmp("DD") ||
+               buf.cmp("DT") ||
+               buf.cmp("PRE"))
+      {
+        if (tolower(buf[0]) == 'h')
+        {
+          font  = FL_HELVETICA_BOLD;
+          fsize = textsize_ + '7' - buf[1];
+        }
+        else if (buf.cmp("DT"))
+        {
+          font  = textfont_ | FL_ITALIC;
+          fsize = textsize_;
+        }
+        else if (buf.cmp("PRE"))
+        {
+          font  = FL_COURIER;
+          fsize = textsize_;
+          pre   = 1;
+        }
 
-            if (block->border)
-              fl_rect(tx, ty, tw, th);
+        if (buf.cmp("LI"))
+        {
+          if (block.ol) {
+            char buf[10];
+            snprintf(buf, sizeof(buf), "%d. ", block.ol_num);
+            add_text(dl, buf, xx - (int)fl_width(buf), yy, pos);
           }
-          else if (buf.cmp("I") ||
-                   buf.cmp("EM"))
-            pushfont(font |= FL_ITALIC, fsize);
-          else if (buf.cmp("CODE") ||
-                   buf.cmp("TT"))
-            pushfont(font = FL_COURIER, fsize);
-          else if (buf.cmp("KBD"))
-            pushfont(font = FL_COURIER_BOLD, fsize);
-          else if (buf.cmp("VAR"))
-            pushfont(font = FL_COURIER_ITALIC, fsize);
-          else if (buf.cmp("/HEAD"))
-            head = 0;
-          else if (buf.cmp("/H1") ||
-                   buf.cmp("/H2") ||
-                   buf.cmp("/H3") ||
-                   buf.cmp("/H4") ||
-                   buf.cmp("/H5") ||
-                   buf.cmp("/H6") ||
-                   buf.cmp("/B") ||
-                   buf.cmp("/STRONG") ||
-                   buf.cmp("/I") ||
-                   buf.cmp("/EM") ||
-                   buf.cmp("/CODE") ||
-                   buf.cmp("/TT") ||
-                   buf.cmp("/KBD") ||
-                   buf.cmp("/VAR"))
-            popfont(font, fsize, fcolor);
-          else if (buf.cmp("/PRE"))
-          {
-            popfont(font, fsize, fcolor);
-            pre = 0;
+          else {
+            // draw bullet (&bull;) Unicode: U+2022, UTF-8 (hex): e2 80 a2
+            unsigned char bullet[4] = { 0xe2, 0x80, 0xa2, 0x00 };
+            add_text(dl, (char *)bullet, xx - fsize, yy, pos);
           }
-          else if (buf.cmp("IMG"))
-          {
-            Fl_Shared_Image *img = 0;
-            int         width, height;
-            char        wattr[8], hattr[8];
+        }
 
+        pushfont(font, fsize);
+        buf.clear();
+      }
+      else if (buf.cmp("A") &&
+               get_attr(attrs, "HREF", attr, sizeof(attr)) != nullptr)
+      {
+        fl_color(linkcolor_);
+        underline = 1;
+      }
+      else if (buf.cmp("/A"))
+      {
+        fl_color(textcolor_);
+        underline = 0;
+      }
+      else if (buf.cmp("FONT"))
+      {
+        if (get_attr(attrs, "COLOR", attr, sizeof(attr)) != nullptr) {
+          textcolor_ = get_color(attr, textcolor_);
+        }
 
-            get_attr(attrs, "WIDTH", wattr, sizeof(wattr));
-            get_attr(attrs, "HEIGHT", hattr, sizeof(hattr));
-            width  = get_length(wattr);
-            height = get_length(hattr);
+        if (get_attr(attrs, "FACE", attr, sizeof(attr)) != nullptr) {
+          if (!strncasecmp(attr, "helvetica", 9) ||
+              !strncasecmp(attr, "arial", 5) ||
+              !strncasecmp(attr, "sans", 4)) font = FL_HELVETICA;
+          else if (!strncasecmp(attr, "times", 5) ||
+                   !strncasecmp(attr, "serif", 5)) font = FL_TIMES;
+          else if (!strncasecmp(attr, "symbol", 6)) font = FL_SYMBOL;
+          else font = FL_COURIER;
+        }
 
-            if (get_attr(attrs, "SRC", attr, sizeof(attr))) {
-              img = get_image(attr, width, height);
-              if (!width) width = img->w();
-              if (!height) height = img->h();
-            }
+        if (get_attr(attrs, "SIZE", attr, sizeof(attr)) != nullptr) {
+          if (isdigit(attr[0] & 255)) {
+            // Absolute size
+            fsize = (int)(textsize_ * pow(1.2, atof(attr) - 3.0));
+          } else {
+            // Relative size
+            fsize = (int)(fsize * pow(1.2, atof(attr) - 3.0));
+          }
+        }
 
-            if (!width || !height) {
-              if (get_attr(attrs, "ALT", attr, sizeof(attr)) == nullptr) {
-                strcpy(attr, "IMG");
-              }
-            }
+        pushfont(font, fsize);
+      }
+      else if (buf.cmp("/FONT"))
+      {
+        popfont(font, fsize, textcolor_);
+      }
+      else if (buf.cmp("U"))
+        underline = 1;
+      else if (buf.cmp("/U"))
+        underline = 0;
+      else if (buf.cmp("B") ||
+               buf.cmp("STRONG"))
+        pushfont(font |= FL_BOLD, fsize);
+      else if (buf.cmp("TD") ||
+               buf.cmp("TH"))
+      {
+        if (tolower(buf[1]) == 'h')
+          pushfont(font |= FL_BOLD, fsize);
+        else
+          pushfont(font = textfont_, fsize);
+
+        // The cell is clipped against the top left corner of the view
+        // when it is drawn, see draw_item().
+        Draw_Item &cell = add_item(dl, Draw_Item::Kind::CELL,
+                                   block.x - 4, block.y - fsize - 3,
+                                   block.w - block.x + 7, block.h + fsize - 5);
+        cell.bgcolor = block.bgcolor;
+        cell.border  = block.border;
+      }
+      else if (buf.cmp("I") ||
+               buf.cmp("EM"))
+        pushfont(font |= FL_ITALIC, fsize);
+      else if (buf.cmp("CODE") ||
+               buf.cmp("TT"))
+        pushfont(font = FL_COURIER, fsize);
+      else if (buf.cmp("KBD"))
+        pushfont(font = FL_COURIER_BOLD, fsize);
+      else if (buf.cmp("VAR"))
+        pushfont(font = FL_COURIER_ITALIC, fsize);
+      else if (buf.cmp("/HEAD"))
+        head = 0;
+      else if (buf.cmp("/H1") ||
+               buf.cmp("/H2") ||
+               buf.cmp("/H3") ||
+               buf.cmp("/H4") ||
+               buf.cmp("/H5") ||
+               buf.cmp("/H6") ||
+               buf.cmp("/B") ||
+               buf.cmp("/STRONG") ||
+               buf.cmp("/I") ||
+               buf.cmp("/EM") ||
+               buf.cmp("/CODE") ||
+               buf.cmp("/TT") ||
+               buf.cmp("/KBD") ||
+               buf.cmp("/VAR"))
+        popfont(font, fsize, fcolor);
+      else if (buf.cmp("/PRE"))
+      {
+        popfont(font, fsize, fcolor);
+        pre = 0;
+      }
+      else if (buf.cmp("IMG"))
+      {
+        Fl_Shared_Image *img = 0;
+        int         width, height;
+        char        wattr[8], hattr[8];
 
-            ww = width;
 
-            if (needspace && xx > block->x)
-              xx += (int)fl_width(' ');
+        get_attr(attrs, "WIDTH", wattr, sizeof(wattr));
+        get_attr(attrs, "HEIGHT", hattr, sizeof(hattr));
+        width  = get_length(wattr);
+        height = get_length(hattr);
 
-            if ((xx + ww) > block->w)
-            {
-              if (line < 31)
-                line ++;
+        if (get_attr(attrs, "SRC", attr, sizeof(attr))) {
+          img = get_image(attr, width, height);
+          if (img && !width) width = img->w();
+          if (img && !height) height = img->h();
+        }
 
-              xx = block->line[line];
-              yy += hh;
-              hh = 0;
-            }
+        if (!width || !height) {
+          if (get_attr(attrs, "ALT", attr, sizeof(attr)) == nullptr) {
+            strcpy(attr, "IMG");
+          }
+        }
 
-            if (img) {
-              img->draw(xx + view.x() - leftline_,
-                        yy + view.y() - fl_height() + fl_descent() + 2);
-            }
+        ww = width;
 
-            xx += ww;
-            if ((height + 2) > hh)
-              hh = height + 2;
+        if (needspace && xx > block.x)
+          xx += (int)fl_width(' ');
 
-            needspace = 0;
-          }
-          buf.clear();
-        }
-        else if (*ptr == '\n' && pre)
+        if ((xx + ww) > block.w)
         {
-          hv_draw(buf.c_str(), xx + view.x() - leftline_, yy + view.y());
-          buf.clear();
-
           if (line < 31)
             line ++;
-          xx = block->line[line];
-          yy += hh;
-          hh = fsize + 2;
-          needspace = 0;
 
-          ptr ++;
-          current_pos_ = (int) (ptr-value_);
+          xx = block.line[line];
+          yy += hh;
+          hh = 0;
         }
-        else if (fl_ascii_isspace(*ptr))
-        {
-          if (pre)
-          {
-            if (*ptr == ' ')
-              buf += ' ';
-            else
-            {
-              // Do tabs every 8 columns...
-              buf += ' '; // at least one space
-              while (buf.size() & 7)
-                buf += ' ';
-            }
-          }
 
-          ptr ++;
-          if (!pre) current_pos_ = (int) (ptr-value_);
-          needspace = 1;
+        if (img) {
+          Draw_Item &item = add_item(dl, Draw_Item::Kind::IMAGE,
+                                     xx, yy - fl_height() + fl_descent() + 2,
+                                     img->w(), img->h());
+          item.img = img;
         }
-        else if (*ptr == '&') // process html entity
-        {
-          ptr ++;
 
-          int qch = quote_char(ptr);
+        xx += ww;
+        if ((height + 2) > hh)
+          hh = height + 2;
 
-          if (qch < 0)
-            buf += '&';
-          else {
-            size_t utf8l = buf.size();
-            buf.add(qch);
-            utf8l = buf.size() - utf8l; // length of added UTF-8 text
-            const char *oldptr = ptr;
-            ptr = strchr(ptr, ';') + 1;
-            entity_extra_length += int(ptr - (oldptr-1)) - utf8l; // extra length between html entity and UTF-8
-          }
+        needspace = 0;
+      }
+      buf.clear();
+    }
+    else if (*ptr == '\n' && pre)
+    {
+      add_text(dl, buf.c_str(), xx, yy, pos);
+      buf.clear();
 
-          if ((fsize + 2) > hh)
-            hh = fsize + 2;
-        }
+      if (line < 31)
+        line ++;
+      xx = block.line[line];
+      yy += hh;
+      hh = fsize + 2;
+      needspace = 0;
+
+      ptr ++;
+      pos = (int) (ptr-value_);
+    }
+    else if (fl_ascii_isspace(*ptr))
+    {
+      if (pre)
+      {
+        if (*ptr == ' ')
+          buf += ' ';
         else
         {
-          buf += *ptr++;
-
-          if ((fsize + 2) > hh)
-            hh = fsize + 2;
+          // Do tabs every 8 columns...
+          buf += ' '; // at least one space
+          while (buf.size() & 7)
+            buf += ' ';
         }
       }
 
-      if (buf.size() > 0 && !pre && !head)
-      {
-        ww = buf.width();
+      ptr ++;
+      if (!pre) pos = (int) (ptr-value_);
+      needspace = 1;
+    }
+    else if (*ptr == '&') // process html entity
+    {
+      ptr ++;
 
-        if (needspace && xx > block->x)
-          xx += (int)fl_width(' ');
+      int qch = quote_char(ptr);
 
-        if ((xx + ww) > block->w)
-        {
-          if (line < 31)
-            line ++;
-          xx = block->line[line];
-          yy += hh;
-          hh = 0;
-        }
+      if (qch < 0)
+        buf += '&';
+      else {
+        size_t utf8l = buf.size();
+        buf.add(qch);
+        utf8l = buf.size() - utf8l; // length of added UTF-8 text
+        const char *oldptr = ptr;
+        ptr = strchr(ptr, ';') + 1;
+        entity_extra_length += int(ptr - (oldptr-1)) - utf8l; // extra length between html entity and UTF-8
       }
 
-      if (buf.size() > 0 && !head)
-      {
-        hv_draw(buf.c_str(), xx + view.x() - leftline_, yy + view.y());
-        if (underline) fl_xyline(xx + view.x() - leftline_, yy + view.y() + 1,
-                                 xx + view.x() - leftline_ + ww);
-        current_pos_ = (int) (ptr-value_);
+      if ((fsize + 2) > hh)
+        hh = fsize + 2;
+    }
+    else
+    {
+      buf += *ptr++;
+
+      if ((fsize + 2) > hh)
+        hh = fsize + 2;
+    }
+  }
+
+  if (buf.size() > 0 && !pre && !head)
+  {
+    ww = buf.width();
+
+    if (needspace && xx > block.x)
+      xx += (int)fl_width(' ');
+
+    if ((xx + ww) > block.w)
+    {
+      if (line < 31)
+        line ++;
+      xx = block.line[line];
+      yy += hh;
+      hh = 0;
+    }
+  }
+
+  if (buf.size() > 0 && !head)
+  {
+    add_text(dl, buf.c_str(), xx, yy, pos);
+    if (underline) add_item(dl, Draw_Item::Kind::LINE, xx, yy + 1, ww, 0);
+  }
+} // build_display_list()
+
+
+/**
+  \brief Draws one item of a display list.
+
+  Text that is inside the current selection is drawn with the selection
+  colors that were set up by draw().
+
+  \param[in] dl the display list that contains the item
+  \param[in] item the item to draw
+ */
+void Fl_Help_View::Impl::draw_item(const Display_List &dl, const Draw_Item &item)
+{
+  int xx = item.x + view.x() - leftline_;
+  int yy = item.y + view.y() - topline_;
+
+  switch (item.kind) {
+    case Draw_Item::Kind::TEXT:
+      fl_font(item.font, item.size);
+      if (selected_ && item.pos<selection_last_ && item.pos>=selection_first_) {
+        int w = item.w;
+        if (item.pos+item.len<selection_last_)
+          w += item.space;
+        fl_color(tmp_selection_color_);
+        fl_rectf(xx, yy+item.descent-item.h, w, item.h);
+        fl_color(selection_text_color_);
+      } else {
+        fl_color(item.color);
+      }
+      fl_draw(dl.text.c_str() + item.text, item.len, xx, yy);
+      break;
+    case Draw_Item::Kind::LINE:
+      fl_color(item.color);
+      fl_xyline(xx, yy, xx + item.w);
+      break;
+    case Draw_Item::Kind::RULE:
+      // Horizontal rules are not scrolled horizontally
+      fl_color(item.color);
+      fl_line(item.x + view.x(), yy, item.x + item.w + view.x(), yy);
+      break;
+    case Draw_Item::Kind::CELL: {
+      int tw = item.w, th = item.h;
+      xx = item.x - leftline_;
+      yy = item.y - topline_;
+      if (xx < 0) {
+        tw += xx;
+        xx  = 0;
+      }
+      if (yy < 0) {
+        th += yy;
+        yy  = 0;
+      }
+      xx += view.x();
+      yy += view.y();
+      if (item.bgcolor != bgcolor_) {
+        fl_color(item.bgcolor);
+        fl_rectf(xx, yy, tw, th);
       }
+      fl_color(item.color);
+      if (item.border)
+        fl_rect(xx, yy, tw, th);
+      break; }
+    case Draw_Item::Kind::IMAGE:
+      item.img->draw(xx, yy);
+      break;
+  }
+}
+
+
+// ------ Fl_Help_View Protected and Public methods
+
+// ---- Widget management
+
+/**
+  \brief Draws the Fl_Help_View widget.
+*/
+void Fl_Help_View::draw() {
+  impl_->draw();
+}
+
+/**
+  \brief Draws the Fl_Help_View widget.
+  \see Fl_Help_View::draw()
+ */
+void Fl_Help_View::Impl::draw()
+{
+  int                   i;              // Looping var
+  int                   ww, hh;         // Current sizes
+  Fl_Boxtype            b = view.box() ? view.box() : FL_DOWN_BOX;
+                                        // Box to draw...
+
+  DEBUG_FUNCTION(__LINE__,__FUNCTION__);
+
+  // Draw the scrollbar(s) and box first...
+  ww = view.w();
+  hh = view.h();
+  i  = 0;
+
+  view.draw_box(b, view.x(), view.y(), ww, hh, bgcolor_);
+
+  if ( view.hscrollbar_.visible() || view.scrollbar_.visible() ) {
+    int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
+    int hor_vis = view.hscrollbar_.visible();
+    int ver_vis = view.scrollbar_.visible();
+    // Scrollbar corner
+    int scorn_x = view.x() + ww - (ver_vis?scrollsize:0) - Fl::box_dw(b) + Fl::box_dx(b);
+    int scorn_y = view.y() + hh - (hor_vis?scrollsize:0) - Fl::box_dh(b) + Fl::box_dy(b);
+    if ( hor_vis ) {
+      if ( view.hscrollbar_.h() != scrollsize ) {            // scrollsize changed?
+        view.hscrollbar_.resize(view.x(), scorn_y, scorn_x - view.x(), scrollsize);
+        view.init_sizes();
+      }
+      view.draw_child(view.hscrollbar_);
+      hh -= scrollsize;
     }
+    if ( ver_vis ) {
+      if ( view.scrollbar_.w() != scrollsize ) {             // scrollsize changed?
+        view.scrollbar_.resize(scorn_x, view.y(), scrollsize, scorn_y - view.y());
+        view.init_sizes();
+      }
+      view.draw_child(view.scrollbar_);
+      ww -= scrollsize;
+    }
+    if ( hor_vis && ver_vis ) {
+      // Both scrollbars visible? Draw little gray box in corner
+      fl_color(FL_GRAY);
+      fl_rectf(scorn_x, scorn_y, scrollsize, scrollsize);
+    }
+  }
+
+  if (!value_)
+    return;
+
+  if (selected_) {
+    if (Fl::focus() == &view) {
+      // If this widget has the focus, we use the selection color directly
+      tmp_selection_color_ = view.selection_color();
+    } else {
+      // Otherwise we blend the selection color with the background color
+      tmp_selection_color_ = fl_color_average(bgcolor_, view.selection_color(), 0.8f);
+    }
+    selection_text_color_ = fl_contrast(textcolor_, tmp_selection_color_);
+  }
+
+  // Clip the drawing to the inside of the box...
+  fl_push_clip(view.x() + Fl::box_dx(b), view.y() + Fl::box_dy(b),
+               ww - Fl::box_dw(b), hh - Fl::box_dh(b));
+
+  // Draw all visible blocks...
+  for (i = 0; i < (int)blocks_.size(); i ++) {
+    const Text_Block &block = blocks_[i];
+    if ((block.y + block.h) < topline_ || block.y >= (topline_ + view.h()))
+      continue;
+    const Display_List &dl = display_list(i);
+    for (const Draw_Item &item : dl.items) {
+      // Skip text and images that are above or below the view, this
+      // matters for long <PRE> blocks
+      if (item.kind == Draw_Item::Kind::TEXT &&
+          (item.y + item.descent < topline_ || item.y - item.h >= topline_ + hh))
+        continue;
+      if (item.kind == Draw_Item::Kind::IMAGE &&
+          (item.y + item.h < topline_ || item.y >= topline_ + hh))
+        continue;
+      draw_item(dl, item);
+    }
+  }
 
   fl_pop_clip();
 } // draw()
@@ -3611,13 +4166,6 @@ int Fl_Help_View::find(const char *s, int p) {
  */
 int Fl_Help_View::Impl::find(const char *s, int p)
 {
-  int           i,                              // Looping var
-                c;                              // Current character
-  Text_Block *b;                             // Current block
-  const char    *bp,                            // Block matching pointer
-                *bs,                            // Start of current comparison
-                *sp;                            // Search string pointer
-
   DEBUG_FUNCTION(__LINE__,__FUNCTION__);
 
   // Range check input and value...
@@ -3625,21 +4173,65 @@ int Fl_Help_View::Impl::find(const char *s, int p)
 
   if (p < 0 || p >= (int)strlen(value_)) p = 0;
 
-  // Look for the string...
-  for (i = (int)blocks_.size(), b = &blocks_[0]; i > 0; i--, b++) {
-    if (b->end < (value_ + p))
-      continue;
+  finish_format();
+  if (!search_index_.valid)
+    build_search_index();
 
-    if (b->start < (value_ + p))
-      bp = value_ + p;
-    else
-      bp = b->start;
+  // Case insensitive match for ASCII, binary match for everything else
+  std::string needle = s;
+  for (char &c : needle) {
+    if (c > 0x20 && c < 0x7f) c = tolower(c);
+  }
 
-    bp = vanilla(bp, b->end);
-    if (bp == b->end)
-      continue;
+  const std::string &text = search_index_.text;
+  const std::vector<int> &block_start = search_index_.block_start;
+  size_t pos = search_index_.to_text(p);
+  for (;;) {
+    pos = text.find(needle, pos);
+    if (pos == std::string::npos)
+      break;
+    // Matches must not extend beyond the end of a block
+    int i = int(std::upper_bound(block_start.begin(), block_start.end(), (int)pos) - block_start.begin()) - 1;
+    if (i < 0)
+      break;
+    size_t end = (i + 1 < (int)block_start.size()) ? block_start[i + 1] : text.size();
+    if (pos + needle.size() <= end && (pos < end || needle.empty())) {
+      // Found a match!
+      const Text_Block *b = &blocks_[i];
+      topline(b->y - b->h);
+      return search_index_.to_value((int)pos);
+    }
+    pos ++;
+  }
+
+  // No match!
+  return (-1);
+}
 
-    for (sp = s, bs = bp; *sp && *bp && bp < b->end; ) {
+
+/**
+  \brief Builds the plain text of all blocks for find().
+
+  Tags are removed, HTML entities are converted to UTF-8, newlines are
+  converted to spaces, and ASCII characters are converted to lowercase.
+  The index remembers where each block starts and how to map offsets in
+  the plain text back to offsets in value_.
+ */
+void Fl_Help_View::Impl::build_search_index()
+{
+  Search_Index &si = search_index_;
+  char          cbuf[6];                // UTF-8 encoded character
+  int           next = 0;               // Offset in value_ that follows the previous character
+
+  si.clear();
+  si.valid = true;
+
+  for (const Text_Block &b : blocks_) {
+    si.block_start.push_back((int)si.text.size());
+    const char *bp = vanilla(b.start, b.end);
+    while (bp < b.end) {
+      const char *np = bp + 1;          // Next character in value_
+      int c;                            // Current character
       bool is_html_entity = false;
       if (*bp == '&') {
         // decode HTML entity...
@@ -3649,58 +4241,74 @@ int Fl_Help_View::Impl::find(const char *s, int p)
           const char *entity_end = strchr(bp + 1, ';');
           if (entity_end) {
             is_html_entity = true; // c contains the unicode character
-            bp = entity_end;
+            np = entity_end + 1;
           } else {
             c = '&';
           }
         }
       } else {
-        c = *bp;
+        c = (uchar)*bp;
       }
 
       if (c == '\n') c = ' '; // treat newline as a single space
+      if (c > 0x20 && c < 0x80) c = tolower(c);
 
-      // *FIXME* *UTF-8* (A.S. 02/14/2016)
-      // At this point c may be an arbitrary Unicode Code Point corresponding
-      // to a quoted character (see above), i.e. it _can_ be a multi byte
-      // UTF-8 sequence and must be compared with the corresponding
-      // multi byte string in (*sp)...
-      // For instance: "&euro;" == 0x20ac -> 0xe2 0x82 0xac (UTF-8: 3 bytes).
-      // Hint: use fl_utf8encode() [see below]
-
-      int utf_len = 1;
-      if (c > 0x20 && c < 0x80 && tolower(*sp) == tolower(c)) {
-        // Check for ASCII case insensitive match.
-        //printf("%ld text match %c/%c\n", bp-value_, *sp, c);
-        sp++;
-        bp = vanilla(bp+1, b->end);
-      } else if (is_html_entity && fl_utf8decode(sp, nullptr, &utf_len) == (unsigned int)c ) {
-        // Check if a &lt; entity ini html matches a UTF-8 character in the
-        // search string.
-        //printf("%ld unicode match 0x%02X 0x%02X\n", bp-value_, *sp, c);
-        sp += utf_len;
-        bp = vanilla(bp+1, b->end);
-      } else if (*sp == c) {
-        // Check if UTF-8 bytes in html and the search string match.
-        //printf("%ld binary match %c/%c\n", bp-value_, *sp, c);
-        sp++;
-        bp = vanilla(bp+1, b->end);
-      } else {
-        // No match, so reset to start of search... .
-        //printf("reset search (%c/%c)\n", *sp, c);
-        sp = s;
-        bp = bs = vanilla(bs+1, b->end);
-      }
-    }
+      // Add a map entry if this character is not right after the previous one
+      int tpos = (int)si.text.size(), vpos = int(bp - value_);
+      if (vpos != next)
+        si.map.push_back(std::make_pair(tpos, vpos));
 
-    if (!*sp) { // Found a match!
-      topline(b->y - b->h);
-      return int(bs - value_);
+      if (is_html_entity && c >= 0x80)
+        si.text.append(cbuf, fl_utf8encode(c, cbuf));
+      else
+        si.text += (char)c;
+      next = vpos + int(si.text.size() - tpos);
+
+      bp = vanilla(np, b.end);
     }
   }
+}
 
-  // No match!
-  return (-1);
+
+/** Clears the search index. */
+void Fl_Help_View::Impl::Search_Index::clear()
+{
+  valid = false;
+  text.clear();
+  block_start.clear();
+  map.clear();
+}
+
+
+/**
+  \brief Converts an offset in the plain text to an offset in value_.
+  \param[in] pos offset in the plain text
+  \return offset in value_
+ */
+int Fl_Help_View::Impl::Search_Index::to_value(int pos) const
+{
+  auto it = std::upper_bound(map.begin(), map.end(), std::make_pair(pos, INT_MAX));
+  if (it == map.begin()) return pos;
+  --it;
+  return it->second + (pos - it->first);
+}
+
+
+/**
+  \brief Returns the first offset in the plain text at or after an offset in value_.
+  \param[in] pos offset in value_
+  \return offset in the plain text
+ */
+int Fl_Help_View::Impl::Search_Index::to_text(int pos) const
+{
+  // The map is sorted by both, the text and the value_ offsets
+  auto it = std::upper_bound(map.begin(), map.end(), pos,
+    [](int v, const std::pair<int, int> &e) { return v < e.second; });
+  if (it == map.begin())
+    return std::min(pos, (int)text.size());
+  int next = (it == map.end()) ? (int)text.size() : it->first;
+  --it;
+  return std::min(it->first + (pos - it->second), next);
 }
 
 
@@ -3832,6 +4440,11 @@ void Fl_Help_View::Impl::topline(const char *anchor)
 {
   std::string target_name = to_lower(anchor); // Convert to lower case
   auto tl = target_line_map_.find(target_name);
+  if (tl == target_line_map_.end() && format_state_) {
+    // The target may be in the part that is not formatted yet
+    finish_format();
+    tl = target_line_map_.find(target_name);
+  }
   if (tl != target_line_map_.end()) {
     // Found the target name, scroll to the line
     topline(tl->second);
@@ -4404,7 +5017,8 @@ static size_t url_scheme(const std::string &url, bool skip_slashes)
 /** Return a pointer to the internal text buffer. */
 const char *Fl_Help_View::value() const { return impl_->value(); }
 
-/** Return the document height in pixels. */
+/** Return the document height in pixels.
+  While a large document is still formatted in the background, this is an estimate. */
 int Fl_Help_View::size() const { return impl_->size(); }
 
 /** Set the default text color. */
@@ -21,6 +21,7 @@
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Image.H>
 #include "flstring.h"
+#include "Fl_Pixel_Ops.H"
 
 #include <stdlib.h>
 
@@ -430,6 +431,7 @@ Fl_RGB_Image::Fl_RGB_Image(const uchar *bits, int bits_length, int W, int H, int
 
   The RGBA image is built fully opaque except for the transparent area
   of the pixmap that is assigned the \p bg color with full transparency.
+  This also works for an Fl_GIF_Image that stores pixels rather than XPM data.
 
   This constructor creates a new internal data array and sets
   Fl_RGB_Image::alloc_array to 1 so the data array is deleted when the
@@ -446,7 +448,22 @@ Fl_RGB_Image::Fl_RGB_Image(const Fl_Pixmap *pxm, Fl_Color bg):
   if (pxm && pxm->data_w() > 0 && pxm->data_h() > 0) {
     array = new uchar[data_w() * data_h() * d()];
     alloc_array = 1;
-    fl_convert_pixmap(pxm->data(), (uchar*)array, bg);
+    if (pxm->count() == 1 && pxm->d() > 0) {
+      // not XPM data but pixels, e.g. an Fl_GIF_Image
+      const uchar *from = (const uchar *)pxm->data()[0];
+      uchar *to = (uchar *)array;
+      uchar bgr, bgg, bgb;
+      Fl::get_color(bg, bgr, bgg, bgb);
+      int pd = pxm->d(), n = data_w() * data_h();
+      for (int i = 0; i < n; i++, from += pd, to += 4) {
+        if (pd < 3) to[0] = to[1] = to[2] = from[0];
+        else { to[0] = from[0]; to[1] = from[1]; to[2] = from[2]; }
+        to[3] = (pd == 2 || pd == 4) ? from[pd - 1] : 255;
+        if (!to[3]) { to[0] = bgr; to[1] = bgg; to[2] = bgb; }
+      }
+    } else {
+      fl_convert_pixmap(pxm->data(), (uchar*)array, bg);
+    }
   }
   data((const char **)&array, 1);
   scale(pxm->w(), pxm->h(), 0, 1);
@@ -775,47 +792,23 @@ void Fl_RGB_Image::color_average(Fl_Color c, float i) {
   uncache();
 
   // Allocate memory as needed...
-  uchar         *new_array,
-                *new_ptr;
+  uchar         *new_array;
 
   if (!alloc_array) new_array = new uchar[data_h() * data_w() * d()];
   else new_array = (uchar *)array;
 
   // Get the color to blend with...
   uchar         r, g, b;
-  unsigned      ia, ir, ig, ib;
-
   Fl::get_color(c, r, g, b);
   if (i < 0.0f) i = 0.0f;
   else if (i > 1.0f) i = 1.0f;
 
-  ia = (unsigned)(256 * i);
-  ir = r * (256 - ia);
-  ig = g * (256 - ia);
-  ib = b * (256 - ia);
-
   // Update the image data to do the blend...
-  const uchar   *old_ptr;
-  int           x, y;
-  int   line_i = ld() ? ld() - (data_w()*d()) : 0; // increment from line end to beginning of next line
-
-  if (d() < 3) {
-    ig = (r * 31 + g * 61 + b * 8) / 100 * (256 - ia);
-
-    for (new_ptr = new_array, old_ptr = array, y = 0; y < data_h(); y ++, old_ptr += line_i)
-      for (x = 0; x < data_w(); x ++) {
-        *new_ptr++ = (*old_ptr++ * ia + ig) >> 8;
-        if (d() > 1) *new_ptr++ = *old_ptr++;
-      }
-  } else {
-    for (new_ptr = new_array, old_ptr = array, y = 0; y < data_h(); y ++, old_ptr += line_i)
-      for (x = 0; x < data_w(); x ++) {
-        *new_ptr++ = (*old_ptr++ * ia + ir) >> 8;
-        *new_ptr++ = (*old_ptr++ * ia + ig) >> 8;
-        *new_ptr++ = (*old_ptr++ * ia + ib) >> 8;
-        if (d() > 3) *new_ptr++ = *old_ptr++;
-      }
-  }
+  int line_d = data_w() * d();
+  int line_i = ld() ? ld() : line_d;
+  for (int y = 0; y < data_h(); y ++)
+    Fl_Pixel_Ops::color_average(array + y * line_i, new_array + y * line_d, data_w(), d(),
+                                r, g, b, (unsigned)(256 * i));
 
   // Set the new pointers/values as needed...
   if (!alloc_array) {
@@ -837,23 +830,16 @@ void Fl_RGB_Image::desaturate() {
   uncache();
 
   // Allocate memory for a grayscale image...
-  uchar         *new_array,
-                *new_ptr;
+  uchar         *new_array;
   int           new_d;
 
   new_d     = d() - 2;
   new_array = new uchar[data_h() * data_w() * new_d];
 
   // Copy the image data, converting to grayscale...
-  const uchar   *old_ptr;
-  int           x, y;
-  int   line_i = ld() ? ld() - (data_w()*d()) : 0; // increment from line end to beginning of next line
-
-  for (new_ptr = new_array, old_ptr = array, y = 0; y < data_h(); y ++, old_ptr += line_i)
-    for (x = 0; x < data_w(); x ++, old_ptr += d()) {
-      *new_ptr++ = (uchar)((31 * old_ptr[0] + 61 * old_ptr[1] + 8 * old_ptr[2]) / 100);
-      if (d() > 3) *new_ptr++ = old_ptr[3];
-    }
+  int line_i = ld() ? ld() : data_w() * d();
+  for (int y = 0; y < data_h(); y ++)
+    Fl_Pixel_Ops::gray(array + y * line_i, new_array + y * data_w() * new_d, data_w(), d());
 
   // Free the old array as needed, and then set the new pointers/values...
   if (alloc_array) delete[] (uchar *)array;
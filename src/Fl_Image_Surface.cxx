@@ -15,6 +15,8 @@
 //
 
 #include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Overlay_Window.H>
+#include "Fl_Recording_Graphics_Driver.H"
 
 #include <FL/fl_draw.H> // necessary for FL_EXPORT fl_*_offscreen()
 
@@ -36,6 +38,8 @@
  \version 1.3.4 (1.3.3 without the \p highres parameter)
  */
 Fl_Image_Surface::Fl_Image_Surface(int w, int h, int high_res, Fl_Offscreen off) : Fl_Widget_Surface(NULL) {
+  tile_threads_ = 1;
+  tile_size_ = 512;
   platform_surface = Fl_Image_Surface_Driver::newImageSurfaceDriver(w, h, high_res, off);
   platform_surface->image_surface_ = this;
   driver(platform_surface->driver());
@@ -262,6 +266,97 @@ void Fl_Image_Surface::mask(const Fl_RGB_Image *mask) {
 }
 
 
+/** Sets how many threads draw widgets in the image surface.
+ With more than one thread, Fl_Widget_Surface::draw() records the drawing
+ of the widget, splits the surface in square tiles, and the threads draw the
+ recorded operations in separate tiles at the same time. The result is the
+ same as drawing the widget directly, but large surfaces are drawn faster on
+ multi-core machines.
+
+ Tiled drawing is only used with the Cairo-based graphics drivers (Wayland,
+ and X11 with Cairo), and with widgets whose drawing can be recorded (see
+ Fl_Widget::retained_drawing()): as soon as a widget draws an image, the
+ remainder of its drawing is done directly by a single thread.
+ Text is drawn by one thread at a time.
+ \param[in] threads number of threads, 1 (the default) doesn't use tiles,
+ 0 uses one thread per processor
+ \param[in] tile_size width and height of the tiles, in pixels
+ \version 1.5
+ */
+void Fl_Image_Surface::tiled_drawing(int threads, int tile_size) {
+  tile_threads_ = threads < 0 ? 1 : threads;
+  tile_size_ = tile_size < 16 ? 16 : tile_size;
+}
+
+
+static bool has_subwindow(Fl_Widget *widget) {
+  Fl_Group *g = widget->as_group();
+  if (!g) return false;
+  for (int i = 0; i < g->children(); i++) {
+    Fl_Widget *c = g->child(i);
+    if (c->visible() && (c->as_window() || has_subwindow(c))) return true;
+  }
+  return false;
+}
+
+
+/** Draws a widget in tiles with several threads if set by tiled_drawing(int, int).
+ Called by Fl_Widget_Surface::draw(), returns false to let it draw the widget
+ with a single thread, also if a child changed the drawing surface while the
+ widget was recorded.
+ */
+bool Fl_Image_Surface::draw_widget_(Fl_Widget *widget, int delta_x, int delta_y) {
+  int w, h, X, Y, W, H;
+  printable_rect(&w, &h);
+  if (tile_threads_ == 1 || !widget->visible() || !is_current() ||
+      !platform_surface->can_draw_tiled() || widget->as_gl_window() ||
+      has_subwindow(widget) || fl_clip_box(0, 0, w, h, X, Y, W, H)) {
+    return false;
+  }
+  bool is_window = (widget->as_window() != NULL);
+  uchar old_damage = widget->damage();
+  widget->damage(FL_DAMAGE_ALL);
+  // set origin to the desired top-left position of the widget
+  if (!is_window) {
+    delta_x -= widget->x();
+    delta_y -= widget->y();
+  }
+  if (delta_x || delta_y) translate(delta_x, delta_y);
+  // record the drawing without drawing it, then draw it in tiles
+  Fl_Graphics_Driver *target = fl_graphics_driver;
+  Fl_Recording_Graphics_Driver *recorder =
+    new Fl_Recording_Graphics_Driver(target, new Fl_Display_List, true);
+  recorder->max_size(64 * 1024 * 1024);
+  fl_graphics_driver = recorder;
+  if (is_window) fl_push_clip(0, 0, widget->w(), widget->h());
+  widget->draw();
+  Fl_Overlay_Window *over = (is_window ? widget->as_window()->as_overlay_window() : NULL);
+  if (over) over->draw_overlay();
+  if (is_window) fl_pop_clip();
+  // a child that pushed and popped a drawing surface, e.g. an offscreen
+  // cached widget, restored the real driver and drew the rest directly:
+  // drop the deferred operations and draw the widget again without tiles
+  bool swapped = (fl_graphics_driver != recorder);
+  Fl_Display_List *list = recorder->finish();
+  fl_graphics_driver = target;
+  delete recorder;
+  if (swapped) {
+    delete list;
+    if (delta_x || delta_y) untranslate();
+    widget->clear_damage(old_damage);
+    return false;
+  }
+  if (list) {
+    if (!platform_surface->draw_tiled(*list, tile_threads_, tile_size_)) list->run(target);
+    delete list;
+  }
+  if (delta_x || delta_y) untranslate();
+  if ((old_damage & FL_DAMAGE_CHILD) == 0) widget->clear_damage(old_damage);
+  else widget->damage(FL_DAMAGE_ALL);
+  return true;
+}
+
+
 // implementation of the fl_XXX_offscreen() functions
 
 static Fl_Image_Surface **offscreen_api_surface = NULL;
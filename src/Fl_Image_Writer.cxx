@@ -0,0 +1,633 @@
+//
+// PNG and JPEG image writer for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <config.h>
+#include <FL/Fl_Image_Writer.H>
+#include <FL/Fl_RGB_Image.H>
+#include <FL/fl_string_functions.h>   // fl_strdup()
+#include <FL/fl_utf8.h>               // fl_fopen()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <process.h>                // _beginthreadex()
+#elif HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
+// FIXME: see original commit 2db94dcb4c5bf2ef3fa92f1cd6a41f3f90105361
+// ... about building X11 backend on macOS ≥ 11:
+// "The error happens only if png.h is included without time.h having
+//  been included before. The fix is to #include time.h before png.h.
+//  A better fix than his hack is desirable."
+
+#include <time.h>
+
+// PNG and JPEG library include files
+
+extern "C" {
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+#  include <zlib.h>
+#  ifdef HAVE_PNG_H
+#    include <png.h>
+#  else
+#    include <libpng/png.h>
+#  endif // HAVE_PNG_H
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+#ifdef HAVE_LIBJPEG
+#  include <jpeglib.h>
+#endif // HAVE_LIBJPEG
+} // extern "C"
+
+// Where the encoded image goes
+enum Sink { NO_SINK, FILE_SINK, CALLBACK_SINK, MEMORY_SINK };
+
+#if defined(_WIN32)
+struct Fl_Image_Writer::Thread {
+  HANDLE handle;
+  unsigned id;
+};
+#elif HAVE_PTHREAD
+struct Fl_Image_Writer::Thread {
+  pthread_t id;
+  pthread_mutex_t mutex;
+  int done;
+};
+#else
+struct Fl_Image_Writer::Thread {
+  int unused;
+};
+#endif
+
+#ifdef HAVE_LIBJPEG
+// libjpeg error handler that returns to encode_jpeg_()
+struct Fl_Image_Writer_Jpeg_Error {
+  jpeg_error_mgr pub;
+  jmp_buf jump;
+};
+
+// libjpeg destination manager that sends the image to Fl_Image_Writer::put_()
+struct Fl_Image_Writer_Jpeg_Dest {
+  jpeg_destination_mgr pub;
+  Fl_Image_Writer *writer;
+  JOCTET buffer[16384];
+};
+#endif // HAVE_LIBJPEG
+
+// Library and thread callbacks that need the private methods of the writer
+struct Fl_Image_Writer_Callbacks {
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  static void png_write(png_structp pptr, png_bytep bytes, png_size_t n) {
+    Fl_Image_Writer *w = (Fl_Image_Writer *)png_get_io_ptr(pptr);
+    if (w->put_(bytes, n)) png_error(pptr, "write error");
+  }
+  static void png_flush(png_structp) {}
+  static void png_fail(png_structp pptr, png_const_charp) { png_longjmp(pptr, 1); }
+  static void png_warn(png_structp, png_const_charp) {}
+#endif // HAVE_LIBPNG && HAVE_LIBZ
+#ifdef HAVE_LIBJPEG
+  static void jpeg_fail(j_common_ptr cinfo) {
+    longjmp(((Fl_Image_Writer_Jpeg_Error *)cinfo->err)->jump, 1);
+  }
+  static void jpeg_message(j_common_ptr) {}
+  static void jpeg_init(j_compress_ptr cinfo) {
+    Fl_Image_Writer_Jpeg_Dest *dest = (Fl_Image_Writer_Jpeg_Dest *)cinfo->dest;
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = sizeof(dest->buffer);
+  }
+  static boolean jpeg_empty(j_compress_ptr cinfo) {
+    // the whole buffer must be written, whatever free_in_buffer says
+    Fl_Image_Writer_Jpeg_Dest *dest = (Fl_Image_Writer_Jpeg_Dest *)cinfo->dest;
+    if (dest->writer->put_(dest->buffer, sizeof(dest->buffer)))
+      (*cinfo->err->error_exit)((j_common_ptr)cinfo);
+    jpeg_init(cinfo);
+    return TRUE;
+  }
+  static void jpeg_term(j_compress_ptr cinfo) {
+    Fl_Image_Writer_Jpeg_Dest *dest = (Fl_Image_Writer_Jpeg_Dest *)cinfo->dest;
+    size_t n = sizeof(dest->buffer) - dest->pub.free_in_buffer;
+    if (n && dest->writer->put_(dest->buffer, n))
+      (*cinfo->err->error_exit)((j_common_ptr)cinfo);
+  }
+#endif // HAVE_LIBJPEG
+#if defined(_WIN32)
+  static unsigned __stdcall async_main(void *writer) {
+    ((Fl_Image_Writer *)writer)->run_async_();
+    return 0;
+  }
+#elif HAVE_PTHREAD
+  static void *async_main(void *writer) {
+    ((Fl_Image_Writer *)writer)->run_async_();
+    return NULL;
+  }
+#endif
+};
+
+
+/**
+  Creates a writer for the given image file format, with the default
+  settings and no output.
+  \see output(const char*), output(Output_Cb, void*), output_to_memory()
+*/
+Fl_Image_Writer::Fl_Image_Writer(Format f) {
+  format_ = f;
+  compression_ = -1;
+  filter_ = 0;
+  quality_ = 95;
+  strategy_ = STRATEGY_DEFAULT;
+  sink_ = NO_SINK;
+  filename_ = NULL;
+  output_cb_ = NULL;
+  output_data_ = NULL;
+  buffer_ = NULL;
+  size_ = alloc_ = 0;
+  fp_ = NULL;
+  output_error_ = 0;
+  pixels_ = NULL;
+  w_ = h_ = d_ = ld_ = 0;
+  source_cb_ = NULL;
+  source_data_ = NULL;
+  row_ = pixel_copy_ = NULL;
+  thread_ = NULL;
+  done_cb_ = NULL;
+  done_data_ = NULL;
+  result_ = 0;
+}
+
+
+/** Waits for a running asynchronous write and frees the memory buffer. */
+Fl_Image_Writer::~Fl_Image_Writer() {
+  wait();
+  free(filename_);
+  free(buffer_);
+}
+
+
+/**
+  Makes the next writes create or replace a file.
+  \param[in] filename  name of the file, in UTF-8
+*/
+void Fl_Image_Writer::output(const char *filename) {
+  wait();
+  free(filename_);
+  filename_ = filename ? fl_strdup(filename) : NULL;
+  sink_ = filename ? FILE_SINK : NO_SINK;
+}
+
+
+/**
+  Makes the next writes send the image to a callback, in chunks of a few
+  kilobytes. The callback is called by the thread that encodes the image,
+  which is a worker thread for write_async().
+  \param[in] cb    the callback
+  \param[in] data  user data passed to the callback
+*/
+void Fl_Image_Writer::output(Output_Cb cb, void *data) {
+  wait();
+  output_cb_ = cb;
+  output_data_ = data;
+  sink_ = cb ? CALLBACK_SINK : NO_SINK;
+}
+
+
+/**
+  Makes the next writes store the image in a memory buffer, see buffer()
+  and size(). The buffer grows as needed and is reused by each write,
+  so writing many images of similar size allocates memory only once.
+*/
+void Fl_Image_Writer::output_to_memory() {
+  wait();
+  sink_ = MEMORY_SINK;
+}
+
+
+/**
+  Returns the memory buffer, which the caller must free() after use,
+  and makes the writer allocate a new one for the next write.
+  \see buffer(), size()
+*/
+unsigned char *Fl_Image_Writer::release_buffer() {
+  wait();
+  unsigned char *b = buffer_;
+  buffer_ = NULL;
+  size_ = alloc_ = 0;
+  return b;
+}
+
+
+// Sends encoded bytes to the output, returns non-zero on error
+int Fl_Image_Writer::put_(const unsigned char *bytes, size_t n) {
+  if (output_error_) return output_error_;
+  switch (sink_) {
+    case FILE_SINK:
+      if (fwrite(bytes, 1, n, (FILE *)fp_) != n) output_error_ = -2;
+      break;
+    case CALLBACK_SINK:
+      if (output_cb_(output_data_, bytes, n)) output_error_ = -2;
+      break;
+    case MEMORY_SINK:
+      if (size_ + n > alloc_) {
+        size_t a = alloc_ ? alloc_ * 2 : 65536;
+        while (a < size_ + n) a *= 2;
+        unsigned char *b = (unsigned char *)realloc(buffer_, a);
+        if (!b) { output_error_ = -4; break; }
+        buffer_ = b;
+        alloc_ = a;
+      }
+      memcpy(buffer_ + size_, bytes, n);
+      size_ += n;
+      break;
+  }
+  return output_error_;
+}
+
+
+// Returns row y of the current image
+const unsigned char *Fl_Image_Writer::row_at_(int y) {
+  if (source_cb_) {
+    source_cb_(source_data_, 0, y, w_, row_);
+    return row_;
+  }
+  return pixels_ + (ptrdiff_t)y * ld_;
+}
+
+
+// Encodes the current image to the output, returns what write() returns
+int Fl_Image_Writer::encode_() {
+  if (w_ < 1 || h_ < 1 || d_ < 1 || d_ > 4) return -3;
+  if (sink_ == NO_SINK) return -2;
+#if !(defined(HAVE_LIBPNG) && defined(HAVE_LIBZ))
+  if (format_ == PNG) return -1;
+#endif
+#ifndef HAVE_LIBJPEG
+  if (format_ == JPEG) return -1;
+#endif
+  // a row buffer for Fl_Draw_Image_Cb sources, and to drop the alpha channel
+  int need_row = source_cb_ || (format_ == JPEG && !(d_ & 1));
+  if (need_row && !(row_ = (unsigned char *)malloc((size_t)w_ * d_))) return -4;
+  output_error_ = 0;
+  size_ = 0;
+  if (sink_ == FILE_SINK && !(fp_ = fl_fopen(filename_, "wb"))) {
+    free(row_);
+    row_ = NULL;
+    return -2;
+  }
+  int ret = (format_ == PNG) ? encode_png_() : encode_jpeg_();
+  if (fp_) {
+    if (fclose((FILE *)fp_) && !ret) ret = -2;
+    fp_ = NULL;
+  }
+  free(row_);
+  row_ = NULL;
+  return ret;
+}
+
+
+int Fl_Image_Writer::encode_png_() {
+#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
+  png_structp pptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, this,
+                                             Fl_Image_Writer_Callbacks::png_fail,
+                                             Fl_Image_Writer_Callbacks::png_warn);
+  png_infop iptr = pptr ? png_create_info_struct(pptr) : NULL;
+  if (!iptr) {
+    if (pptr) png_destroy_write_struct(&pptr, NULL);
+    return -4;
+  }
+  // Note: nothing set below may be used after the jump, except members
+  if (setjmp(png_jmpbuf(pptr))) {
+    png_destroy_write_struct(&pptr, &iptr);
+    return output_error_ ? output_error_ : -5;
+  }
+  png_set_write_fn(pptr, this, Fl_Image_Writer_Callbacks::png_write,
+                   Fl_Image_Writer_Callbacks::png_flush);
+
+  static const int color_types[] = {
+    PNG_COLOR_TYPE_GRAY, PNG_COLOR_TYPE_GRAY_ALPHA,
+    PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGB_ALPHA
+  };
+  png_set_IHDR(pptr, iptr, w_, h_, 8,
+               color_types[d_ - 1],
+               PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT,
+               PNG_FILTER_TYPE_DEFAULT);
+  png_set_sRGB(pptr, iptr, PNG_sRGB_INTENT_PERCEPTUAL);
+
+  double dpi = 300.0;
+  int dots_per_meter = (int)(dpi / (2.54 / 100.0));
+  png_set_pHYs(pptr, iptr, dots_per_meter, dots_per_meter, PNG_RESOLUTION_METER);
+
+  // leave libpng's defaults alone unless asked to
+  if (compression_ >= 0)
+    png_set_compression_level(pptr, compression_);
+  if (filter_)
+    png_set_filter(pptr, PNG_FILTER_TYPE_BASE, filter_);
+  if (strategy_ != STRATEGY_DEFAULT) {
+    static const int strategies[] = { Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE };
+    png_set_compression_strategy(pptr, strategies[strategy_]);
+  }
+
+  png_write_info(pptr, iptr);
+  for (int y = 0; y < h_; y++)
+    png_write_row(pptr, (png_bytep)row_at_(y));
+  png_write_end(pptr, iptr);
+  png_destroy_write_struct(&pptr, &iptr);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+
+int Fl_Image_Writer::encode_jpeg_() {
+#ifdef HAVE_LIBJPEG
+  jpeg_compress_struct cinfo;
+  Fl_Image_Writer_Jpeg_Error jerr;
+  Fl_Image_Writer_Jpeg_Dest dest;
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = Fl_Image_Writer_Callbacks::jpeg_fail;
+  jerr.pub.output_message = Fl_Image_Writer_Callbacks::jpeg_message;
+  if (setjmp(jerr.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    return output_error_ ? output_error_ : -5;
+  }
+  jpeg_create_compress(&cinfo);
+  dest.pub.init_destination = Fl_Image_Writer_Callbacks::jpeg_init;
+  dest.pub.empty_output_buffer = Fl_Image_Writer_Callbacks::jpeg_empty;
+  dest.pub.term_destination = Fl_Image_Writer_Callbacks::jpeg_term;
+  dest.writer = this;
+  cinfo.dest = &dest.pub;
+
+  cinfo.image_width = w_;
+  cinfo.image_height = h_;
+  // JPEG has no alpha channel: gray + alpha and RGBA rows are stripped to
+  // gray and RGB, except that libjpeg-turbo takes RGBA rows as they are
+  int strip = !(d_ & 1);
+  cinfo.input_components = d_ < 3 ? 1 : 3;
+  cinfo.in_color_space = d_ < 3 ? JCS_GRAYSCALE : JCS_RGB;
+#ifdef JCS_EXTENSIONS
+  if (d_ == 4) {
+    cinfo.input_components = 4;
+    cinfo.in_color_space = JCS_EXT_RGBA;
+    strip = 0;
+  }
+#endif
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality_, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    const unsigned char *src = row_at_(cinfo.next_scanline);
+    if (strip) { // in place if src is row_
+      unsigned char *dst = row_;
+      if (d_ == 2) {
+        for (int x = 0; x < w_; x++, src += 2) dst[x] = src[0];
+      } else {
+        for (int x = 0; x < w_; x++, src += 4, dst += 3) {
+          dst[0] = src[0];
+          dst[1] = src[1];
+          dst[2] = src[2];
+        }
+      }
+      src = row_;
+    }
+    JSAMPROW row = (JSAMPROW)src;
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return 0;
+#else
+  return -1;
+#endif
+}
+
+
+/**
+  Encodes an image from a pixel buffer.
+  \param[in] pixels  the first row of the image
+  \param[in] w, h    size of the image
+  \param[in] d       bytes per pixel: 1 (gray), 2 (gray + alpha), 3 (RGB),
+                     or 4 (RGBA)
+  \param[in] ld      bytes from one row to the next, may be negative;
+                     0 means w * d
+  \return 0 on success or a negative error code, see Fl_Image_Writer
+*/
+int Fl_Image_Writer::write(const unsigned char *pixels, int w, int h, int d, int ld) {
+  wait();
+  if (!pixels) return -3;
+  pixels_ = pixels;
+  w_ = w; h_ = h; d_ = d;
+  ld_ = ld ? ld : w * d;
+  source_cb_ = NULL;
+  int ret = encode_();
+  pixels_ = NULL;
+  return ret;
+}
+
+
+/**
+  Encodes an Fl_RGB_Image. The image is always written with its original
+  size data_w() and data_h(), even if it has been scaled.
+  \return 0 on success or a negative error code, see Fl_Image_Writer
+*/
+int Fl_Image_Writer::write(const Fl_RGB_Image *img) {
+  if (!img) return -3;
+  return write(img->array, img->data_w(), img->data_h(), img->d(), img->ld());
+}
+
+
+/**
+  Encodes an image whose rows are produced by a callback, one at a time,
+  from top to bottom, so that the whole image never has to be in memory.
+  The callback is called like by fl_draw_image(cb, data, 0, 0, w, h, d),
+  with x = 0 and the full width for each row.
+  \param[in] cb    the callback that fills a row of w * d bytes
+  \param[in] data  user data passed to the callback
+  \param[in] w, h  size of the image
+  \param[in] d     bytes per pixel, 1 to 4
+  \return 0 on success or a negative error code, see Fl_Image_Writer
+*/
+int Fl_Image_Writer::write(Fl_Draw_Image_Cb cb, void *data, int w, int h, int d) {
+  wait();
+  if (!cb) return -3;
+  source_cb_ = cb;
+  source_data_ = data;
+  w_ = w; h_ = h; d_ = d;
+  int ret = encode_();
+  source_cb_ = NULL;
+  return ret;
+}
+
+
+// Runs in the worker thread. thread_ isn't used after the done callback,
+// which may call wait() or start the next write, see in_worker_().
+void Fl_Image_Writer::run_async_() {
+  result_ = encode_();
+#if !defined(_WIN32) && HAVE_PTHREAD
+  pthread_mutex_lock(&thread_->mutex);
+  thread_->done = 1;
+  pthread_mutex_unlock(&thread_->mutex);
+#endif
+  if (done_cb_) done_cb_(this, result_, done_data_);
+}
+
+
+// Returns true if called by the worker thread, i.e. from the done callback
+bool Fl_Image_Writer::in_worker_() const {
+  if (!thread_) return false;
+#if defined(_WIN32)
+  return GetCurrentThreadId() == thread_->id;
+#elif HAVE_PTHREAD
+  return pthread_equal(pthread_self(), thread_->id) != 0;
+#else
+  return false;
+#endif
+}
+
+
+/**
+  Starts encoding an image from a pixel buffer in a worker thread, and
+  returns at once. The pixels are copied first, so the buffer can be
+  reused, e.g. to draw the next image, as soon as this returns. If an
+  asynchronous write is still running it is waited for first, so that
+  calling this once per image overlaps encoding each image with drawing
+  the next one.
+
+  The result is returned by wait(), and passed to the \p done callback
+  which, like the output callback, is called by the worker thread.
+  If FLTK was built without thread support the image is encoded before
+  this returns.
+
+  The done callback may start the next write of the same writer, e.g. to
+  chain writes, or call wait() or output(): the worker thread is then
+  detached instead of joined. It must not be used to change the writer
+  while another thread uses it, e.g. waits for it.
+
+  \param[in] pixels, w, h, d, ld  the image, see write()
+  \param[in] done  called when the image is written, or NULL
+  \param[in] data  user data passed to \p done
+  \return 0 if the write was started, or -3 or -4 if the image is invalid
+          or can't be copied
+*/
+int Fl_Image_Writer::write_async(const unsigned char *pixels, int w, int h, int d, int ld,
+                                 Done_Cb done, void *data) {
+  wait();
+  if (!pixels || w < 1 || h < 1 || d < 1 || d > 4) return -3;
+  size_t row = (size_t)w * d;
+  if (!ld) ld = (int)row;
+  pixel_copy_ = (unsigned char *)malloc(row * h);
+  if (!pixel_copy_) return -4;
+  for (int y = 0; y < h; y++)
+    memcpy(pixel_copy_ + y * row, pixels + (ptrdiff_t)y * ld, row);
+  pixels_ = pixel_copy_;
+  w_ = w; h_ = h; d_ = d;
+  ld_ = (int)row;
+  source_cb_ = NULL;
+  done_cb_ = done;
+  done_data_ = data;
+  // the worker must not run before thread_ is complete, see in_worker_()
+#if defined(_WIN32)
+  thread_ = new Thread;
+  thread_->handle = (HANDLE)_beginthreadex(NULL, 0, Fl_Image_Writer_Callbacks::async_main,
+                                           this, CREATE_SUSPENDED, &thread_->id);
+  if (thread_->handle) {
+    ResumeThread(thread_->handle);
+    return 0;
+  }
+  delete thread_;
+  thread_ = NULL;
+#elif HAVE_PTHREAD
+  thread_ = new Thread;
+  thread_->done = 0;
+  pthread_mutex_init(&thread_->mutex, NULL);
+  pthread_mutex_lock(&thread_->mutex);
+  int err = pthread_create(&thread_->id, NULL, Fl_Image_Writer_Callbacks::async_main, this);
+  pthread_mutex_unlock(&thread_->mutex);
+  if (!err) return 0;
+  pthread_mutex_destroy(&thread_->mutex);
+  delete thread_;
+  thread_ = NULL;
+#endif
+  // no thread: write it now
+  result_ = encode_();
+  if (done_cb_) done_cb_(this, result_, done_data_);
+  free(pixel_copy_);
+  pixel_copy_ = NULL;
+  pixels_ = NULL;
+  return 0;
+}
+
+
+/**
+  Starts encoding an Fl_RGB_Image in a worker thread.
+  \see write_async(const unsigned char*, int, int, int, int, Done_Cb, void*)
+*/
+int Fl_Image_Writer::write_async(const Fl_RGB_Image *img, Done_Cb done, void *data) {
+  if (!img) return -3;
+  return write_async(img->array, img->data_w(), img->data_h(), img->d(), img->ld(),
+                     done, data);
+}
+
+
+/**
+  Waits for the asynchronous write, if any, to finish.
+  Called from the done callback, the write is finished and the worker
+  thread is detached rather than waited for.
+  \return the result of the last write_async(), see write()
+*/
+int Fl_Image_Writer::wait() {
+  if (thread_) {
+    bool detach = in_worker_();
+#if defined(_WIN32)
+    if (!detach) WaitForSingleObject(thread_->handle, INFINITE);
+    CloseHandle(thread_->handle);
+#elif HAVE_PTHREAD
+    if (detach) pthread_detach(thread_->id);
+    else pthread_join(thread_->id, NULL);
+    pthread_mutex_destroy(&thread_->mutex);
+#endif
+    delete thread_;
+    thread_ = NULL;
+    free(pixel_copy_);
+    pixel_copy_ = NULL;
+    pixels_ = NULL;
+  }
+  return result_;
+}
+
+
+/**
+  Returns non-zero while an asynchronous write is running, i.e. if wait()
+  would block.
+*/
+int Fl_Image_Writer::busy() const {
+  if (!thread_) return 0;
+#if defined(_WIN32)
+  return WaitForSingleObject(thread_->handle, 0) != WAIT_OBJECT_0;
+#elif HAVE_PTHREAD
+  pthread_mutex_lock(&thread_->mutex);
+  int done = thread_->done;
+  pthread_mutex_unlock(&thread_->mutex);
+  return !done;
+#else
+  return 0;
+#endif
+}
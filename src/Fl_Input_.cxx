@@ -25,6 +25,8 @@
 #include "flstring.h"
 #include <stdlib.h>
 #include <ctype.h>
+#include <vector>
+#include <algorithm> // std::upper_bound(), std::lower_bound()
 
 #define MAXBUF 1024
 static int l_secret;
@@ -121,6 +123,51 @@ public:
 };
 
 
+// Index of the lines displayed by an Fl_Input_, so that drawing, cursor
+// movement and mouse clicks need not expand all text before the visible lines.
+// Line i displays the text from start[i] to end[i], where end[i] is where
+// expand() stopped: a '\n', the space where a line wraps, or the end of text.
+// The index depends on the font and width used to wrap lines, and is updated
+// incrementally when text is replaced: a multiline widget's lines are
+// recomputed only for the paragraphs which changed.
+class Fl_Input_Line_Index {
+public:
+  Fl_Input_Line_Index() : valid(false), dirty(false) { }
+
+  std::vector<int> start;
+  std::vector<int> end;
+  std::vector<float> width; // width of each line in pixels, or < 0 if not computed
+
+  // what lines were computed with
+  Fl_Font font;
+  Fl_Fontsize size;
+  int wrap_width;
+  uchar type;
+  Fl_Graphics_Driver *driver;
+  float scale;
+  bool valid;
+
+  // after text was replaced, lines for the text from dirty_start to dirty_end
+  // (to the end of text if < 0) are missing, and belong before line dirty_line
+  bool dirty;
+  int dirty_line, dirty_start, dirty_end;
+
+  int lines() const { return (int)start.size(); }
+
+  // the line displaying index i
+  int line_of(int i) const {
+    int l = int(std::upper_bound(start.begin(), start.end(), i) - start.begin()) - 1;
+    return l < 0 ? 0 : l;
+  }
+
+  // the first line ending at or after index i
+  int line_ending_after(int i) const {
+    int l = int(std::lower_bound(end.begin(), end.end(), i) - end.begin());
+    return l < lines() ? l : lines() - 1;
+  }
+};
+
+
 /** \internal
   Converts a given text segment into the text that will be rendered on screen.
 
@@ -289,6 +336,116 @@ void Fl_Input_::setfont() const {
   fl_font(textfont(), textsize());
 }
 
+/** \internal
+  Appends the lines displayed for part of the text to the line index.
+
+  Text is split into lines exactly as drawtext() does, starting at index
+  \p from, which must be the start of a line, and stopping at index \p to,
+  which must be the start of a paragraph, or at the end of the text if \p to
+  is negative. The current font must be set.
+
+  \param [in] from, to range of text
+*/
+void Fl_Input_::index_lines(int from, int to) const {
+  char buf[MAXBUF];
+  const char *p = value() + from;
+  for (;;) {
+    const char *e = expand(p, buf);
+    line_index_->start.push_back((int)(p - value()));
+    line_index_->end.push_back((int)(e - value()));
+    line_index_->width.push_back(-1);
+    if (e >= value_ + size_) break;
+    if (*e == '\n' || *e == ' ') e++;
+    p = e;
+    if (to >= 0 && p - value() >= to) break;
+  }
+}
+
+/** \internal
+  Returns the index of displayed lines, updated if needed.
+
+  The index is computed again when the font, the widget width or type changed
+  since it was last used, and completed after text was replaced.
+  This may change the current font.
+
+  \return the line index, which contains at least one line
+*/
+Fl_Input_Line_Index* Fl_Input_::line_index() const {
+  Fl_Input_Line_Index *lx = line_index_;
+  int wrap_width = w() - Fl::box_dw(box()) - 5; // as in expand()
+  if (!lx->valid || lx->font != textfont() || lx->size != textsize() ||
+      lx->type != type() || lx->driver != fl_graphics_driver ||
+      lx->scale != fl_graphics_driver->scale() || (wrap() && lx->wrap_width != wrap_width)) {
+    lx->font = textfont();
+    lx->size = textsize();
+    lx->type = type();
+    lx->driver = fl_graphics_driver;
+    lx->scale = fl_graphics_driver->scale();
+    lx->wrap_width = wrap_width;
+    lx->start.clear();
+    lx->end.clear();
+    lx->width.clear();
+    lx->dirty = false;
+    setfont();
+    index_lines(0, -1);
+    lx->valid = true;
+  } else if (lx->dirty) {
+    // put aside the lines after the replaced text, add lines of that text, and put them back
+    std::vector<int> start(lx->start.begin() + lx->dirty_line, lx->start.end());
+    std::vector<int> end(lx->end.begin() + lx->dirty_line, lx->end.end());
+    std::vector<float> width(lx->width.begin() + lx->dirty_line, lx->width.end());
+    lx->start.resize(lx->dirty_line);
+    lx->end.resize(lx->dirty_line);
+    lx->width.resize(lx->dirty_line);
+    setfont();
+    index_lines(lx->dirty_start, lx->dirty_end);
+    lx->start.insert(lx->start.end(), start.begin(), start.end());
+    lx->end.insert(lx->end.end(), end.begin(), end.end());
+    lx->width.insert(lx->width.end(), width.begin(), width.end());
+    lx->dirty = false;
+  }
+  return lx;
+}
+
+/** \internal
+  Updates the line index after text was replaced.
+
+  Lines of the paragraphs containing the replaced text are removed from the
+  index and will be computed again when it's next used. Following lines are
+  moved by the number of bytes inserted or deleted.
+
+  \param [in] b, e range of replaced text, before it was replaced
+  \param [in] ilen length of the new text
+*/
+void Fl_Input_::line_index_changed(int b, int e, int ilen) {
+  Fl_Input_Line_Index *lx = line_index_;
+  if (!lx->valid) return;
+  if (lx->dirty || input_type() != FL_MULTILINE_INPUT) {
+    // recompute all lines when used: only multiline text is split into paragraphs
+    lx->valid = false;
+    return;
+  }
+  int delta = ilen - (e - b);
+  int n = lx->lines();
+  // the first line of the paragraph containing b, which may be rewrapped
+  int l0 = lx->line_ending_after(b);
+  while (l0 > 0 && value_[lx->end[l0 - 1]] != '\n') l0--;
+  // the first line after e starting a paragraph, which does not change
+  int l1 = l0 + 1;
+  while (l1 < n && !(lx->start[l1] > e && value_[lx->start[l1] - 1 + delta] == '\n')) l1++;
+  lx->dirty_line = l0;
+  lx->dirty_start = lx->start[l0];
+  lx->dirty_end = (l1 < n ? lx->start[l1] + delta : -1);
+  lx->start.erase(lx->start.begin() + l0, lx->start.begin() + l1);
+  lx->end.erase(lx->end.begin() + l0, lx->end.begin() + l1);
+  lx->width.erase(lx->width.begin() + l0, lx->width.begin() + l1);
+  for (int l = l0; l < lx->lines(); l++) {
+    lx->start[l] += delta;
+    lx->end[l] += delta;
+  }
+  lx->dirty = true;
+}
+
 /**
  Draws the text in the passed bounding box.
 
@@ -337,42 +494,37 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H, bool draw_active) {
     selend = insert_position(); selstart = mark();
   }
 
+  Fl_Input_Line_Index *lx = line_index();
   setfont();
   const char *p, *e;
   char buf[MAXBUF];
 
-  // count how many lines and put the last one into the buffer:
-  // And figure out where the cursor is:
+  // figure out where the cursor is:
   int height = fl_height();
   int threshold = height/2;
-  int lines;
+  int line = lx->line_of(insert_position());
   int curx, cury;
-  for (p=value(), curx=cury=lines=0; ;) {
-    e = expand(p, buf);
-    if (insert_position() >= p-value() && insert_position() <= e-value()) {
-      curx = int(expandpos(p, value()+insert_position(), buf, 0)+.5);
-      if (draw_active && !was_up_down) up_down_pos = curx;
-      cury = lines*height;
-      int newscroll = xscroll_;
-      if (curx > newscroll+W-threshold) {
-        // figure out scrolling so there is space after the cursor:
-        newscroll = curx+threshold-W;
-        // figure out the furthest left we ever want to scroll:
-        int ex = int(expandpos(p, e, buf, 0))+4-W;
-        // use minimum of both amounts:
-        if (ex < newscroll) newscroll = ex;
-      } else if (curx < newscroll+threshold) {
-        newscroll = curx-threshold;
-      }
-      if (newscroll < 0) newscroll = 0;
-      if (newscroll != xscroll_) {
-        xscroll_ = newscroll;
-        mu_p = 0; erase_cursor_only = 0;
-      }
-    }
-    lines++;
-    if (e >= value_+size_) break;
-    p = e+1;
+  p = value() + lx->start[line];
+  e = expand(p, buf);
+  curx = int(expandpos(p, value()+insert_position(), buf, 0)+.5);
+  if (draw_active && !was_up_down) up_down_pos = curx;
+  cury = line*height;
+  int newscroll = xscroll_;
+  if (curx > newscroll+W-threshold) {
+    // figure out scrolling so there is space after the cursor:
+    newscroll = curx+threshold-W;
+    // figure out the furthest left we ever want to scroll:
+    if (lx->width[line] < 0) lx->width[line] = (float)expandpos(p, e, buf, 0);
+    int ex = int(lx->width[line])+4-W;
+    // use minimum of both amounts:
+    if (ex < newscroll) newscroll = ex;
+  } else if (curx < newscroll+threshold) {
+    newscroll = curx-threshold;
+  }
+  if (newscroll < 0) newscroll = 0;
+  if (newscroll != xscroll_) {
+    xscroll_ = newscroll;
+    mu_p = 0; erase_cursor_only = 0;
   }
 
   // adjust the scrolling:
@@ -389,16 +541,21 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H, bool draw_active) {
   fl_push_clip(X, Y, W, H);
   Fl_Color tc = active_r() ? textcolor() : fl_inactive(textcolor());
 
-  p = value();
-  // visit each line and draw it:
+  // visit each visible line and draw it:
   int desc = height-fl_descent();
   float xpos = (float)(X - xscroll_ + 1);
   int ypos = -yscroll_;
   int ypos_cur = 0; //fix issue #270
+  line = 0;
+  if (ypos <= -height) { // skip lines clipped off top
+    line = (-height-ypos)/height + 1;
+    if (line > lx->lines()-1) line = lx->lines()-1;
+    ypos += line*height;
+  }
+  p = value() + lx->start[line];
   for (; ypos < H;) {
 
-    // re-expand line unless it is the last one calculated above:
-    if (lines>1) e = expand(p, buf);
+    e = expand(p, buf);
 
     if (ypos <= -height) goto CONTINUE; // clipped off top
 
@@ -495,9 +652,8 @@ void Fl_Input_::drawtext(int X, int Y, int W, int H, bool draw_active) {
 
   CONTINUE:
     ypos += height;
-    if (e >= value_+size_) break;
-    if (*e == '\n' || *e == ' ') e++;
-    p = e;
+    if (++line >= lx->lines()) break;
+    p = value() + lx->start[line];
   }
 
   // for minimal update, erase all lines below last one if necessary:
@@ -578,18 +734,9 @@ int Fl_Input_::line_end(int i) const {
   if (input_type() != FL_MULTILINE_INPUT) return size();
 
   if (wrap()) {
-    // go to the start of the paragraph:
-    int j = i;
-    while (j > 0 && index(j-1) != '\n') j--;
-    // now measure lines until we get past i, end of that line is real eol:
-    setfont();
-    for (const char* p=value()+j; ;) {
-      char buf[MAXBUF];
-      p = expand(p, buf);
-      int k = (int) (p-value());
-      if (k >= i) return k;
-      p++;
-    }
+    // the first displayed line ending at or after i, end of that line is real eol:
+    Fl_Input_Line_Index *lx = line_index();
+    return lx->end[lx->line_ending_after(i)];
   } else {
     while (i < size() && index(i) != '\n') i++;
     return i;
@@ -607,18 +754,14 @@ int Fl_Input_::line_end(int i) const {
 */
 int Fl_Input_::line_start(int i) const {
   if (input_type() != FL_MULTILINE_INPUT) return 0;
+  if (wrap()) {
+    // the first displayed line ending at or after i, start of that line is real bol:
+    Fl_Input_Line_Index *lx = line_index();
+    return lx->start[lx->line_ending_after(i)];
+  }
   int j = i;
   while (j > 0 && index(j-1) != '\n') j--;
-  if (wrap()) {
-    // now measure lines until we get past i, start of that line is real eol:
-    setfont();
-    for (const char* p=value()+j; ;) {
-      char buf[MAXBUF];
-      const char* e = expand(p, buf);
-      if ((int) (e-value()) >= i) return (int) (p-value());
-      p = e+1;
-    }
-  } else return j;
+  return j;
 }
 
 static int strict_word_start(const char *s, int i, int itype) {
@@ -642,6 +785,7 @@ static int strict_word_end(const char *s, int len, int i, int itype) {
 void Fl_Input_::handle_mouse(int X, int Y, int /*W*/, int /*H*/, int drag) {
   was_up_down = 0;
   if (!size()) return;
+  Fl_Input_Line_Index *lx = line_index();
   setfont();
 
   const char *p, *e;
@@ -649,14 +793,12 @@ void Fl_Input_::handle_mouse(int X, int Y, int /*W*/, int /*H*/, int drag) {
 
   int theline = (input_type()==FL_MULTILINE_INPUT) ?
     (Fl::event_y()-Y+yscroll_)/fl_height() : 0;
+  if (theline < 0) theline = 0;
+  if (theline >= lx->lines()) theline = lx->lines()-1;
 
   int newpos = 0;
-  for (p=value();; ) {
-    e = expand(p, buf);
-    theline--; if (theline < 0) break;
-    if (e >= value_+size_) break;
-    p = e+1;
-  }
+  p = value() + lx->start[theline];
+  e = expand(p, buf);
   const char *l, *r, *t; double f0 = Fl::event_x()-X+xscroll_;
   for (l = p, r = e; l<r; ) {
     double f;
@@ -991,6 +1133,7 @@ int Fl_Input_::replace(int b, int e, const char* text, int ilen) {
     memcpy(buffer+b, text, ilen);
     size_ += ilen;
   }
+  line_index_changed(b, e, ilen);
   om = mark_;
   op = position_;
   mark_ = position_ = undo_->undoat = b+ilen;
@@ -1064,6 +1207,8 @@ int Fl_Input_::apply_undo() {
     size_ -= xlen;
   }
 
+  line_index_changed(b1, b1+xlen, ilen);
+
   undo_->undocut = xlen;
   if (xlen) undo_->undoyankcut = xlen;
   undo_->undoinsert = ilen;
@@ -1319,6 +1464,7 @@ Fl_Input_::Fl_Input_(int X, int Y, int W, int H, const char* l)
   undo_list_ = new Fl_Input_Undo_Action_List();
   redo_list_ = new Fl_Input_Undo_Action_List();
   undo_ = new Fl_Input_Undo_Action();
+  line_index_ = new Fl_Input_Line_Index();
   set_flag(SHORTCUT_LABEL);
   set_flag(MAC_USE_ACCENTS_MENU);
   set_flag(NEEDS_KEYBOARD);
@@ -1385,6 +1531,7 @@ void Fl_Input_::put_in_buffer(int len) {
 */
 int Fl_Input_::static_value(const char* str, int len) {
   clear_changed();
+  line_index_->valid = false;
   undo_->clear();
   undo_list_->clear();
   redo_list_->clear();
@@ -1539,6 +1686,7 @@ Fl_Input_::~Fl_Input_() {
   delete undo_list_;
   delete redo_list_;
   delete undo_;
+  delete line_index_;
   if (bufsize) free((void*)buffer);
 }
 
@@ -0,0 +1,131 @@
+//
+// Per-widget offscreen buffers for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Offscreen_Cache.H"
+#include <FL/Fl.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/fl_draw.H>
+#include <list>
+#include <map>
+
+struct Fl_Offscreen_Cache::Entry {
+  const Fl_Widget *widget;
+  Fl_Image_Surface *surface;
+  Fl_Display_List::Key key;  // widget state when rendered, x and y are ignored
+  size_t bytes;
+};
+
+// Most recently drawn entries first
+typedef std::list<Fl_Offscreen_Cache::Entry*> Fl_Offscreen_Cache_List;
+static Fl_Offscreen_Cache_List lru;
+static std::map<const Fl_Widget*, Fl_Offscreen_Cache_List::iterator> entries;
+
+size_t Fl_Offscreen_Cache::budget_ = 32 * 1024 * 1024;
+size_t Fl_Offscreen_Cache::used_ = 0;
+
+
+Fl_Offscreen_Cache::Entry *Fl_Offscreen_Cache::find_(const Fl_Widget *w) {
+  std::map<const Fl_Widget*, Fl_Offscreen_Cache_List::iterator>::iterator it = entries.find(w);
+  if (it == entries.end()) return NULL;
+  lru.splice(lru.begin(), lru, it->second);
+  return *it->second;
+}
+
+
+void Fl_Offscreen_Cache::release_(Entry *e) {
+  std::map<const Fl_Widget*, Fl_Offscreen_Cache_List::iterator>::iterator it = entries.find(e->widget);
+  lru.erase(it->second);
+  entries.erase(it);
+  used_ -= e->bytes;
+  delete e->surface;
+  delete e;
+}
+
+
+// Releases the least recently drawn buffers until \p bytes fit in the budget
+bool Fl_Offscreen_Cache::make_room_(size_t bytes) {
+  if (bytes > budget_) return false;
+  while (used_ + bytes > budget_ && !lru.empty()) release_(lru.back());
+  return true;
+}
+
+
+/* Draws widget \p w from its offscreen buffer, rendering the buffer first
+ if needed. Returns false, and does nothing, if the widget must be drawn
+ as usual: it is not cached, it is only partially damaged, it doesn't
+ paint its whole area, or its buffer doesn't fit in the budget.
+ */
+bool Fl_Offscreen_Cache::draw(Fl_Widget &w) {
+  if (!w.offscreen_cache() || !(w.damage() & FL_DAMAGE_ALL) || w.w() <= 0 || w.h() <= 0)
+    return false;
+  // the widget's box must paint its area, or the buffer would show
+  // garbage where the parent should be visible
+  Fl_Boxtype b = w.box();
+  if (b == FL_NO_BOX || fl_box(b) != b) return false;
+  Fl_Display_List::Key key;
+  Fl_Display_List::make_key(w, fl_graphics_driver, key);
+  key.x = key.y = 0;
+  Entry *e = find_(&w);
+  if (e && !(e->key == key)) {
+    release_(e);
+    e = NULL;
+  }
+  if (!e) {
+    size_t bytes = size_t(w.w() * key.scale + 1) * size_t(w.h() * key.scale + 1) * 4;
+    if (!make_room_(bytes)) return false;
+    Fl_Image_Surface *surface = new Fl_Image_Surface(w.w(), w.h(), 1);
+    Fl_Widget_Surface *ws = surface; // translate() is public there
+    Fl_Surface_Device::push_current(surface);
+    ws->translate(-w.x(), -w.y());
+    // what shows through the corners of rounded boxes
+    fl_color(w.parent() ? w.parent()->color() : w.color());
+    fl_rectf(w.x(), w.y(), w.w(), w.h());
+    w.draw();
+    ws->untranslate();
+    Fl_Surface_Device::pop_current();
+    e = new Entry;
+    e->widget = &w;
+    e->surface = surface;
+    e->key = key;
+    e->bytes = bytes;
+    lru.push_front(e);
+    entries[&w] = lru.begin();
+    used_ += bytes;
+  }
+  fl_copy_offscreen(w.x(), w.y(), w.w(), w.h(), e->surface->offscreen(), 0, 0);
+  return true;
+}
+
+
+/* Releases the offscreen buffer of widget \p w, if any */
+void Fl_Offscreen_Cache::discard(const Fl_Widget *w) {
+  std::map<const Fl_Widget*, Fl_Offscreen_Cache_List::iterator>::iterator it = entries.find(w);
+  if (it != entries.end()) release_(*it->second);
+}
+
+
+/* Releases all offscreen buffers */
+void Fl_Offscreen_Cache::discard_all() {
+  while (!lru.empty()) release_(lru.back());
+}
+
+
+/* Sets the maximum total size in bytes of all offscreen buffers */
+void Fl_Offscreen_Cache::budget(size_t bytes) {
+  budget_ = bytes;
+  make_room_(0);
+}
@@ -0,0 +1,489 @@
+//
+// Pixel conversion kernels for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Pixel_Ops.H"
+#include <string.h>
+
+// The SIMD kernels are compiled for their instruction set with function
+// attributes, the rest of the library keeps the default target.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ >= 5)
+#  define FL_PIXEL_OPS_X86 1
+#  define FL_TARGET(t) __attribute__((target(t)))
+#  include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  define FL_PIXEL_OPS_X86 1
+#  define FL_TARGET(t)
+#  include <immintrin.h>
+#  include <intrin.h>
+#else
+#  define FL_PIXEL_OPS_X86 0
+#endif
+
+int Fl_Pixel_Ops::simd_ = -1;
+
+/* Returns the best instruction set the CPU and the OS support */
+int Fl_Pixel_Ops::cpu_simd() {
+#if FL_PIXEL_OPS_X86 && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return AVX2;
+  if (__builtin_cpu_supports("ssse3")) return SSSE3;
+#elif FL_PIXEL_OPS_X86
+  int r[4];
+  __cpuid(r, 0);
+  int max_leaf = r[0];
+  __cpuid(r, 1);
+  bool ssse3 = (r[2] & (1<<9)) != 0;
+  bool avx = (r[2] & (1<<27)) && (r[2] & (1<<28)) && (_xgetbv(0) & 6) == 6;
+  if (avx && max_leaf >= 7) {
+    __cpuidex(r, 7, 0);
+    if (r[1] & (1<<5)) return AVX2;
+  }
+  if (ssse3) return SSSE3;
+#endif
+  return SCALAR;
+}
+
+/* Limits the kernels to an instruction set, the CPU may still lower it */
+void Fl_Pixel_Ops::simd(int level) {
+  int cpu = cpu_simd();
+  simd_ = (level < SCALAR ? SCALAR : level > cpu ? cpu : level);
+}
+
+////////////////////////////////////////////////////////////////
+// scalar kernels, they also do what is left by the SIMD kernels
+
+static void shuffle32_scalar(const uchar *from, uchar *to, int n, int delta,
+                             const signed char map[4]) {
+  for (; n--; from += delta, to += 4) {
+    for (int k = 0; k < 4; k++)
+      to[k] = (map[k] < 0 ? 0 : from[map[k]]);
+  }
+}
+
+static void premultiply32_scalar(const uchar *from, uchar *to, int n, int delta,
+                                 const signed char map[4]) {
+  for (; n--; from += delta, to += 4) {
+    unsigned a = from[map[3]];
+    to[0] = uchar(from[map[0]] * a / 255);
+    to[1] = uchar(from[map[1]] * a / 255);
+    to[2] = uchar(from[map[2]] * a / 255);
+    to[3] = uchar(a);
+  }
+}
+
+static void blend_scalar(const uchar *from, int delta, uchar *to, int n) {
+  const int g = (delta == 2 ? 0 : 1), b = (delta == 2 ? 0 : 2);
+  for (; n--; from += delta, to += 3) {
+    unsigned a = from[delta-1];
+    if (a == 255) { // special case "copy"
+      to[0] = from[0];
+      to[1] = from[g];
+      to[2] = from[b];
+    } else if (a) { // common case "blend"
+      a += a>>7; // multiply by 1.004 to compensate integer rounding error
+      unsigned na = 256 - a;
+      to[0] = uchar((from[0] * a + to[0] * na) >> 8);
+      to[1] = uchar((from[g] * a + to[1] * na) >> 8);
+      to[2] = uchar((from[b] * a + to[2] * na) >> 8);
+    }
+  }
+}
+
+// Each byte j of a pixel becomes (byte * mul[j] + add[j]) >> 8
+static void color_average_scalar(const uchar *from, uchar *to, int n, int delta,
+                                 const unsigned mul[4], const unsigned add[4]) {
+  for (; n--; from += delta, to += delta) {
+    for (int j = 0; j < delta; j++)
+      to[j] = uchar((from[j] * mul[j] + add[j]) >> 8);
+  }
+}
+
+static void gray_scalar(const uchar *from, uchar *to, int n, int delta) {
+  for (; n--; from += delta) {
+    *to++ = uchar((31 * from[0] + 61 * from[1] + 8 * from[2]) / 100);
+    if (delta > 3) *to++ = from[3];
+  }
+}
+
+#if FL_PIXEL_OPS_X86
+
+////////////////////////////////////////////////////////////////
+// SSSE3 and AVX2 kernels, they return the number of pixels done.
+// 4 pixels are read with one 16 byte load, so 'need' more pixels
+// must be left in the row not to read beyond it.
+
+// Sets the _mm_shuffle_epi8() mask that gathers 4 pixels into 16 bytes
+static void gather_mask(char m[16], int delta, const signed char map[4]) {
+  for (int p = 0; p < 4; p++)
+    for (int k = 0; k < 4; k++)
+      m[4*p+k] = char(map[k] < 0 ? -128 : p*delta + map[k]);
+}
+
+static int pixels_per_load(int delta) {
+  int need = (16 + delta - 1) / delta;
+  return need < 4 ? 4 : need;
+}
+
+FL_TARGET("ssse3")
+static int shuffle32_ssse3(const uchar *from, uchar *to, int n, int delta,
+                           const signed char map[4]) {
+  char m[16];
+  gather_mask(m, delta, map);
+  const __m128i mask = _mm_loadu_si128((const __m128i*)m);
+  const int need = pixels_per_load(delta);
+  int i = 0;
+  for (; i + need <= n; i += 4, from += 4*delta, to += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)from);
+    _mm_storeu_si128((__m128i*)to, _mm_shuffle_epi8(v, mask));
+  }
+  return i;
+}
+
+FL_TARGET("avx2")
+static int shuffle32_avx2(const uchar *from, uchar *to, int n, int delta,
+                          const signed char map[4]) {
+  char m[16];
+  gather_mask(m, delta, map);
+  const __m128i m128 = _mm_loadu_si128((const __m128i*)m);
+  const __m256i mask = _mm256_inserti128_si256(_mm256_castsi128_si256(m128), m128, 1);
+  const int need = 4 + pixels_per_load(delta);
+  int i = 0;
+  for (; i + need <= n; i += 8, from += 8*delta, to += 32) {
+    __m256i v = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)from));
+    v = _mm256_inserti128_si256(v, _mm_loadu_si128((const __m128i*)(from + 4*delta)), 1);
+    _mm256_storeu_si256((__m256i*)to, _mm256_shuffle_epi8(v, mask));
+  }
+  return i + shuffle32_ssse3(from, to, n - i, delta, map);
+}
+
+// Sets the masks that spread the alpha of 2 gathered pixels over their
+// 16 bit color channels, the alpha channel gets 0 and is later set to 255
+// so that alpha*255/255 leaves it unchanged.
+static void alpha_masks(char lo[16], char hi[16]) {
+  for (int p = 0; p < 2; p++)
+    for (int k = 0; k < 4; k++) {
+      lo[8*p+2*k] = char(k < 3 ? 4*p + 3 : -128);
+      hi[8*p+2*k] = char(k < 3 ? 4*p + 11 : -128);
+      lo[8*p+2*k+1] = hi[8*p+2*k+1] = -128;
+    }
+}
+
+// x/255 rounded down is (x*0x8081)>>23 for all x <= 255*255
+
+FL_TARGET("ssse3")
+static int premultiply32_ssse3(const uchar *from, uchar *to, int n, int delta,
+                               const signed char map[4]) {
+  char m[16], alo[16], ahi[16];
+  gather_mask(m, delta, map);
+  alpha_masks(alo, ahi);
+  const __m128i mask = _mm_loadu_si128((const __m128i*)m);
+  const __m128i amask_lo = _mm_loadu_si128((const __m128i*)alo);
+  const __m128i amask_hi = _mm_loadu_si128((const __m128i*)ahi);
+  const __m128i opaque = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+  const __m128i div255 = _mm_set1_epi16(short(0x8081));
+  const __m128i zero = _mm_setzero_si128();
+  const int need = pixels_per_load(delta);
+  int i = 0;
+  for (; i + need <= n; i += 4, from += 4*delta, to += 16) {
+    __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)from), mask);
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    lo = _mm_mullo_epi16(lo, _mm_or_si128(_mm_shuffle_epi8(v, amask_lo), opaque));
+    hi = _mm_mullo_epi16(hi, _mm_or_si128(_mm_shuffle_epi8(v, amask_hi), opaque));
+    lo = _mm_srli_epi16(_mm_mulhi_epu16(lo, div255), 7);
+    hi = _mm_srli_epi16(_mm_mulhi_epu16(hi, div255), 7);
+    _mm_storeu_si128((__m128i*)to, _mm_packus_epi16(lo, hi));
+  }
+  return i;
+}
+
+FL_TARGET("avx2")
+static int premultiply32_avx2(const uchar *from, uchar *to, int n, int delta,
+                              const signed char map[4]) {
+  char m[16], alo[16], ahi[16];
+  gather_mask(m, delta, map);
+  alpha_masks(alo, ahi);
+  __m128i t = _mm_loadu_si128((const __m128i*)m);
+  const __m256i mask = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)alo);
+  const __m256i amask_lo = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)ahi);
+  const __m256i amask_hi = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  const __m256i opaque = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255,
+                                           0, 0, 0, 255, 0, 0, 0, 255);
+  const __m256i div255 = _mm256_set1_epi16(short(0x8081));
+  const __m256i zero = _mm256_setzero_si256();
+  const int need = 4 + pixels_per_load(delta);
+  int i = 0;
+  for (; i + need <= n; i += 8, from += 8*delta, to += 32) {
+    __m256i v = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)from));
+    v = _mm256_inserti128_si256(v, _mm_loadu_si128((const __m128i*)(from + 4*delta)), 1);
+    v = _mm256_shuffle_epi8(v, mask);
+    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+    lo = _mm256_mullo_epi16(lo, _mm256_or_si256(_mm256_shuffle_epi8(v, amask_lo), opaque));
+    hi = _mm256_mullo_epi16(hi, _mm256_or_si256(_mm256_shuffle_epi8(v, amask_hi), opaque));
+    lo = _mm256_srli_epi16(_mm256_mulhi_epu16(lo, div255), 7);
+    hi = _mm256_srli_epi16(_mm256_mulhi_epu16(hi, div255), 7);
+    _mm256_storeu_si256((__m256i*)to, _mm256_packus_epi16(lo, hi));
+  }
+  return i + premultiply32_ssse3(from, to, n - i, delta, map);
+}
+
+// Blending: a = alpha + alpha/128 and (from * a + to * (256 - a)) >> 8
+// never exceed 16 bits, and alpha 0 and 255 give the special cases of the
+// scalar code. The RGB destination is widened to 4 byte pixels and back,
+// and exactly 12 bytes are stored: rewriting the next 4 bytes unchanged
+// would make the next load wait for that store.
+
+static void blend_masks(char src[16], char dst[16], char rgb[16], int delta) {
+  static const signed char rgba[4] = {0, 1, 2, 3}, graya[4] = {0, 0, 0, 1};
+  static const signed char widen[4] = {0, 1, 2, -1};
+  gather_mask(src, delta, delta == 2 ? graya : rgba);
+  gather_mask(dst, 3, widen);
+  for (int j = 0; j < 16; j++) rgb[j] = char(j < 12 ? j + j/3 : -128);
+}
+
+FL_TARGET("ssse3")
+static inline void store12(uchar *to, __m128i v) {
+  _mm_storel_epi64((__m128i*)to, v);
+  int last = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+  memcpy(to + 8, &last, 4);
+}
+
+FL_TARGET("ssse3")
+static int blend_ssse3(const uchar *from, int delta, uchar *to, int n) {
+  char ms[16], md[16], mr[16], alo[16], ahi[16];
+  blend_masks(ms, md, mr, delta);
+  alpha_masks(alo, ahi);
+  const __m128i src_mask = _mm_loadu_si128((const __m128i*)ms);
+  const __m128i dst_mask = _mm_loadu_si128((const __m128i*)md);
+  const __m128i rgb_mask = _mm_loadu_si128((const __m128i*)mr);
+  const __m128i amask_lo = _mm_loadu_si128((const __m128i*)alo);
+  const __m128i amask_hi = _mm_loadu_si128((const __m128i*)ahi);
+  const __m128i c256 = _mm_set1_epi16(256);
+  const __m128i zero = _mm_setzero_si128();
+  const int ns = pixels_per_load(delta), nd = pixels_per_load(3);
+  const int need = ns > nd ? ns : nd;
+  int i = 0;
+  for (; i + need <= n; i += 4, from += 4*delta, to += 12) {
+    __m128i s = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)from), src_mask);
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)to), dst_mask);
+    __m128i alo = _mm_shuffle_epi8(s, amask_lo);
+    __m128i ahi = _mm_shuffle_epi8(s, amask_hi);
+    alo = _mm_add_epi16(alo, _mm_srli_epi16(alo, 7));
+    ahi = _mm_add_epi16(ahi, _mm_srli_epi16(ahi, 7));
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alo),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c256, alo)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), ahi),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c256, ahi)));
+    __m128i r = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    store12(to, _mm_shuffle_epi8(r, rgb_mask));
+  }
+  return i;
+}
+
+FL_TARGET("avx2")
+static int blend_avx2(const uchar *from, int delta, uchar *to, int n) {
+  char ms[16], md[16], mr[16], alo[16], ahi[16];
+  blend_masks(ms, md, mr, delta);
+  alpha_masks(alo, ahi);
+  __m128i t = _mm_loadu_si128((const __m128i*)ms);
+  const __m256i src_mask = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)md);
+  const __m256i dst_mask = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)mr);
+  const __m256i rgb_mask = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)alo);
+  const __m256i amask_lo = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  t = _mm_loadu_si128((const __m128i*)ahi);
+  const __m256i amask_hi = _mm256_inserti128_si256(_mm256_castsi128_si256(t), t, 1);
+  const __m256i c256 = _mm256_set1_epi16(256);
+  const __m256i zero = _mm256_setzero_si256();
+  const int ns = pixels_per_load(delta), nd = pixels_per_load(3);
+  const int need = 4 + (ns > nd ? ns : nd);
+  int i = 0;
+  for (; i + need <= n; i += 8, from += 8*delta, to += 24) {
+    __m256i s = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)from));
+    s = _mm256_inserti128_si256(s, _mm_loadu_si128((const __m128i*)(from + 4*delta)), 1);
+    s = _mm256_shuffle_epi8(s, src_mask);
+    __m256i d = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)to));
+    d = _mm256_inserti128_si256(d, _mm_loadu_si128((const __m128i*)(to + 12)), 1);
+    d = _mm256_shuffle_epi8(d, dst_mask);
+    __m256i alo = _mm256_shuffle_epi8(s, amask_lo);
+    __m256i ahi = _mm256_shuffle_epi8(s, amask_hi);
+    alo = _mm256_add_epi16(alo, _mm256_srli_epi16(alo, 7));
+    ahi = _mm256_add_epi16(ahi, _mm256_srli_epi16(ahi, 7));
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alo),
+                                  _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(c256, alo)));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), ahi),
+                                  _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(c256, ahi)));
+    __m256i r = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+    r = _mm256_shuffle_epi8(r, rgb_mask);
+    store12(to, _mm256_castsi256_si128(r));
+    store12(to + 12, _mm256_extracti128_si256(r, 1));
+  }
+  return i + blend_ssse3(from, delta, to, n - i);
+}
+
+// Color average: 48 bytes are a whole number of pixels of any size, the
+// kernel processes them as 3 vectors with their own factors and offsets.
+
+FL_TARGET("ssse3")
+static int color_average_ssse3(const uchar *from, uchar *to, int n, int delta,
+                               const unsigned mul[4], const unsigned add[4]) {
+  short m[48], a[48];
+  for (int j = 0; j < 48; j++) {
+    m[j] = short(mul[j % delta]);
+    a[j] = short(add[j % delta]);
+  }
+  __m128i vm[6], va[6];
+  for (int k = 0; k < 6; k++) {
+    vm[k] = _mm_loadu_si128((const __m128i*)(m + 8*k));
+    va[k] = _mm_loadu_si128((const __m128i*)(a + 8*k));
+  }
+  const __m128i zero = _mm_setzero_si128();
+  const int step = 48 / delta;
+  int i = 0;
+  for (; i + step <= n; i += step, from += 48, to += 48) {
+    for (int k = 0; k < 3; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(from + 16*k));
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), vm[2*k]), va[2*k]);
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), vm[2*k+1]), va[2*k+1]);
+      _mm_storeu_si128((__m128i*)(to + 16*k),
+                       _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+  }
+  return i;
+}
+
+// Gray: _mm_maddubs_epi16() and _mm_hadd_epi16() sum 31*r + 61*g + 8*b
+// of 8 pixels, x/100 rounded down is (x*5243)>>19 for all x <= 25500.
+
+FL_TARGET("ssse3")
+static int gray_ssse3(const uchar *from, uchar *to, int n, int delta) {
+  static const signed char rgb[4] = {0, 1, 2, -1}, rgba[4] = {0, 1, 2, 3};
+  char m[16], a0[16], a1[16];
+  gather_mask(m, delta, delta == 3 ? rgb : rgba);
+  for (int j = 0; j < 16; j++) {
+    a0[j] = char(j < 4 ? 4*j + 3 : -128);
+    a1[j] = char(j >= 4 && j < 8 ? 4*(j-4) + 3 : -128);
+  }
+  const __m128i mask = _mm_loadu_si128((const __m128i*)m);
+  const __m128i amask0 = _mm_loadu_si128((const __m128i*)a0);
+  const __m128i amask1 = _mm_loadu_si128((const __m128i*)a1);
+  const __m128i weights = _mm_set1_epi32(31 | (61 << 8) | (8 << 16));
+  const __m128i div100 = _mm_set1_epi16(5243);
+  const int need = 4 + pixels_per_load(delta);
+  int i = 0;
+  for (; i + need <= n; i += 8, from += 8*delta) {
+    __m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)from), mask);
+    __m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(from + 4*delta)), mask);
+    __m128i x = _mm_hadd_epi16(_mm_maddubs_epi16(v0, weights), _mm_maddubs_epi16(v1, weights));
+    x = _mm_srli_epi16(_mm_mulhi_epu16(x, div100), 3);
+    x = _mm_packus_epi16(x, x);
+    if (delta == 3) {
+      _mm_storel_epi64((__m128i*)to, x);
+      to += 8;
+    } else {
+      __m128i alpha = _mm_or_si128(_mm_shuffle_epi8(v0, amask0), _mm_shuffle_epi8(v1, amask1));
+      _mm_storeu_si128((__m128i*)to, _mm_unpacklo_epi8(x, alpha));
+      to += 16;
+    }
+  }
+  return i;
+}
+
+#endif // FL_PIXEL_OPS_X86
+
+////////////////////////////////////////////////////////////////
+
+/* Converts a row of pixels into 32-bit pixels, see the byte map above */
+void Fl_Pixel_Ops::shuffle32(const uchar *from, uchar *to, int n, int delta,
+                             const signed char map[4]) {
+  int i = 0;
+#if FL_PIXEL_OPS_X86
+  if (delta >= 1 && delta <= 4) {
+    switch (simd()) {
+      case AVX2:  i = shuffle32_avx2(from, to, n, delta, map); break;
+      case SSSE3: i = shuffle32_ssse3(from, to, n, delta, map); break;
+    }
+  }
+#endif
+  shuffle32_scalar(from + i*delta, to + 4*i, n - i, delta, map);
+}
+
+/* Converts a row of pixels into premultiplied 32-bit pixels */
+void Fl_Pixel_Ops::premultiply32(const uchar *from, uchar *to, int n, int delta,
+                                 const signed char map[4]) {
+  int i = 0;
+#if FL_PIXEL_OPS_X86
+  if (delta >= 1 && delta <= 4) {
+    switch (simd()) {
+      case AVX2:  i = premultiply32_avx2(from, to, n, delta, map); break;
+      case SSSE3: i = premultiply32_ssse3(from, to, n, delta, map); break;
+    }
+  }
+#endif
+  premultiply32_scalar(from + i*delta, to + 4*i, n - i, delta, map);
+}
+
+/* Composites a row of gray+alpha or RGBA pixels over RGB pixels */
+void Fl_Pixel_Ops::blend(const uchar *from, int delta, uchar *rgb, int n) {
+  int i = 0;
+#if FL_PIXEL_OPS_X86
+  if (delta == 2 || delta == 4) {
+    switch (simd()) {
+      case AVX2:  i = blend_avx2(from, delta, rgb, n); break;
+      case SSSE3: i = blend_ssse3(from, delta, rgb, n); break;
+    }
+  }
+#endif
+  blend_scalar(from + i*delta, delta, rgb + 3*i, n - i);
+}
+
+/* Averages a row of pixels with the color r,g,b, weight is the share of
+ the pixels, 0 to 256. The alpha channel is not changed. */
+void Fl_Pixel_Ops::color_average(const uchar *from, uchar *to, int n, int delta,
+                                 uchar r, uchar g, uchar b, unsigned weight) {
+  unsigned mul[4] = { weight, weight, weight, weight }, add[4];
+  if (delta < 3) {
+    add[0] = (r * 31 + g * 61 + b * 8) / 100 * (256 - weight);
+    mul[1] = 256; add[1] = 0;
+  } else {
+    add[0] = r * (256 - weight);
+    add[1] = g * (256 - weight);
+    add[2] = b * (256 - weight);
+    mul[3] = 256; add[3] = 0;
+  }
+  int i = 0;
+#if FL_PIXEL_OPS_X86
+  if (delta >= 1 && delta <= 4 && simd() >= SSSE3)
+    i = color_average_ssse3(from, to, n, delta, mul, add);
+#endif
+  color_average_scalar(from + i*delta, to + i*delta, n - i, delta, mul, add);
+}
+
+/* Converts a row of RGB or RGBA pixels into gray or gray+alpha pixels */
+void Fl_Pixel_Ops::gray(const uchar *from, uchar *to, int n, int delta) {
+  int i = 0;
+#if FL_PIXEL_OPS_X86
+  if ((delta == 3 || delta == 4) && simd() >= SSSE3)
+    i = gray_ssse3(from, to, n, delta);
+#endif
+  gray_scalar(from + i*delta, to + i*(delta-2), n - i, delta);
+}
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 
 #include <string>
 
@@ -1244,13 +1245,16 @@ char Fl_Preferences::get_userdata_path( char *path, int pathlen ) {
 
  \return -1 if anything went wrong, i.e. file could not be opened, permissions
     blocked writing, etc.
- \return 0 if the file was written to disk. This does not check if the disk ran
-    out of space and the file is truncated.
+ \return 0 if the file was written to disk. The file is written to a
+    temporary file first, which then replaces the preferences file, so a full
+    disk or a crash never leaves a truncated file behind.
  \return 1 if no data was written to the database and no write attempt
     to disk was made.
  */
 int Fl_Preferences::flush() {
   int ret = dirty();
+  if (ret == 0)
+    return 1;
   if (ret != 1)
     return ret;
   return rootNode->write();
@@ -1471,14 +1475,37 @@ int Fl_Preferences::RootNode::write() {
   if ( ((root_type_&Fl_Preferences::ROOT_MASK)==Fl_Preferences::SYSTEM) && !(fileAccess_ & Fl_Preferences::SYSTEM_WRITE_OK) )
     return -1;
   fl_make_path_for_file(filename_);
-  FILE *f = fl_fopen( filename_, "wb" );
-  if ( !f )
+  // write to a temporary file first and rename it, so that a crash or a full
+  // disk never leaves a truncated preferences file behind; if the file is a
+  // symbolic link, replace the file it points to and keep the link
+  char *target = Fl::system_driver()->real_path( filename_ );
+  const char *path = target ? target : filename_;
+  size_t n = strlen( path ) + 5;
+  char *tmpname = (char*)malloc( n );
+  snprintf( tmpname, n, "%s.tmp", path );
+  FILE *f = fl_fopen( tmpname, "wb" );
+  if ( !f ) {
+    free( tmpname );
+    free( target );
     return -1;
+  }
   fprintf( f, "; FLTK preferences file format 1.0\n" );
   fprintf( f, "; vendor: %s\n", vendor_ );
   fprintf( f, "; application: %s\n", application_ );
   prefs_->node->write( f );
-  fclose( f );
+  int err = ferror( f );
+  if ( fclose( f ) ) err = 1;
+  if ( !err ) {
+    // the new file gets the access mode of the one it replaces
+    struct stat st;
+    if ( fl_stat( path, &st ) == 0 )
+      fl_chmod( tmpname, st.st_mode & 07777 );
+    err = Fl::system_driver()->replace_file( tmpname, path );
+  }
+  if ( err ) fl_unlink( tmpname );
+  free( tmpname );
+  free( target );
+  if ( err ) return -1;
   if (Fl::system_driver()->preferences_need_protection_check()) {
     // unix: make sure that system prefs are user-readable
     if (strncmp(filename_, "/etc/fltk/", 10) == 0) {
@@ -1547,6 +1574,17 @@ char Fl_Preferences::RootNode::getPath( char *path, int pathlen ) {
   return ret;
 }
 
+// nodes with fewer entries or children than this search them linearly
+static const int min_hashed = 8;
+
+// FNV-1a hash of the first len bytes of a name
+static unsigned hash_name( const char *name, size_t len ) {
+  unsigned h = 2166136261U;
+  for ( size_t i = 0; i < len; i++ )
+    h = ( h ^ (unsigned char)name[i] ) * 16777619U;
+  return h;
+}
+
 // create a node that represents a group
 // - path must be a single word, preferable alnum(), dot and underscore only. Space is ok.
 Fl_Preferences::Node::Node( const char *path ) {
@@ -1559,6 +1597,9 @@ Fl_Preferences::Node::Node( const char *path ) {
   indexed_ = 0;
   index_ = 0;
   nIndex_ = NIndex_ = 0;
+  entryHash_ = 0;
+  childHash_ = 0;
+  nEntryHash_ = nChildHash_ = nChild_ = 0;
 }
 
 void Fl_Preferences::Node::deleteAllChildren() {
@@ -1568,7 +1609,11 @@ void Fl_Preferences::Node::deleteAllChildren() {
     delete current_node;
   }
   first_child_ = NULL;
-  dirty_ = 1;
+  nChild_ = 0;
+  free( childHash_ );
+  childHash_ = NULL;
+  nChildHash_ = 0;
+  markDirty();
   updateIndex();
 }
 
@@ -1589,7 +1634,10 @@ void Fl_Preferences::Node::deleteAllEntries() {
     nEntry_ = 0;
     NEntry_ = 0;
   }
-  dirty_ = 1;
+  free( entryHash_ );
+  entryHash_ = NULL;
+  nEntryHash_ = 0;
+  markDirty();
 }
 
 // delete this and all depending nodes
@@ -1599,18 +1647,23 @@ Fl_Preferences::Node::~Node() {
   deleteAllChildren();
   deleteAllEntries();
   deleteIndex();
+  deleteHash();
   if ( path_ ) {
     ::free( path_ );
     path_ = NULL;
   }
 }
 
-// recursively check if any entry is dirty (was changed after loading a fresh prefs file)
+// check if any entry in this node or below is dirty (was changed after loading
+// a fresh prefs file); markDirty() sets the flag of all parents as well
 char Fl_Preferences::Node::dirty() {
-  if ( dirty_ ) return 1;
-  if ( next_ && next_->dirty() ) return 1;
-  if ( first_child_ && first_child_->dirty() ) return 1;
-  return 0;
+  return dirty_;
+}
+
+// mark this node and all its parents as changed
+void Fl_Preferences::Node::markDirty() {
+  for ( Node *nd = this; nd && !nd->dirty_; nd = nd->parent() )
+    nd->dirty_ = 1;
 }
 
 // recursively clear all dirty flags
@@ -1623,11 +1676,8 @@ void Fl_Preferences::Node::clearDirtyFlags() {
   }
 }
 
-// write this node (recursively from the last neighbor back to this)
-// write all entries
-// write all children
+// write this node: all entries, then all children in the order they were created
 int Fl_Preferences::Node::write( FILE *f ) {
-  if ( next_ ) next_->write( f );
   fprintf( f, "\n[%s]\n\n", path_ );
   for ( int i = 0; i < nEntry_; i++ ) {
     char *src = entry_[i].value;
@@ -1652,7 +1702,11 @@ int Fl_Preferences::Node::write( FILE *f ) {
     else
       fprintf( f, "%s\n", entry_[i].name );
   }
-  if ( first_child_ ) first_child_->write( f );
+  if ( first_child_ ) {
+    createIndex();
+    for ( int i = 0; i < nIndex_; i++ )
+      index_[i]->write( f );
+  }
   dirty_ = 0;
   return 0;
 }
@@ -1665,6 +1719,9 @@ void Fl_Preferences::Node::setParent( Node *pn ) {
   snprintf( nameBuffer, sizeof(nameBuffer), "%s/%s", pn->path_, path_ );
   free( path_ );
   path_ = fl_strdup( nameBuffer );
+  pn->nChild_++;
+  pn->hashChild( this );
+  pn->updateIndex();
 }
 
 // find the corresponding root node
@@ -1684,25 +1741,23 @@ Fl_Preferences::Node *Fl_Preferences::Node::addChild( const char *path ) {
   char *name = fl_strdup( nameBuffer );
   Node *nd = find( name );
   free( name );
-  updateIndex();
   return nd;
 }
 
 // create and set, or change an entry within this node
 void Fl_Preferences::Node::set( const char *name, const char *value )
 {
-  for ( int i=0; i<nEntry_; i++ ) {
-    if ( strcmp( name, entry_[i].name ) == 0 ) {
-      if ( !value ) return; // annotation
-      if ( strcmp( value, entry_[i].value ) != 0 ) {
-        if ( entry_[i].value )
-          free( entry_[i].value );
-        entry_[i].value = fl_strdup( value );
-        dirty_ = 1;
-      }
-      lastEntrySet = i;
-      return;
+  int i = getEntry( name );
+  if ( i >= 0 ) {
+    if ( !value ) return; // annotation
+    if ( strcmp( value, entry_[i].value ) != 0 ) {
+      if ( entry_[i].value )
+        free( entry_[i].value );
+      entry_[i].value = fl_strdup( value );
+      markDirty();
     }
+    lastEntrySet = i;
+    return;
   }
   if ( NEntry_==nEntry_ ) {
     NEntry_ = NEntry_ ? NEntry_*2 : 10;
@@ -1712,7 +1767,8 @@ void Fl_Preferences::Node::set( const char *name, const char *value )
   entry_[ nEntry_ ].value = value?fl_strdup(value):0;
   lastEntrySet = nEntry_;
   nEntry_++;
-  dirty_ = 1;
+  hashEntry( lastEntrySet );
+  markDirty();
 }
 
 // create or set a value (or annotation) from a single line in the file buffer
@@ -1756,21 +1812,36 @@ const char *Fl_Preferences::Node::get( const char *name ) {
 
 // find the index of an entry, returns -1 if no such entry
 int Fl_Preferences::Node::getEntry( const char *name ) {
-  for ( int i=0; i<nEntry_; i++ ) {
-    if ( strcmp( name, entry_[i].name ) == 0 ) {
-      return i;
+  if ( nEntry_ < min_hashed ) {
+    for ( int i=0; i<nEntry_; i++ ) {
+      if ( strcmp( name, entry_[i].name ) == 0 ) {
+        return i;
+      }
     }
+    return -1;
+  }
+  if ( !entryHash_ ) rebuildEntryHash();
+  size_t len = strlen( name );
+  for ( unsigned h = hash_name( name, len ); ; h++ ) {
+    int ix = entryHash_[ h & (nEntryHash_-1) ] - 1;
+    if ( ix < 0 ) return -1;
+    if ( strcmp( name, entry_[ix].name ) == 0 ) return ix;
   }
-  return -1;
 }
 
 // remove one entry form this group
 char Fl_Preferences::Node::deleteEntry( const char *name ) {
   int ix = getEntry( name );
   if ( ix == -1 ) return 0;
+  free( entry_[ix].name );
+  free( entry_[ix].value );
   memmove( entry_+ix, entry_+ix+1, (nEntry_-ix-1) * sizeof(Entry) );
   nEntry_--;
-  dirty_ = 1;
+  // the indices of the following entries changed
+  free( entryHash_ );
+  entryHash_ = NULL;
+  nEntryHash_ = 0;
+  markDirty();
   return 1;
 }
 
@@ -1783,18 +1854,15 @@ Fl_Preferences::Node *Fl_Preferences::Node::find( const char *path ) {
     if ( path[ len ] == 0 )
       return this;
     if ( path[ len ] == '/' ) {
-      Node *nd;
-      for ( nd = first_child_; nd; nd = nd->next_ ) {
-        Node *nn = nd->find( path );
-        if ( nn ) return nn;
-      }
       const char *s = path+len+1;
       const char *e = strchr( s, '/' );
+      Node *nd = findChild( s, e ? e-s : strlen( s ) );
+      if ( nd ) return nd->find( path );
       if (e) strlcpy( nameBuffer, s, e-s+1 );
       else strlcpy( nameBuffer, s, sizeof(nameBuffer));
       nd = new Node( nameBuffer );
       nd->setParent( this );
-      dirty_ = 1;
+      markDirty();
       return nd->find( path );
     }
   }
@@ -1821,23 +1889,15 @@ Fl_Preferences::Node *Fl_Preferences::Node::search( const char *path, int offset
         return nn->search( path+2, 2 ); // do a relative search on the root node
       }
     }
-    offset = (int) strlen( path_ ) + 1;
   }
-  int len = (int) strlen( path_ );
-  if ( len < offset-1 ) return 0;
-  len -= offset;
-  if ( ( len <= 0 ) || ( strncmp( path, path_+offset, len ) == 0 ) ) {
-    if ( len > 0 && path[ len ] == 0 )
-      return this;
-    if ( len <= 0 || path[ len ] == '/' ) {
-      for ( Node *nd = first_child_; nd; nd = nd->next_ ) {
-        Node *nn = nd->search( path, offset );
-        if ( nn ) return nn;
-      }
-      return 0;
-    }
+  // walk down the tree, one group name at a time
+  Node *nd = this;
+  for (;;) {
+    const char *e = strchr( path, '/' );
+    nd = nd->findChild( path, e ? e-path : strlen( path ) );
+    if ( !nd || !e ) return nd;
+    path = e+1;
   }
-  return 0;
 }
 
 // return the number of child nodes (groups)
@@ -1906,7 +1966,13 @@ char Fl_Preferences::Node::remove() {
         break;
       }
     }
-    parent_node->dirty_ = 1;
+    if ( nd ) {
+      parent_node->nChild_--;
+      free( parent_node->childHash_ ); // rebuilt when needed
+      parent_node->childHash_ = NULL;
+      parent_node->nChildHash_ = 0;
+    }
+    parent_node->markDirty();
     parent_node->updateIndex();
   }
   delete this;
@@ -1941,6 +2007,82 @@ void Fl_Preferences::Node::deleteIndex() {
   indexed_ = 0;
 }
 
+// Nodes with many entries or children find them in open addressing hash
+// tables with linear probing. The tables have at least twice as many slots
+// as there are entries or children. They are built by the first lookup and
+// kept up to date when names are added, but simply deleted when names are
+// removed, because that changes the indices of the entries.
+
+// add entry ix to the hash table, if there is one
+void Fl_Preferences::Node::hashEntry( int ix ) {
+  if ( !entryHash_ ) return;
+  if ( 2*nEntry_ > nEntryHash_ ) { rebuildEntryHash(); return; }
+  unsigned h = hash_name( entry_[ix].name, strlen( entry_[ix].name ) );
+  while ( entryHash_[ h & (nEntryHash_-1) ] ) h++;
+  entryHash_[ h & (nEntryHash_-1) ] = ix + 1;
+}
+
+void Fl_Preferences::Node::rebuildEntryHash() {
+  free( entryHash_ );
+  nEntryHash_ = 16;
+  while ( nEntryHash_ < 4*nEntry_ ) nEntryHash_ *= 2;
+  entryHash_ = (int*)calloc( nEntryHash_, sizeof(int) );
+  for ( int i = 0; i < nEntry_; i++ ) {
+    unsigned h = hash_name( entry_[i].name, strlen( entry_[i].name ) );
+    while ( entryHash_[ h & (nEntryHash_-1) ] ) h++;
+    entryHash_[ h & (nEntryHash_-1) ] = i + 1;
+  }
+}
+
+// add a new child to the hash table, if there is one
+void Fl_Preferences::Node::hashChild( Node *nd ) {
+  if ( !childHash_ ) return;
+  if ( 2*nChild_ > nChildHash_ ) { rebuildChildHash(); return; }
+  const char *name = nd->name();
+  unsigned h = hash_name( name, strlen( name ) );
+  while ( childHash_[ h & (nChildHash_-1) ] ) h++;
+  childHash_[ h & (nChildHash_-1) ] = nd;
+}
+
+void Fl_Preferences::Node::rebuildChildHash() {
+  free( childHash_ );
+  nChildHash_ = 16;
+  while ( nChildHash_ < 4*nChild_ ) nChildHash_ *= 2;
+  childHash_ = (Node**)calloc( nChildHash_, sizeof(Node*) );
+  for ( Node *nd = first_child_; nd; nd = nd->next_ ) {
+    const char *name = nd->name();
+    unsigned h = hash_name( name, strlen( name ) );
+    while ( childHash_[ h & (nChildHash_-1) ] ) h++;
+    childHash_[ h & (nChildHash_-1) ] = nd;
+  }
+}
+
+void Fl_Preferences::Node::deleteHash() {
+  free( entryHash_ );
+  free( childHash_ );
+  entryHash_ = NULL;
+  childHash_ = NULL;
+  nEntryHash_ = nChildHash_ = 0;
+}
+
+// find the child with the given name of len bytes, returns 0 if there is none
+Fl_Preferences::Node *Fl_Preferences::Node::findChild( const char *name, size_t len ) {
+  if ( nChild_ < min_hashed ) {
+    for ( Node *nd = first_child_; nd; nd = nd->next_ ) {
+      const char *n = nd->name();
+      if ( strncmp( n, name, len ) == 0 && n[len] == 0 ) return nd;
+    }
+    return 0;
+  }
+  if ( !childHash_ ) rebuildChildHash();
+  for ( unsigned h = hash_name( name, len ); ; h++ ) {
+    Node *nd = childHash_[ h & (nChildHash_-1) ];
+    if ( !nd ) return 0;
+    const char *n = nd->name();
+    if ( strncmp( n, name, len ) == 0 && n[len] == 0 ) return nd;
+  }
+}
+
 /**
  \brief Create a plugin.
 
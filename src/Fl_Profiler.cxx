@@ -0,0 +1,236 @@
+//
+// Event loop and draw profiler for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Profiler.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Widget.H>
+#include <FL/fl_utf8.h>
+#include <FL/names.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <typeinfo>
+#if defined(__GNUC__)
+#  include <cxxabi.h>
+#endif
+
+namespace {
+
+struct Entry {
+  const char *name;
+  const char *type;       // typeid() name of the widget, or NULL
+  char label[32];         // start of the widget label
+  const void *callback;
+  double ts, dur;         // microseconds since start(), dur < 0 while open
+  int event;
+  unsigned char category;
+};
+
+Entry *ring = NULL;
+int ring_size = 0;
+// Spans are numbered in the order they begin, span n is in ring[n % ring_size].
+// Spans before first_serial are cleared or overwritten.
+long long next_serial = 0;
+long long first_serial = 0;
+Fl_Timestamp epoch;
+
+const char *category_names[] = {
+  "wait", "event", "timeout", "idle", "callback", "draw", "flush", "user"
+};
+
+// Copies at most size-1 bytes of label, without splitting UTF-8 characters
+void copy_label(char *to, const char *label, int size) {
+  int n = 0;
+  if (label) {
+    n = (int)strlen(label);
+    if (n > size - 1) {
+      n = size - 1;
+      while (n > 0 && (label[n] & 0xc0) == 0x80) n--;
+    }
+    memcpy(to, label, n);
+  }
+  to[n] = 0;
+}
+
+void write_string(FILE *f, const char *s) {
+  putc('"', f);
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+    else if (c < 0x20) fprintf(f, "\\u%04x", c);
+    else putc(c, f);
+  }
+  putc('"', f);
+}
+
+// Writes the class name of a widget, demangled if possible
+void write_type(FILE *f, const char *type) {
+#if defined(__GNUC__)
+  int status = -1;
+  char *name = abi::__cxa_demangle(type, NULL, NULL, &status);
+  if (status == 0 && name) {
+    write_string(f, name);
+    free(name);
+    return;
+  }
+  free(name);
+#else
+  if (!strncmp(type, "class ", 6)) type += 6;
+  else if (!strncmp(type, "struct ", 7)) type += 7;
+#endif
+  write_string(f, type);
+}
+
+// Writes microseconds with three decimals, whatever the locale is
+void write_us(FILE *f, double us) {
+  long long ns = (long long)(us * 1000.0 + 0.5);
+  fprintf(f, "%lld.%03d", ns / 1000, (int)(ns % 1000));
+}
+
+const char *event_name(int event) {
+  std::map<int, const char*>::const_iterator it = fl_eventnames.find(event);
+  return it == fl_eventnames.end() ? "unknown event" : it->second;
+}
+
+} // namespace
+
+char Fl_Profiler::active_ = 0;
+
+
+void Fl_Profiler::Span::begin_(Category c, const char *name, const Fl_Widget *w,
+                               const void *cb, int event) {
+  entry_ = next_serial++;
+  Entry &e = ring[entry_ % ring_size];
+  Fl_Timestamp now = Fl::now();
+  e.name = name;
+  e.type = w ? typeid(*w).name() : NULL;
+  copy_label(e.label, w ? w->label() : NULL, sizeof(e.label));
+  e.callback = cb;
+  e.ts = Fl::seconds_between(now, epoch) * 1e6;
+  e.dur = -1;
+  e.event = event;
+  e.category = (unsigned char)c;
+}
+
+
+void Fl_Profiler::Span::end_() {
+  // the entry may have been overwritten, cleared, or reallocated meanwhile
+  if (entry_ < first_serial || next_serial - entry_ > ring_size) return;
+  Entry &e = ring[entry_ % ring_size];
+  Fl_Timestamp now = Fl::now();
+  e.dur = Fl::seconds_between(now, epoch) * 1e6 - e.ts;
+}
+
+
+/**
+  Returns non-zero if FLTK records its own spans, i.e. if it was built
+  with the CMake option FLTK_OPTION_PROFILER.
+*/
+int Fl_Profiler::available() {
+  return FLTK_HAVE_PROFILER;
+}
+
+
+/**
+  Starts recording spans.
+  If the profiler is already running it keeps its spans, unless
+  \p capacity is changed.
+  \param[in] capacity the number of spans kept in the ring buffer
+*/
+void Fl_Profiler::start(int capacity) {
+  if (capacity < 1) capacity = 1;
+  if (capacity != ring_size) {
+    delete[] ring;
+    ring = new Entry[capacity];
+    ring_size = capacity;
+    first_serial = next_serial;
+  }
+  if (first_serial == next_serial) epoch = Fl::now();
+  active_ = 1;
+}
+
+
+/**
+  Stops recording spans. The spans recorded so far are kept until
+  clear() or the next start() with a different capacity.
+*/
+void Fl_Profiler::stop() {
+  active_ = 0;
+}
+
+
+/** Forgets all spans recorded so far. */
+void Fl_Profiler::clear() {
+  first_serial = next_serial;
+  epoch = Fl::now();
+}
+
+
+/** Returns the number of spans in the ring buffer. */
+int Fl_Profiler::count() {
+  long long n = next_serial - first_serial;
+  return n < ring_size ? (int)n : ring_size;
+}
+
+
+/**
+  Writes the spans in the ring buffer to a file in the Chrome trace event
+  format, which can be opened in chrome://tracing or https://ui.perfetto.dev .
+  Spans that have not ended yet are left out.
+  \param[in] filename name of the file, in UTF-8
+  \return 0 on success, -1 if the file can't be written
+*/
+int Fl_Profiler::write_trace(const char *filename) {
+  FILE *f = fl_fopen(filename, "w");
+  if (!f) return -1;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+        "\"args\":{\"name\":\"FLTK\"}}", f);
+  for (long long n = next_serial - count(); n < next_serial; n++) {
+    const Entry &e = ring[n % ring_size];
+    if (e.dur < 0) continue;
+    fputs(",\n{\"name\":", f);
+    if (e.name) write_string(f, e.name);
+    else if (e.event >= 0) write_string(f, event_name(e.event));
+    else if (e.type) write_type(f, e.type);
+    else write_string(f, category_names[e.category]);
+    fprintf(f, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":",
+            category_names[e.category]);
+    write_us(f, e.ts);
+    fputs(",\"dur\":", f);
+    write_us(f, e.dur);
+    fputs(",\"args\":{", f);
+    const char *sep = "";
+    if (e.type) {
+      fputs("\"class\":", f);
+      write_type(f, e.type);
+      fputs(",\"label\":", f);
+      write_string(f, e.label);
+      sep = ",";
+    }
+    if (e.callback) {
+      fprintf(f, "%s\"callback\":\"%p\"", sep, e.callback);
+      sep = ",";
+    }
+    if (e.event >= 0) {
+      fprintf(f, "%s\"event\":", sep);
+      write_string(f, event_name(e.event));
+    }
+    fputs("}}", f);
+  }
+  fputs("\n]}\n", f);
+  return fclose(f) ? -1 : 0;
+}
@@ -0,0 +1,959 @@
+//
+// Retained display lists for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Recording_Graphics_Driver.H"
+#include <FL/Fl.H>
+#include <FL/Fl_Widget.H>
+#include <FL/fl_draw.H>
+#include <map>
+#include <string.h>
+
+// Opcodes of the display list, each one is followed by its arguments
+enum {
+  OP_MATRIX = 1,        // 6 doubles
+  OP_POINT,             // 2 ints
+  OP_RECT,              // 4 ints
+  OP_FOCUS_RECT,        // 4 ints
+  OP_RECTF,             // 4 ints
+  OP_RBOX,              // 6 ints
+  OP_ROUNDED_RECT,      // 5 ints
+  OP_ROUNDED_RECTF,     // 5 ints
+  OP_COLORED_RECTF,     // 7 ints
+  OP_LINE4,             // 4 ints
+  OP_LINE6,             // 6 ints
+  OP_XYLINE3,           // 3 ints
+  OP_XYLINE4,           // 4 ints
+  OP_XYLINE5,           // 5 ints
+  OP_YXLINE3,           // 3 ints
+  OP_YXLINE4,           // 4 ints
+  OP_YXLINE5,           // 5 ints
+  OP_LOOP6,             // 6 ints
+  OP_LOOP8,             // 8 ints
+  OP_POLYGON6,          // 6 ints
+  OP_POLYGON8,          // 8 ints
+  OP_PUSH_CLIP,         // 4 ints
+  OP_PUSH_NO_CLIP,
+  OP_POP_CLIP,
+  OP_RESTORE_CLIP,
+  OP_BEGIN_POINTS,
+  OP_BEGIN_LINE,
+  OP_BEGIN_LOOP,
+  OP_BEGIN_POLYGON,
+  OP_BEGIN_COMPLEX_POLYGON,
+  OP_TRANSFORMED_VERTEX,  // 2 doubles
+  OP_TRANSFORMED_VERTEX0, // 2 doubles (recorded from floats)
+  OP_VERTEX,            // 2 doubles
+  OP_END_POINTS,
+  OP_END_LINE,
+  OP_END_LOOP,
+  OP_FIXLOOP,
+  OP_END_POLYGON,
+  OP_END_COMPLEX_POLYGON,
+  OP_GAP,
+  OP_CIRCLE,            // 3 doubles
+  OP_ARC_D,             // 5 doubles
+  OP_ARC_I,             // 4 ints, 2 doubles
+  OP_PIE,               // 4 ints, 2 doubles
+  OP_DRAW_CIRCLE,       // 4 ints
+  OP_CURVE,             // 8 doubles
+  OP_LINE_STYLE,        // 2 ints, string (length -1 if no dashes)
+  OP_COLOR,             // 1 int
+  OP_COLOR_RGB,         // 3 ints
+  OP_TEXT,              // string, 2 ints
+  OP_TEXT_F,            // string, 2 doubles (recorded from floats)
+  OP_TEXT_ANGLE,        // 1 int, string, 2 ints
+  OP_RTL_TEXT,          // string, 2 ints
+  OP_FONT,              // 2 ints
+  OP_OVERRIDE_SCALE,
+  OP_RESTORE_SCALE,
+  OP_ANTIALIAS          // 1 int
+};
+
+// All display lists, by widget
+typedef std::map<const Fl_Widget*, Fl_Display_List*> Fl_Display_List_Map;
+static Fl_Display_List_Map display_lists;
+
+Fl_Recording_Graphics_Driver *Fl_Recording_Graphics_Driver::current_ = NULL;
+
+
+bool Fl_Display_List::Key::operator==(const Key &k) const {
+  return x == k.x && y == k.y && w == k.w && h == k.h && scale == k.scale &&
+    driver == k.driver && !memcmp(&m, &k.m, sizeof(m)) && box == k.box &&
+    color == k.color && selection_color == k.selection_color &&
+    labelcolor == k.labelcolor && label == k.label && labelfont == k.labelfont &&
+    labelsize == k.labelsize && align == k.align && image == k.image &&
+    deimage == k.deimage && active == k.active && output == k.output &&
+    focused == k.focused;
+}
+
+
+void Fl_Display_List::make_key(Fl_Widget &w, Fl_Graphics_Driver *d, Key &k) {
+  k.x = w.x(); k.y = w.y(); k.w = w.w(); k.h = w.h();
+  k.driver = Fl_Recording_Graphics_Driver::real_driver(d);
+  k.scale = k.driver->scale();
+  Fl_Recording_Graphics_Driver::get_matrix(d, k.m);
+  k.box = w.box();
+  k.color = w.color();
+  k.selection_color = w.selection_color();
+  k.labelcolor = w.labelcolor();
+  k.label = w.label();
+  k.labelfont = w.labelfont();
+  k.labelsize = w.labelsize();
+  k.align = w.align();
+  k.image = w.image();
+  k.deimage = w.deimage();
+  k.active = w.active_r();
+  k.output = w.output();
+  k.focused = (Fl::focus() == &w);
+}
+
+
+Fl_Display_List *Fl_Display_List::find(const Fl_Widget *w) {
+  Fl_Display_List_Map::iterator it = display_lists.find(w);
+  return it == display_lists.end() ? NULL : it->second;
+}
+
+
+/* Replays the display list of widget \p w with the current graphics driver.
+ Returns false, and does nothing, if the widget has no valid list; the
+ widget must then be drawn as usual.
+ */
+bool Fl_Display_List::replay(Fl_Widget &w) {
+  if (!w.retained_drawing() || !(w.damage() & FL_DAMAGE_ALL)) return false;
+  Fl_Display_List *list = find(&w);
+  if (!list) return false;
+  Key k;
+  make_key(w, fl_graphics_driver, k);
+  if (!(k == list->key_)) {
+    discard(&w);
+    return false;
+  }
+  list->run(fl_graphics_driver);
+  return true;
+}
+
+
+/* Deletes the display list of widget \p w, if any */
+void Fl_Display_List::discard(const Fl_Widget *w) {
+  Fl_Display_List_Map::iterator it = display_lists.find(w);
+  if (it == display_lists.end()) return;
+  delete it->second;
+  display_lists.erase(it);
+}
+
+
+/* Deletes all display lists.
+ This is called when global drawing resources (color map, fonts, scheme)
+ change, because lists only reference these by index.
+ */
+void Fl_Display_List::discard_all() {
+  for (Fl_Display_List_Map::iterator it = display_lists.begin(); it != display_lists.end(); ++it)
+    delete it->second;
+  display_lists.clear();
+}
+
+
+// reads the arguments of an opcode from the list
+namespace {
+  class Reader {
+    const unsigned char *p_;
+  public:
+    Reader(const unsigned char *p) : p_(p) {}
+    const unsigned char *pos() const { return p_; }
+    unsigned char op() { return *p_++; }
+    int i() { int v; memcpy(&v, p_, sizeof(v)); p_ += sizeof(v); return v; }
+    double d() { double v; memcpy(&v, p_, sizeof(v)); p_ += sizeof(v); return v; }
+    const char *s(int &n) {
+      n = i();
+      const char *s = (const char*)p_;
+      if (n > 0) p_ += n;
+      return s;
+    }
+  };
+}
+
+
+void Fl_Display_List::run(Fl_Graphics_Driver *d) const {
+  if (data_.empty()) return;
+  Fl_Graphics_Driver::matrix m0;
+  Fl_Recording_Graphics_Driver::get_matrix(d, m0);
+  std::vector<float> scales;
+  Reader r(&data_[0]);
+  const unsigned char *end = r.pos() + data_.size();
+  while (r.pos() < end) {
+    int a, b, c, e, f, g, h, n;
+    double x, y, z, u, v, w;
+    const char *s;
+    switch (r.op()) {
+      case OP_MATRIX:
+        x = r.d(); y = r.d(); z = r.d(); u = r.d(); v = r.d(); w = r.d();
+        d->load_matrix(x, y, z, u, v, w);
+        break;
+      case OP_POINT: a = r.i(); b = r.i(); d->point(a, b); break;
+      case OP_RECT: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->rect(a, b, c, e); break;
+      case OP_FOCUS_RECT: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->focus_rect(a, b, c, e); break;
+      case OP_RECTF: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->rectf(a, b, c, e); break;
+      case OP_RBOX:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i(); g = r.i();
+        d->_rbox(a, b, c, e, f, g);
+        break;
+      case OP_ROUNDED_RECT:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i();
+        d->rounded_rect(a, b, c, e, f);
+        break;
+      case OP_ROUNDED_RECTF:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i();
+        d->rounded_rectf(a, b, c, e, f);
+        break;
+      case OP_COLORED_RECTF:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i(); g = r.i(); h = r.i();
+        d->colored_rectf(a, b, c, e, (uchar)f, (uchar)g, (uchar)h);
+        break;
+      case OP_LINE4: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->line(a, b, c, e); break;
+      case OP_LINE6:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i(); g = r.i();
+        d->line(a, b, c, e, f, g);
+        break;
+      case OP_XYLINE3: a = r.i(); b = r.i(); c = r.i(); d->xyline(a, b, c); break;
+      case OP_XYLINE4: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->xyline(a, b, c, e); break;
+      case OP_XYLINE5:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i();
+        d->xyline(a, b, c, e, f);
+        break;
+      case OP_YXLINE3: a = r.i(); b = r.i(); c = r.i(); d->yxline(a, b, c); break;
+      case OP_YXLINE4: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->yxline(a, b, c, e); break;
+      case OP_YXLINE5:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i();
+        d->yxline(a, b, c, e, f);
+        break;
+      case OP_LOOP6:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i(); g = r.i();
+        d->loop(a, b, c, e, f, g);
+        break;
+      case OP_LOOP8: {
+        int p[8];
+        for (int i = 0; i < 8; i++) p[i] = r.i();
+        d->loop(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+        break;
+      }
+      case OP_POLYGON6:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); f = r.i(); g = r.i();
+        d->polygon(a, b, c, e, f, g);
+        break;
+      case OP_POLYGON8: {
+        int p[8];
+        for (int i = 0; i < 8; i++) p[i] = r.i();
+        d->polygon(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+        break;
+      }
+      case OP_PUSH_CLIP: a = r.i(); b = r.i(); c = r.i(); e = r.i(); d->push_clip(a, b, c, e); break;
+      case OP_PUSH_NO_CLIP: d->push_no_clip(); break;
+      case OP_POP_CLIP: d->pop_clip(); break;
+      case OP_RESTORE_CLIP: d->restore_clip(); break;
+      case OP_BEGIN_POINTS: d->begin_points(); break;
+      case OP_BEGIN_LINE: d->begin_line(); break;
+      case OP_BEGIN_LOOP: d->begin_loop(); break;
+      case OP_BEGIN_POLYGON: d->begin_polygon(); break;
+      case OP_BEGIN_COMPLEX_POLYGON: d->begin_complex_polygon(); break;
+      case OP_TRANSFORMED_VERTEX: x = r.d(); y = r.d(); d->transformed_vertex(x, y); break;
+      case OP_TRANSFORMED_VERTEX0: x = r.d(); y = r.d(); d->transformed_vertex0((float)x, (float)y); break;
+      case OP_VERTEX: x = r.d(); y = r.d(); d->vertex(x, y); break;
+      case OP_END_POINTS: d->end_points(); break;
+      case OP_END_LINE: d->end_line(); break;
+      case OP_END_LOOP: d->end_loop(); break;
+      case OP_FIXLOOP: d->fixloop(); break;
+      case OP_END_POLYGON: d->end_polygon(); break;
+      case OP_END_COMPLEX_POLYGON: d->end_complex_polygon(); break;
+      case OP_GAP: d->gap(); break;
+      case OP_CIRCLE: x = r.d(); y = r.d(); z = r.d(); d->circle(x, y, z); break;
+      case OP_ARC_D:
+        x = r.d(); y = r.d(); z = r.d(); u = r.d(); v = r.d();
+        d->arc(x, y, z, u, v);
+        break;
+      case OP_ARC_I:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); x = r.d(); y = r.d();
+        d->arc(a, b, c, e, x, y);
+        break;
+      case OP_PIE:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i(); x = r.d(); y = r.d();
+        d->pie(a, b, c, e, x, y);
+        break;
+      case OP_DRAW_CIRCLE:
+        a = r.i(); b = r.i(); c = r.i(); e = r.i();
+        d->draw_circle(a, b, c, (Fl_Color)e);
+        break;
+      case OP_CURVE: {
+        double p[8];
+        for (int i = 0; i < 8; i++) p[i] = r.d();
+        d->curve(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+        break;
+      }
+      case OP_LINE_STYLE: {
+        a = r.i(); b = r.i(); s = r.s(n);
+        if (n < 0) {
+          d->line_style(a, b, NULL);
+        } else { // the driver expects a modifiable, zero-terminated array
+          std::vector<char> dashes(s, s + n);
+          dashes.push_back(0);
+          d->line_style(a, b, &dashes[0]);
+        }
+        break;
+      }
+      case OP_COLOR: d->color((Fl_Color)r.i()); break;
+      case OP_COLOR_RGB: a = r.i(); b = r.i(); c = r.i(); d->color((uchar)a, (uchar)b, (uchar)c); break;
+      case OP_TEXT: s = r.s(n); a = r.i(); b = r.i(); d->draw(s, n, a, b); break;
+      case OP_TEXT_F: s = r.s(n); x = r.d(); y = r.d(); d->draw(s, n, (float)x, (float)y); break;
+      case OP_TEXT_ANGLE: a = r.i(); s = r.s(n); b = r.i(); c = r.i(); d->draw(a, s, n, b, c); break;
+      case OP_RTL_TEXT: s = r.s(n); a = r.i(); b = r.i(); d->rtl_draw(s, n, a, b); break;
+      case OP_FONT: a = r.i(); b = r.i(); d->font((Fl_Font)a, (Fl_Fontsize)b); break;
+      case OP_OVERRIDE_SCALE: scales.push_back(d->override_scale()); break;
+      case OP_RESTORE_SCALE:
+        if (!scales.empty()) {
+          d->restore_scale(scales.back());
+          scales.pop_back();
+        }
+        break;
+      case OP_ANTIALIAS: d->antialias(r.i()); break;
+      default: // can't happen, the list is corrupted
+        d->load_matrix(m0.a, m0.b, m0.c, m0.d, m0.x, m0.y);
+        return;
+    }
+  }
+  d->load_matrix(m0.a, m0.b, m0.c, m0.d, m0.x, m0.y);
+}
+
+
+Fl_Display_List::Recorder::Recorder(Fl_Widget &w) : widget_(w), driver_(NULL) {
+  if (!w.retained_drawing()) return;
+  discard(&w);
+  // only complete drawings of unclipped widgets can be replayed later
+  int X, Y, W, H;
+  if (!(w.damage() & FL_DAMAGE_ALL) ||
+      fl_clip_box(w.x(), w.y(), w.w(), w.h(), X, Y, W, H)) return;
+  Fl_Display_List *list = new Fl_Display_List;
+  make_key(w, fl_graphics_driver, list->key_);
+  driver_ = new Fl_Recording_Graphics_Driver(fl_graphics_driver, list);
+  fl_graphics_driver = driver_;
+}
+
+
+Fl_Display_List::Recorder::~Recorder() {
+  if (!driver_) return;
+  Fl_Display_List *list = driver_->finish();
+  if (fl_graphics_driver == driver_) {
+    fl_graphics_driver = driver_->target();
+  } else if (list) { // draw() changed the drawing surface, the list is incomplete
+    delete list;
+    list = NULL;
+  }
+  delete driver_;
+  if (list) display_lists[&widget_] = list;
+}
+
+
+// Forwards one call to the target driver with the current matrix
+class Fl_Recording_Graphics_Driver::Forward {
+  Fl_Recording_Graphics_Driver *d_;
+public:
+  Forward(Fl_Recording_Graphics_Driver *d) : d_(d) {
+    d->forwarding_++;
+    d->target_->load_matrix(d->m.a, d->m.b, d->m.c, d->m.d, d->m.x, d->m.y);
+  }
+  ~Forward() { d_->forwarding_--; }
+};
+
+#define FORWARD(call) { Forward f_(this); return target_->call; }
+// pixel operations are not forwarded while they are deferred
+#define DRAW(call) { if (deferred_()) return; Forward f_(this); target_->call; }
+
+
+Fl_Recording_Graphics_Driver::Fl_Recording_Graphics_Driver(Fl_Graphics_Driver *target,
+                                                           Fl_Display_List *list,
+                                                           bool defer) {
+  target_ = target;
+  list_ = list;
+  forwarding_ = 0;
+  defer_ = defer;
+  clip_depth_ = 0;
+  max_size_ = Fl_Display_List::max_size;
+  outer_ = current_;
+  current_ = this;
+  Fl_Graphics_Driver::scale(target->scale());
+  get_matrix(target, target_m_);
+  m = list_m_ = target_m_;
+  font_ = target->font();
+  size_ = target->size();
+  color_ = target->color();
+  font_descriptor(target->font_descriptor());
+  // the list starts with the drawing state it depends upon, a deferred
+  // list is drawn later by another driver and also needs the matrix
+  if (defer) {
+    list->data_.push_back(OP_MATRIX);
+    put_(&m.a, sizeof(double)); put_(&m.b, sizeof(double)); put_(&m.c, sizeof(double));
+    put_(&m.d, sizeof(double)); put_(&m.x, sizeof(double)); put_(&m.y, sizeof(double));
+  }
+  list->data_.push_back(OP_COLOR);
+  put_int_((int)color_);
+  if (size_ > 0) {
+    list->data_.push_back(OP_FONT);
+    put_int_(font_);
+    put_int_(size_);
+  }
+}
+
+
+Fl_Recording_Graphics_Driver::~Fl_Recording_Graphics_Driver() {
+  if (list_) delete finish();
+}
+
+
+Fl_Display_List *Fl_Recording_Graphics_Driver::finish() {
+  if (current_ == this) current_ = outer_;
+  target_->load_matrix(target_m_.a, target_m_.b, target_m_.c, target_m_.d,
+                       target_m_.x, target_m_.y);
+  Fl_Display_List *list = list_;
+  list_ = NULL;
+  if (list && !list->replayable_) {
+    delete list;
+    list = NULL;
+  }
+  return list;
+}
+
+
+/* Returns the driver that really draws when \p d is a recording driver */
+Fl_Graphics_Driver *Fl_Recording_Graphics_Driver::real_driver(Fl_Graphics_Driver *d) {
+  for (Fl_Recording_Graphics_Driver *r = current_; r; r = r->outer_) {
+    if (d == r) d = r->target_;
+  }
+  return d;
+}
+
+
+/* Gets the current transformation matrix of driver \p d */
+void Fl_Recording_Graphics_Driver::get_matrix(Fl_Graphics_Driver *d, matrix &m) {
+  m.a = d->transform_dx(1, 0);
+  m.b = d->transform_dy(1, 0);
+  m.c = d->transform_dx(0, 1);
+  m.d = d->transform_dy(0, 1);
+  m.x = d->transform_x(0, 0);
+  m.y = d->transform_y(0, 0);
+}
+
+
+// Returns true if opcode \p op was added to the list, its arguments must follow
+bool Fl_Recording_Graphics_Driver::record_(unsigned char op) {
+  if (forwarding_ || !list_ || !list_->replayable_) return false;
+  if (list_->data_.size() > max_size_) {
+    cannot_replay_();
+    return false;
+  }
+  if (memcmp(&m, &list_m_, sizeof(m))) {
+    list_m_ = m;
+    list_->data_.push_back(OP_MATRIX);
+    put_(&m.a, sizeof(double)); put_(&m.b, sizeof(double)); put_(&m.c, sizeof(double));
+    put_(&m.d, sizeof(double)); put_(&m.x, sizeof(double)); put_(&m.y, sizeof(double));
+  }
+  list_->data_.push_back(op);
+  return true;
+}
+
+
+void Fl_Recording_Graphics_Driver::put_(const void *p, size_t n) {
+  const unsigned char *b = (const unsigned char*)p;
+  list_->data_.insert(list_->data_.end(), b, b + n);
+}
+
+
+void Fl_Recording_Graphics_Driver::put_str_(const char *s, int n) {
+  if (n < 0) n = 0;
+  put_int_(n);
+  put_(s, n);
+}
+
+
+// the current drawing can't be replayed, stop recording it
+void Fl_Recording_Graphics_Driver::cannot_replay_() {
+  if (forwarding_ || !list_) return;
+  if (deferred_()) { // draw what was deferred, starting from the initial clip
+    Forward f_(this);
+    for (; clip_depth_ > 0; clip_depth_--) target_->pop_clip();
+    list_->run(target_);
+  }
+  list_->replayable_ = false;
+  std::vector<unsigned char>().swap(list_->data_);
+}
+
+
+// Recorded operations
+
+void Fl_Recording_Graphics_Driver::point(int x, int y) {
+  if (record_(OP_POINT)) { put_int_(x); put_int_(y); }
+  DRAW(point(x, y));
+}
+
+void Fl_Recording_Graphics_Driver::rect(int x, int y, int w, int h) {
+  if (record_(OP_RECT)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); }
+  DRAW(rect(x, y, w, h));
+}
+
+void Fl_Recording_Graphics_Driver::focus_rect(int x, int y, int w, int h) {
+  if (record_(OP_FOCUS_RECT)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); }
+  DRAW(focus_rect(x, y, w, h));
+}
+
+void Fl_Recording_Graphics_Driver::rectf(int x, int y, int w, int h) {
+  if (record_(OP_RECTF)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); }
+  DRAW(rectf(x, y, w, h));
+}
+
+void Fl_Recording_Graphics_Driver::_rbox(int fill, int x, int y, int w, int h, int r) {
+  if (record_(OP_RBOX)) {
+    put_int_(fill); put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_int_(r);
+  }
+  DRAW(_rbox(fill, x, y, w, h, r));
+}
+
+void Fl_Recording_Graphics_Driver::rounded_rect(int x, int y, int w, int h, int r) {
+  if (record_(OP_ROUNDED_RECT)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_int_(r); }
+  DRAW(rounded_rect(x, y, w, h, r));
+}
+
+void Fl_Recording_Graphics_Driver::rounded_rectf(int x, int y, int w, int h, int r) {
+  if (record_(OP_ROUNDED_RECTF)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_int_(r); }
+  DRAW(rounded_rectf(x, y, w, h, r));
+}
+
+void Fl_Recording_Graphics_Driver::colored_rectf(int x, int y, int w, int h, uchar r, uchar g, uchar b) {
+  if (record_(OP_COLORED_RECTF)) {
+    put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_int_(r); put_int_(g); put_int_(b);
+  }
+  DRAW(colored_rectf(x, y, w, h, r, g, b));
+}
+
+void Fl_Recording_Graphics_Driver::line(int x, int y, int x1, int y1) {
+  if (record_(OP_LINE4)) { put_int_(x); put_int_(y); put_int_(x1); put_int_(y1); }
+  DRAW(line(x, y, x1, y1));
+}
+
+void Fl_Recording_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y2) {
+  if (record_(OP_LINE6)) {
+    put_int_(x); put_int_(y); put_int_(x1); put_int_(y1); put_int_(x2); put_int_(y2);
+  }
+  DRAW(line(x, y, x1, y1, x2, y2));
+}
+
+void Fl_Recording_Graphics_Driver::xyline(int x, int y, int x1) {
+  if (record_(OP_XYLINE3)) { put_int_(x); put_int_(y); put_int_(x1); }
+  DRAW(xyline(x, y, x1));
+}
+
+void Fl_Recording_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
+  if (record_(OP_XYLINE4)) { put_int_(x); put_int_(y); put_int_(x1); put_int_(y2); }
+  DRAW(xyline(x, y, x1, y2));
+}
+
+void Fl_Recording_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
+  if (record_(OP_XYLINE5)) { put_int_(x); put_int_(y); put_int_(x1); put_int_(y2); put_int_(x3); }
+  DRAW(xyline(x, y, x1, y2, x3));
+}
+
+void Fl_Recording_Graphics_Driver::yxline(int x, int y, int y1) {
+  if (record_(OP_YXLINE3)) { put_int_(x); put_int_(y); put_int_(y1); }
+  DRAW(yxline(x, y, y1));
+}
+
+void Fl_Recording_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
+  if (record_(OP_YXLINE4)) { put_int_(x); put_int_(y); put_int_(y1); put_int_(x2); }
+  DRAW(yxline(x, y, y1, x2));
+}
+
+void Fl_Recording_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
+  if (record_(OP_YXLINE5)) { put_int_(x); put_int_(y); put_int_(y1); put_int_(x2); put_int_(y3); }
+  DRAW(yxline(x, y, y1, x2, y3));
+}
+
+void Fl_Recording_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
+  if (record_(OP_LOOP6)) {
+    put_int_(x0); put_int_(y0); put_int_(x1); put_int_(y1); put_int_(x2); put_int_(y2);
+  }
+  DRAW(loop(x0, y0, x1, y1, x2, y2));
+}
+
+void Fl_Recording_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
+  if (record_(OP_LOOP8)) {
+    put_int_(x0); put_int_(y0); put_int_(x1); put_int_(y1);
+    put_int_(x2); put_int_(y2); put_int_(x3); put_int_(y3);
+  }
+  DRAW(loop(x0, y0, x1, y1, x2, y2, x3, y3));
+}
+
+void Fl_Recording_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
+  if (record_(OP_POLYGON6)) {
+    put_int_(x0); put_int_(y0); put_int_(x1); put_int_(y1); put_int_(x2); put_int_(y2);
+  }
+  DRAW(polygon(x0, y0, x1, y1, x2, y2));
+}
+
+void Fl_Recording_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
+  if (record_(OP_POLYGON8)) {
+    put_int_(x0); put_int_(y0); put_int_(x1); put_int_(y1);
+    put_int_(x2); put_int_(y2); put_int_(x3); put_int_(y3);
+  }
+  DRAW(polygon(x0, y0, x1, y1, x2, y2, x3, y3));
+}
+
+void Fl_Recording_Graphics_Driver::push_clip(int x, int y, int w, int h) {
+  if (record_(OP_PUSH_CLIP)) { put_int_(x); put_int_(y); put_int_(w); put_int_(h); clip_depth_++; }
+  FORWARD(push_clip(x, y, w, h));
+}
+
+void Fl_Recording_Graphics_Driver::push_no_clip() {
+  if (record_(OP_PUSH_NO_CLIP)) clip_depth_++;
+  FORWARD(push_no_clip());
+}
+
+void Fl_Recording_Graphics_Driver::pop_clip() {
+  if (record_(OP_POP_CLIP)) clip_depth_--;
+  FORWARD(pop_clip());
+}
+
+void Fl_Recording_Graphics_Driver::restore_clip() {
+  record_(OP_RESTORE_CLIP);
+  FORWARD(restore_clip());
+}
+
+void Fl_Recording_Graphics_Driver::begin_points() {
+  record_(OP_BEGIN_POINTS);
+  DRAW(begin_points());
+}
+
+void Fl_Recording_Graphics_Driver::begin_line() {
+  record_(OP_BEGIN_LINE);
+  DRAW(begin_line());
+}
+
+void Fl_Recording_Graphics_Driver::begin_loop() {
+  record_(OP_BEGIN_LOOP);
+  DRAW(begin_loop());
+}
+
+void Fl_Recording_Graphics_Driver::begin_polygon() {
+  record_(OP_BEGIN_POLYGON);
+  DRAW(begin_polygon());
+}
+
+void Fl_Recording_Graphics_Driver::begin_complex_polygon() {
+  record_(OP_BEGIN_COMPLEX_POLYGON);
+  DRAW(begin_complex_polygon());
+}
+
+void Fl_Recording_Graphics_Driver::transformed_vertex(double xf, double yf) {
+  if (record_(OP_TRANSFORMED_VERTEX)) { put_double_(xf); put_double_(yf); }
+  DRAW(transformed_vertex(xf, yf));
+}
+
+void Fl_Recording_Graphics_Driver::transformed_vertex0(float x, float y) {
+  if (record_(OP_TRANSFORMED_VERTEX0)) { put_double_(x); put_double_(y); }
+  DRAW(transformed_vertex0(x, y));
+}
+
+void Fl_Recording_Graphics_Driver::vertex(double x, double y) {
+  if (record_(OP_VERTEX)) { put_double_(x); put_double_(y); }
+  DRAW(vertex(x, y));
+}
+
+void Fl_Recording_Graphics_Driver::end_points() {
+  record_(OP_END_POINTS);
+  DRAW(end_points());
+}
+
+void Fl_Recording_Graphics_Driver::end_line() {
+  record_(OP_END_LINE);
+  DRAW(end_line());
+}
+
+void Fl_Recording_Graphics_Driver::end_loop() {
+  record_(OP_END_LOOP);
+  DRAW(end_loop());
+}
+
+void Fl_Recording_Graphics_Driver::fixloop() {
+  record_(OP_FIXLOOP);
+  DRAW(fixloop());
+}
+
+void Fl_Recording_Graphics_Driver::end_polygon() {
+  record_(OP_END_POLYGON);
+  DRAW(end_polygon());
+}
+
+void Fl_Recording_Graphics_Driver::end_complex_polygon() {
+  record_(OP_END_COMPLEX_POLYGON);
+  DRAW(end_complex_polygon());
+}
+
+void Fl_Recording_Graphics_Driver::gap() {
+  record_(OP_GAP);
+  DRAW(gap());
+}
+
+void Fl_Recording_Graphics_Driver::circle(double x, double y, double r) {
+  if (record_(OP_CIRCLE)) { put_double_(x); put_double_(y); put_double_(r); }
+  DRAW(circle(x, y, r));
+}
+
+void Fl_Recording_Graphics_Driver::arc(double x, double y, double r, double start, double end) {
+  if (record_(OP_ARC_D)) {
+    put_double_(x); put_double_(y); put_double_(r); put_double_(start); put_double_(end);
+  }
+  DRAW(arc(x, y, r, start, end));
+}
+
+void Fl_Recording_Graphics_Driver::arc(int x, int y, int w, int h, double a1, double a2) {
+  if (record_(OP_ARC_I)) {
+    put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_double_(a1); put_double_(a2);
+  }
+  DRAW(arc(x, y, w, h, a1, a2));
+}
+
+void Fl_Recording_Graphics_Driver::pie(int x, int y, int w, int h, double a1, double a2) {
+  if (record_(OP_PIE)) {
+    put_int_(x); put_int_(y); put_int_(w); put_int_(h); put_double_(a1); put_double_(a2);
+  }
+  DRAW(pie(x, y, w, h, a1, a2));
+}
+
+void Fl_Recording_Graphics_Driver::draw_circle(int x, int y, int d, Fl_Color c) {
+  if (record_(OP_DRAW_CIRCLE)) { put_int_(x); put_int_(y); put_int_(d); put_int_((int)c); }
+  if (deferred_()) return;
+  {
+    Forward f_(this);
+    target_->draw_circle(x, y, d, c);
+  }
+  color_ = target_->color();
+}
+
+void Fl_Recording_Graphics_Driver::curve(double X0, double Y0, double X1, double Y1,
+                                         double X2, double Y2, double X3, double Y3) {
+  if (record_(OP_CURVE)) {
+    put_double_(X0); put_double_(Y0); put_double_(X1); put_double_(Y1);
+    put_double_(X2); put_double_(Y2); put_double_(X3); put_double_(Y3);
+  }
+  DRAW(curve(X0, Y0, X1, Y1, X2, Y2, X3, Y3));
+}
+
+void Fl_Recording_Graphics_Driver::line_style(int style, int width, char* dashes) {
+  if (record_(OP_LINE_STYLE)) {
+    put_int_(style); put_int_(width);
+    if (dashes) put_str_(dashes, (int)strlen(dashes));
+    else put_int_(-1);
+  }
+  FORWARD(line_style(style, width, dashes));
+}
+
+void Fl_Recording_Graphics_Driver::color(Fl_Color c) {
+  if (record_(OP_COLOR)) put_int_((int)c);
+  color_ = c;
+  FORWARD(color(c));
+}
+
+void Fl_Recording_Graphics_Driver::color(uchar r, uchar g, uchar b) {
+  if (record_(OP_COLOR_RGB)) { put_int_(r); put_int_(g); put_int_(b); }
+  {
+    Forward f_(this);
+    target_->color(r, g, b);
+  }
+  color_ = target_->color();
+}
+
+void Fl_Recording_Graphics_Driver::draw(const char *str, int nChars, int x, int y) {
+  if (record_(OP_TEXT)) { put_str_(str, nChars); put_int_(x); put_int_(y); }
+  DRAW(draw(str, nChars, x, y));
+}
+
+void Fl_Recording_Graphics_Driver::draw(const char *str, int nChars, float x, float y) {
+  if (record_(OP_TEXT_F)) { put_str_(str, nChars); put_double_(x); put_double_(y); }
+  DRAW(draw(str, nChars, x, y));
+}
+
+void Fl_Recording_Graphics_Driver::draw(int angle, const char *str, int nChars, int x, int y) {
+  if (record_(OP_TEXT_ANGLE)) { put_int_(angle); put_str_(str, nChars); put_int_(x); put_int_(y); }
+  DRAW(draw(angle, str, nChars, x, y));
+}
+
+void Fl_Recording_Graphics_Driver::rtl_draw(const char *str, int nChars, int x, int y) {
+  if (record_(OP_RTL_TEXT)) { put_str_(str, nChars); put_int_(x); put_int_(y); }
+  DRAW(rtl_draw(str, nChars, x, y));
+}
+
+void Fl_Recording_Graphics_Driver::font(Fl_Font face, Fl_Fontsize fsize) {
+  if (record_(OP_FONT)) { put_int_(face); put_int_(fsize); }
+  {
+    Forward f_(this);
+    target_->font(face, fsize);
+  }
+  font_ = target_->font();
+  size_ = target_->size();
+  font_descriptor(target_->font_descriptor());
+}
+
+float Fl_Recording_Graphics_Driver::override_scale() {
+  record_(OP_OVERRIDE_SCALE);
+  FORWARD(override_scale());
+}
+
+void Fl_Recording_Graphics_Driver::restore_scale(float s) {
+  record_(OP_RESTORE_SCALE);
+  FORWARD(restore_scale(s));
+}
+
+void Fl_Recording_Graphics_Driver::antialias(int state) {
+  if (record_(OP_ANTIALIAS)) put_int_(state);
+  FORWARD(antialias(state));
+}
+
+
+// Operations that can't be replayed
+
+void Fl_Recording_Graphics_Driver::draw_image(const uchar* buf, int X,int Y,int W,int H, int D, int L) {
+  cannot_replay_();
+  FORWARD(draw_image(buf, X, Y, W, H, D, L));
+}
+
+void Fl_Recording_Graphics_Driver::draw_image_mono(const uchar* buf, int X,int Y,int W,int H, int D, int L) {
+  cannot_replay_();
+  FORWARD(draw_image_mono(buf, X, Y, W, H, D, L));
+}
+
+void Fl_Recording_Graphics_Driver::draw_image(Fl_Draw_Image_Cb cb, void* data, int X,int Y,int W,int H, int D) {
+  cannot_replay_();
+  FORWARD(draw_image(cb, data, X, Y, W, H, D));
+}
+
+void Fl_Recording_Graphics_Driver::draw_image_mono(Fl_Draw_Image_Cb cb, void* data, int X,int Y,int W,int H, int D) {
+  cannot_replay_();
+  FORWARD(draw_image_mono(cb, data, X, Y, W, H, D));
+}
+
+void Fl_Recording_Graphics_Driver::draw_rgb(Fl_RGB_Image * rgb,int XP, int YP, int WP, int HP, int cx, int cy) {
+  cannot_replay_();
+  FORWARD(draw_rgb(rgb, XP, YP, WP, HP, cx, cy));
+}
+
+void Fl_Recording_Graphics_Driver::draw_pixmap(Fl_Pixmap * pxm,int XP, int YP, int WP, int HP, int cx, int cy) {
+  cannot_replay_();
+  FORWARD(draw_pixmap(pxm, XP, YP, WP, HP, cx, cy));
+}
+
+void Fl_Recording_Graphics_Driver::draw_bitmap(Fl_Bitmap *bm, int XP, int YP, int WP, int HP, int cx, int cy) {
+  cannot_replay_();
+  FORWARD(draw_bitmap(bm, XP, YP, WP, HP, cx, cy));
+}
+
+void Fl_Recording_Graphics_Driver::copy_offscreen(int x, int y, int w, int h, Fl_Offscreen pixmap, int srcx, int srcy) {
+  cannot_replay_();
+  FORWARD(copy_offscreen(x, y, w, h, pixmap, srcx, srcy));
+}
+
+void Fl_Recording_Graphics_Driver::clip_region(Fl_Region r) {
+  cannot_replay_();
+  FORWARD(clip_region(r));
+}
+
+void Fl_Recording_Graphics_Driver::set_color(Fl_Color i, unsigned int c) {
+  cannot_replay_();
+  FORWARD(set_color(i, c));
+}
+
+void Fl_Recording_Graphics_Driver::free_color(Fl_Color i, int overlay) {
+  cannot_replay_();
+  FORWARD(free_color(i, overlay));
+}
+
+void Fl_Recording_Graphics_Driver::overlay_rect(int x, int y, int w , int h) {
+  cannot_replay_();
+  FORWARD(overlay_rect(x, y, w, h));
+}
+
+void Fl_Recording_Graphics_Driver::scale(float f) {
+  cannot_replay_();
+  Fl_Graphics_Driver::scale(f);
+  FORWARD(scale(f));
+}
+
+void Fl_Recording_Graphics_Driver::gc(void *ctxt) {
+  cannot_replay_();
+  FORWARD(gc(ctxt));
+}
+
+// the caller is about to draw with the platform context, bypassing the list
+void *Fl_Recording_Graphics_Driver::gc() {
+  cannot_replay_();
+  FORWARD(gc());
+}
+
+
+// Queries and resource management, forwarded without recording
+
+void Fl_Recording_Graphics_Driver::global_gc() FORWARD(global_gc())
+void Fl_Recording_Graphics_Driver::cache(Fl_Pixmap *img) FORWARD(cache(img))
+void Fl_Recording_Graphics_Driver::cache(Fl_Bitmap *img) FORWARD(cache(img))
+void Fl_Recording_Graphics_Driver::cache(Fl_RGB_Image *img) FORWARD(cache(img))
+void Fl_Recording_Graphics_Driver::uncache(Fl_RGB_Image *img, fl_uintptr_t &id_, fl_uintptr_t &mask_)
+  FORWARD(uncache(img, id_, mask_))
+void Fl_Recording_Graphics_Driver::uncache_pixmap(fl_uintptr_t p) FORWARD(uncache_pixmap(p))
+void Fl_Recording_Graphics_Driver::cache_size(Fl_Image *img, int &width, int &height)
+  FORWARD(cache_size(img, width, height))
+void Fl_Recording_Graphics_Driver::make_unused_color_(unsigned char &r, unsigned char &g,
+                                                      unsigned char &b, int color_count, void **data)
+  FORWARD(make_unused_color_(r, g, b, color_count, data))
+char Fl_Recording_Graphics_Driver::can_do_alpha_blending() FORWARD(can_do_alpha_blending())
+int Fl_Recording_Graphics_Driver::clip_box(int x, int y, int w, int h, int &X, int &Y, int &W, int &H)
+  FORWARD(clip_box(x, y, w, h, X, Y, W, H))
+int Fl_Recording_Graphics_Driver::not_clipped(int x, int y, int w, int h) FORWARD(not_clipped(x, y, w, h))
+Fl_Region Fl_Recording_Graphics_Driver::clip_region() FORWARD(clip_region())
+bool Fl_Recording_Graphics_Driver::can_fill_non_convex_polygon() FORWARD(can_fill_non_convex_polygon())
+Fl_Color Fl_Recording_Graphics_Driver::color() FORWARD(color())
+int Fl_Recording_Graphics_Driver::has_feature(driver_feature feature) FORWARD(has_feature(feature))
+Fl_Font Fl_Recording_Graphics_Driver::font() FORWARD(font())
+Fl_Fontsize Fl_Recording_Graphics_Driver::size() FORWARD(size())
+double Fl_Recording_Graphics_Driver::width(const char *str, int nChars) FORWARD(width(str, nChars))
+double Fl_Recording_Graphics_Driver::width(unsigned int c) FORWARD(width(c))
+void Fl_Recording_Graphics_Driver::text_extents(const char *str, int n, int& dx, int& dy, int& w, int& h)
+  FORWARD(text_extents(str, n, dx, dy, w, h))
+int Fl_Recording_Graphics_Driver::height() FORWARD(height())
+int Fl_Recording_Graphics_Driver::descent() FORWARD(descent())
+uchar **Fl_Recording_Graphics_Driver::mask_bitmap() FORWARD(mask_bitmap())
+float Fl_Recording_Graphics_Driver::scale_font_for_PostScript(Fl_Font_Descriptor *desc, int s)
+  FORWARD(scale_font_for_PostScript(desc, s))
+float Fl_Recording_Graphics_Driver::scale_bitmap_for_PostScript() FORWARD(scale_bitmap_for_PostScript())
+void Fl_Recording_Graphics_Driver::add_rectangle_to_region(Fl_Region r, int x, int y, int w, int h)
+  FORWARD(add_rectangle_to_region(r, x, y, w, h))
+Fl_Region Fl_Recording_Graphics_Driver::XRectangleRegion(int x, int y, int w, int h)
+  FORWARD(XRectangleRegion(x, y, w, h))
+void Fl_Recording_Graphics_Driver::XDestroyRegion(Fl_Region r) FORWARD(XDestroyRegion(r))
+const char *Fl_Recording_Graphics_Driver::get_font_name(Fl_Font fnum, int* ap) FORWARD(get_font_name(fnum, ap))
+int Fl_Recording_Graphics_Driver::get_font_sizes(Fl_Font fnum, int*& sizep) FORWARD(get_font_sizes(fnum, sizep))
+Fl_Font Fl_Recording_Graphics_Driver::set_fonts(const char *name) FORWARD(set_fonts(name))
+Fl_Fontdesc *Fl_Recording_Graphics_Driver::calc_fl_fonts() FORWARD(calc_fl_fonts())
+unsigned Fl_Recording_Graphics_Driver::font_desc_size() FORWARD(font_desc_size())
+const char *Fl_Recording_Graphics_Driver::font_name(int num) FORWARD(font_name(num))
+void Fl_Recording_Graphics_Driver::font_name(int num, const char *name) FORWARD(font_name(num, name))
+PangoFontDescription *Fl_Recording_Graphics_Driver::pango_font_description()
+  FORWARD(pango_font_description())
+int Fl_Recording_Graphics_Driver::antialias() FORWARD(antialias())
+void Fl_Recording_Graphics_Driver::delete_bitmask(fl_uintptr_t bm) FORWARD(delete_bitmask(bm))
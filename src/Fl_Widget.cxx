@@ -18,10 +18,12 @@
 #include <FL/Fl_Widget.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Tooltip.H>
+#include <FL/Fl_Profiler.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_string_functions.h>
 #include <stdlib.h>
 #include "flstring.h"
+#include "Fl_Offscreen_Cache.H"
 
 /*
  The Fl_Widget::type_ property is primarily used as a subtype field to further
@@ -270,6 +272,8 @@ Fl_Widget::~Fl_Widget() {
 #endif // DEBUG_DELETE
   parent_ = 0; // Don't throw focus to a parent widget.
   fl_throw_focus(this);
+  if (flags_ & RETAINED_DRAWING) Fl_Display_List::discard(this);
+  if (flags_ & OFFSCREEN_CACHED) Fl_Offscreen_Cache::discard(this);
   // remove stale entries from default callback queue (Fl::readqueue())
   if (callback_ == default_callback) cleanup_readqueue(this);
   if ( (flags_ & AUTO_DELETE_USER_DATA) && user_data_)
@@ -310,6 +314,94 @@ void Fl_Widget::draw_focus(Fl_Boxtype bt, int X, int Y, int W, int H, Fl_Color b
   fl_draw_box_focus(bt, X, Y, W, H, FL_BLACK, bg);
 }
 
+/**
+  Sets whether this widget replays a recorded display list when it is
+  redrawn unchanged.
+
+  When set, the drawing operations issued by draw() are recorded the next time
+  the widget is completely drawn. Later, when the widget is redrawn only
+  because its parent or window is redrawn (e.g. when the window is exposed or a
+  sibling widget changes), the recorded operations are replayed instead of
+  calling draw() again. This saves the work done by complex but rarely
+  changing widgets, like charts, clocks, or custom dashboards.
+
+  The recorded list is discarded when redraw() or damage() is called for
+  the widget or one of its children, and when its position, size, colors,
+  label, box, active state, focus, or the screen scale change. A widget
+  whose appearance depends on other state must call redraw() when that
+  state changes, which is what all FLTK widgets do.
+
+  Drawings containing images, and drawings that ask the graphics driver for
+  its platform graphics context with fl_graphics_driver->gc(), are not
+  recorded: such widgets are always drawn by draw(). Drawing through global
+  platform variables like \c fl_gc on X11 and Windows can't be detected and
+  is missing when the list is replayed, don't set this flag for widgets
+  that draw with platform calls.
+
+  \param[in] v  non-zero to enable display list recording, 0 to disable it
+  \see retained_drawing() const
+*/
+void Fl_Widget::retained_drawing(int v) {
+  if (v) {
+    set_flag(RETAINED_DRAWING);
+  } else {
+    clear_flag(RETAINED_DRAWING);
+    Fl_Display_List::discard(this);
+  }
+}
+
+/**
+  Sets whether this widget is copied from an offscreen buffer when it is
+  redrawn unchanged.
+
+  When set, the widget is drawn once into an offscreen buffer the next time
+  it is completely drawn, and the buffer is copied to the window instead of
+  calling draw() as long as the widget is not damaged itself. This suits
+  widgets that are expensive to draw and rarely change, like labels with
+  large images, Fl_Help_View pages or SVG icons.
+
+  The buffer is released when redraw() or damage() is called for the widget
+  or one of its children, and re-rendered when its size, colors, label, box,
+  active state, focus, or the screen scale change. A widget whose appearance
+  depends on other state must call redraw() when that state changes.
+
+  The widget's box must paint its whole area: widgets with FL_NO_BOX or a
+  frame box type are always drawn by draw(). Areas not painted by the box,
+  like the corners of rounded boxes, show the color() of the parent.
+
+  Buffers are allocated at the display's drawing resolution. Their total size
+  is limited by offscreen_cache_budget(); when a new buffer would exceed it,
+  the least recently drawn buffers are released.
+
+  \param[in] v  non-zero to enable the offscreen buffer, 0 to disable it
+  \see offscreen_cache() const, retained_drawing(int)
+*/
+void Fl_Widget::offscreen_cache(int v) {
+  if (v) {
+    set_flag(OFFSCREEN_CACHED);
+  } else {
+    clear_flag(OFFSCREEN_CACHED);
+    Fl_Offscreen_Cache::discard(this);
+  }
+}
+
+/**
+  Sets the maximum total size in bytes of the offscreen buffers of all widgets.
+  The default is 32 MB. Buffers exceeding the new budget are released.
+  \see offscreen_cache(int)
+*/
+void Fl_Widget::offscreen_cache_budget(size_t bytes) {
+  Fl_Offscreen_Cache::budget(bytes);
+}
+
+/**
+  Returns the maximum total size in bytes of the offscreen buffers of all widgets.
+  \see offscreen_cache_budget(size_t)
+*/
+size_t Fl_Widget::offscreen_cache_budget() {
+  return Fl_Offscreen_Cache::budget();
+}
+
 void Fl_Widget::activate() {
   if (!active()) {
     clear_flag(INACTIVE);
@@ -471,6 +563,7 @@ void Fl_Widget::bind_deimage(Fl_Image* img) {
 void Fl_Widget::do_callback(Fl_Widget *widget, void *arg, Fl_Callback_Reason reason) {
   Fl::callback_reason_ = reason;
   if (!callback_) return;
+  FL_PROFILE_SPAN(WIDGET_CALLBACK, "callback", this, callback_, -1);
   Fl_Widget_Tracker wp(this);
   callback_(widget, arg);
   if (wp.deleted()) return;
@@ -44,6 +44,7 @@ void Fl_Widget_Surface::draw(Fl_Widget* widget, int delta_x, int delta_y)
 {
   int old_x, old_y, new_x, new_y, is_window;
   if ( ! widget->visible() ) return;
+  if (draw_widget_(widget, delta_x, delta_y)) return;
   bool need_push = !is_current();
   if (need_push) Fl_Surface_Device::push_current(this);
   is_window = (widget->as_window() != NULL);
@@ -19,6 +19,7 @@
 // is now private in class Fl::, and is used to implement this.
 
 #include "Fl_Private.H"
+#include <FL/Fl_Profiler.H>
 
 struct idle_cb {
   void (*cb)(void*);
@@ -43,6 +44,7 @@ static idle_cb* freelist;
 static void call_idle() {
   idle_cb* p = first;
   last = p; first = p->next;
+  FL_PROFILE_SPAN(IDLE, "idle", NULL, p->cb, -1);
   p->cb(p->data); // this may call add_idle() or remove_idle()!
 }
 
@@ -21,6 +21,7 @@
 #include <FL/Fl.H>
 #include "Fl_Screen_Driver.H"
 #include "Fl_System_Driver.H"
+#include "Fl_Offscreen_Cache.H"
 #include <FL/fl_draw.H>
 #include <FL/platform.H>
 #include <FL/math.h>
@@ -235,6 +236,9 @@ int Fl::scheme(const char *s) {
 int Fl::reload_scheme() {
   Fl_Window *win;
 
+  Fl_Display_List::discard_all();
+  Fl_Offscreen_Cache::discard_all();
+
   if (scheme_ && !fl_ascii_strcasecmp(scheme_, "plastic")) {
     // Update the tile image to match the background color...
     uchar r, g, b;
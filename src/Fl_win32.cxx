@@ -57,6 +57,7 @@ void fl_cleanup_dc_list(void);
 #include "Fl_Window_Driver.H"
 #include "Fl_Screen_Driver.H"
 #include "Fl_Timeout.h"
+#include "Fl_Private.H"
 #include "print_button.h"
 #include <FL/Fl_Graphics_Driver.H> // for fl_graphics_driver
 #include "drivers/WinAPI/Fl_WinAPI_Pen_Events.H"
@@ -403,7 +404,8 @@ double Fl_WinAPI_System_Driver::wait(double time_to_wait) {
     }
   }
 
-  if (Fl::idle() || Fl::damage())
+  // damage deferred to the next paced frame waits for its timeout
+  if (Fl::idle() || (Fl::damage() && !Fl::Private::frame_pending_))
     time_to_wait = 0.0;
 
   // if there are no more windows and this timer is set
@@ -467,7 +469,7 @@ double Fl_WinAPI_System_Driver::wait(double time_to_wait) {
     process_awake_handler_requests();
   }
 
-  Fl::flush();
+  Fl::Private::flush_frame();
 
   // This should return 0 if only timer events were handled:
   return 1;
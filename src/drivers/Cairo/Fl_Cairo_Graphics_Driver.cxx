@@ -23,6 +23,7 @@
 
 #include "Fl_Cairo_Graphics_Driver.H"
 #include "../../Fl_Screen_Driver.H"
+#include "../../Fl_Recording_Graphics_Driver.H"
 #include <FL/platform.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_utf8.h>
@@ -38,6 +39,11 @@
 #include <stdlib.h>  // abs(int)
 #include <string.h>  // memcpy()
 #include <stdint.h>  // uint32_t
+#include <vector>
+#if HAVE_PTHREAD
+#  include <pthread.h>
+#  include <unistd.h>  // sysconf()
+#endif
 
 extern unsigned fl_cmap[256]; // defined in fl_color.cxx
 
@@ -117,9 +123,11 @@ Fl_Cairo_Graphics_Driver::Fl_Cairo_Graphics_Driver() : Fl_Graphics_Driver() {
   left_margin = top_margin = 0;
   needs_commit_tag_ = NULL;
   what = NONE;
+  layout_cache_ = NULL;
 }
 
 Fl_Cairo_Graphics_Driver::~Fl_Cairo_Graphics_Driver() {
+  delete layout_cache_;
   if (pango_layout_) g_object_unref(pango_layout_);
   if (pango_context_) g_object_unref(pango_context_);
 }
@@ -1314,14 +1322,119 @@ const char *Fl_Cairo_Graphics_Driver::clean_utf8(const char* str, int &n) {
 }
 
 
+Fl_Pango_Layout_Cache::Fl_Pango_Layout_Cache(PangoContext *context, size_t max_bytes) {
+  PangoFontMap *font_map = pango_context_get_font_map(context); // 1.6
+#if PANGO_VERSION_CHECK(1,22,0)
+  context_ = pango_font_map_create_context(font_map); // 1.22
+#else
+  context_ = pango_context_new();
+  pango_context_set_font_map(context_, font_map);
+#endif
+  bytes_ = 0;
+  max_bytes_ = max_bytes;
+  hits_ = misses_ = evictions_ = 0;
+}
+
+
+Fl_Pango_Layout_Cache::~Fl_Pango_Layout_Cache() {
+  clear();
+  g_object_unref(context_);
+}
+
+
+void Fl_Pango_Layout_Cache::remove_(Entry_List::iterator e) {
+  g_object_unref(e->layout);
+  pango_font_description_free(e->desc);
+  bytes_ -= e->bytes;
+  index_.erase(e->key);
+  lru_.erase(e);
+}
+
+
+void Fl_Pango_Layout_Cache::clear() {
+  while (!lru_.empty()) remove_(--lru_.end());
+}
+
+
+void Fl_Pango_Layout_Cache::max_bytes(size_t m) {
+  max_bytes_ = m;
+  while (bytes_ > max_bytes_ && !lru_.empty()) {
+    remove_(--lru_.end());
+    evictions_++;
+  }
+}
+
+
+// Returns a layout containing text str of n bytes, which must be valid UTF-8,
+// drawn with font description fd of FLTK font number font and size size.
+// The layout remains valid until the next call.
+PangoLayout *Fl_Pango_Layout_Cache::layout(PangoFontDescription *fd, Fl_Font font, int size,
+                                           const char *str, int n) {
+  Key key;
+  key.font = font;
+  key.size = size;
+  key.hash = 14695981039346656037ULL; // 64-bit FNV-1a
+  for (int i = 0; i < n; i++) key.hash = (key.hash ^ (uchar)str[i]) * 1099511628211ULL;
+  std::map<Key, Entry_List::iterator>::iterator it = index_.find(key);
+  if (it != index_.end()) {
+    Entry_List::iterator e = it->second;
+    if (e->text.size() == size_t(n) && memcmp(e->text.data(), str, n) == 0 &&
+        pango_font_description_equal(e->desc, fd)) {
+      hits_++;
+      lru_.splice(lru_.begin(), lru_, e);
+      return e->layout;
+    }
+    remove_(e); // another text with the same hash, or the font changed
+  }
+  misses_++;
+  Entry entry;
+  entry.key = key;
+  entry.text.assign(str, n);
+  entry.desc = pango_font_description_copy(fd);
+  entry.layout = pango_layout_new(context_);
+  pango_layout_set_font_description(entry.layout, fd);
+  pango_layout_set_text(entry.layout, str, n);
+  // a rough estimate of what Pango allocates for a shaped single-line layout
+  entry.bytes = sizeof(Entry) + 2 * sizeof(void*) + 512 + 40 * size_t(n);
+  bytes_ += entry.bytes;
+  lru_.push_front(entry);
+  index_[key] = lru_.begin();
+  while (bytes_ > max_bytes_ && lru_.size() > 1) {
+    remove_(--lru_.end());
+    evictions_++;
+  }
+  return lru_.front().layout;
+}
+
+
+// Returns a layout containing the UTF-8 string str of n bytes in the current font,
+// from the layout cache when possible.
+PangoLayout *Fl_Cairo_Graphics_Driver::shaped_layout_(const char *str, int n) {
+  if (n > Fl_Pango_Layout_Cache::max_length) {
+    pango_layout_set_text(pango_layout_, str, n);
+    return pango_layout_;
+  }
+  if (!layout_cache_) layout_cache_ = new Fl_Pango_Layout_Cache(pango_context_);
+  Fl_Cairo_Font_Descriptor *fd = (Fl_Cairo_Font_Descriptor*)font_descriptor();
+  return layout_cache_->layout(fd->fontref, font(), fd->size, str, n);
+}
+
+
+void Fl_Cairo_Graphics_Driver::text_cache_stats(unsigned long &hits, unsigned long &misses,
+                                                unsigned long &evictions) {
+  hits = layout_cache_ ? layout_cache_->hits() : 0;
+  misses = layout_cache_ ? layout_cache_->misses() : 0;
+  evictions = layout_cache_ ? layout_cache_->evictions() : 0;
+}
+
+
 void Fl_Cairo_Graphics_Driver::draw(const char* str, int n, float x, float y) {
   if (!n) return;
   cairo_save(cairo_);
   Fl_Cairo_Font_Descriptor *fd = (Fl_Cairo_Font_Descriptor*)font_descriptor();
   cairo_translate(cairo_, x - 0.5, y - (fd->line_height - fd->descent) / float(PANGO_SCALE) - 0.5);
   str = clean_utf8(str, n);
-  pango_layout_set_text(pango_layout_, str, n);
-  pango_cairo_show_layout(cairo_, pango_layout_); // 1.1O
+  pango_cairo_show_layout(cairo_, shaped_layout_(str, n)); // 1.1O
   cairo_restore(cairo_);
   surface_needs_commit();
 }
@@ -1388,18 +1501,16 @@ double Fl_Cairo_Graphics_Driver::width(const char* str, int n) {
 int Fl_Cairo_Graphics_Driver::do_width_unscaled_(const char* str, int n) {
   if (!n) return 0;
   str = clean_utf8(str, n);
-  pango_layout_set_text(pango_layout_, str, n);
   PangoRectangle p_rect;
-  pango_layout_get_extents(pango_layout_, NULL, &p_rect);
+  pango_layout_get_extents(shaped_layout_(str, n), NULL, &p_rect);
   return p_rect.width;
 }
 
 
 void Fl_Cairo_Graphics_Driver::text_extents(const char* txt, int n, int& dx, int& dy, int& w, int& h) {
   txt = clean_utf8(txt, n);
-  pango_layout_set_text(pango_layout_, txt, n);
   PangoRectangle ink_rect;
-  pango_layout_get_extents(pango_layout_, &ink_rect, NULL);
+  pango_layout_get_extents(shaped_layout_(txt, n), &ink_rect, NULL);
   double f = PANGO_SCALE;
   Fl_Cairo_Font_Descriptor *fd = (Fl_Cairo_Font_Descriptor*)font_descriptor();
   dx = ink_rect.x / f;
@@ -1548,4 +1659,186 @@ cairo_pattern_t *Fl_Cairo_Graphics_Driver::calc_cairo_mask(const Fl_RGB_Image *r
   return mask_pattern;
 }
 
+
+// Tiled drawing of a display list by several threads
+
+#if HAVE_PTHREAD
+
+namespace {
+
+// Text is drawn and measured with global font tables and caches,
+// so tiles draw text one at a time
+pthread_mutex_t text_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Draws one tile. Text operations can call each other, the driver only
+// takes the text lock at the outermost call.
+class Fl_Cairo_Tile_Graphics_Driver : public Fl_Cairo_Graphics_Driver {
+  int locked_;
+  class Lock {
+    Fl_Cairo_Tile_Graphics_Driver *d_;
+  public:
+    Lock(Fl_Cairo_Tile_Graphics_Driver *d) : d_(d) {
+      if (!d_->locked_++) pthread_mutex_lock(&text_mutex);
+    }
+    ~Lock() {
+      if (!--d_->locked_) pthread_mutex_unlock(&text_mutex);
+    }
+  };
+public:
+  Fl_Cairo_Tile_Graphics_Driver() : locked_(0) {}
+  void font(Fl_Font f, Fl_Fontsize s) FL_OVERRIDE {
+    Lock l(this); Fl_Cairo_Graphics_Driver::font(f, s);
+  }
+  void draw(const char *str, int n, int x, int y) FL_OVERRIDE {
+    draw(str, n, float(x), float(y));
+  }
+  void draw(const char *str, int n, float x, float y) FL_OVERRIDE {
+    Lock l(this); Fl_Cairo_Graphics_Driver::draw(str, n, x, y);
+  }
+  void draw(int angle, const char *str, int n, int x, int y) FL_OVERRIDE {
+    Lock l(this); Fl_Cairo_Graphics_Driver::draw(angle, str, n, x, y);
+  }
+  void rtl_draw(const char *str, int n, int x, int y) FL_OVERRIDE {
+    Lock l(this); Fl_Cairo_Graphics_Driver::rtl_draw(str, n, x, y);
+  }
+  double width(const char *str, int n) FL_OVERRIDE {
+    Lock l(this); return Fl_Cairo_Graphics_Driver::width(str, n);
+  }
+  double width(unsigned c) FL_OVERRIDE {
+    Lock l(this); return Fl_Cairo_Graphics_Driver::width(c);
+  }
+  void text_extents(const char *str, int n, int &dx, int &dy, int &w, int &h) FL_OVERRIDE {
+    Lock l(this); Fl_Cairo_Graphics_Driver::text_extents(str, n, dx, dy, w, h);
+  }
+  int height() FL_OVERRIDE { Lock l(this); return Fl_Cairo_Graphics_Driver::height(); }
+  int descent() FL_OVERRIDE { Lock l(this); return Fl_Cairo_Graphics_Driver::descent(); }
+};
+
+// The tiles of one draw_tiled() call, threads take the next tile to draw
+struct Tile_Job {
+  const Fl_Display_List *list;
+  unsigned char *data;
+  int stride, W, H;
+  cairo_format_t format;
+  cairo_matrix_t matrix;  // user to device space of the surface
+  float scale;
+  int tile_size, columns, count;
+  int next;
+  pthread_mutex_t mutex;
+};
+
+void draw_tile(Tile_Job *job, int i) {
+  int tx = (i % job->columns) * job->tile_size;
+  int ty = (i / job->columns) * job->tile_size;
+  int tw = job->W - tx < job->tile_size ? job->W - tx : job->tile_size;
+  int th = job->H - ty < job->tile_size ? job->H - ty : job->tile_size;
+  // the tile shares the pixels of the surface
+  cairo_surface_t *surf = cairo_image_surface_create_for_data(
+      job->data + ty * job->stride + tx * 4, job->format, tw, th, job->stride);
+  cairo_t *cr = cairo_create(surf);
+  cairo_matrix_t m = job->matrix;
+  m.x0 -= tx;
+  m.y0 -= ty;
+  cairo_set_matrix(cr, &m);
+  cairo_translate(cr, -0.5, -0.5); // set_cairo() translates it back
+  cairo_save(cr);
+  Fl_Cairo_Tile_Graphics_Driver *d = new Fl_Cairo_Tile_Graphics_Driver();
+  d->Fl_Graphics_Driver::scale(job->scale);
+  d->set_cairo(cr, 1);
+  job->list->run(d);
+  pthread_mutex_lock(&text_mutex); // the destructor releases Pango objects
+  delete d;
+  pthread_mutex_unlock(&text_mutex);
+  cairo_destroy(cr);
+  cairo_surface_destroy(surf);
+}
+
+void *tile_worker(void *data) {
+  Tile_Job *job = (Tile_Job*)data;
+  for (;;) {
+    pthread_mutex_lock(&job->mutex);
+    int i = job->next++;
+    pthread_mutex_unlock(&job->mutex);
+    if (i >= job->count) return NULL;
+    draw_tile(job, i);
+  }
+}
+
+} // namespace
+
+#endif // HAVE_PTHREAD
+
+
+/* Draws display list \p list in this driver's surface, which is \p W x \p H
+ pixels large, with \p threads threads each drawing tiles of \p tile_size
+ pixels. 0 threads means one per processor.
+ Returns false, and draws nothing, if the surface can't be drawn in tiles.
+ */
+bool Fl_Cairo_Graphics_Driver::draw_tiled(int W, int H, const Fl_Display_List &list,
+                                          int threads, int tile_size) {
+#if HAVE_PTHREAD
+  if (!cairo_ || tile_size < 16) return false;
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1) threads = 1;
+  cairo_surface_t *target = cairo_get_target(cairo_);
+  cairo_surface_t *image = NULL; // a copy of a surface which is not an image
+  if (cairo_surface_get_type(target) == CAIRO_SURFACE_TYPE_IMAGE) {
+    cairo_format_t f = cairo_image_surface_get_format(target);
+    if (f != CAIRO_FORMAT_RGB24 && f != CAIRO_FORMAT_ARGB32) return false;
+    cairo_surface_flush(target);
+    W = cairo_image_surface_get_width(target);
+    H = cairo_image_surface_get_height(target);
+  } else {
+    if (W < 1 || H < 1) return false;
+    image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, W, H);
+    cairo_t *c = cairo_create(image);
+    cairo_set_source_surface(c, target, 0, 0);
+    cairo_set_operator(c, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(c);
+    cairo_destroy(c);
+    cairo_surface_flush(image);
+  }
+  cairo_surface_t *pixels = image ? image : target;
+  Tile_Job job;
+  job.list = &list;
+  job.data = cairo_image_surface_get_data(pixels);
+  job.stride = cairo_image_surface_get_stride(pixels);
+  job.format = cairo_image_surface_get_format(pixels);
+  job.W = W;
+  job.H = H;
+  cairo_get_matrix(cairo_, &job.matrix);
+  job.scale = scale();
+  job.tile_size = tile_size;
+  job.columns = (W + tile_size - 1) / tile_size;
+  job.count = job.columns * ((H + tile_size - 1) / tile_size);
+  job.next = 0;
+  pthread_mutex_init(&job.mutex, NULL);
+  if (threads > job.count) threads = job.count;
+  std::vector<pthread_t> workers;
+  for (int i = 1; i < threads; i++) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, tile_worker, &job)) break;
+    workers.push_back(t);
+  }
+  tile_worker(&job); // this thread draws tiles too
+  for (size_t i = 0; i < workers.size(); i++) pthread_join(workers[i], NULL);
+  pthread_mutex_destroy(&job.mutex);
+  cairo_surface_mark_dirty(pixels);
+  if (image) {
+    cairo_save(cairo_);
+    cairo_identity_matrix(cairo_);
+    cairo_reset_clip(cairo_);
+    cairo_set_source_surface(cairo_, image, 0, 0);
+    cairo_set_operator(cairo_, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cairo_);
+    cairo_restore(cairo_);
+    cairo_surface_destroy(image);
+  }
+  surface_needs_commit();
+  return true;
+#else
+  return false;
+#endif // HAVE_PTHREAD
+}
+
 #endif // USE_PANGO
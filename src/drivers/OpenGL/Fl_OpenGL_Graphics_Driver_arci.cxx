@@ -39,6 +39,17 @@ void Fl_OpenGL_Graphics_Driver::arc(int x,int y,int w,int h,double a1,double a2)
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
+  if (line_stipple_ == FL_SOLID) {
+    GLfloat px = (GLfloat)(cx+cos(a1)*rx), py = (GLfloat)(cy-sin(a1)*ry);
+    for (int i=1; i<=nSeg; i++) {
+      a1 += incr;
+      GLfloat qx = (GLfloat)(cx+cos(a1)*rx), qy = (GLfloat)(cy-sin(a1)*ry);
+      batch_line(px, py, qx, qy);
+      px = qx; py = qy;
+    }
+    return;
+  }
+  flush_batch();
   glBegin(GL_LINE_STRIP);
   for (int i=0; i<=nSeg; i++) {
     glVertex2d(cx+cos(a1)*rx, cy-sin(a1)*ry);
@@ -61,11 +72,12 @@ void Fl_OpenGL_Graphics_Driver::pie(int x,int y,int w,int h,double a1,double a2)
   int nSeg = (int)(10 * sqrt(rMax))+1;
   double incr = (a2-a1)/(double)nSeg;
 
-  glBegin(GL_TRIANGLE_FAN);
-  glVertex2d(cx, cy);
-  for (int i=0; i<=nSeg; i++) {
-    glVertex2d(cx+cos(a1)*rx, cy-sin(a1)*ry);
+  // a triangle fan around the center
+  GLfloat px = (GLfloat)(cx+cos(a1)*rx), py = (GLfloat)(cy-sin(a1)*ry);
+  for (int i=1; i<=nSeg; i++) {
     a1 += incr;
+    GLfloat qx = (GLfloat)(cx+cos(a1)*rx), qy = (GLfloat)(cy-sin(a1)*ry);
+    batch_triangle((GLfloat)cx, (GLfloat)cy, px, py, qx, qy);
+    px = qx; py = qy;
   }
-  glEnd();
 }
@@ -36,15 +36,18 @@ void Fl_OpenGL_Graphics_Driver::color(Fl_Color i) {
   if (i & 0xffffff00) {
     unsigned rgba = ((unsigned)i)^0x000000ff;
     Fl_Graphics_Driver::color(i);
-    glColor4ub(rgba>>24, rgba>>16, rgba>>8, rgba);
+    rgba_[0] = GLubyte(rgba>>24); rgba_[1] = GLubyte(rgba>>16); rgba_[2] = GLubyte(rgba>>8); rgba_[3] = GLubyte(rgba);
+    glColor4ubv(rgba_);
   } else {
     unsigned rgba = ((unsigned)fl_cmap[i])^0x000000ff;
     Fl_Graphics_Driver::color(fl_cmap[i]);
-    glColor4ub(rgba>>24, rgba>>16, rgba>>8, rgba);
+    rgba_[0] = GLubyte(rgba>>24); rgba_[1] = GLubyte(rgba>>16); rgba_[2] = GLubyte(rgba>>8); rgba_[3] = GLubyte(rgba);
+    glColor4ubv(rgba_);
   }
 }
 
 void Fl_OpenGL_Graphics_Driver::color(uchar r, uchar g, uchar b) {
   Fl_Graphics_Driver::color( fl_rgb_color(r, g, b) );
+  rgba_[0] = r; rgba_[1] = g; rgba_[2] = b; rgba_[3] = 0xff;
   glColor3ub(r,g,b);
 }
@@ -31,6 +31,7 @@
 // OpenGL implementation does not support cap and join types
 
 void Fl_OpenGL_Graphics_Driver::line_style(int style, int width, char* dashes) {
+  flush_batch(); // batched lines use the previous width and stipple
   if (width<1) width = 1;
   line_width_ = (float)width;
 
@@ -28,17 +28,86 @@
 #include <FL/Fl.H>
 #include <FL/math.h>
 
+#ifndef GL_ARRAY_BUFFER_BINDING
+#  define GL_ARRAY_BUFFER_BINDING 0x8894
+#endif
+
+// --- batching of primitives
+
+// Drawing a widget tree issues thousands of tiny rectangles and lines.
+// Instead of one glBegin()/glEnd() pair each, they are accumulated with their
+// color in a client-side vertex array which is sent to OpenGL in one call
+// when the kind of primitive changes, when the clip, the line style, or
+// the texture state is about to change, before anything is drawn without
+// the batch (stippled lines, text, images), and by Fl_Gl_Window::draw_flush()
+// and draw_end(). OpenGL calls of user code in between must be preceded by
+// Fl_Gl_Window::draw_flush().
+
+// Maximum number of vertices accumulated before they are sent to OpenGL
+static const size_t batch_max = 3 * 16384;
+
+void Fl_OpenGL_Graphics_Driver::batch_begin(GLenum mode) {
+  if (mode != batch_mode_ || batch_.size() >= batch_max) {
+    flush_batch();
+    batch_mode_ = mode;
+  }
+}
+
+void Fl_OpenGL_Graphics_Driver::flush_batch() {
+  if (batch_.empty()) return;
+  // client-side vertex arrays are not usable while a vertex buffer object is bound
+  GLint array_buffer = 0;
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+  if (array_buffer) {
+    glBegin(batch_mode_);
+    for (size_t i = 0; i < batch_.size(); i++) {
+      glColor4ubv(batch_[i].rgba);
+      glVertex2f(batch_[i].x, batch_[i].y);
+    }
+    glEnd();
+  } else {
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(Batch_Vertex), &batch_[0].x);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Batch_Vertex), batch_[0].rgba);
+    glDrawArrays(batch_mode_, 0, (GLsizei)batch_.size());
+    glPopClientAttrib();
+  }
+  // the current color is undefined after drawing with a color array
+  glColor4ubv(rgba_);
+  batch_.clear();
+}
+
+// same as glRectf(x, y, r, b)
+void Fl_OpenGL_Graphics_Driver::batch_rect(GLfloat x, GLfloat y, GLfloat r, GLfloat b) {
+  batch_begin(GL_TRIANGLES);
+  batch_vertex(x, y); batch_vertex(r, y); batch_vertex(r, b);
+  batch_vertex(x, y); batch_vertex(r, b); batch_vertex(x, b);
+}
+
+void Fl_OpenGL_Graphics_Driver::batch_line(GLfloat x, GLfloat y, GLfloat x1, GLfloat y1) {
+  batch_begin(GL_LINES);
+  batch_vertex(x, y); batch_vertex(x1, y1);
+}
+
+void Fl_OpenGL_Graphics_Driver::batch_triangle(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2) {
+  batch_begin(GL_TRIANGLES);
+  batch_vertex(x0, y0); batch_vertex(x1, y1); batch_vertex(x2, y2);
+}
+
 // --- line and polygon drawing with integer coordinates
 
 void Fl_OpenGL_Graphics_Driver::point(int x, int y) {
   if (line_width_ == 1.0f) {
-    glBegin(GL_POINTS);
-    glVertex2f(x+0.5f, y+0.5f);
-    glEnd();
+    batch_begin(GL_POINTS);
+    batch_vertex(x+0.5f, y+0.5f);
   } else {
     float offset = line_width_ / 2.0f;
     float xx = x+0.5f, yy = y+0.5f;
-    glRectf(xx-offset, yy-offset, xx+offset, yy+offset);
+    batch_rect(xx-offset, yy-offset, xx+offset, yy+offset);
   }
 }
 
@@ -46,15 +115,15 @@ void Fl_OpenGL_Graphics_Driver::rect(int x, int y, int w, int h) {
   float offset = line_width_ / 2.0f;
   float xx = x+0.5f, yy = y+0.5f;
   float rr = x+w-0.5f, bb = y+h-0.5f;
-  glRectf(xx-offset, yy-offset, rr+offset, yy+offset);
-  glRectf(xx-offset, bb-offset, rr+offset, bb+offset);
-  glRectf(xx-offset, yy-offset, xx+offset, bb+offset);
-  glRectf(rr-offset, yy-offset, rr+offset, bb+offset);
+  batch_rect(xx-offset, yy-offset, rr+offset, yy+offset);
+  batch_rect(xx-offset, bb-offset, rr+offset, bb+offset);
+  batch_rect(xx-offset, yy-offset, xx+offset, bb+offset);
+  batch_rect(rr-offset, yy-offset, rr+offset, bb+offset);
 }
 
 void Fl_OpenGL_Graphics_Driver::rectf(int x, int y, int w, int h) {
   if (w<=0 || h<=0) return;
-  glRectf((GLfloat)x, (GLfloat)y, (GLfloat)(x+w), (GLfloat)(y+h));
+  batch_rect((GLfloat)x, (GLfloat)y, (GLfloat)(x+w), (GLfloat)(y+h));
 }
 
 void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1) {
@@ -70,22 +139,23 @@ void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1) {
   float xx = x+0.5f, xx1 = x1+0.5f;
   float yy = y+0.5f, yy1 = y1+0.5f;
   if (line_width_==1.0f) {
-    glBegin(GL_LINE_STRIP);
-    glVertex2f(xx, yy);
-    glVertex2f(xx1, yy1);
-    glEnd();
+    if (line_stipple_ == FL_SOLID) {
+      batch_line(xx, yy, xx1, yy1);
+    } else {
+      flush_batch();
+      glBegin(GL_LINE_STRIP);
+      glVertex2f(xx, yy);
+      glVertex2f(xx1, yy1);
+      glEnd();
+    }
   } else {
     float dx = xx1-xx, dy = yy1-yy;
     float len = sqrtf(dx*dx+dy*dy);
     dx = dx/len*line_width_*0.5f;
     dy = dy/len*line_width_*0.5f;
 
-    glBegin(GL_TRIANGLE_STRIP);
-    glVertex2f(xx-dy, yy+dx);
-    glVertex2f(xx+dy, yy-dx);
-    glVertex2f(xx1-dy, yy1+dx);
-    glVertex2f(xx1+dy, yy1-dx);
-    glEnd();
+    batch_triangle(xx-dy, yy+dx, xx+dy, yy-dx, xx1-dy, yy1+dx);
+    batch_triangle(xx+dy, yy-dx, xx1+dy, yy1-dx, xx1-dy, yy1+dx);
   }
 }
 
@@ -98,46 +168,53 @@ void Fl_OpenGL_Graphics_Driver::line(int x, int y, int x1, int y1, int x2, int y
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1) {
   float offset = line_width_ / 2.0f;
   float xx = (float)x, yy = y+0.5f, rr = x1+1.0f;
-  glRectf(xx, yy-offset, rr, yy+offset);
+  batch_rect(xx, yy-offset, rr, yy+offset);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2) {
   float offset = line_width_ / 2.0f;
   float xx = (float)x, yy = y+0.5f, rr = x1+0.5f, bb = y2+1.0f;
-  glRectf(xx, yy-offset, rr+offset, yy+offset);
-  glRectf(rr-offset, yy+offset, rr+offset, bb);
+  batch_rect(xx, yy-offset, rr+offset, yy+offset);
+  batch_rect(rr-offset, yy+offset, rr+offset, bb);
 }
 
 void Fl_OpenGL_Graphics_Driver::xyline(int x, int y, int x1, int y2, int x3) {
   float offset = line_width_ / 2.0f;
   float xx = (float)x, yy = y+0.5f, xx1 = x1+0.5f, rr = x3+1.0f, bb = y2+0.5f;
-  glRectf(xx, yy-offset, xx1+offset, yy+offset);
-  glRectf(xx1-offset, yy+offset, xx1+offset, bb+offset);
-  glRectf(xx1+offset, bb-offset, rr, bb+offset);
+  batch_rect(xx, yy-offset, xx1+offset, yy+offset);
+  batch_rect(xx1-offset, yy+offset, xx1+offset, bb+offset);
+  batch_rect(xx1+offset, bb-offset, rr, bb+offset);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1) {
   float offset = line_width_ / 2.0f;
   float xx = x+0.5f, yy = (float)y, bb = y1+1.0f;
-  glRectf(xx-offset, yy, xx+offset, bb);
+  batch_rect(xx-offset, yy, xx+offset, bb);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2) {
   float offset = line_width_ / 2.0f;
   float xx = x+0.5f, yy = (float)y, rr = x2+1.0f, bb = y1+0.5f;
-  glRectf(xx-offset, yy, xx+offset, bb+offset);
-  glRectf(xx+offset, bb-offset, rr, bb+offset);
+  batch_rect(xx-offset, yy, xx+offset, bb+offset);
+  batch_rect(xx+offset, bb-offset, rr, bb+offset);
 }
 
 void Fl_OpenGL_Graphics_Driver::yxline(int x, int y, int y1, int x2, int y3) {
   float offset = line_width_ / 2.0f;
   float xx = x+0.5f, yy = (float)y, yy1 = y1+0.5f, rr = x2+0.5f, bb = y3+1.0f;
-  glRectf(xx-offset, yy, xx+offset, yy1+offset);
-  glRectf(xx+offset, yy1-offset, rr+offset, yy1+offset);
-  glRectf(rr-offset, yy1+offset, rr+offset, bb);
+  batch_rect(xx-offset, yy, xx+offset, yy1+offset);
+  batch_rect(xx+offset, yy1-offset, rr+offset, yy1+offset);
+  batch_rect(rr-offset, yy1+offset, rr+offset, bb);
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2) {
+  if (line_stipple_ == FL_SOLID) {
+    batch_line((GLfloat)x0, (GLfloat)y0, (GLfloat)x1, (GLfloat)y1);
+    batch_line((GLfloat)x1, (GLfloat)y1, (GLfloat)x2, (GLfloat)y2);
+    batch_line((GLfloat)x2, (GLfloat)y2, (GLfloat)x0, (GLfloat)y0);
+    return;
+  }
+  flush_batch();
   glBegin(GL_LINE_LOOP);
   glVertex2i(x0, y0);
   glVertex2i(x1, y1);
@@ -146,6 +223,14 @@ void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int
 }
 
 void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
+  if (line_stipple_ == FL_SOLID) {
+    batch_line((GLfloat)x0, (GLfloat)y0, (GLfloat)x1, (GLfloat)y1);
+    batch_line((GLfloat)x1, (GLfloat)y1, (GLfloat)x2, (GLfloat)y2);
+    batch_line((GLfloat)x2, (GLfloat)y2, (GLfloat)x3, (GLfloat)y3);
+    batch_line((GLfloat)x3, (GLfloat)y3, (GLfloat)x0, (GLfloat)y0);
+    return;
+  }
+  flush_batch();
   glBegin(GL_LINE_LOOP);
   glVertex2i(x0, y0);
   glVertex2i(x1, y1);
@@ -155,25 +240,19 @@ void Fl_OpenGL_Graphics_Driver::loop(int x0, int y0, int x1, int y1, int x2, int
 }
 
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glEnd();
+  batch_triangle((GLfloat)x0, (GLfloat)y0, (GLfloat)x1, (GLfloat)y1, (GLfloat)x2, (GLfloat)y2);
 }
 
+// the quadrilateral must be convex, as with GL_POLYGON
 void Fl_OpenGL_Graphics_Driver::polygon(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3) {
-  glBegin(GL_POLYGON);
-  glVertex2i(x0, y0);
-  glVertex2i(x1, y1);
-  glVertex2i(x2, y2);
-  glVertex2i(x3, y3);
-  glEnd();
+  batch_triangle((GLfloat)x0, (GLfloat)y0, (GLfloat)x1, (GLfloat)y1, (GLfloat)x2, (GLfloat)y2);
+  batch_triangle((GLfloat)x0, (GLfloat)y0, (GLfloat)x2, (GLfloat)y2, (GLfloat)x3, (GLfloat)y3);
 }
 
 void Fl_OpenGL_Graphics_Driver::focus_rect(int x, int y, int w, int h) {
   float width = line_width_;
   int stipple = line_stipple_;
+  flush_batch(); // the dotted loop is drawn immediately
   line_style(FL_DOT, 1);
   glBegin(GL_LINE_LOOP);
   glVertex2f(x+0.5f, y+0.5f);
@@ -256,6 +335,7 @@ static Fl_Gl_Region gl_rstack[FL_REGION_STACK_SIZE];
  and apply the new clipping area.
  */
 void Fl_OpenGL_Graphics_Driver::push_clip(int x, int y, int w, int h) {
+  flush_batch();
   if (gl_rstackptr==gl_region_stack_max) {
     Fl::warning("Fl_OpenGL_Graphics_Driver::push_clip: clip stack overflow!\n");
     return;
@@ -273,6 +353,7 @@ void Fl_OpenGL_Graphics_Driver::push_clip(int x, int y, int w, int h) {
  Remove the current clipping area and apply the previous one on the stack.
  */
 void Fl_OpenGL_Graphics_Driver::pop_clip() {
+  flush_batch();
   if (gl_rstackptr==0) {
     glDisable(GL_SCISSOR_TEST);
     Fl::warning("Fl_OpenGL_Graphics_Driver::pop_clip: clip stack underflow!\n");
@@ -286,6 +367,7 @@ void Fl_OpenGL_Graphics_Driver::pop_clip() {
  Push a full area onton the stack, so no clipping will take place.
  */
 void Fl_OpenGL_Graphics_Driver::push_no_clip() {
+  flush_batch();
   if (gl_rstackptr==gl_region_stack_max) {
     Fl::warning("Fl_OpenGL_Graphics_Driver::push_no_clip: clip stack overflow!\n");
     return;
@@ -307,6 +389,7 @@ Fl_Region Fl_OpenGL_Graphics_Driver::clip_region() {
  we can.
  */
 void Fl_OpenGL_Graphics_Driver::clip_region(Fl_Region r) {
+  flush_batch();
   if (r==NULL) {
     glDisable(GL_SCISSOR_TEST);
   } else {
@@ -318,6 +401,7 @@ void Fl_OpenGL_Graphics_Driver::clip_region(Fl_Region r) {
  Apply the current clipping rect.
  */
 void Fl_OpenGL_Graphics_Driver::restore_clip() {
+  flush_batch();
   if (gl_rstackptr==0) {
     glDisable(GL_SCISSOR_TEST);
   } else {
@@ -57,50 +57,65 @@
 // double Fl_OpenGL_Graphics_Driver::transform_dx(double x, double y)
 // double Fl_OpenGL_Graphics_Driver::transform_dy(double x, double y)
 
-void Fl_OpenGL_Graphics_Driver::begin_points() {
+// Points, solid lines and loops, and convex polygons are added to the batch
+// of primitives (see Fl_OpenGL_Graphics_Driver_rect.cxx) as GL_POINTS,
+// GL_LINES and GL_TRIANGLES. Stippled lines are drawn immediately so that
+// the stipple pattern continues from one segment to the next.
+
+void Fl_OpenGL_Graphics_Driver::begin_path(SHAPE kind, GLenum mode) {
   n = 0; gap_ = 0;
-  what = POINTS;
-  glBegin(GL_POINTS);
+  what = kind;
+  path_count_ = 0;
+  path_batched_ = (kind == POINTS || kind == POLYGON || line_stipple_ == FL_SOLID);
+  if (!path_batched_) {
+    flush_batch();
+    glBegin(mode);
+  }
+}
+
+void Fl_OpenGL_Graphics_Driver::begin_points() {
+  begin_path(POINTS, GL_POINTS);
 }
 
 void Fl_OpenGL_Graphics_Driver::end_points() {
-  glEnd();
+  if (!path_batched_) glEnd();
+  path_batched_ = false;
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_line() {
-  n = 0; gap_ = 0;
-  what = LINE;
-  glBegin(GL_LINE_STRIP);
+  begin_path(LINE, GL_LINE_STRIP);
 }
 
 void Fl_OpenGL_Graphics_Driver::end_line() {
-  glEnd();
+  if (!path_batched_) glEnd();
+  path_batched_ = false;
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_loop() {
-  n = 0; gap_ = 0;
-  what = LOOP;
-  glBegin(GL_LINE_LOOP);
+  begin_path(LOOP, GL_LINE_LOOP);
 }
 
 void Fl_OpenGL_Graphics_Driver::end_loop() {
-  glEnd();
+  if (!path_batched_) glEnd();
+  else if (path_count_ > 2) batch_line(path_prev_[0], path_prev_[1], path_first_[0], path_first_[1]);
+  path_batched_ = false;
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_polygon() {
-  n = 0; gap_ = 0;
-  what = POLYGON;
-  glBegin(GL_POLYGON);
+  begin_path(POLYGON, GL_POLYGON);
 }
 
 void Fl_OpenGL_Graphics_Driver::end_polygon() {
-  glEnd();
+  if (!path_batched_) glEnd();
+  path_batched_ = false;
 }
 
 void Fl_OpenGL_Graphics_Driver::begin_complex_polygon() {
   n = 0;
   what = COMPLEX_POLYGON;
+  path_batched_ = false;
 #ifndef SLOW_COMPLEX_POLY
+  flush_batch();
   glBegin(GL_POLYGON);
 #endif
 }
@@ -197,7 +212,7 @@ void Fl_OpenGL_Graphics_Driver::end_complex_polygon()
 
     //  fill the pixels between node pairs
 //    Using lines requires additional attention to the current line width and pattern
-//    We are using glRectf instead
+//    We are using batched rectangles instead
 //    glBegin(GL_LINES);
     for (i = 0; i < nNodes; i += 2) {
       float x0 = nodeX[i];
@@ -209,7 +224,7 @@ void Fl_OpenGL_Graphics_Driver::end_complex_polygon()
           x0 = xMin;
         if (x1 > xMax)
           x1 = xMax;
-        glRectf((GLfloat)(x0-0.25f), (GLfloat)(y), (GLfloat)(x1+0.25f), (GLfloat)(y+1.0f));
+        batch_rect((GLfloat)(x0-0.25f), (GLfloat)(y), (GLfloat)(x1+0.25f), (GLfloat)(y+1.0f));
 //        glVertex2f((GLfloat)x0, (GLfloat)y);
 //        glVertex2f((GLfloat)x1, (GLfloat)y);
       }
@@ -238,12 +253,32 @@ void Fl_OpenGL_Graphics_Driver::transformed_vertex(double xf, double yf) {
 #ifdef SLOW_COMPLEX_POLY
   if (what==COMPLEX_POLYGON) {
     Fl_Graphics_Driver::transformed_vertex(xf, yf);
-  } else {
-    glVertex2d(xf, yf);
+    return;
   }
-#else
-  glVertex2d(xf, yf);
 #endif
+  if (!path_batched_) {
+    glVertex2d(xf, yf);
+    return;
+  }
+  GLfloat x = (GLfloat)xf, y = (GLfloat)yf;
+  switch (what) {
+    case POINTS:
+      batch_begin(GL_POINTS);
+      batch_vertex(x, y);
+      break;
+    case LINE:
+    case LOOP:
+      if (path_count_ > 0) batch_line(path_prev_[0], path_prev_[1], x, y);
+      break;
+    case POLYGON: // as a triangle fan
+      if (path_count_ > 1) batch_triangle(path_first_[0], path_first_[1], path_prev_[0], path_prev_[1], x, y);
+      break;
+    default:
+      break;
+  }
+  if (path_count_ == 0) { path_first_[0] = x; path_first_[1] = y; }
+  path_prev_[0] = x; path_prev_[1] = y;
+  path_count_++;
 }
 
 void Fl_OpenGL_Graphics_Driver::circle(double cx, double cy, double r) {
@@ -260,9 +295,10 @@ void Fl_OpenGL_Graphics_Driver::circle(double cx, double cy, double r) {
   double x = r; //we start at angle = 0
   double y = 0;
 
+  flush_batch();
   glBegin(GL_LINE_LOOP);
   for(int ii = 0; ii < num_segments; ii++) {
-    vertex(x + cx, y + cy); // output vertex
+    glVertex2d(transform_x(x + cx, y + cy), transform_y(x + cx, y + cy)); // output vertex
     double tx = -y;
     double ty = x;
     x += tx * tangetial_factor;
@@ -21,6 +21,7 @@
 #include <sys/mman.h>
 #include <unistd.h> // for close()
 #include <errno.h>
+#include <math.h> // for ceil()
 #include <string.h> // for strerror()
 #include <cairo/cairo.h>
 
@@ -54,18 +55,28 @@ void Fl_Wayland_Graphics_Driver::create_shm_buffer(Fl_Wayland_Graphics_Driver::w
   int stride = buffer->draw_buffer.stride;
   int height = buffer->draw_buffer.data_size / stride;
   const size_t default_pool_size = 10000000; // larger pools are possible if needed
-  int chunk_offset = 0; // offset to start of available memory in pool
+  size_t chunk_offset = 0; // offset to start of available memory in pool
   struct wld_shm_pool_data *pool_data = current_pool ? // data record attached to current pool
     (struct wld_shm_pool_data *)wl_shm_pool_get_user_data(current_pool) : NULL;
-  size_t pool_size = current_pool ? pool_data->pool_size : default_pool_size; // current pool size
-  if (current_pool && !wl_list_empty(&pool_data->buffers)) {
-    // last wld_buffer created from current pool
-    struct wld_buffer *record = wl_container_of(pool_data->buffers.next, record, link);
-    chunk_offset = ((char*)record->data - pool_data->pool_memory) +
-                   record->draw_buffer.data_size;
+  struct wl_list *insert_after = NULL; // where to list the new buffer among the pool's buffers
+  if (current_pool) {
+    // The pool's buffers are listed by decreasing offset. Look for the lowest
+    // memory chunk large enough, reusing memory of buffers released since
+    // the pool was created, e.g., after windows were resized.
+    struct wld_buffer *record;
+    wl_list_for_each_reverse(record, &pool_data->buffers, link) {
+      size_t record_offset = (char*)record->data - pool_data->pool_memory;
+      if (record_offset >= chunk_offset + buffer->draw_buffer.data_size) {
+        insert_after = &record->link;
+        break;
+      }
+      chunk_offset = record_offset + record->draw_buffer.data_size;
+    }
+    if (!insert_after && chunk_offset + buffer->draw_buffer.data_size <= pool_data->pool_size)
+      insert_after = &pool_data->buffers;
   }
-  if (!current_pool || chunk_offset + buffer->draw_buffer.data_size > pool_size) {
-    // if true, a new pool is needed
+  if (!insert_after) {
+    // a new pool is needed
     if (current_pool && wl_list_empty(&pool_data->buffers)) {
       wl_shm_pool_destroy(current_pool);
       /*int err = */munmap(pool_data->pool_memory, pool_data->pool_size);
@@ -73,7 +84,7 @@ void Fl_Wayland_Graphics_Driver::create_shm_buffer(Fl_Wayland_Graphics_Driver::w
       free(pool_data);
     }
     chunk_offset = 0;
-    pool_size = default_pool_size;
+    size_t pool_size = default_pool_size;
     if (buffer->draw_buffer.data_size > pool_size)
       pool_size = 2 * buffer->draw_buffer.data_size; // a larger pool is needed
     int fd = libdecor_os_create_anonymous_file(pool_size);
@@ -94,15 +105,18 @@ void Fl_Wayland_Graphics_Driver::create_shm_buffer(Fl_Wayland_Graphics_Driver::w
     pool_data->pool_size = pool_size;
     wl_list_init(&pool_data->buffers);
     wl_shm_pool_set_user_data(current_pool, pool_data);
+    insert_after = &pool_data->buffers;
   }
-  buffer->wl_buffer = wl_shm_pool_create_buffer(current_pool, chunk_offset,
+  buffer->wl_buffer = wl_shm_pool_create_buffer(current_pool, (int32_t)chunk_offset,
                                                 width, height, stride, wld_format);
   wl_buffer_add_listener(buffer->wl_buffer, &buffer_listener, buffer);
-  // add this buffer to head of list of current pool's buffers
-  wl_list_insert(&pool_data->buffers, &buffer->link);
+  // list this buffer among the current pool's buffers, keeping them by decreasing offset
+  wl_list_insert(insert_after, &buffer->link);
   buffer->shm_pool = current_pool;
   buffer->data = (void*)(pool_data->pool_memory + chunk_offset);
-//fprintf(stderr, "last=%p chunk_offset=%d ", pool_data->buffers.next, chunk_offset);
+  if (buffer->stale) cairo_region_destroy(buffer->stale);
+  buffer->stale = NULL; // new memory does not contain anything yet
+//fprintf(stderr, "chunk_offset=%lu ", chunk_offset);
 //fprintf(stderr, "create_shm_buffer: %dx%d = %d\n", width, height, size);
 }
 
@@ -138,51 +152,124 @@ const struct wl_callback_listener *Fl_Wayland_Graphics_Driver::p_surface_frame_l
   &surface_frame_listener;
 
 
-// copy pixels in region r from the Cairo surface to the Wayland buffer
-static void copy_region(struct wld_window *window, cairo_region_t *r) {
-  struct Fl_Wayland_Graphics_Driver::wld_buffer *buffer = window->buffer;
+// Returns the region, in pixels of the window's draw_buffer, corresponding to
+// region r in FLTK units, or to the whole buffer when r is NULL.
+static cairo_region_t *buffer_region(struct wld_window *window, cairo_region_t *r) {
+  struct Fl_Wayland_Graphics_Driver::draw_buffer *draw_buffer = &window->buffer->draw_buffer;
+  cairo_rectangle_int_t all = {0, 0, draw_buffer->width,
+                               int(draw_buffer->data_size / draw_buffer->stride)};
+  if (!r) return cairo_region_create_rectangle(&all);
   float f = Fl::screen_scale(window->fl_win->screen_num());
   int d = Fl_Wayland_Window_Driver::driver(window->fl_win)->wld_scale();
+  cairo_region_t *pixels = cairo_region_create();
   int count = cairo_region_num_rectangles(r);
   cairo_rectangle_int_t rect;
   for (int i = 0; i < count; i++) {
     cairo_region_get_rectangle(r, i, &rect);
     int left = d * int(rect.x * f);
     int top = d * int(rect.y * f);
-    int right = d * ceil((rect.x + rect.width) * f);
-    if (right > d * int(window->fl_win->w() * f)) right = d * int(window->fl_win->w() * f);
-    int width = right - left;
-    int bottom = d * ceil((rect.y + rect.height) * f);
-    if (bottom > d * int(window->fl_win->h() * f)) bottom = d * int(window->fl_win->h() * f);
-    int height = bottom - top;
-    int offset = top * buffer->draw_buffer.stride + 4 * left;
-    int W4 = 4 * width;
-    for (int l = 0; l < height; l++) {
-      if (offset + W4 >= (int)buffer->draw_buffer.data_size) {
-        W4 = buffer->draw_buffer.data_size - offset;
-        if (W4 <= 0) break;
-      }
-      memcpy((uchar*)buffer->data + offset, buffer->draw_buffer.buffer + offset, W4);
-      offset += buffer->draw_buffer.stride;
+    cairo_rectangle_int_t px = {left, top, int(d * ceil((rect.x + rect.width) * f)) - left,
+                                int(d * ceil((rect.y + rect.height) * f)) - top};
+    cairo_region_union_rectangle(pixels, &px);
+  }
+  cairo_region_intersect_rectangle(pixels, &all);
+  return pixels;
+}
+
+
+// Records that the part of the window's draw_buffer corresponding to region r
+// (the whole window if r is NULL) was drawn and is to be sent to the compositor
+// by the next buffer_commit().
+void Fl_Wayland_Graphics_Driver::buffer_damage(struct wld_window *window, cairo_region_t *r) {
+  struct wld_buffer *buffer = window->buffer;
+  if (!buffer || !buffer->damage) return; // everything is already damaged
+  if (!r) {
+    cairo_region_destroy(buffer->damage);
+    buffer->damage = NULL;
+    return;
+  }
+  cairo_region_t *pixels = buffer_region(window, r);
+  cairo_region_union(buffer->damage, pixels);
+  cairo_region_destroy(pixels);
+}
+
+
+// copy pixels in region r of the draw_buffer, or all pixels if r is NULL, to the Wayland buffer
+static void copy_region(struct Fl_Wayland_Graphics_Driver::draw_buffer *draw_buffer,
+                        struct Fl_Wayland_Graphics_Driver::wld_buffer *target,
+                        cairo_region_t *r) {
+  if (!r) {
+    memcpy(target->data, draw_buffer->buffer, draw_buffer->data_size);
+    return;
+  }
+  int count = cairo_region_num_rectangles(r);
+  cairo_rectangle_int_t rect;
+  for (int i = 0; i < count; i++) {
+    cairo_region_get_rectangle(r, i, &rect);
+    size_t offset = rect.y * draw_buffer->stride + 4 * rect.x;
+    for (int l = 0; l < rect.height; l++) {
+      memcpy((uchar*)target->data + offset, draw_buffer->buffer + offset, 4 * rect.width);
+      offset += draw_buffer->stride;
     }
-    wl_surface_damage_buffer(window->wl_surface, left, top, width, height);
   }
 }
 
 
+// Returns a buffer to receive the window's next frame: the window's buffer itself or one
+// of its swap buffers, whichever is not held by the compositor, creating a swap buffer
+// if necessary. Returns the buffer last attached if all are held, as before swap buffers.
+static struct Fl_Wayland_Graphics_Driver::wld_buffer *free_buffer(
+                                        struct Fl_Wayland_Graphics_Driver::wld_buffer *buffer) {
+  if (!buffer->in_use) return buffer;
+  int i;
+  for (i = 0; i < Fl_Wayland_Graphics_Driver::max_swap_buffers - 1 && buffer->swap[i]; i++) {
+    if (!buffer->swap[i]->in_use) return buffer->swap[i];
+  }
+  if (i >= Fl_Wayland_Graphics_Driver::max_swap_buffers - 1) return buffer->front;
+  struct Fl_Wayland_Graphics_Driver::wld_buffer *swap =
+    (struct Fl_Wayland_Graphics_Driver::wld_buffer*)calloc(1,
+                                      sizeof(struct Fl_Wayland_Graphics_Driver::wld_buffer));
+  swap->draw_buffer = buffer->draw_buffer;
+  swap->draw_buffer.buffer = NULL; // pixels are drawn only to buffer's draw_buffer
+  swap->draw_buffer.cairo_ = NULL;
+  Fl_Wayland_Graphics_Driver::create_shm_buffer(swap);
+  buffer->swap[i] = swap;
+  return swap;
+}
+
+
 void Fl_Wayland_Graphics_Driver::buffer_commit(struct wld_window *window, cairo_region_t *r)
 {
-  if (!window->buffer->wl_buffer) create_shm_buffer(window->buffer);
-  cairo_surface_t *surf = cairo_get_target(window->buffer->draw_buffer.cairo_);
+  struct wld_buffer *buffer = window->buffer;
+  if (r) buffer_damage(window, r);
+  if (!buffer->wl_buffer) create_shm_buffer(buffer);
+  cairo_surface_t *surf = cairo_get_target(buffer->draw_buffer.cairo_);
   cairo_surface_flush(surf);
-  if (r) copy_region(window, r);
-  else {
-    memcpy(window->buffer->data, window->buffer->draw_buffer.buffer,
-           window->buffer->draw_buffer.data_size);
+  // the damage is now stale in all Wayland buffers of the window
+  cairo_region_t *damage = buffer->damage ? buffer->damage : buffer_region(window, NULL);
+  for (int i = 0; i < max_swap_buffers; i++) {
+    struct wld_buffer *b = (i == 0 ? buffer : buffer->swap[i - 1]);
+    if (b && b->stale) cairo_region_union(b->stale, damage);
+  }
+  struct wld_buffer *target = free_buffer(buffer);
+  copy_region(&buffer->draw_buffer, target, target->stale);
+  if (target->stale) cairo_region_destroy(target->stale);
+  target->stale = cairo_region_create();
+  if (!buffer->front) { // first frame of this buffer
     wl_surface_damage_buffer(window->wl_surface, 0, 0, 1000000, 1000000);
+  } else {
+    cairo_rectangle_int_t rect;
+    int count = cairo_region_num_rectangles(damage);
+    for (int i = 0; i < count; i++) {
+      cairo_region_get_rectangle(damage, i, &rect);
+      wl_surface_damage_buffer(window->wl_surface, rect.x, rect.y, rect.width, rect.height);
+    }
   }
-  window->buffer->in_use = true;
-  wl_surface_attach(window->wl_surface, window->buffer->wl_buffer, 0, 0);
+  cairo_region_destroy(damage);
+  buffer->damage = cairo_region_create();
+  target->in_use = true;
+  buffer->front = target;
+  wl_surface_attach(window->wl_surface, target->wl_buffer, 0, 0);
   wl_surface_set_buffer_scale( window->wl_surface,
       Fl_Wayland_Window_Driver::driver(window->fl_win)->wld_scale() );
   if (!window->covered) { // see issue #878
@@ -190,7 +277,7 @@ void Fl_Wayland_Graphics_Driver::buffer_commit(struct wld_window *window, cairo_
     wl_callback_add_listener(window->frame_cb, p_surface_frame_listener, window);
   }
   wl_surface_commit(window->wl_surface);
-  window->buffer->draw_buffer_needs_commit = false;
+  buffer->draw_buffer_needs_commit = false;
 }
 
 
@@ -238,6 +325,8 @@ static void do_buffer_release(struct Fl_Wayland_Graphics_Driver::wld_buffer *buf
       free(pool_data);
     }
   }
+  if (buffer->damage) cairo_region_destroy(buffer->damage);
+  if (buffer->stale) cairo_region_destroy(buffer->stale);
   free(buffer);
 }
 
@@ -250,6 +339,12 @@ void Fl_Wayland_Graphics_Driver::buffer_release(struct wld_window *window)
     delete[] window->buffer->draw_buffer.buffer;
     window->buffer->draw_buffer.buffer = NULL;
     cairo_destroy(window->buffer->draw_buffer.cairo_);
+    for (int i = 0; i < max_swap_buffers - 1; i++) {
+      struct wld_buffer *swap = window->buffer->swap[i];
+      if (!swap) break;
+      swap->released = true;
+      if (!swap->in_use) do_buffer_release(swap);
+    }
     if (!window->buffer->in_use) do_buffer_release(window->buffer);
     window->buffer = NULL;
   }
@@ -154,6 +154,15 @@ Fl_RGB_Image* Fl_Wayland_Image_Surface_Driver::image() {
 }
 
 
+bool Fl_Wayland_Image_Surface_Driver::draw_tiled(const Fl_Display_List &list, int threads,
+                                                 int tile_size) {
+  struct Fl_Wayland_Graphics_Driver::draw_buffer *off_buf =
+    Fl_Wayland_Graphics_Driver::offscreen_buffer(offscreen);
+  return ((Fl_Cairo_Graphics_Driver*)driver())->draw_tiled(off_buf->width,
+                      int(off_buf->data_size / off_buf->stride), list, threads, tile_size);
+}
+
+
 void Fl_Wayland_Image_Surface_Driver::mask(const Fl_RGB_Image *mask) {
   bool using_copy = false;
   shape_data_ =  (struct shape_data_type*)calloc(1, sizeof(struct shape_data_type));
@@ -375,6 +375,8 @@ void Fl_Wayland_Window_Driver::make_current() {
     ((Fl_Cairo_Graphics_Driver*)fl_graphics_driver)->needs_commit_tag(
                                             &window->buffer->draw_buffer_needs_commit);
   }
+  // drawing outside flush() may change any part of the window
+  if (!Fl_Wayland_Window_Driver::in_flush_) Fl_Wayland_Graphics_Driver::buffer_damage(window);
   ((Fl_Wayland_Graphics_Driver*)fl_graphics_driver)->set_cairo(
                       window->buffer->draw_buffer.cairo_, f * wld_s);
   ((Fl_Cairo_Graphics_Driver*)fl_graphics_driver)->wld_scale = wld_s;
@@ -423,7 +425,9 @@ void Fl_Wayland_Window_Driver::flush() {
   Fl_Wayland_Window_Driver::in_flush_ = true;
   Fl_Window_Driver::flush();
   Fl_Wayland_Window_Driver::in_flush_ = false;
-  if (!window->frame_cb) Fl_Wayland_Graphics_Driver::buffer_commit(window, r);
+  // if a frame is pending, the damage is committed when it's done
+  Fl_Wayland_Graphics_Driver::buffer_damage(window, r);
+  if (!window->frame_cb) Fl_Wayland_Graphics_Driver::buffer_commit(window);
 }
 
 
@@ -966,7 +970,7 @@ static void handle_configure(struct libdecor_frame *frame,
 #endif
   bool condition = in_decorated_window_resizing;
   if (condition) { // see issue #878
-    condition = (window->covered ? (window->buffer && window->buffer->in_use) : (window->frame_cb != NULL));
+    condition = (window->covered ? (window->buffer && Fl_Wayland_Graphics_Driver::buffer_in_use(window->buffer)) : (window->frame_cb != NULL));
   }
   if (condition) {
     // Skip resizing & redrawing. The last resize request won't be skipped because
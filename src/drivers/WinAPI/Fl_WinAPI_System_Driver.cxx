@@ -312,6 +312,13 @@ int Fl_WinAPI_System_Driver::rename(const char *fnam, const char *newnam) {
   return _wrename(wbuf, wbuf1);
 }
 
+// _wrename() fails if newnam exists, MoveFileExW() replaces it in one step
+int Fl_WinAPI_System_Driver::replace_file(const char *fnam, const char *newnam) {
+  utf8_to_wchar(fnam, wbuf);
+  utf8_to_wchar(newnam, wbuf1);
+  return MoveFileExW(wbuf, wbuf1, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+}
+
 // See Fl::args_to_utf8()
 int Fl_WinAPI_System_Driver::args_to_utf8(int argc, char ** &argv) {
   int i;
@@ -1146,6 +1146,7 @@ XFontStruct* Fl_XFont_On_Demand::value() {
 PangoFontMap *Fl_Xlib_Graphics_Driver::pfmap_ = 0;
 PangoContext *Fl_Xlib_Graphics_Driver::pctxt_ = 0;
 PangoLayout *Fl_Xlib_Graphics_Driver::playout_ = 0;
+Fl_Pango_Layout_Cache *Fl_Xlib_Graphics_Driver::layout_cache_ = 0;
 
 PangoContext *Fl_Xlib_Graphics_Driver::context() {
   if (fl_display && !pctxt_) {
@@ -1161,6 +1162,30 @@ PangoContext *Fl_Xlib_Graphics_Driver::context() {
 }
 
 
+// Returns a layout containing the UTF-8 string str of n bytes in the current font.
+// Layouts are taken from the layout cache unless text is being drawn rotated,
+// which is done by setting a matrix on pctxt_ for each string.
+PangoLayout *Fl_Xlib_Graphics_Driver::shaped_layout_(const char *str, int n) {
+  if (n <= Fl_Pango_Layout_Cache::max_length && !pango_context_get_matrix(pctxt_)) { // 1.6
+    if (!layout_cache_) layout_cache_ = new Fl_Pango_Layout_Cache(pctxt_);
+    return layout_cache_->layout(pfd_array[font_], font_, size_unscaled(), str, n);
+  }
+  pango_layout_set_font_description(playout_, pfd_array[font_]);
+  const char *old = pango_layout_get_text(playout_);
+  if ((int)strlen(old) != n || memcmp(str, old, n)) // do not re-set text if equal to text already in layout
+    pango_layout_set_text(playout_, str, n);
+  return playout_;
+}
+
+
+void Fl_Xlib_Graphics_Driver::text_cache_stats(unsigned long &hits, unsigned long &misses,
+                                               unsigned long &evictions) {
+  hits = layout_cache_ ? layout_cache_->hits() : 0;
+  misses = layout_cache_ ? layout_cache_->misses() : 0;
+  evictions = layout_cache_ ? layout_cache_->evictions() : 0;
+}
+
+
 void Fl_Xlib_Graphics_Driver::font_unscaled(Fl_Font fnum, Fl_Fontsize size) {
   if (!size) return;
   if (size < 0) {
@@ -1213,9 +1238,9 @@ void Fl_Xlib_Graphics_Driver::draw_unscaled(int angle, const char *str, int n, i
   pango_matrix_rotate(&mat, angle); // 1.6
   pango_context_set_matrix(pctxt_, &mat); // 1.6
   str = Fl_Cairo_Graphics_Driver::clean_utf8(str, n);
-  pango_layout_set_text(playout_, str, n);
   int w, h;
-  pango_layout_get_pixel_size(playout_, &w, &h);
+  // with a matrix on pctxt_ this is playout_, set to the current font
+  pango_layout_get_pixel_size(shaped_layout_(str, n), &w, &h);
   pango_matrix_scale(&mat, l/w, l/w); // 1.6
   pango_context_set_matrix(pctxt_, &mat); // 1.6
   do_draw(0, str, n, 0, 0);
@@ -1254,7 +1279,6 @@ void Fl_Xlib_Graphics_Driver::do_draw(int from_right, const char *str, int n, in
     if (--n == 0) return;
     tmpv = NULL;
   }
-  pango_layout_set_font_description(playout_, pfd_array[font_]);
   if (tmpv) { // replace newlines by spaces in a copy of str
     str2 = (char*)malloc(n);
     memcpy(str2, str, n);
@@ -1266,11 +1290,8 @@ void Fl_Xlib_Graphics_Driver::do_draw(int from_right, const char *str, int n, in
     while (tmpv);
     str = str2;
   }
-  const char *old = 0;
-  if (!str2) old = pango_layout_get_text(playout_);
   str = Fl_Cairo_Graphics_Driver::clean_utf8(str, n);
-  if (!old || (int)strlen(old) != n || memcmp(str, old, n)) // do not re-set text if equal to text already in layout
-        pango_layout_set_text(playout_, str, n);
+  PangoLayout *layout = shaped_layout_(str, n);
   if (str2) free(str2);
 
   XftColor color;
@@ -1288,11 +1309,11 @@ void Fl_Xlib_Graphics_Driver::do_draw(int from_right, const char *str, int n, in
   XftDrawSetClip(draw_, region);
 
   int  dx, dy, w, h, y_correction, desc = descent_unscaled(), lheight = height_unscaled();
-  fl_pango_layout_get_pixel_extents(playout_, dx, dy, w, h, desc, lheight, y_correction);
+  fl_pango_layout_get_pixel_extents(layout, dx, dy, w, h, desc, lheight, y_correction);
   if (from_right) {
     x -= w;
   }
-  pango_xft_render_layout(draw_, &color, playout_, x * PANGO_SCALE,
+  pango_xft_render_layout(draw_, &color, layout, x * PANGO_SCALE,
                           (y - y_correction  - lheight + desc) * PANGO_SCALE ); // 1.8
   }
 
@@ -1340,20 +1361,16 @@ double Fl_Xlib_Graphics_Driver::do_width_unscaled_(const char* str, int n) {
   if (!fl_display || size_ == 0) return -1;
   if (!playout_) context();
   int width, height;
-  pango_layout_set_font_description(playout_, pfd_array[font_]);
   str = Fl_Cairo_Graphics_Driver::clean_utf8(str, n);
-  pango_layout_set_text(playout_, str, n);
-  pango_layout_get_pixel_size(playout_, &width, &height);
+  pango_layout_get_pixel_size(shaped_layout_(str, n), &width, &height);
   return (double)width;
 }
 
 void Fl_Xlib_Graphics_Driver::text_extents_unscaled(const char *str, int n, int &dx, int &dy, int &w, int &h) {
   if (!playout_) context();
-  pango_layout_set_font_description(playout_, pfd_array[font_]);
   str = Fl_Cairo_Graphics_Driver::clean_utf8(str, n);
-  pango_layout_set_text(playout_, str, n);
   int y_correction;
-  fl_pango_layout_get_pixel_extents(playout_, dx, dy, w, h, descent_unscaled(), height_unscaled(), y_correction);
+  fl_pango_layout_get_pixel_extents(shaped_layout_(str, n), dx, dy, w, h, descent_unscaled(), height_unscaled(), y_correction);
   dy -= y_correction;
   correct_extents(scale(), dx, dy, w, h);
 }
@@ -54,6 +54,7 @@
 #  include <FL/Fl_Tiled_Image.H>
 #  include "../../Fl_Screen_Driver.H"
 #  include "../../Fl_XColor.H"
+#  include "../../Fl_Pixel_Ops.H"
 #  include "../../flstring.h"
 #if HAVE_XRENDER
 #  include <X11/extensions/Xrender.h>
@@ -61,6 +62,11 @@
 #    define RepeatPad  2
 #  endif
 #endif // HAVE_XRENDER
+#if HAVE_XSHM
+#  include <X11/extensions/XShm.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif // HAVE_XSHM
 
 static XImage xi;       // template used to pass info to X
 static int bytes_per_pixel;
@@ -310,19 +316,39 @@ static void rrr_converter(const uchar *from, uchar *to, int w, int delta) {
   U32 *t = (U32*)to; for (; w--; from += delta) *t++ = f
 #  endif
 
+// The 32-bit layouts that only move bytes around, and the premultiplied
+// ARGB32 format, are converted by the SIMD kernels of Fl_Pixel_Ops when
+// the CPU has them. The maps give the source byte of each output byte in
+// memory order, hence the little-endian only code.
+
+#  if WORDS_BIGENDIAN
+#    define SIMD32(kernel, b0, b1, b2, b3)
+#  else
+#    define SIMD32(kernel, b0, b1, b2, b3) \
+  if (delta >= 1 && delta <= 4 && Fl_Pixel_Ops::simd()) { \
+    static const signed char map[4] = {b0, b1, b2, b3}; \
+    Fl_Pixel_Ops::kernel(from, to, w, delta, map); \
+    return; \
+  }
+#  endif
+
 static void rgbx_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, -1, 2, 1, 0)
   INNARDS32((unsigned(from[0])<<24)+(from[1]<<16)+(from[2]<<8));
 }
 
 static void xbgr_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, 0, 1, 2, -1)
   INNARDS32((from[0])+(from[1]<<8)+(from[2]<<16));
 }
 
 static void xrgb_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, 2, 1, 0, -1)
   INNARDS32((from[0]<<16)+(from[1]<<8)+(from[2]));
 }
 
 static void argb_premul_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(premultiply32, 2, 1, 0, 3)
   INNARDS32((unsigned(from[3]) << 24) +
              (((from[0] * from[3]) / 255) << 16) +
              (((from[1] * from[3]) / 255) << 8) +
@@ -330,6 +356,7 @@ static void argb_premul_converter(const uchar *from, uchar *to, int w, int delta
 }
 
 static void depth2_to_argb_premul_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(premultiply32, 0, 0, 0, 1)
   INNARDS32((unsigned(from[1]) << 24) +
             (((from[0] * from[1]) / 255) << 16) +
             (((from[0] * from[1]) / 255) << 8) +
@@ -337,14 +364,17 @@ static void depth2_to_argb_premul_converter(const uchar *from, uchar *to, int w,
 }
 
 static void bgrx_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, -1, 0, 1, 2)
   INNARDS32((from[0]<<8)+(from[1]<<16)+(unsigned(from[2])<<24));
 }
 
 static void rrrx_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, -1, 0, 0, 0)
   INNARDS32(unsigned(*from) * 0x1010100U);
 }
 
 static void xrrr_converter(const uchar *from, uchar *to, int w, int delta) {
+  SIMD32(shuffle32, 0, 0, 0, -1)
   INNARDS32(*from * 0x10101U);
 }
 
@@ -469,6 +499,106 @@ static void figure_out_visual() {
 
 #  define MAXBUFFER 0x40000 // 256k
 
+#if HAVE_XSHM
+
+// Large images are converted directly into a shared memory segment which is
+// sent to the X server with XShmPutImage(), avoiding to copy all pixels
+// through the X connection. The segment is kept and enlarged as needed.
+// This is not possible with remote displays or when the X server lacks the
+// MIT-SHM extension (e.g., some Xvfb configurations): the regular XPutImage()
+// path is then used.
+
+#  define SHM_MIN_PIXELS 0x4000 // smaller images are faster to send with XPutImage()
+
+static int shm_state = 0; // 0: not tried yet, 1: usable, -1: not usable
+static XShmSegmentInfo shm_info;
+static size_t shm_size = 0; // size of the attached segment
+static bool shm_pending = false; // true while the X server may read the segment
+static bool shm_error = false;
+
+static int shm_error_handler(Display *, XErrorEvent *) {
+  shm_error = true;
+  return 0;
+}
+
+static void shm_detach() {
+  if (!shm_size) return;
+  XShmDetach(fl_display, &shm_info);
+  XSync(fl_display, False);
+  shmdt(shm_info.shmaddr);
+  shm_size = 0;
+  shm_pending = false;
+}
+
+// Makes sure the segment has at least size bytes, returns false if impossible
+static bool shm_reserve(size_t size) {
+  if (size <= shm_size) {
+    if (shm_pending) { // wait until the X server has read the previous image
+      XSync(fl_display, False);
+      shm_pending = false;
+    }
+    return true;
+  }
+  shm_detach();
+  size = (size + 0xffff) & ~(size_t)0xffff;
+  shm_info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (shm_info.shmid < 0) return false;
+  shm_info.shmaddr = (char*)shmat(shm_info.shmid, 0, 0);
+  if (shm_info.shmaddr == (char*)-1) {
+    shmctl(shm_info.shmid, IPC_RMID, 0);
+    return false;
+  }
+  shm_info.readOnly = True;
+  // XShmAttach() fails when the X server can't access our memory (remote display)
+  shm_error = false;
+  XErrorHandler old_handler = XSetErrorHandler(shm_error_handler);
+  XShmAttach(fl_display, &shm_info);
+  XSync(fl_display, False);
+  XSetErrorHandler(old_handler);
+  // the segment will be destroyed when both the X server and we detach from it
+  shmctl(shm_info.shmid, IPC_RMID, 0);
+  if (shm_error) {
+    shmdt(shm_info.shmaddr);
+    return false;
+  }
+  shm_size = size;
+  return true;
+}
+
+// Returns an image of size w x h in the shared memory segment, or NULL.
+// The image rows are at least as wide as w and suitably aligned for the converters.
+static XImage *shm_image(int w, int h) {
+  if (shm_state == 0) {
+    shm_state = (XShmQueryExtension(fl_display) ? 1 : -1);
+  }
+  if (shm_state < 0) return NULL;
+  // 32-bit converters may store 2 pixels at once
+  int width = (bytes_per_pixel == 4 ? (w + 1) & ~1 : w);
+  XImage *img = XShmCreateImage(fl_display, fl_visual->visual, fl_visual->depth,
+                                ZPixmap, NULL, &shm_info, width, h);
+  if (!img) {
+    shm_state = -1;
+    return NULL;
+  }
+  // the X server reads the segment as is: our converters must produce its format
+  if (img->bits_per_pixel != xi.bits_per_pixel ||
+      (bytes_per_pixel > 1 && img->byte_order != xi.byte_order) ||
+      (img->bytes_per_line & (sizeof(STORETYPE) - 1))) {
+    XDestroyImage(img);
+    shm_state = -1;
+    return NULL;
+  }
+  if (!shm_reserve((size_t)img->bytes_per_line * h)) {
+    XDestroyImage(img);
+    shm_state = -1;
+    return NULL;
+  }
+  img->data = shm_info.shmaddr;
+  return img;
+}
+
+#endif // HAVE_XSHM
+
 static void innards(const uchar *buf, int X, int Y, int W, int H,
                     int delta, int linedelta, int mono,
                     Fl_Draw_Image_Cb cb, void* userdata,
@@ -504,6 +634,34 @@ static void innards(const uchar *buf, int X, int Y, int W, int H,
     }
   }
 
+#if HAVE_XSHM
+  XImage *shm_xi = (alpha || w*h < SHM_MIN_PIXELS ? NULL : shm_image(w, h));
+  if (shm_xi) {
+    uchar *to = (uchar*)shm_xi->data;
+    if (buf) {
+      buf += delta*dx+linedelta*dy;
+      for (int j=0; j<h; j++) {
+        conv(buf, to, w, delta);
+        buf += linedelta;
+        to += shm_xi->bytes_per_line;
+      }
+    } else {
+      STORETYPE* linebuf = new STORETYPE[(W*delta+(sizeof(STORETYPE)-1))/sizeof(STORETYPE)];
+      for (int j=0; j<h; j++) {
+        cb(userdata, dx, dy+j, w, (uchar*)linebuf);
+        conv((uchar*)linebuf, to, w, delta);
+        to += shm_xi->bytes_per_line;
+      }
+      delete[] linebuf;
+    }
+    XShmPutImage(fl_display, fl_window, gc, shm_xi, 0, 0, X+dx, Y+dy, w, h, False);
+    shm_pending = true;
+    shm_xi->data = NULL;
+    XDestroyImage(shm_xi);
+    return;
+  }
+#endif // HAVE_XSHM
+
   // See if the data is already in the right format.  Unfortunately
   // some 32-bit x servers (XFree86) care about the unknown 8 bits
   // and they must be zero.  I can't confirm this for user-supplied
@@ -667,63 +825,9 @@ static void alpha_blend(Fl_RGB_Image *img, int X, int Y, int W, int H, int cx, i
     fl_draw_image(srcptr, X, Y, W, H, img->d(), ld);
     return;
   }
-  int srcskip = ld - img->d() * W;
-  uchar *dstptr = dst;
-
-  uchar srcr, srcg, srcb;  // source color components
-  uchar dstr, dstg, dstb;  // destination color components
-  unsigned int srca, dsta; // source alpha and inverse source alpha
-
-  if (img->d() == 2) {
-    // Composite grayscale + alpha over RGB...
-    for (int y = H; y > 0; y--, srcptr+=srcskip)
-      for (int x = W; x > 0; x--) {
-        srcg = *srcptr++;
-        srca = *srcptr++;
-        if (srca == 255) { // special case "copy"
-          *dstptr++ = srcg;
-          *dstptr++ = srcg;
-          *dstptr++ = srcg;
-        } else if (srca == 0) { // special case "ignore"
-          dstptr += 3;
-        } else { // common case "blend"
-          srca += srca>>7; // multiply by 1.004 to compensate integer rounding error
-          dstr = dstptr[0];
-          dstg = dstptr[1];
-          dstb = dstptr[2];
-          dsta = 256 - srca;
-          unsigned int srcg_pm = srcg * srca; // premultiply once
-          *dstptr++ = (srcg_pm + dstr * dsta) >> 8;
-          *dstptr++ = (srcg_pm + dstg * dsta) >> 8;
-          *dstptr++ = (srcg_pm + dstb * dsta) >> 8;
-        }
-      }
-  } else {
-    // Composite RGBA over RGB...
-    for (int y = H; y > 0; y--, srcptr+=srcskip)
-      for (int x = W; x > 0; x--) {
-        srcr = *srcptr++;
-        srcg = *srcptr++;
-        srcb = *srcptr++;
-        srca = *srcptr++;
-        if (srca == 255) { // special case "copy"
-          *dstptr++ = srcr;
-          *dstptr++ = srcg;
-          *dstptr++ = srcb;
-        } else if (srca == 0) { // special case "ignore"
-          dstptr += 3;
-        } else { // common case "blend"
-          srca += srca>>7; // multiply by 1.004 to compensate integer rounding error
-          dstr = dstptr[0];
-          dstg = dstptr[1];
-          dstb = dstptr[2];
-          dsta = 256 - srca;
-          *dstptr++ = (srcr * srca + dstr * dsta) >> 8;
-          *dstptr++ = (srcg * srca + dstg * dsta) >> 8;
-          *dstptr++ = (srcb * srca + dstb * dsta) >> 8;
-        }
-      }
-  }
+  // Composite grayscale + alpha or RGBA over RGB...
+  for (int y = 0; y < H; y++)
+    Fl_Pixel_Ops::blend(srcptr + y * ld, img->d(), dst + y * W * 3, W);
   fl_draw_image(dst, X, Y, W, H, 3, 0);
 
   delete[] dst;
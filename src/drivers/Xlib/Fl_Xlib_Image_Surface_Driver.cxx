@@ -171,6 +171,14 @@ void Fl_Xlib_Image_Surface_Driver::end_current()
 
 #if FLTK_USE_CAIRO
 
+bool Fl_Xlib_Image_Surface_Driver::draw_tiled(const Fl_Display_List &list, int threads,
+                                              int tile_size) {
+  int W, H;
+  Fl::screen_driver()->offscreen_size(offscreen, W, H);
+  return ((Fl_Cairo_Graphics_Driver*)driver())->draw_tiled(W, H, list, threads, tile_size);
+}
+
+
 void Fl_Xlib_Image_Surface_Driver::mask(const Fl_RGB_Image *mask) {
   bool using_copy = false;
   shape_data_ =  (struct shape_data_type*)calloc(1, sizeof(struct shape_data_type));
@@ -24,6 +24,7 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Device.H>
 #include <FL/Fl_Graphics_Driver.H>
+#include "Fl_Offscreen_Cache.H"
 
 // fl_cmap needs to be defined globally (here) and is used in the device
 // specific graphics drivers. It is required to 'FL_EXPORT' this symbol
@@ -82,6 +83,8 @@ void Fl::set_color(Fl_Color i, uchar red, uchar green, uchar blue, uchar alpha)
 
 void Fl::set_color(Fl_Color i, unsigned c)
 {
+  Fl_Display_List::discard_all();
+  Fl_Offscreen_Cache::discard_all();
   Fl_Graphics_Driver::default_driver().set_color(i, c);
 }
 
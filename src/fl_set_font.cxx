@@ -21,6 +21,7 @@
 #include <FL/platform.H>
 #include <FL/fl_draw.H>
 #include "Fl_Screen_Driver.H"
+#include "Fl_Offscreen_Cache.H"
 #include "flstring.h"
 #include <stdlib.h>
 
@@ -43,6 +44,8 @@ static int table_size;
  function Fl::get_font_name() or as listed by applications test/fonts or test/utf8. No prefix is to be added.
 */
 void Fl::set_font(Fl_Font fnum, const char* name) {
+  Fl_Display_List::discard_all();
+  Fl_Offscreen_Cache::discard_all();
   Fl_Graphics_Driver &d = Fl_Graphics_Driver::default_driver();
   unsigned width = d.font_desc_size();
   if (!fl_fonts) fl_fonts = d.calc_fl_fonts();
@@ -14,18 +14,9 @@
 //     https://www.fltk.org/bugs.php
 //
 
-#include <config.h>
 #include <FL/Fl_JPEG_Image.H>
 #include <FL/Fl_RGB_Image.H>
-#include <FL/fl_utf8.h>               // fl_fopen()
-#include <stdio.h>
-#include <stdlib.h>                   // malloc, free
-
-extern "C" {
-#ifdef HAVE_LIBJPEG
-#  include <jpeglib.h>
-#endif // HAVE_LIBJPEG
-} // extern "C"
+#include <FL/Fl_Image_Writer.H>
 
 /**
   \file fl_write_jpeg.cxx
@@ -46,8 +37,7 @@ extern "C" {
   For images with alpha channel (depth 2 or 4), the alpha component is ignored
   and only the color data is written since JPEG does not support transparency.
 
-  \note Error handling is limited to basic error detection: library availability
-    and file opening errors.
+  Use Fl_Image_Writer to choose the quality, or to write to memory.
 
   \param[in]  filename  Output filename, extension should be '.jpg' or '.jpeg'
   \param[in]  img       RGB image to be written
@@ -56,9 +46,10 @@ extern "C" {
 
   \retval      0        success, file has been written
   \retval     -1        jpeg library not available
-  \retval     -2        file open error
-  \retval     -3        invalid image depth (must be 1, 2, 3, or 4)
+  \retval     -2        file open or write error
+  \retval     -3        invalid image size or depth (must be 1, 2, 3, or 4)
   \retval     -4        memory allocation error
+  \retval     -5        error reported by the jpeg library
 
   \see fl_write_jpeg(const char *, const char *, int, int, int, int)
 */
@@ -99,99 +90,7 @@ int fl_write_jpeg(const char *filename, const unsigned char *pixels, int w, int
   \see fl_write_jpeg(const char *filename, Fl_RGB_Image *img)
 */
 int fl_write_jpeg(const char *filename, const char *pixels, int w, int h, int d, int ld) {
-
-#ifdef HAVE_LIBJPEG
-
-  FILE *fp;
-  J_COLOR_SPACE color_space;
-  int out_d;              // output depth (without alpha)
-  unsigned char *row_buf = NULL;  // buffer for stripping alpha channel
-
-  // Validate depth: must be 1, 2, 3, or 4
-  if (d < 1 || d > 4) {
-    return -3;
-  }
-
-  if ((fp = fl_fopen(filename, "wb")) == NULL) {
-    return -2;
-  }
-
-  // Determine output depth and color space
-  // Strip alpha channel: depth 2 -> 1 (gray), depth 4 -> 3 (RGB)
-  switch (d) {
-    case 1:
-    case 2:
-      color_space = JCS_GRAYSCALE;
-      out_d = 1;
-      break;
-    default:  // 3 or 4
-      color_space = JCS_RGB;
-      out_d = 3;
-      break;
-  }
-
-  if (ld == 0)
-    ld = w * d;
-
-  // Allocate buffer for stripping alpha if needed
-  int strip_alpha = (d == 2 || d == 4);
-  if (strip_alpha) {
-    row_buf = (unsigned char *)malloc(w * out_d);
-    if (row_buf == NULL) {
-      fclose(fp);
-      return -4;
-    }
-  }
-
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-
-  cinfo.err = jpeg_std_error(&jerr);
-  jpeg_create_compress(&cinfo);
-  jpeg_stdio_dest(&cinfo, fp);
-
-  cinfo.image_width = w;
-  cinfo.image_height = h;
-  cinfo.input_components = out_d;
-  cinfo.in_color_space = color_space;
-
-  jpeg_set_defaults(&cinfo);
-  jpeg_set_quality(&cinfo, 95, TRUE);  // Quality 95 is a good balance
-
-  jpeg_start_compress(&cinfo, TRUE);
-
-  JSAMPROW row_pointer;
-  const unsigned char *ptr = (const unsigned char *)pixels;
-
-  while (cinfo.next_scanline < cinfo.image_height) {
-    if (strip_alpha) {
-      // Strip alpha channel: copy only color components
-      const unsigned char *src = ptr;
-      unsigned char *dst = row_buf;
-      for (int x = 0; x < w; x++) {
-        for (int c = 0; c < out_d; c++) {
-          *dst++ = *src++;
-        }
-        src++;  // skip alpha byte
-      }
-      row_pointer = (JSAMPROW)row_buf;
-    } else {
-      row_pointer = (JSAMPROW)ptr;
-    }
-    jpeg_write_scanlines(&cinfo, &row_pointer, 1);
-    ptr += ld;
-  }
-
-  jpeg_finish_compress(&cinfo);
-  jpeg_destroy_compress(&cinfo);
-
-  if (row_buf)
-    free(row_buf);
-
-  fclose(fp);
-  return 0;
-
-#else
-  return -1;
-#endif
+  Fl_Image_Writer writer(Fl_Image_Writer::JPEG);
+  writer.output(filename);
+  return writer.write((const unsigned char *)pixels, w, h, d, ld);
 }
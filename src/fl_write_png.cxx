@@ -14,33 +14,9 @@
 //     https://www.fltk.org/bugs.php
 //
 
-#include <config.h>
 #include <FL/Fl_PNG_Image.H>
 #include <FL/Fl_RGB_Image.H>
-#include <FL/fl_string_functions.h>
-#include <FL/fl_utf8.h>               // fl_fopen()
-#include <stdio.h>
-
-// FIXME: see original commit 2db94dcb4c5bf2ef3fa92f1cd6a41f3f90105361
-// ... about building X11 backend on macOS ≥ 11:
-// "The error happens only if png.h is included without time.h having
-//  been included before. The fix is to #include time.h before png.h.
-//  A better fix than his hack is desirable."
-
-#include <time.h>
-
-// PNG library include files
-
-extern "C" {
-#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
-#include <zlib.h>
-#ifdef HAVE_PNG_H
-#include <png.h>
-#else
-#include <libpng/png.h>
-#endif // HAVE_PNG_H
-#endif // HAVE_LIBPNG && HAVE_LIBZ
-} // extern "C"
+#include <FL/Fl_Image_Writer.H>
 
 /**
   \file fl_write_png.cxx
@@ -64,8 +40,7 @@ extern "C" {
   Image depth 1 (gray), 2 (gray + alpha channel), 3 (RGB) and 4 (RGBA)
   are supported.
 
-  \note Currently there is no error handling except for errors when opening
-    the file. This may be changed in the future.
+  Use Fl_Image_Writer to choose the compression, or to write to memory.
 
   \param[in]  filename  Output filename, extension should be '.png'
   \param[in]  img       RGB image to be written
@@ -74,7 +49,10 @@ extern "C" {
 
   \retval      0        success, file has been written
   \retval     -1        png or zlib library not available
-  \retval     -2        file open error
+  \retval     -2        file open or write error
+  \retval     -3        invalid image size or depth (must be 1, 2, 3, or 4)
+  \retval     -4        memory allocation error
+  \retval     -5        error reported by the png library
 
   \see fl_write_png(const char *, int, int, int, const unsigned char *)
 */
@@ -125,56 +103,7 @@ int fl_write_png(const char *filename, const unsigned char *pixels, int w, int h
   \see fl_write_png(const char *filename, Fl_RGB_Image *img)
 */
 int fl_write_png(const char *filename, const char *pixels, int w, int h, int d, int ld) {
-
-#if defined(HAVE_LIBPNG) && defined(HAVE_LIBZ)
-
-  FILE *fp;
-  int color_type;
-
-  if ((fp = fl_fopen(filename, "wb")) == NULL) {
-    return -2;
-  }
-
-  switch (d) {
-    case 1:  color_type = PNG_COLOR_TYPE_GRAY;        break;
-    case 2:  color_type = PNG_COLOR_TYPE_GRAY_ALPHA;  break;
-    case 3:  color_type = PNG_COLOR_TYPE_RGB;         break;
-    case 4:  color_type = PNG_COLOR_TYPE_RGB_ALPHA;   break;
-    default: color_type = PNG_COLOR_TYPE_RGB;
-  }
-
-  if (ld == 0)
-    ld = w * d;
-
-  png_structp pptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
-  png_infop iptr = png_create_info_struct(pptr);
-  png_bytep ptr = (png_bytep)pixels;
-
-  png_init_io(pptr, fp);
-  png_set_IHDR(pptr, iptr, w, h, 8,
-               color_type,
-               PNG_INTERLACE_NONE,
-               PNG_COMPRESSION_TYPE_DEFAULT,
-               PNG_FILTER_TYPE_DEFAULT);
-  png_set_sRGB(pptr, iptr, PNG_sRGB_INTENT_PERCEPTUAL);
-
-  double dpi = 300.0;
-  int dots_per_meter = (int)(dpi / (2.54 / 100.0));
-  png_set_pHYs(pptr, iptr, dots_per_meter, dots_per_meter, PNG_RESOLUTION_METER);
-
-  png_write_info(pptr, iptr);
-
-  for (int i = 0; i < h; i++, ptr += ld) {
-    png_write_row(pptr, ptr);
-  }
-
-  png_write_end(pptr, iptr);
-  png_destroy_write_struct(&pptr, &iptr);
-
-  fclose(fp);
-  return 0;
-
-#else
-  return -1;
-#endif
+  Fl_Image_Writer writer(Fl_Image_Writer::PNG);
+  writer.output(filename);
+  return writer.write((const unsigned char *)pixels, w, h, d, ld);
 }
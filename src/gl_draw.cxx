@@ -46,10 +46,16 @@
 #endif
 #include <FL/glut.H> // for glutStrokeString() and glutStrokeLength()
 #include <stdlib.h>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 #ifndef GL_TEXTURE_RECTANGLE_ARB
 #  define GL_TEXTURE_RECTANGLE_ARB 0x84F5
 #endif
+#ifndef GL_ARRAY_BUFFER_BINDING
+#  define GL_ARRAY_BUFFER_BINDING 0x8894
+#endif
 
 
 /** Returns the current font's height */
@@ -259,83 +265,235 @@ void gl_color(Fl_Color i) {
 }
 
 
-#if ! defined(FL_DOXYGEN) // do not want too much of the gl_texture_fifo internals in the documentation
+#if ! defined(FL_DOXYGEN) // do not want too much of the glyph atlas internals in the documentation
 
-/* Implement the gl_texture_fifo mechanism:
- Strings to be drawn are memorized in a fifo pile (which max size can
- be increased calling gl_texture_pile_height(int)).
- Each pile element contains the string, the font, the GUI scale, and
- an image of the string in the form of a GL texture.
+/* Implement the glyph atlas mechanism:
+ Each glyph is rasterized once, the first time it is drawn, and stored in
+ a page of a persistent texture atlas. Glyphs are identified by their font,
+ the GUI scale, and their Unicode code point.
+ Each atlas page is a rectangle texture with the alpha channel only in which
+ glyphs are packed in horizontal shelves. The maximum number of pages can be
+ changed calling gl_texture_pile_height(int). When all pages are full, the least
+ recently used page is emptied and reused.
  Strings are drawn in 2 steps:
-    1) compute the texture for that string if it was not computed before;
-    2) draw the texture using the current GL color.
+    1) rasterize the glyphs of the string that are not yet in the atlas;
+    2) draw all quads of the string with one vertex array per atlas page
+       using the current GL color.
 */
 
-// manages a fifo pile of pre-computed string textures
-class gl_texture_fifo {
+// manages the pages of pre-computed glyph textures
+class gl_glyph_atlas {
   friend class Fl_Gl_Window_Driver;
 private:
-  typedef struct { // information for a pre-computed texture
-    GLuint texName; // its name
-    char *utf8; //its text
+  struct glyph_key { // what identifies a glyph in the atlas
     Fl_Font_Descriptor *fdesc; // its font
     float scale; // scaling factor of the GUI
-    int str_len; // the length of the utf8 text
-  } data;
-  data *fifo; // array of pile elements
-  int size_; // pile height
-  int current; // the oldest texture to have entered the pile
-  int last; // pile top
-  int textures_generated; // true after glGenTextures has been called
-  void display_texture(int rank);
-  int compute_texture(const char* str, int n);
-  int already_known(const char *str, int n);
+    unsigned ucs; // its Unicode code point
+    bool operator<(const glyph_key &k) const {
+      if (fdesc != k.fdesc) return fdesc < k.fdesc;
+      if (scale != k.scale) return scale < k.scale;
+      return ucs < k.ucs;
+    }
+  };
+  struct glyph { // where a glyph is in the atlas
+    int page; // rank of the atlas page
+    int x, y, w, h; // location of the glyph image in the page
+    int descent; // descent of the glyph image
+    float advance; // horizontal advance of the pen
+  };
+  struct shelf { // a row of glyphs in an atlas page
+    int y, h; // vertical position and height of the shelf
+    int x; // first free column in the shelf
+  };
+  struct page { // information for an atlas texture
+    GLuint texName; // its name
+    int w, h; // its size
+    int next_y; // top of the unused part of the page
+    unsigned long stamp; // last time the page was used
+    std::vector<shelf> shelves;
+  };
+  struct page_less { // orders the glyphs of the string being drawn by atlas page
+    const std::vector<const glyph*> &g;
+    page_less(const std::vector<const glyph*> &v) : g(v) {}
+    bool operator()(int a, int b) const { return g[a]->page < g[b]->page; }
+  };
+  typedef std::map<glyph_key, glyph> glyph_map;
+  glyph_map glyphs; // all glyphs present in the atlas
+  std::vector<page> pages; // all atlas pages
+  int max_pages; // maximum number of atlas pages
+  unsigned long stamp; // incremented at each drawn string
+  std::vector<const glyph*> string_glyphs; // glyphs of the string being drawn
+  // buffers used to draw the string, kept to avoid reallocation
+  std::vector<int> order; // glyph ranks sorted by atlas page
+  std::vector<float> offsets; // horizontal position of each glyph
+  std::vector<GLfloat> vertices, texcoords; // 4 vertices per glyph
+  static const int page_size = 1024; // default size of an atlas page
+  void clear_page(int rank);
+  int add_page(int w, int h);
+  int evict_page();
+  bool place(int rank, int w, int h, int &x, int &y);
+  const glyph *find_or_add(unsigned ucs, const char *utf8, int len, int &scaled_size);
+  void display_string();
 public:
-  gl_texture_fifo(int max = 100); // 100 = default height of texture pile
-  inline int size(void) {return size_; }
-  ~gl_texture_fifo(void);
+  gl_glyph_atlas(int max = 8); // 8 = default number of atlas pages
+  inline int size(void) {return max_pages; }
+  ~gl_glyph_atlas(void);
 };
 
-gl_texture_fifo::gl_texture_fifo(int max)
+gl_glyph_atlas::gl_glyph_atlas(int max)
+{
+  max_pages = (max > 0 ? max : 1);
+  stamp = 0;
+}
+
+gl_glyph_atlas::~gl_glyph_atlas()
+{
+  for (size_t i = 0; i < pages.size(); i++) glDeleteTextures(1, &pages[i].texName);
+}
+
+static gl_glyph_atlas *gl_atlas = NULL; // points to the glyph atlas class instance
+
+
+// Cross-platform implementation of the texture mechanism for text rendering
+// using textures with the alpha channel only.
+
+// empties an atlas page, clearing its texture so that the border of each
+// glyph is transparent when the texture is sampled with GL_LINEAR
+void gl_glyph_atlas::clear_page(int rank)
+{
+  page &p = pages[rank];
+  p.next_y = 0;
+  p.shelves.clear();
+  char *zero = (char*)calloc(p.w * p.h, 1);
+  GLint alignment;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+  glPushAttrib(GL_TEXTURE_BIT);
+  glBindTexture(GL_TEXTURE_RECTANGLE_ARB, p.texName);
+  glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  // GL_ALPHA8 is defined in GL/gl.h of X11 and of MinGW32 and of MinGW64 and of OpenGL.framework for MacOS
+  glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_ALPHA8, p.w, p.h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, zero);
+  glPopAttrib();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+  free(zero);
+}
+
+// creates a new atlas page at least as large as w x h and returns its rank
+int gl_glyph_atlas::add_page(int w, int h)
 {
-  size_ = max;
-  last = current = -1;
-  textures_generated = 0;
-  fifo = (data*)calloc(size_, sizeof(data));
+  page p;
+  glGenTextures(1, &p.texName);
+  p.w = (w > page_size ? w : page_size);
+  p.h = (h > page_size ? h : page_size);
+  p.stamp = stamp;
+  pages.push_back(p);
+  clear_page((int)pages.size() - 1);
+  return (int)pages.size() - 1;
 }
 
-gl_texture_fifo::~gl_texture_fifo()
+// empties the least recently used page and returns its rank, or -1 if all
+// pages contain glyphs of the string being drawn
+int gl_glyph_atlas::evict_page()
 {
-  for (int i = 0; i < size_; i++) {
-    if (fifo[i].utf8) free(fifo[i].utf8);
-    if (textures_generated) glDeleteTextures(1, &fifo[i].texName);
+  int lru = -1;
+  for (int i = 0; i < (int)pages.size(); i++) {
+    if (pages[i].stamp == stamp) continue;
+    if (lru < 0 || pages[i].stamp < pages[lru].stamp) lru = i;
+  }
+  if (lru < 0) return -1;
+  for (glyph_map::iterator it = glyphs.begin(); it != glyphs.end(); ) {
+    if (it->second.page == lru) glyphs.erase(it++);
+    else ++it;
   }
-  free(fifo);
+  clear_page(lru);
+  return lru;
 }
 
-// returns rank of pre-computed texture for a string if it exists
-int gl_texture_fifo::already_known(const char *str, int n)
+// finds room for a w x h image in an atlas page, leaving a 1-pixel gap around it
+bool gl_glyph_atlas::place(int rank, int w, int h, int &x, int &y)
 {
-  int rank;
-  for ( rank = 0; rank <= last; rank++) {
-    if ((fifo[rank].str_len == n) &&
-        (fifo[rank].fdesc == gl_fontsize) &&
-        (fifo[rank].scale == Fl_Gl_Window_Driver::gl_scale) &&
-        (memcmp(str, fifo[rank].utf8, n) == 0)) {
-      return rank;
+  page &p = pages[rank];
+  for (size_t i = 0; i < p.shelves.size(); i++) {
+    shelf &s = p.shelves[i];
+    // don't waste a tall shelf on a much shorter glyph
+    if (s.h >= h && s.h <= h + h / 4 + 1 && s.x + w <= p.w) {
+      x = s.x; y = s.y;
+      s.x += w + 1;
+      return true;
     }
   }
-  return -1; // means no texture exists yet for that string
+  if (p.next_y + h > p.h || w > p.w) return false;
+  shelf s;
+  s.y = p.next_y; s.h = h; s.x = w + 1;
+  p.shelves.push_back(s);
+  p.next_y += h + 1;
+  x = 0; y = s.y;
+  return true;
 }
 
-static gl_texture_fifo *gl_fifo = NULL; // points to the texture pile class instance
+// returns the atlas glyph of a code point, rasterizing it if necessary.
+// scaled_size is the font size in the GL scene, 0 until computed.
+const gl_glyph_atlas::glyph *gl_glyph_atlas::find_or_add(unsigned ucs, const char *utf8, int len, int &scaled_size)
+{
+  glyph_key key;
+  key.fdesc = gl_fontsize;
+  key.scale = Fl_Gl_Window_Driver::gl_scale;
+  key.ucs = ucs;
+  glyph_map::iterator it = glyphs.find(key);
+  if (it != glyphs.end()) {
+    pages[it->second.page].stamp = stamp;
+    return &it->second;
+  }
+  Fl_Fontsize fs = fl_size();
+  if (!scaled_size) scaled_size = int(fs * Fl_Gl_Window_Driver::gl_scale);
+  float s = fl_graphics_driver->scale();
+  fl_graphics_driver->Fl_Graphics_Driver::scale(1); // temporarily remove scaling factor
+  fl_font(fl_font(), scaled_size); // the font size to use in the GL scene
+  glyph g;
+  g.advance = float(fl_width(utf8, len));
+  // leave room at right for glyphs that extend beyond their advance (e.g., italics)
+  g.w = (int)ceil(g.advance) + scaled_size / 6 + 1;
+  g.h = fl_height();
+  g.descent = fl_descent();
+  fl_graphics_driver->Fl_Graphics_Driver::scale(s); // re-install scaling factor
+  fl_font(fl_font(), fs);
+  // find room in a page, preferring recently used ones
+  g.page = -1;
+  for (int i = (int)pages.size() - 1; i >= 0 && g.page < 0; i--) {
+    if (place(i, g.w, g.h, g.x, g.y)) g.page = i;
+  }
+  if (g.page < 0) {
+    int rank = ((int)pages.size() < max_pages ? -1 : evict_page());
+    if (rank < 0 || !place(rank, g.w, g.h, g.x, g.y)) {
+      rank = add_page(g.w, g.h);
+      place(rank, g.w, g.h, g.x, g.y);
+    }
+    g.page = rank;
+  }
+  pages[g.page].stamp = stamp;
+  char *alpha_buf = Fl_Gl_Window_Driver::global()->alpha_mask_for_string(utf8, len, g.w, g.h, scaled_size);
 
+  // save GL parameters GL_UNPACK_ROW_LENGTH and GL_UNPACK_ALIGNMENT
+  GLint row_length, alignment;
+  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
 
-// Cross-platform implementation of the texture mechanism for text rendering
-// using textures with the alpha channel only.
+  // put the bitmap in the alpha-component-only texture of the page
+  glPushAttrib(GL_TEXTURE_BIT);
+  glBindTexture (GL_TEXTURE_RECTANGLE_ARB, pages[g.page].texName);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, g.w);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, g.x, g.y, g.w, g.h, GL_ALPHA, GL_UNSIGNED_BYTE, alpha_buf);
+  delete[] alpha_buf; // free the buffer now we have copied it into the GL texture
+  glPopAttrib();
+  // restore saved GL parameters
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+  return &(glyphs[key] = g);
+}
 
-// displays a pre-computed texture on the GL scene
-void gl_texture_fifo::display_texture(int rank)
+// draws the glyphs of string_glyphs on the GL scene
+void gl_glyph_atlas::display_string()
 {
   // GL_TRANSFORM_BIT for GL_PROJECTION and GL_MODELVIEW
   // GL_ENABLE_BIT for GL_DEPTH_TEST, GL_LIGHTING
@@ -366,23 +524,66 @@ void gl_texture_fifo::display_texture(int rank)
   glScalef (R/winw, R/winh, 1.0f);
   glTranslatef (-winw/R, -winh/R, 0.0f);
   glEnable (GL_TEXTURE_RECTANGLE_ARB);
-  glBindTexture (GL_TEXTURE_RECTANGLE_ARB, fifo[rank].texName);
-  GLint width, height;
-  glGetTexLevelParameteriv(GL_TEXTURE_RECTANGLE_ARB, 0, GL_TEXTURE_WIDTH, &width);
-  glGetTexLevelParameteriv(GL_TEXTURE_RECTANGLE_ARB, 0, GL_TEXTURE_HEIGHT, &height);
-  //write the texture on screen
-  glBegin (GL_QUADS);
-  float ox = pos[0];
-  float oy = pos[1] + height - Fl_Gl_Window_Driver::gl_scale * fl_descent();
-  glTexCoord2f (0.0f, 0.0f); // draw lower left in world coordinates
-  glVertex2f (ox, oy);
-  glTexCoord2f (0.0f, (GLfloat)height); // draw upper left in world coordinates
-  glVertex2f (ox, oy - height);
-  glTexCoord2f ((GLfloat)width, (GLfloat)height); // draw upper right in world coordinates
-  glVertex2f (ox + width, oy - height);
-  glTexCoord2f ((GLfloat)width, 0.0f); // draw lower right in world coordinates
-  glVertex2f (ox + width, oy);
-  glEnd ();
+  // compute the quads of all glyphs, grouped by atlas page
+  size_t count = string_glyphs.size();
+  order.resize(count);
+  for (size_t i = 0; i < count; i++) order[i] = (int)i;
+  if (count > 1) std::stable_sort(order.begin(), order.end(), page_less(string_glyphs));
+  vertices.resize(8 * count);
+  texcoords.resize(8 * count);
+  offsets.resize(count);
+  float pen = 0;
+  for (size_t i = 0; i < count; i++) {
+    offsets[i] = pen;
+    pen += string_glyphs[i]->advance;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const glyph *g = string_glyphs[order[i]];
+    GLfloat *v = &vertices[8 * i], *t = &texcoords[8 * i];
+    float ox = pos[0] + floorf(offsets[order[i]] + 0.5f);
+    float oy = pos[1] + g->h - g->descent;
+    // upper left, lower left, lower right, upper right in world coordinates
+    v[0] = ox;        v[1] = oy;
+    v[2] = ox;        v[3] = oy - g->h;
+    v[4] = ox + g->w; v[5] = oy - g->h;
+    v[6] = ox + g->w; v[7] = oy;
+    t[0] = (GLfloat)g->x;          t[1] = (GLfloat)g->y;
+    t[2] = (GLfloat)g->x;          t[3] = (GLfloat)(g->y + g->h);
+    t[4] = (GLfloat)(g->x + g->w); t[5] = (GLfloat)(g->y + g->h);
+    t[6] = (GLfloat)(g->x + g->w); t[7] = (GLfloat)g->y;
+  }
+  // client-side vertex arrays are not usable while a vertex buffer object is bound
+  GLint array_buffer = 0;
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+  if (!array_buffer) {
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, &vertices[0]);
+    glTexCoordPointer(2, GL_FLOAT, 0, &texcoords[0]);
+  }
+  //write the textures on screen, one batch per atlas page
+  size_t first = 0;
+  while (first < count) {
+    int rank = string_glyphs[order[first]]->page;
+    size_t last = first + 1;
+    while (last < count && string_glyphs[order[last]]->page == rank) last++;
+    glBindTexture (GL_TEXTURE_RECTANGLE_ARB, pages[rank].texName);
+    if (!array_buffer) {
+      glDrawArrays(GL_QUADS, GLint(4 * first), GLsizei(4 * (last - first)));
+    } else {
+      glBegin (GL_QUADS);
+      for (size_t i = 4 * first; i < 4 * last; i++) {
+        glTexCoord2f (texcoords[2 * i], texcoords[2 * i + 1]);
+        glVertex2f (vertices[2 * i], vertices[2 * i + 1]);
+      }
+      glEnd ();
+    }
+    first = last;
+  }
+  if (!array_buffer) glPopClientAttrib();
 
   // reset original matrices
   glPopMatrix(); // GL_MODELVIEW
@@ -391,7 +592,7 @@ void gl_texture_fifo::display_texture(int rank)
   glPopAttrib(); // GL_TRANSFORM_BIT | GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT
 #if HAVE_GL_GLU_H
   //set the raster position to end of string
-  pos[0] += width;
+  pos[0] += pen;
   GLdouble modelmat[16];
   glGetDoublev (GL_MODELVIEW_MATRIX, modelmat);
   GLdouble projmat[16];
@@ -407,69 +608,20 @@ void gl_texture_fifo::display_texture(int rank)
   }
   glRasterPos2d(objX, objY);
 #endif // HAVE_GL_GLU_H
-} // display_texture
-
-
-// pre-computes a string texture
-int gl_texture_fifo::compute_texture(const char* str, int n)
-{
-  current = (current + 1) % size_;
-  if (current > last) last = current;
-  if ( fifo[current].utf8 ) free(fifo[current].utf8);
-  fifo[current].utf8 = (char *)malloc(n + 1);
-  memcpy(fifo[current].utf8, str, n);
-  fifo[current].utf8[n] = 0;
-  fifo[current].str_len = n; // record length of text in utf8
-  Fl_Fontsize fs = fl_size();
-  float s = fl_graphics_driver->scale();
-  fl_graphics_driver->Fl_Graphics_Driver::scale(1); // temporarily remove scaling factor
-  fl_font(fl_font(), int(fs * Fl_Gl_Window_Driver::gl_scale)); // the font size to use in the GL scene
-  int w = (int)ceil( fl_width(fifo[current].utf8, n) );
-  w = ((w + 3) / 4) * 4; // make w a multiple of 4
-  int h = fl_height();
-  fl_graphics_driver->Fl_Graphics_Driver::scale(s); // re-install scaling factor
-  fl_font(fl_font(), fs);
-  fs = int(fs * Fl_Gl_Window_Driver::gl_scale);
-  fifo[current].scale = Fl_Gl_Window_Driver::gl_scale;
-  fifo[current].fdesc = gl_fontsize;
-  char *alpha_buf = Fl_Gl_Window_Driver::global()->alpha_mask_for_string(str, n, w, h, fs);
-
-  // save GL parameters GL_UNPACK_ROW_LENGTH and GL_UNPACK_ALIGNMENT
-  GLint row_length, alignment;
-  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
-  glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
-
-  // put the bitmap in an alpha-component-only texture
-  glPushAttrib(GL_TEXTURE_BIT);
-  glBindTexture (GL_TEXTURE_RECTANGLE_ARB, fifo[current].texName);
-  glTexParameteri(GL_TEXTURE_RECTANGLE_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-  // GL_ALPHA8 is defined in GL/gl.h of X11 and of MinGW32 and of MinGW64 and of OpenGL.framework for MacOS
-  glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_ALPHA8, w, h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha_buf);
-  /* For the record: texture construction if an alpha-only-texture is not possible
-   glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA8, w, h, 0, GL_BGRA_EXT, GL_UNSIGNED_INT_8_8_8_8_REV, rgba_buf);
-   and also, replace GL_SRC_ALPHA by GL_ONE in glBlendFunc() call of display_texture()
-   */
-  delete[] alpha_buf; // free the buffer now we have copied it into the GL texture
-  glPopAttrib();
-  // restore saved GL parameters
-  glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
-  return current;
-}
+} // display_string
 
 #endif  // ! defined(FL_DOXYGEN)
 
 /**
- Returns the current maximum height of the pile of pre-computed string textures.
- The default value is 100
+ Returns the current maximum number of texture pages of the glyph atlas.
+ The default value is 8
+ \see gl_texture_pile_height(int)
  \see Fl::draw_GL_text_with_textures(int)
  */
 int gl_texture_pile_height(void)
 {
-  if (! gl_fifo) gl_fifo = new gl_texture_fifo();
-  return gl_fifo->size();
+  if (! gl_atlas) gl_atlas = new gl_glyph_atlas();
+  return gl_atlas->size();
 }
 
 /** To call after GL operations that may invalidate textures used to draw text in GL scenes
@@ -477,22 +629,28 @@ int gl_texture_pile_height(void)
  */
 void gl_texture_reset()
 {
-  if (gl_fifo) gl_texture_pile_height(gl_texture_pile_height());
+  if (gl_atlas) gl_texture_pile_height(gl_texture_pile_height());
 }
 
 
 /**
- Changes the maximum height of the pile of pre-computed string textures
-
- Strings that are often re-displayed can be processed much faster if
- this pile is set high enough to hold all of them.
- \param max Maximum height of the texture pile
+ Changes the maximum number of texture pages of the glyph atlas.
+
+ Each glyph drawn by gl_draw() is rasterized once and kept in a texture page
+ of 1024x1024 pixels (alpha channel only) shared by all fonts and sizes, so
+ that it can be re-displayed without being computed again.
+ When all pages are full, the least recently used one is emptied.
+ Pages are created only when needed, so that a high value costs nothing
+ to programs that draw few different glyphs.
+ Calling this function empties the atlas.
+ Before FLTK 1.5.0, \p max was the number of pre-computed strings.
+ \param max Maximum number of atlas pages
  \see Fl::draw_GL_text_with_textures(int)
 */
 void gl_texture_pile_height(int max)
 {
-  if (gl_fifo) delete gl_fifo;
-  gl_fifo = new gl_texture_fifo(max);
+  if (gl_atlas) delete gl_atlas;
+  gl_atlas = new gl_glyph_atlas(max);
 }
 
 
@@ -508,7 +666,7 @@ void Fl_Gl_Window_Driver::draw_string_legacy(const char* str, int n)
 }
 
 
-/** draws a utf8 string using an OpenGL texture */
+/** draws a utf8 string using the OpenGL glyph atlas */
 void Fl_Gl_Window_Driver::draw_string_with_texture(const char* str, int n)
 {
   // Check if the raster pos is valid.
@@ -518,16 +676,19 @@ void Fl_Gl_Window_Driver::draw_string_with_texture(const char* str, int n)
   if (!valid) return;
   Fl_Gl_Window *gwin = Fl_Window::current()->as_gl_window();
   gl_scale = (gwin ? gwin->pixels_per_unit() : 1);
-  if (!gl_fifo) gl_fifo = new gl_texture_fifo();
-  if (!gl_fifo->textures_generated) {
-    if (has_texture_rectangle) for (int i = 0; i < gl_fifo->size_; i++) glGenTextures(1, &(gl_fifo->fifo[i].texName));
-    gl_fifo->textures_generated = 1;
-  }
-  int index = gl_fifo->already_known(str, n);
-  if (index == -1) {
-    index = gl_fifo->compute_texture(str, n);
+  if (!gl_atlas) gl_atlas = new gl_glyph_atlas();
+  gl_atlas->stamp++;
+  gl_atlas->string_glyphs.clear();
+  int scaled_size = 0;
+  const char *end = str + n;
+  while (str < end) {
+    int len;
+    unsigned ucs = fl_utf8decode(str, end, &len);
+    if (len < 1) len = 1;
+    gl_atlas->string_glyphs.push_back(gl_atlas->find_or_add(ucs, str, len, scaled_size));
+    str += len;
   }
-  gl_fifo->display_texture(index);
+  gl_atlas->display_string();
 }
 
 
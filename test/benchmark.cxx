@@ -0,0 +1,734 @@
+//
+// Drawing benchmarks for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+//
+// This program draws core widgets into an Fl_Image_Surface, without showing
+// any window, and writes the timings as JSON so that they can be compared
+// across releases:
+//
+//   benchmark [-n frames] [-o file.json] [name ...]
+//
+// -n sets the number of frames drawn by each benchmark (default 100), -o
+// writes the results to a file instead of stdout, and names select the
+// benchmarks to run (default: all). Progress goes to stderr.
+//
+// Note: no window is shown, but on X11 the offscreen drawing is done by the
+// X server, so a display connection is still required (Xvfb will do).
+//
+// The gif_load_* benchmarks decode a GIF image and draw it, once stored as
+// RGB pixels (the default) and once as XPM data like FLTK 1.4 did, see
+// Fl_GIF_Image::xpm_data.
+//
+// The pixel_* and image_color_average/desaturate benchmarks time the pixel
+// kernels used for alpha blending without XRender and for image effects,
+// the *_scalar variants do the same without SIMD instructions.
+//
+// The png_write_* and jpeg_write benchmarks encode a drawn Fl_Browser into
+// memory with Fl_Image_Writer, with the default and with fast settings.
+//
+// The preferences_set_get benchmark sets and reads back 100000 entries of
+// an in-memory Fl_Preferences group, no drawing is involved.
+//
+// The dashboard_* benchmarks draw many widgets into a larger surface with
+// 1, 2, 4, and 8 threads, see Fl_Image_Surface::tiled_drawing(); comparing
+// them shows how tiled drawing scales with the number of cores.
+//
+// The load time of large FLUID projects is measured by fluid_benchmark.sh.
+//
+
+#include <FL/Fl.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Text_Display.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/Fl_Browser.H>
+#include <FL/Fl_Table.H>
+#include <FL/Fl_Tree.H>
+#include <FL/Fl_Terminal.H>
+#include <FL/Fl_Image.H>
+#include <FL/Fl_GIF_Image.H>
+#include <FL/Fl_Image_Writer.H>
+#include <FL/Fl_Preferences.H>
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Chart.H>
+#include <FL/Fl_Dial.H>
+#include <FL/Fl_Slider.H>
+#include <FL/fl_draw.H>
+#include <FL/fl_utf8.h>
+#include "../src/Fl_Pixel_Ops.H"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const int W = 800, H = 600;      // size of the surface
+static Fl_Image_Surface *surface = NULL;
+
+// Waits until the (possibly asynchronous) drawing is done by reading back a pixel
+static void sync() {
+  uchar pixel[3];
+  fl_read_image(pixel, 0, 0, 1, 1);
+}
+
+// Draws a widget into the surface and waits until it is rendered
+static void draw_widget(Fl_Widget *w) {
+  surface->draw(w);
+  sync();
+}
+
+// ----- the benchmarks --------------------------------------------------------
+
+// A benchmark creates its widgets in setup(), draws one frame in frame(),
+// and deletes its widgets in cleanup(). Only frame() is timed.
+
+struct Benchmark {
+  const char *name;
+  const char *description;
+  void (*setup)();
+  void (*frame)(int i);
+  void (*cleanup)();
+};
+
+// Fl_Text_Display with a large buffer, scrolled by a page per frame
+
+static Fl_Text_Buffer *text_buffer = NULL;
+static Fl_Text_Display *text_display = NULL;
+static const int text_lines = 100000;
+
+static void text_setup(int wrap) {
+  text_buffer = new Fl_Text_Buffer();
+  char line[200];
+  for (int i = 0; i < text_lines; i++) {
+    snprintf(line, sizeof(line),
+             "%06d  The quick brown fox jumps over the lazy dog, %s.\n",
+             i, (i % 7) ? "again and again" :
+             "and then it keeps running far beyond the right edge of the display");
+    text_buffer->append(line);
+  }
+  text_display = new Fl_Text_Display(0, 0, W, H);
+  text_display->buffer(text_buffer);
+  text_display->textfont(FL_COURIER);
+  if (wrap) text_display->wrap_mode(Fl_Text_Display::WRAP_AT_BOUNDS, 0);
+}
+
+static void text_setup() { text_setup(0); }
+static void text_wrap_setup() { text_setup(1); }
+
+static void text_frame(int i) {
+  text_display->scroll(1 + (i * 37) % (text_lines - 40), 0);
+  draw_widget(text_display);
+}
+
+static void text_cleanup() {
+  delete text_display;
+  delete text_buffer;
+}
+
+// Fl_Browser with formatted lines, scrolled by a page per frame
+
+static Fl_Browser *browser = NULL;
+static const int browser_lines = 20000;
+
+static void browser_setup() {
+  browser = new Fl_Browser(0, 0, W, H);
+  static int widths[] = { 80, 200, 0 };
+  browser->column_widths(widths);
+  char line[200];
+  for (int i = 0; i < browser_lines; i++) {
+    snprintf(line, sizeof(line), "%s%d\t@b%s\t@i@C%dcolumn text of line %d",
+             (i % 5) ? "" : "@B17", i, (i % 2) ? "odd" : "even", i % 16, i);
+    browser->add(line);
+  }
+}
+
+static void browser_frame(int i) {
+  browser->topline(1 + (i * 29) % (browser_lines - 30));
+  draw_widget(browser);
+}
+
+static void browser_cleanup() { delete browser; }
+
+// Fl_Table with row and column headers, scrolled by a page per frame
+
+class Bench_Table : public Fl_Table {
+protected:
+  void draw_cell(TableContext context, int R, int C, int X, int Y, int W, int H) FL_OVERRIDE {
+    char s[40];
+    switch (context) {
+      case CONTEXT_STARTPAGE:
+        fl_font(FL_HELVETICA, 14);
+        return;
+      case CONTEXT_COL_HEADER:
+      case CONTEXT_ROW_HEADER:
+        snprintf(s, sizeof(s), "%d", context == CONTEXT_COL_HEADER ? C : R);
+        fl_push_clip(X, Y, W, H);
+        fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, FL_BACKGROUND_COLOR);
+        fl_color(FL_BLACK);
+        fl_draw(s, X, Y, W, H, FL_ALIGN_CENTER);
+        fl_pop_clip();
+        return;
+      case CONTEXT_CELL:
+        snprintf(s, sizeof(s), "%d/%d", R, C);
+        fl_push_clip(X, Y, W, H);
+        fl_color((R + C) % 2 ? FL_WHITE : fl_rgb_color(240, 240, 255));
+        fl_rectf(X, Y, W, H);
+        fl_color(FL_BLACK);
+        fl_draw(s, X, Y, W, H, FL_ALIGN_CENTER);
+        fl_color(FL_LIGHT2);
+        fl_rect(X, Y, W, H);
+        fl_pop_clip();
+        return;
+      default:
+        return;
+    }
+  }
+public:
+  Bench_Table(int X, int Y, int W, int H) : Fl_Table(X, Y, W, H) {
+    rows(10000);
+    cols(30);
+    row_header(1);
+    col_header(1);
+    col_width_all(70);
+    row_height_all(22);
+    end();
+  }
+};
+
+static Bench_Table *table = NULL;
+
+static void table_setup() { table = new Bench_Table(0, 0, W, H); }
+
+static void table_frame(int i) {
+  table->row_position((i * 25) % (table->rows() - 30));
+  table->col_position((i * 3) % (table->cols() - 10));
+  draw_widget(table);
+}
+
+static void table_cleanup() { delete table; }
+
+// Fl_Tree with nested items, scrolled by a page per frame
+
+static Fl_Tree *tree = NULL;
+static int tree_range = 1;        // maximum vertical scroll position
+
+static void tree_setup() {
+  tree = new Fl_Tree(0, 0, W, H);
+  tree->showroot(0);
+  char path[100];
+  for (int i = 0; i < 100; i++) {
+    for (int j = 0; j < 50; j++) {
+      snprintf(path, sizeof(path), "Folder %03d/Item %03d.%02d", i, i, j);
+      tree->add(path);
+    }
+  }
+  tree->end();
+  draw_widget(tree); // computes the size of the tree
+  tree->vposition(1 << 30);
+  if (tree->vposition() > 0) tree_range = tree->vposition();
+}
+
+static void tree_frame(int i) {
+  tree->vposition((i * 500) % tree_range);
+  draw_widget(tree);
+}
+
+static void tree_cleanup() { delete tree; }
+
+// Fl_Terminal receiving colored output, ten lines per frame
+
+static Fl_Terminal *terminal = NULL;
+
+static void terminal_setup() {
+  terminal = new Fl_Terminal(0, 0, W, H);
+  terminal->redraw_style(Fl_Terminal::NO_REDRAW);
+  terminal->history_lines(1000);
+}
+
+static void terminal_frame(int i) {
+  char line[200];
+  for (int j = 0; j < 10; j++) {
+    snprintf(line, sizeof(line),
+             "\033[3%dm%6d\033[0m build step %d: \033[1mcompiling\033[0m src/file_%d.cxx\n",
+             1 + (i + j) % 7, i * 10 + j, j, i);
+    terminal->append(line);
+  }
+  draw_widget(terminal);
+}
+
+static void terminal_cleanup() { delete terminal; }
+
+// Fl_RGB_Image drawn at a different size in each frame, and resampled
+
+static Fl_RGB_Image *image = NULL;
+static uchar *image_data = NULL;
+
+static void image_setup() {
+  const int iw = 1024, ih = 768;
+  image_data = new uchar[iw * ih * 3];
+  uchar *p = image_data;
+  for (int y = 0; y < ih; y++) {
+    for (int x = 0; x < iw; x++) {
+      *p++ = (uchar)(x ^ y);
+      *p++ = (uchar)(x * 255 / iw);
+      *p++ = (uchar)(y * 255 / ih);
+    }
+  }
+  image = new Fl_RGB_Image(image_data, iw, ih, 3);
+}
+
+static void image_scale_frame(int i) {
+  // a new size makes sure the scaled image is not taken from a cache
+  image->scale(W - 100 + i % 100, H - 100 + (i * 7) % 100, 0, 1);
+  image->draw(0, 0);
+  sync();
+}
+
+static void image_copy_frame(int i) {
+  Fl_Image *copy = image->copy(W - 100 + i % 100, H - 100 + (i * 7) % 100);
+  delete copy;
+}
+
+static void image_cleanup() {
+  delete image;
+  delete[] image_data;
+}
+
+// Text drawing and measuring with several fonts and sizes
+
+static void font_setup() {}
+
+static void font_frame(int i) {
+  static const char *lines[] = {
+    "The quick brown fox jumps over the lazy dog. 0123456789",
+    "Sphinx of black quartz, judge my vow! (){}[]<>#%&@$",
+    "\xc3\x84rger \xc3\xbc" "ber \xc3\xa9t\xc3\xa9, \xce\xb1\xce\xb2\xce\xb3 \xe2\x82\xac 100",
+  };
+  fl_color(FL_WHITE);
+  fl_rectf(0, 0, W, H);
+  fl_color(FL_BLACK);
+  int y = 0;
+  for (int j = 0; y < H; j++) {
+    Fl_Fontsize size = 8 + (i + j) % 17;
+    fl_font((Fl_Font)(j % 12), size);
+    const char *s = lines[j % 3];
+    double w = fl_width(s);
+    fl_draw(s, 10, y + size);
+    fl_line(10, y + size + 2, 10 + (int)w, y + size + 2);
+    y += size + 4;
+  }
+  sync();
+}
+
+static void font_cleanup() {}
+
+// A 256 color GIF image decoded from memory and drawn
+
+static uchar *gif_data = NULL;
+static size_t gif_size = 0;
+static int gif_bits = 0, gif_nbits = 0, gif_block = 0; // block = start of sub-block
+
+static void gif_byte(int b) { gif_data[gif_size++] = (uchar)b; }
+
+// Appends an LZW code to the image data, in sub-blocks of up to 255 bytes
+static void gif_code(int code, int size) {
+  gif_bits |= code << gif_nbits;
+  gif_nbits += size;
+  while (gif_nbits >= 8) {
+    if (gif_size - gif_block == 256) { gif_data[gif_block] = 255; gif_block = (int)gif_size; gif_byte(0); }
+    gif_byte(gif_bits & 255);
+    gif_bits >>= 8;
+    gif_nbits -= 8;
+  }
+}
+
+static void gif_setup(bool xpm) {
+  const int iw = 1024, ih = 768;
+  static short child[4096][256]; // LZW table: code of a string + one pixel
+  gif_data = new uchar[iw * ih * 2 + 1024];
+  gif_size = gif_bits = gif_nbits = 0;
+  const char header[] = "GIF89a";
+  for (int i = 0; i < 6; i++) gif_byte(header[i]);
+  gif_byte(iw & 255); gif_byte(iw >> 8); gif_byte(ih & 255); gif_byte(ih >> 8);
+  gif_byte(0xf7); gif_byte(0); gif_byte(0);               // global 256 color map
+  for (int i = 0; i < 256; i++) { gif_byte(i); gif_byte(255 - i); gif_byte((i * 7) & 255); }
+  gif_byte(0x2c);                                         // image descriptor
+  for (int i = 0; i < 4; i++) gif_byte(0);
+  gif_byte(iw & 255); gif_byte(iw >> 8); gif_byte(ih & 255); gif_byte(ih >> 8);
+  gif_byte(0);
+  gif_byte(8);                                            // LZW code size
+  gif_block = (int)gif_size; gif_byte(0);
+  int size = 9, next = 258, prefix = -1;
+  memset(child, 0xff, sizeof(child));
+  gif_code(256, size);
+  for (int y = 0; y < ih; y++) {
+    for (int x = 0; x < iw; x++) {
+      int c = ((x / 16 + y / 16) * 5 + ((x * y) >> 12)) & 255; // bands and noise
+      if (prefix < 0) { prefix = c; continue; }
+      if (child[prefix][c] >= 0) { prefix = child[prefix][c]; continue; }
+      gif_code(prefix, size);
+      child[prefix][c] = (short)next++;
+      if (next > (1 << size) && size < 12) size++;
+      if (next == 4096) {
+        gif_code(256, size);
+        memset(child, 0xff, sizeof(child));
+        size = 9; next = 258;
+      }
+      prefix = c;
+    }
+  }
+  gif_code(prefix, size);
+  gif_code(257, size);
+  if (gif_nbits) gif_code(0, 8 - gif_nbits);
+  gif_data[gif_block] = (uchar)(gif_size - gif_block - 1);
+  gif_byte(0);                                            // block terminator
+  gif_byte(0x3b);                                         // trailer
+  Fl_GIF_Image::xpm_data = xpm;
+}
+
+static void gif_rgb_setup() { gif_setup(false); }
+static void gif_xpm_setup() { gif_setup(true); }
+
+static void gif_frame(int) {
+  Fl_GIF_Image gif(NULL, gif_data, gif_size);
+  gif.draw(0, 0);
+  sync();
+}
+
+static void gif_cleanup() {
+  Fl_GIF_Image::xpm_data = false;
+  delete[] gif_data;
+}
+
+// The pixel kernels of Fl_Pixel_Ops on a 1024x768 RGBA image, with the
+// best SIMD instruction set of the CPU and with the scalar code
+
+static uchar *pixels = NULL, *pixels_rgb = NULL;
+static const int PW = 1024, PH = 768;
+
+static void pixels_setup(int simd) {
+  pixels = new uchar[PW * PH * 4];
+  pixels_rgb = new uchar[PW * PH * 4];
+  for (int i = 0; i < PW * PH; i++) {
+    pixels[4*i] = (uchar)i;
+    pixels[4*i+1] = (uchar)(i >> 4);
+    pixels[4*i+2] = (uchar)(i >> 8);
+    pixels[4*i+3] = (uchar)((i % PW) * 255 / PW);  // alpha gradient
+  }
+  memset(pixels_rgb, 0x80, PW * PH * 4);
+  Fl_Pixel_Ops::simd(simd ? Fl_Pixel_Ops::AVX2 : Fl_Pixel_Ops::SCALAR);
+}
+
+static void pixels_simd_setup() { pixels_setup(1); }
+static void pixels_scalar_setup() { pixels_setup(0); }
+
+static void blend_frame(int) {
+  for (int y = 0; y < PH; y++)
+    Fl_Pixel_Ops::blend(pixels + y * PW * 4, 4, pixels_rgb + y * PW * 3, PW);
+}
+
+static void premultiply_frame(int) {
+  static const signed char argb[4] = {2, 1, 0, 3};
+  for (int y = 0; y < PH; y++)
+    Fl_Pixel_Ops::premultiply32(pixels + y * PW * 4, pixels_rgb + y * PW * 4, PW, 4, argb);
+}
+
+static void color_average_frame(int i) {
+  Fl_RGB_Image img(pixels, PW, PH, 4);
+  img.color_average((Fl_Color)(FL_RED + i % 6), 0.75f);
+}
+
+static void desaturate_frame(int) {
+  Fl_RGB_Image img(pixels, PW, PH, 4);
+  img.desaturate();
+}
+
+static void pixels_cleanup() {
+  Fl_Pixel_Ops::simd(Fl_Pixel_Ops::AVX2);
+  delete[] pixels;
+  delete[] pixels_rgb;
+}
+
+// A drawn surface encoded as PNG or JPEG into memory
+
+static Fl_Image_Writer *writer = NULL;
+static uchar *capture = NULL;
+
+static void write_setup(Fl_Image_Writer::Format format, int fast) {
+  browser_setup();
+  draw_widget(browser);
+  capture = fl_read_image(NULL, 0, 0, W, H);
+  browser_cleanup();
+  writer = new Fl_Image_Writer(format);
+  writer->output_to_memory();
+  if (fast) {
+    writer->compression(2);
+    writer->filter(Fl_Image_Writer::FILTER_SUB);
+  }
+}
+
+static void png_write_setup() { write_setup(Fl_Image_Writer::PNG, 0); }
+static void png_write_fast_setup() { write_setup(Fl_Image_Writer::PNG, 1); }
+static void jpeg_write_setup() { write_setup(Fl_Image_Writer::JPEG, 0); }
+
+static void write_frame(int) {
+  writer->write(capture, W, H, 3);
+}
+
+static void write_cleanup() {
+  delete writer;
+  delete[] capture;
+}
+
+// Fl_Preferences with 100000 entries in one group, all set and read back
+
+static Fl_Preferences *prefs = NULL;
+static char (*pref_keys)[16] = NULL;
+static const int pref_entries = 100000;
+
+static void prefs_setup() {
+  prefs = new Fl_Preferences(Fl_Preferences::MEMORY, "fltk.org", "benchmark");
+  pref_keys = new char[pref_entries][16];
+  for (int k = 0; k < pref_entries; k++) {
+    snprintf(pref_keys[k], sizeof(pref_keys[k]), "recent%d", k);
+    prefs->set(pref_keys[k], 0);
+  }
+}
+
+static void prefs_frame(int i) {
+  int k, v;
+  for (k = 0; k < pref_entries; k++)
+    prefs->set(pref_keys[k], i + k);
+  for (k = 0; k < pref_entries; k++)
+    prefs->get(pref_keys[k], v, 0);
+}
+
+static void prefs_cleanup() {
+  delete prefs;
+  delete[] pref_keys;
+}
+
+// A dashboard of 600 widgets drawn into a 4000x3000 surface by several threads
+
+static const int DW = 4000, DH = 3000;  // size of the dashboard surface
+static Fl_Image_Surface *dashboard_surface = NULL;
+static Fl_Group *dashboard = NULL;
+
+static void dashboard_setup(int threads) {
+  dashboard_surface = new Fl_Image_Surface(DW, DH);
+  dashboard_surface->tiled_drawing(threads, 256);
+  Fl_Surface_Device::push_current(dashboard_surface);
+  dashboard = new Fl_Group(0, 0, DW, DH);
+  dashboard->box(FL_FLAT_BOX);
+  const int cw = DW / 20, ch = DH / 10;  // 20 x 10 cells of 3 widgets
+  static char labels[200][16];
+  for (int r = 0; r < 10; r++) {
+    for (int c = 0; c < 20; c++) {
+      int x = c * cw, y = r * ch, k = r * 20 + c;
+      snprintf(labels[k], sizeof(labels[k]), "Sensor %d", k);
+      Fl_Box *b = new Fl_Box(FL_UP_BOX, x + 2, y + 2, cw - 4, 30, labels[k]);
+      b->labelfont(FL_HELVETICA_BOLD);
+      Fl_Chart *chart = new Fl_Chart(x + 2, y + 34, cw - 4, ch - 110);
+      chart->type(k % 2 ? FL_LINE_CHART : FL_FILLED_CHART);
+      for (int i = 0; i < 40; i++)
+        chart->add((i * (k + 3)) % 17 + 5.0, NULL, (Fl_Color)(FL_RED + k % 6));
+      Fl_Dial *dial = new Fl_Dial(x + 2, y + ch - 74, 70, 70);
+      dial->type(FL_FILL_DIAL);
+      dial->value((k % 10) / 10.0);
+      Fl_Slider *slider = new Fl_Slider(x + 76, y + ch - 50, cw - 80, 24);
+      slider->type(FL_HOR_NICE_SLIDER);
+      slider->value((k % 7) / 7.0);
+    }
+  }
+  dashboard->end();
+}
+
+static void dashboard_1_setup() { dashboard_setup(1); }
+static void dashboard_2_setup() { dashboard_setup(2); }
+static void dashboard_4_setup() { dashboard_setup(4); }
+static void dashboard_8_setup() { dashboard_setup(8); }
+
+static void dashboard_frame(int i) {
+  ((Fl_Dial*)dashboard->child(2))->value((i % 10) / 10.0); // changes a little
+  dashboard_surface->draw(dashboard);
+  sync();
+}
+
+static void dashboard_cleanup() {
+  delete dashboard;
+  Fl_Surface_Device::pop_current();
+  delete dashboard_surface;
+}
+
+static const Benchmark benchmarks[] = {
+  { "text_display_scroll", "Fl_Text_Display, 100000 lines, scrolling",
+    text_setup, text_frame, text_cleanup },
+  { "text_display_wrap_scroll", "Fl_Text_Display, 100000 wrapped lines, scrolling",
+    text_wrap_setup, text_frame, text_cleanup },
+  { "browser_scroll", "Fl_Browser, 20000 formatted lines, scrolling",
+    browser_setup, browser_frame, browser_cleanup },
+  { "table_scroll", "Fl_Table, 10000 x 30 cells, scrolling",
+    table_setup, table_frame, table_cleanup },
+  { "tree_scroll", "Fl_Tree, 5000 items in 100 folders, scrolling",
+    tree_setup, tree_frame, tree_cleanup },
+  { "terminal_output", "Fl_Terminal, 10 colored lines of output per frame",
+    terminal_setup, terminal_frame, terminal_cleanup },
+  { "image_draw_scaled", "Fl_RGB_Image 1024x768, drawn at a new size",
+    image_setup, image_scale_frame, image_cleanup },
+  { "image_copy_resampled", "Fl_RGB_Image 1024x768, copy() to a new size",
+    image_setup, image_copy_frame, image_cleanup },
+  { "font_rendering", "fl_draw() and fl_width() in 12 fonts and 17 sizes",
+    font_setup, font_frame, font_cleanup },
+  { "gif_load_rgb", "Fl_GIF_Image 1024x768, 256 colors, decoded and drawn",
+    gif_rgb_setup, gif_frame, gif_cleanup },
+  { "gif_load_xpm", "Fl_GIF_Image 1024x768, 256 colors, decoded to XPM and drawn",
+    gif_xpm_setup, gif_frame, gif_cleanup },
+  { "pixel_blend", "Fl_Pixel_Ops::blend(), 1024x768 RGBA over RGB",
+    pixels_simd_setup, blend_frame, pixels_cleanup },
+  { "pixel_blend_scalar", "Fl_Pixel_Ops::blend(), 1024x768 RGBA over RGB, no SIMD",
+    pixels_scalar_setup, blend_frame, pixels_cleanup },
+  { "pixel_premultiply", "Fl_Pixel_Ops::premultiply32(), 1024x768 RGBA to ARGB32",
+    pixels_simd_setup, premultiply_frame, pixels_cleanup },
+  { "pixel_premultiply_scalar", "Fl_Pixel_Ops::premultiply32(), 1024x768 RGBA, no SIMD",
+    pixels_scalar_setup, premultiply_frame, pixels_cleanup },
+  { "image_color_average", "Fl_RGB_Image 1024x768 RGBA, color_average()",
+    pixels_simd_setup, color_average_frame, pixels_cleanup },
+  { "image_color_average_scalar", "Fl_RGB_Image 1024x768 RGBA, color_average(), no SIMD",
+    pixels_scalar_setup, color_average_frame, pixels_cleanup },
+  { "image_desaturate", "Fl_RGB_Image 1024x768 RGBA, desaturate()",
+    pixels_simd_setup, desaturate_frame, pixels_cleanup },
+  { "image_desaturate_scalar", "Fl_RGB_Image 1024x768 RGBA, desaturate(), no SIMD",
+    pixels_scalar_setup, desaturate_frame, pixels_cleanup },
+  { "png_write", "Fl_Image_Writer, 800x600 PNG into memory, default settings",
+    png_write_setup, write_frame, write_cleanup },
+  { "png_write_fast", "Fl_Image_Writer, 800x600 PNG into memory, level 2, sub filter",
+    png_write_fast_setup, write_frame, write_cleanup },
+  { "jpeg_write", "Fl_Image_Writer, 800x600 JPEG into memory, quality 95",
+    jpeg_write_setup, write_frame, write_cleanup },
+  { "preferences_set_get", "Fl_Preferences, 100000 entries, set and get each",
+    prefs_setup, prefs_frame, prefs_cleanup },
+  { "dashboard_1_thread", "600 widgets on a 4000x3000 surface, 1 thread",
+    dashboard_1_setup, dashboard_frame, dashboard_cleanup },
+  { "dashboard_2_threads", "600 widgets on a 4000x3000 surface, 2 threads in tiles",
+    dashboard_2_setup, dashboard_frame, dashboard_cleanup },
+  { "dashboard_4_threads", "600 widgets on a 4000x3000 surface, 4 threads in tiles",
+    dashboard_4_setup, dashboard_frame, dashboard_cleanup },
+  { "dashboard_8_threads", "600 widgets on a 4000x3000 surface, 8 threads in tiles",
+    dashboard_8_setup, dashboard_frame, dashboard_cleanup },
+};
+
+static const int num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+// ----- running and reporting -------------------------------------------------
+
+struct Result {
+  const char *name;
+  int frames;
+  double setup, total, min, max; // milliseconds
+};
+
+static Result run(const Benchmark &b, int frames) {
+  Result r;
+  r.name = b.name;
+  r.frames = frames;
+  Fl_Timestamp start = Fl::now();
+  b.setup();
+  r.setup = Fl::seconds_since(start) * 1000.0;
+  r.total = r.max = 0.0;
+  r.min = 1e30;
+  for (int i = 0; i < frames; i++) {
+    Fl_Timestamp t = Fl::now();
+    b.frame(i);
+    double ms = Fl::seconds_since(t) * 1000.0;
+    r.total += ms;
+    if (ms < r.min) r.min = ms;
+    if (ms > r.max) r.max = ms;
+  }
+  b.cleanup();
+  return r;
+}
+
+static void write_json(FILE *f, const Result *results, int n) {
+  fprintf(f, "{\n  \"fltk_version\": \"%d.%d.%d\",\n",
+          FL_MAJOR_VERSION, FL_MINOR_VERSION, FL_PATCH_VERSION);
+  fprintf(f, "  \"surface\": { \"width\": %d, \"height\": %d },\n", W, H);
+  fprintf(f, "  \"benchmarks\": [\n");
+  for (int i = 0; i < n; i++) {
+    const Result &r = results[i];
+    fprintf(f, "    { \"name\": \"%s\", \"frames\": %d, \"setup_ms\": %.3f, "
+               "\"total_ms\": %.3f, \"mean_ms\": %.3f, \"min_ms\": %.3f, \"max_ms\": %.3f }%s\n",
+            r.name, r.frames, r.setup, r.total, r.frames ? r.total / r.frames : 0.0,
+            r.frames ? r.min : 0.0, r.max, (i < n - 1) ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+}
+
+static void usage() {
+  fprintf(stderr, "usage: benchmark [-n frames] [-o file.json] [name ...]\nbenchmarks:\n");
+  for (int i = 0; i < num_benchmarks; i++)
+    fprintf(stderr, "  %-26s %s\n", benchmarks[i].name, benchmarks[i].description);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  int frames = 100;
+  const char *output = NULL;
+  bool selected[num_benchmarks];
+  bool any_selected = false;
+  memset(selected, 0, sizeof(selected));
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+      if (frames < 1) usage();
+    } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+      output = argv[++i];
+    } else if (argv[i][0] == '-') {
+      usage();
+    } else {
+      int j;
+      for (j = 0; j < num_benchmarks; j++) {
+        if (!strcmp(argv[i], benchmarks[j].name)) break;
+      }
+      if (j == num_benchmarks) usage();
+      selected[j] = any_selected = true;
+    }
+  }
+
+  Fl::scheme("gtk+");
+  surface = new Fl_Image_Surface(W, H);
+  Fl_Surface_Device::push_current(surface); // all benchmarks draw here
+
+  Result results[num_benchmarks];
+  int n = 0;
+  for (int i = 0; i < num_benchmarks; i++) {
+    if (any_selected && !selected[i]) continue;
+    fprintf(stderr, "%-26s ", benchmarks[i].name);
+    fflush(stderr);
+    results[n] = run(benchmarks[i], frames);
+    fprintf(stderr, "%9.3f ms/frame\n", results[n].total / frames);
+    n++;
+  }
+  Fl_Surface_Device::pop_current();
+  delete surface;
+
+  FILE *f = output ? fl_fopen(output, "w") : stdout;
+  if (!f) {
+    fprintf(stderr, "benchmark: can't write %s\n", output);
+    return 1;
+  }
+  write_json(f, results, n);
+  if (output) fclose(f);
+  return 0;
+}
@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# Load-time benchmark for FLUID, the Fast Light User Interface Designer.
+#
+# Copyright 2025 by Bill Spitzak and others.
+#
+# This library is free software. Distribution and use rights are outlined in
+# the file "COPYING" which should have been included with this file.  If this
+# file is missing or damaged, see the license at:
+#
+#     https://www.fltk.org/COPYING.php
+#
+# Please see the following page on how to report bugs and issues:
+#
+#     https://www.fltk.org/bugs.php
+#
+
+#
+# This script writes synthetic .fl projects of the given numbers of widgets
+# into a temporary directory, then loads and compiles each of them with
+# 'fluid -c -t', which prints the time taken per project:
+#
+#   fluid_benchmark.sh path/to/fluid [widgets ...]
+#
+# The default sizes are 2000 and 20000 widgets, the larger project is about
+# 4.7 MB. There is one window per 1000 widgets, split into groups of 20
+# widgets; every widget has a name, a label, a tooltip and a callback.
+# Drawing is timed by test/benchmark, see benchmark.cxx.
+#
+
+if test $# -lt 1 -o ! -x "$1"; then
+  echo "Usage: $0 path/to/fluid [widgets ...]" >&2
+  exit 1
+fi
+case "$1" in
+  /*) fluid="$1" ;;
+  *) fluid="`pwd`/$1" ;;
+esac
+shift
+test $# -eq 0 && set 2000 20000
+
+dir=`mktemp -d "${TMPDIR:-/tmp}/fluid_benchmark.XXXXXX"` || exit 1
+trap 'rm -rf "$dir"' 0
+
+for widgets in "$@"; do
+  project="$dir/synthetic_$widgets.fl"
+  awk -v widgets="$widgets" '
+    BEGIN {
+      split("Fl_Button Fl_Check_Button Fl_Input Fl_Value_Slider Fl_Box", types, " ")
+      print "# data file for the Fltk User Interface Designer (fluid)"
+      print "version 1.0500"
+      print "header_name {.h}"
+      print "code_name {.cxx}"
+      print "decl {\\#include <stdio.h>} {private local\n}"
+      for (n = 0; n < widgets; n++) {
+        if (n % 1000 == 0) {
+          if (n) print "    }\n  }\n}"
+          win = n / 1000 + 1
+          printf "Function {make_window_%d()} {open\n} {\n", win
+          printf "  Fl_Window window_%d {\n    label {Window %d} open\n", win, win
+          print "    xywh {0 0 1000 1000} type Double visible\n  } {"
+        } else if (n % 20 == 0) {
+          print "    }"
+        }
+        g = int((n % 1000) / 20)
+        if (n % 20 == 0) {
+          printf "    Fl_Group group_%d {\n      label {Group %d} open\n", n / 20, n / 20
+          printf "      xywh {%d %d 200 100} box ENGRAVED_FRAME\n    } {\n", (g % 5) * 200, int(g / 5) * 100
+        }
+        t = types[n % 5 + 1]
+        printf "      %s widget_%d {\n        label {%s %d}\n", t, n, t, n
+        printf "        callback {printf(\"%s %d changed\\\\n\");\nfflush(stdout);}\n", t, n
+        printf "        tooltip {Tooltip of widget %d, a %s} xywh {%d %d 90 20}\n      }\n",
+               n, t, (g % 5) * 200 + (n % 2) * 100 + 5, int(g / 5) * 100 + int(n % 20 / 2) * 9 + 5
+      }
+      if (widgets > 0) print "    }\n  }\n}"
+    }' > "$project" || exit 1
+  size=`wc -c < "$project"`
+  echo "$widgets widgets, $size bytes:"
+  (cd "$dir" && "$fluid" -c -t "$project") || exit 1
+done
@@ -0,0 +1,156 @@
+//
+// OpenGL text benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures how many labels per second gl_draw() draws from the glyph atlas
+// into an Fl_Gl_Window, and checks that glyphs drawn again after their atlas
+// page was evicted look the same as before.
+//
+// Usage: gl_labels [-n count] [-f frames] [-p pages] [-s sizes]
+//
+// Each frame draws count labels in 4 fonts and the given number of font
+// sizes. With the defaults the glyphs don't fit in the 2 atlas pages, so
+// that the least recently used page is evicted several times per frame.
+// A reference label is then drawn again and compared with the first frame.
+// The result is printed to stdout after the given number of frames, and the
+// exit status is 1 if the reference label changed.
+// Use LIBGL_ALWAYS_SOFTWARE=1 to measure Mesa's software rasterizer.
+
+#include <config.h>
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+#include <FL/Fl_Box.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !HAVE_GL
+
+int main(int argc, char **argv) {
+  Fl_Window window(300, 100);
+  Fl_Box box(0, 0, 300, 100, "This demo does\nnot work without GL");
+  window.end();
+  window.show(argc, argv);
+  return Fl::run();
+}
+
+#else
+
+#include <FL/gl.h>
+#include <FL/Fl_Gl_Window.H>
+
+static int count = 2000;     // number of labels per frame
+static int frames = 50;      // number of frames to measure
+static int pages = 2;        // maximum number of glyph atlas pages
+static int font_sizes = 60;  // number of font sizes
+static int status = 0;       // exit status
+
+static const Fl_Font fonts[4] = { FL_HELVETICA, FL_HELVETICA_BOLD, FL_TIMES, FL_COURIER };
+
+// the reference label, drawn last in each frame
+static const int ref_w = 200, ref_h = 30;
+static const char *ref_label = "Atlas 0123456789";
+
+class labels_window : public Fl_Gl_Window {
+  int frame;
+  double elapsed;
+  unsigned char *reference; // pixels of the reference label in the first frame
+  unsigned char *pixels;    // pixels of the reference label in the current frame
+  void draw() FL_OVERRIDE;
+public:
+  labels_window(int w, int h) : Fl_Gl_Window(w, h, "gl_labels") {
+    frame = 0;
+    elapsed = 0;
+    reference = new unsigned char[ref_w * ref_h * 3];
+    pixels = new unsigned char[ref_w * ref_h * 3];
+  }
+  ~labels_window() {
+    delete[] reference;
+    delete[] pixels;
+  }
+};
+
+void labels_window::draw() {
+  if (!valid()) {
+    glViewport(0, 0, pixel_w(), pixel_h());
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, w(), 0, h(), -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+  }
+  glClearColor(1, 1, 1, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+  Fl_Timestamp start = Fl::now();
+  char label[32];
+  unsigned seed = 1 + frame;
+  for (int i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    int x = (seed >> 8) % w(), y = (seed >> 4) % h();
+    gl_font(fonts[i % 4], 10 + (seed >> 16) % font_sizes);
+    gl_color(fl_rgb_color(uchar(seed >> 24), uchar(seed >> 16), uchar(seed >> 8)));
+    snprintf(label, sizeof(label), "Label %u", seed % 100000);
+    gl_draw(label, x, y);
+  }
+  glFinish();
+  elapsed += Fl::seconds_since(start);
+
+  // draw the reference label on a cleared area and compare it with the first frame
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(0, 0, ref_w, ref_h);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+  gl_font(FL_HELVETICA, 20);
+  gl_color(FL_BLACK);
+  gl_draw(ref_label, 5, 8);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, ref_w, ref_h, GL_RGB, GL_UNSIGNED_BYTE, frame ? pixels : reference);
+  if (frame && memcmp(pixels, reference, ref_w * ref_h * 3)) {
+    fprintf(stderr, "frame %d: the reference label differs from the first frame\n", frame);
+    status = 1;
+  }
+
+  if (++frame < frames) {
+    redraw();
+  } else {
+    double total = double(count) * frames;
+    printf("%d frames, %d labels per frame, %d atlas pages: %.3f s, %.0f labels/s\n",
+           frames, count, pages, elapsed, total / elapsed);
+    fflush(stdout);
+    hide();
+  }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc - 1; i++) {
+    if (!strcmp(argv[i], "-n")) count = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-f")) frames = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-p")) pages = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s")) font_sizes = atoi(argv[++i]);
+  }
+  if (count < 1) count = 1;
+  if (frames < 2) frames = 2;
+  if (pages < 1) pages = 1;
+  if (font_sizes < 1) font_sizes = 1;
+  Fl::draw_GL_text_with_textures(1);
+  gl_texture_pile_height(pages);
+  labels_window window(600, 400);
+  window.mode(FL_RGB | FL_DOUBLE);
+  window.show();
+  Fl::run();
+  return status;
+}
+
+#endif // HAVE_GL
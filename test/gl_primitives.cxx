@@ -0,0 +1,107 @@
+//
+// OpenGL 2D primitives benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 1998-2025 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// Measures how many rectangles, lines, and polygons per second the FLTK
+// 2D drawing API can draw into an Fl_Gl_Window.
+//
+// Usage: gl_primitives [-n count] [-f frames]
+//
+// The result is printed to stdout after the given number of frames.
+// Use LIBGL_ALWAYS_SOFTWARE=1 to measure Mesa's software rasterizer.
+
+#include <config.h>
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+#include <FL/Fl_Box.H>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !HAVE_GL
+
+int main(int argc, char **argv) {
+  Fl_Window window(300, 100);
+  Fl_Box box(0, 0, 300, 100, "This demo does\nnot work without GL");
+  window.end();
+  window.show(argc, argv);
+  return Fl::run();
+}
+
+#else
+
+#include <FL/gl.h>
+#include <FL/Fl_Gl_Window.H>
+#include <FL/fl_draw.H>
+
+static int count = 20000; // number of primitives of each kind per frame
+static int frames = 50;   // number of frames to measure
+
+class primitives_window : public Fl_Gl_Window {
+  int frame;
+  double elapsed;
+  void draw() FL_OVERRIDE;
+public:
+  primitives_window(int w, int h) : Fl_Gl_Window(w, h, "gl_primitives") {
+    frame = 0;
+    elapsed = 0;
+  }
+};
+
+void primitives_window::draw() {
+  if (!valid()) {
+    glViewport(0, 0, pixel_w(), pixel_h());
+  }
+  glClearColor(1, 1, 1, 1);
+  glClear(GL_COLOR_BUFFER_BIT);
+  Fl_Timestamp start = Fl::now();
+  draw_begin();
+  unsigned seed = 1;
+  for (int i = 0; i < count; i++) {
+    seed = seed * 1103515245 + 12345;
+    int x = (seed >> 8) % w(), y = (seed >> 4) % h();
+    fl_color(fl_rgb_color(uchar(seed >> 24), uchar(seed >> 16), uchar(seed >> 8)));
+    fl_rectf(x, y, 8, 6);
+    fl_line(x, y, x + 12, y + 7);
+    fl_polygon(x, y, x + 6, y + 9, x - 4, y + 5);
+  }
+  draw_end();
+  glFinish();
+  elapsed += Fl::seconds_since(start);
+  if (++frame < frames) {
+    redraw();
+  } else {
+    double total = 3.0 * count * frames;
+    printf("%d frames, %d primitives per frame: %.3f s, %.0f primitives/s\n",
+           frames, 3 * count, elapsed, total / elapsed);
+    fflush(stdout);
+    hide();
+  }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc - 1; i++) {
+    if (!strcmp(argv[i], "-n")) count = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-f")) frames = atoi(argv[++i]);
+  }
+  if (count < 1) count = 1;
+  if (frames < 1) frames = 1;
+  primitives_window window(600, 400);
+  window.mode(FL_RGB | FL_DOUBLE);
+  window.show();
+  return Fl::run();
+}
+
+#endif // HAVE_GL
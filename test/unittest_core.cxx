@@ -18,13 +18,18 @@
 
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/fl_draw.H>
 #include <FL/Fl_Terminal.H>
 #include <FL/Fl_Preferences.H>
 #include <FL/fl_callback_macros.H>
 #include <FL/filename.H>
 #include <FL/fl_utf8.h>
+#include "../src/Fl_Pixel_Ops.H"
 
 #include <string>
+#include <string.h>
 
 
 /* Test additions to Fl_Preferences. */
@@ -50,6 +55,197 @@ TEST(Fl_Preferences, Strings) {
   return true;
 }
 
+/* The SIMD pixel kernels must give the same bytes as the scalar code. */
+static bool pixel_ops_match(int delta, const signed char map[4], bool premultiply) {
+  const int n = 67;
+  uchar src[4*n], ref[4*n], out[4*n];
+  for (int i = 0; i < 4*n; i++) src[i] = uchar(i * 37 + 11);
+  for (int level = Fl_Pixel_Ops::SSSE3; level <= Fl_Pixel_Ops::cpu_simd(); level++) {
+    for (int w = 0; w <= n; w++) {
+      Fl_Pixel_Ops::simd(Fl_Pixel_Ops::SCALAR);
+      if (premultiply) Fl_Pixel_Ops::premultiply32(src, ref, w, delta, map);
+      else Fl_Pixel_Ops::shuffle32(src, ref, w, delta, map);
+      Fl_Pixel_Ops::simd(level);
+      if (premultiply) Fl_Pixel_Ops::premultiply32(src, out, w, delta, map);
+      else Fl_Pixel_Ops::shuffle32(src, out, w, delta, map);
+      if (memcmp(ref, out, 4*w) != 0) return false;
+    }
+  }
+  return true;
+}
+
+TEST(Fl_Pixel_Ops, shuffle32) {
+  static const signed char maps[][4] = {
+    {0, 1, 2, -1}, {2, 1, 0, -1}, {-1, 2, 1, 0}, {-1, 0, 1, 2}, {0, 0, 0, -1}, {-1, 0, 0, 0}
+  };
+  for (int delta = 1; delta <= 4; delta++) {
+    for (int m = 0; m < 6; m++) {
+      if (maps[m][2] >= delta) continue;
+      EXPECT_TRUE(pixel_ops_match(delta, maps[m], false));
+    }
+  }
+  // the xrgb layout of the Xlib driver on a little-endian machine
+  const uchar rgb[6] = { 1, 2, 3, 4, 5, 6 };
+  uchar out[8];
+  static const signed char xrgb[4] = {2, 1, 0, -1};
+  Fl_Pixel_Ops::shuffle32(rgb, out, 2, 3, xrgb);
+  EXPECT_EQ(memcmp(out, "\3\2\1\0\6\5\4\0", 8), 0);
+  Fl_Pixel_Ops::simd(Fl_Pixel_Ops::AVX2);
+  return true;
+}
+
+TEST(Fl_Pixel_Ops, premultiply32) {
+  static const signed char argb[4] = {2, 1, 0, 3};
+  static const signed char gray[4] = {0, 0, 0, 1};
+  EXPECT_TRUE(pixel_ops_match(4, argb, true));
+  EXPECT_TRUE(pixel_ops_match(2, gray, true));
+  // all color and alpha values, compared with the formula of the scalar converter
+  uchar *src = new uchar[4*65536], *out = new uchar[4*65536];
+  for (int i = 0; i < 65536; i++) {
+    src[4*i] = uchar(i); src[4*i+1] = uchar(i ^ 0x5a); src[4*i+2] = uchar(~i); src[4*i+3] = uchar(i >> 8);
+  }
+  bool ok = true;
+  for (int level = Fl_Pixel_Ops::SCALAR; ok && level <= Fl_Pixel_Ops::cpu_simd(); level++) {
+    Fl_Pixel_Ops::simd(level);
+    Fl_Pixel_Ops::premultiply32(src, out, 65536, 4, argb);
+    for (int i = 0; ok && i < 65536; i++) {
+      const uchar *s = src + 4*i, *o = out + 4*i;
+      ok = (o[0] == s[2]*s[3]/255 && o[1] == s[1]*s[3]/255 && o[2] == s[0]*s[3]/255 && o[3] == s[3]);
+    }
+  }
+  delete[] src;
+  delete[] out;
+  Fl_Pixel_Ops::simd(Fl_Pixel_Ops::AVX2);
+  EXPECT_TRUE(ok);
+  return true;
+}
+
+/* Blending, color average, and gray conversion of rows of any width. */
+static bool image_ops_match(int level) {
+  const int n = 67;
+  uchar src[4*n], ref[4*n], out[4*n];
+  for (int i = 0; i < 4*n; i++) src[i] = uchar(i % 5 == 0 ? 255 : i % 7 == 0 ? 0 : i * 37 + 11);
+  for (int w = 0; w <= n; w++) {
+    for (int d = 1; d <= 4; d++) {
+      if (d == 2 || d == 4) {
+        for (int i = 0; i < 3*w; i++) ref[i] = out[i] = uchar(i * 13);
+        Fl_Pixel_Ops::simd(Fl_Pixel_Ops::SCALAR);
+        Fl_Pixel_Ops::blend(src, d, ref, w);
+        Fl_Pixel_Ops::simd(level);
+        Fl_Pixel_Ops::blend(src, d, out, w);
+        if (memcmp(ref, out, 3*w) != 0) return false;
+      }
+      Fl_Pixel_Ops::simd(Fl_Pixel_Ops::SCALAR);
+      Fl_Pixel_Ops::color_average(src, ref, w, d, 10, 200, 77, w * 256 / n);
+      Fl_Pixel_Ops::simd(level);
+      Fl_Pixel_Ops::color_average(src, out, w, d, 10, 200, 77, w * 256 / n);
+      if (memcmp(ref, out, d*w) != 0) return false;
+      if (d >= 3) {
+        Fl_Pixel_Ops::simd(Fl_Pixel_Ops::SCALAR);
+        Fl_Pixel_Ops::gray(src, ref, w, d);
+        Fl_Pixel_Ops::simd(level);
+        Fl_Pixel_Ops::gray(src, out, w, d);
+        if (memcmp(ref, out, (d-2)*w) != 0) return false;
+      }
+    }
+  }
+  return true;
+}
+
+TEST(Fl_Pixel_Ops, image_ops) {
+  for (int level = Fl_Pixel_Ops::SSSE3; level <= Fl_Pixel_Ops::cpu_simd(); level++) {
+    EXPECT_TRUE(image_ops_match(level));
+  }
+  Fl_Pixel_Ops::simd(Fl_Pixel_Ops::AVX2);
+  return true;
+}
+
+/* Drawing into an Fl_Image_Surface needs a display connection on X11 and
+ Wayland, so the following tests only run in the unittests window, not with
+ option `--core`. */
+static bool can_draw() { return Fl::first_window() != NULL; }
+
+// Draws widget w into a new surface, returns its RGB pixels
+static uchar *draw_to_image(Fl_Widget *w, int threads = 1) {
+  Fl_Image_Surface surf(w->w(), w->h());
+  surf.tiled_drawing(threads, 16);
+  Fl_Surface_Device::push_current(&surf);
+  surf.draw(w, 0, 0);
+  uchar *pixels = fl_read_image(NULL, 0, 0, w->w(), w->h());
+  Fl_Surface_Device::pop_current();
+  return pixels;
+}
+
+static bool same_image(uchar *a, uchar *b, int w, int h) {
+  bool same = (a && b && memcmp(a, b, size_t(w) * h * 3) == 0);
+  delete[] a;
+  delete[] b;
+  return same;
+}
+
+// An offscreen cached child swaps the drawing surface while the group is
+// recorded for tiled drawing, the group must look the same as untiled
+TEST(Fl_Image_Surface, tiled_drawing_cached_child) {
+  if (!can_draw()) return true;
+  Fl_Group::current(NULL);
+  Fl_Group *g = new Fl_Group(0, 0, 120, 80);
+  g->box(FL_FLAT_BOX);
+  g->color(FL_RED);
+  Fl_Box *cached = new Fl_Box(10, 10, 60, 40, "cached");
+  cached->box(FL_FLAT_BOX);
+  cached->color(FL_BLUE);
+  Fl_Box *above = new Fl_Box(50, 30, 60, 40, "above");
+  above->box(FL_FLAT_BOX);
+  above->color(FL_GREEN);
+  g->end();
+  uchar *plain = draw_to_image(g);
+  cached->offscreen_cache(1);
+  uchar *tiled = draw_to_image(g, 4);
+  EXPECT_TRUE(same_image(plain, tiled, g->w(), g->h()));
+  delete g;
+  return true;
+}
+
+// A box that counts how often its draw() method runs
+class Ut_Counting_Box : public Fl_Box {
+public:
+  int draws;
+  Ut_Counting_Box(int X, int Y, int W, int H, const char *L)
+  : Fl_Box(X, Y, W, H, L), draws(0) { }
+  void draw() FL_OVERRIDE {
+    draws++;
+    Fl_Box::draw();
+    fl_color(FL_RED);
+    fl_line(x(), y(), x() + w() - 1, y() + h() - 1);
+    fl_pie(x() + 4, y() + 4, 16, 16, 0, 270);
+  }
+};
+
+// The second drawing of a retained widget replays its display list
+TEST(Fl_Display_List, record_and_replay) {
+  if (!can_draw()) return true;
+  Fl_Group::current(NULL);
+  Fl_Group *g = new Fl_Group(0, 0, 100, 60);
+  g->box(FL_FLAT_BOX);
+  Ut_Counting_Box *b = new Ut_Counting_Box(10, 10, 80, 40, "retained");
+  b->box(FL_UP_BOX);
+  b->retained_drawing(1);
+  g->end();
+  Fl_Image_Surface surf(g->w(), g->h());
+  Fl_Surface_Device::push_current(&surf);
+  surf.draw(g, 0, 0); // records the box
+  uchar *drawn = fl_read_image(NULL, 0, 0, g->w(), g->h());
+  fl_color(FL_BLACK);
+  fl_rectf(0, 0, g->w(), g->h());
+  surf.draw(g, 0, 0); // replays it
+  uchar *replayed = fl_read_image(NULL, 0, 0, g->w(), g->h());
+  Fl_Surface_Device::pop_current();
+  EXPECT_EQ(b->draws, 1);
+  EXPECT_TRUE(same_image(drawn, replayed, g->w(), g->h()));
+  delete g;
+  return true;
+}
+
 #if 0
 
 TEST(fl_filename, ext) {